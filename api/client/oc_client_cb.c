@@ -30,10 +30,20 @@
 #include "api/oc_ri_internal.h"
 #include "messaging/coap/options_internal.h"
 #include "oc_client_state.h"
+#include "util/oc_features.h"
 #include "util/oc_list.h"
 #include "util/oc_memb.h"
 #include "util/oc_macros_internal.h"
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+#include "util/oc_hash_index_internal.h"
+#include "util/oc_hash_internal.h"
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+#include "api/oc_blockwise_stream_internal.h"
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 #ifdef OC_TCP
 #include "api/oc_ping_internal.h"
 #include "messaging/coap/signal_internal.h"
@@ -63,6 +73,59 @@ typedef struct client_cb_match_address_t
   oc_method_t method;
 } client_cb_match_address_t;
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+#ifdef OC_DYNAMIC_ALLOCATION
+static oc_hash_index_t g_client_cbs_by_mid;
+static oc_hash_index_t g_client_cbs_by_token;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+static oc_hash_index_entry_t
+  g_client_cbs_by_mid_entries[2 * (OC_MAX_NUM_CONCURRENT_REQUESTS + 1) + 1];
+static oc_hash_index_entry_t
+  g_client_cbs_by_token_entries[2 * (OC_MAX_NUM_CONCURRENT_REQUESTS + 1) + 1];
+static oc_hash_index_t g_client_cbs_by_mid =
+  OC_HASH_INDEX_STATIC_INIT(g_client_cbs_by_mid_entries);
+static oc_hash_index_t g_client_cbs_by_token =
+  OC_HASH_INDEX_STATIC_INIT(g_client_cbs_by_token_entries);
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static uint32_t
+client_cb_mid_hash(uint16_t mid)
+{
+  return oc_hash_fnv1a_uint(OC_HASH_FNV1A_INIT, mid);
+}
+
+static uint32_t
+client_cb_token_hash(const uint8_t *token, uint8_t token_len)
+{
+  return oc_hash_fnv1a(OC_HASH_FNV1A_INIT, token, token_len);
+}
+
+static bool
+client_cb_index_add(oc_client_cb_t *cb)
+{
+  if (!oc_hash_index_insert(&g_client_cbs_by_mid, client_cb_mid_hash(cb->mid),
+                            cb)) {
+    return false;
+  }
+  if (!oc_hash_index_insert(&g_client_cbs_by_token,
+                            client_cb_token_hash(cb->token, cb->token_len),
+                            cb)) {
+    oc_hash_index_remove(&g_client_cbs_by_mid, client_cb_mid_hash(cb->mid),
+                         cb);
+    return false;
+  }
+  return true;
+}
+
+static void
+client_cb_index_remove(const oc_client_cb_t *cb)
+{
+  oc_hash_index_remove(&g_client_cbs_by_mid, client_cb_mid_hash(cb->mid), cb);
+  oc_hash_index_remove(&g_client_cbs_by_token,
+                       client_cb_token_hash(cb->token, cb->token_len), cb);
+}
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 oc_client_cb_t *
 oc_ri_alloc_client_cb(const char *uri, const oc_endpoint_t *endpoint,
                       oc_method_t method, const char *query,
@@ -93,10 +156,55 @@ oc_ri_alloc_client_cb(const char *uri, const oc_endpoint_t *endpoint,
   if (query_len > 0) {
     oc_new_string(&cb->query, query, query_len);
   }
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (!client_cb_index_add(cb)) {
+    OC_ERR("cannot index client callback");
+    oc_free_string(&cb->uri);
+    oc_free_string(&cb->query);
+    oc_memb_free(&g_client_cbs_s, cb);
+    return NULL;
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
   oc_list_add(g_client_cbs, cb);
   return cb;
 }
 
+void
+oc_client_cb_set_mid(oc_client_cb_t *cb, uint16_t mid)
+{
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  bool indexed = oc_hash_index_remove(&g_client_cbs_by_mid,
+                                      client_cb_mid_hash(cb->mid), cb);
+  cb->mid = mid;
+  if (indexed) {
+    // cannot fail, a slot was freed by the removal
+    oc_hash_index_insert(&g_client_cbs_by_mid, client_cb_mid_hash(cb->mid),
+                         cb);
+  }
+#else  /* !OC_HAS_FEATURE_REQUEST_INDEX */
+  cb->mid = mid;
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+}
+
+void
+oc_client_cb_set_token(oc_client_cb_t *cb, const uint8_t *token,
+                       uint8_t token_len)
+{
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  bool indexed = oc_hash_index_remove(
+    &g_client_cbs_by_token, client_cb_token_hash(cb->token, cb->token_len), cb);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+  memcpy(cb->token, token, token_len);
+  cb->token_len = token_len;
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (indexed) {
+    // cannot fail, a slot was freed by the removal
+    oc_hash_index_insert(&g_client_cbs_by_token,
+                         client_cb_token_hash(cb->token, cb->token_len), cb);
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+}
+
 oc_client_cb_t *
 oc_client_cb_find_by_filter(oc_client_cb_filter_t filter, const void *user_data)
 {
@@ -134,6 +242,14 @@ client_cb_filter_is_equal_by_token(const oc_client_cb_t *client_cb,
          memcmp(client_cb->token, match->data, match->length) == 0;
 }
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+static bool
+client_cb_index_match_token(const void *item, const void *key)
+{
+  return client_cb_filter_is_equal_by_token((const oc_client_cb_t *)item, key);
+}
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 oc_client_cb_t *
 oc_ri_find_client_cb_by_token(const uint8_t *token, uint8_t token_len)
 {
@@ -141,8 +257,14 @@ oc_ri_find_client_cb_by_token(const uint8_t *token, uint8_t token_len)
     .data = token,
     .length = token_len,
   };
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  return (oc_client_cb_t *)oc_hash_index_find(
+    &g_client_cbs_by_token, client_cb_token_hash(token, token_len),
+    client_cb_index_match_token, &match);
+#else  /* !OC_HAS_FEATURE_REQUEST_INDEX */
   return oc_client_cb_find_by_filter(client_cb_filter_is_equal_by_token,
                                      &match);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 static bool
@@ -153,10 +275,24 @@ client_cb_filter_is_equal_by_mid(const oc_client_cb_t *client_cb,
   return client_cb->mid == *mid;
 }
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+static bool
+client_cb_index_match_mid(const void *item, const void *key)
+{
+  return client_cb_filter_is_equal_by_mid((const oc_client_cb_t *)item, key);
+}
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 oc_client_cb_t *
 oc_ri_find_client_cb_by_mid(uint16_t mid)
 {
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  return (oc_client_cb_t *)oc_hash_index_find(&g_client_cbs_by_mid,
+                                              client_cb_mid_hash(mid),
+                                              client_cb_index_match_mid, &mid);
+#else  /* !OC_HAS_FEATURE_REQUEST_INDEX */
   return oc_client_cb_find_by_filter(client_cb_filter_is_equal_by_mid, &mid);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 static bool
@@ -193,6 +329,9 @@ client_cb_remove_from_lists(const oc_client_cb_t *cb)
 #ifdef OC_TCP
   oc_ri_remove_timed_event_callback(cb, &oc_remove_ping_handler_async);
 #endif /* OC_TCP */
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  client_cb_index_remove(cb);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
   oc_list_remove(g_client_cbs, cb);
 }
 
@@ -226,6 +365,9 @@ oc_client_cb_dealloc(oc_client_cb_t *cb)
 #ifdef OC_BLOCK_WISE
   oc_blockwise_scrub_buffers_for_client_cb(cb);
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  oc_blockwise_stream_remove(cb);
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   oc_free_string(&cb->uri);
   oc_free_string(&cb->query);
   oc_memb_free(&g_client_cbs_s, cb);
@@ -284,9 +426,28 @@ oc_client_cb_remove_with_notify_timeout_async(void *data)
   return OC_EVENT_DONE;
 }
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+static bool
+client_cb_index_match_mid_to_free(const void *item, const void *key)
+{
+  const oc_client_cb_t *cb = (const oc_client_cb_t *)item;
+  return !cb->multicast && !cb->discovery && cb->ref_count == 0 &&
+         cb->mid == *(const uint16_t *)key;
+}
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 void
 oc_ri_free_client_cbs_by_mid_v1(uint16_t mid, oc_status_t code)
 {
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  oc_client_cb_t *cb;
+  while ((cb = (oc_client_cb_t *)oc_hash_index_find(
+            &g_client_cbs_by_mid, client_cb_mid_hash(mid),
+            client_cb_index_match_mid_to_free, &mid)) != NULL) {
+    cb->ref_count = 1;
+    client_cb_notify_with_code(cb, code);
+  }
+#else  /* !OC_HAS_FEATURE_REQUEST_INDEX */
   oc_client_cb_t *cb = (oc_client_cb_t *)oc_list_head(g_client_cbs);
   while (cb != NULL) {
     oc_client_cb_t *next = cb->next;
@@ -299,6 +460,7 @@ oc_ri_free_client_cbs_by_mid_v1(uint16_t mid, oc_status_t code)
     }
     cb = next;
   }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 void
@@ -586,6 +748,10 @@ void
 oc_client_cbs_shutdown(void)
 {
   client_cb_free_all();
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  oc_hash_index_deinit(&g_client_cbs_by_mid);
+  oc_hash_index_deinit(&g_client_cbs_by_token);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 #endif /* OC_CLIENT */
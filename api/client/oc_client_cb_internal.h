@@ -97,6 +97,13 @@ bool oc_client_cb_invoke(const coap_packet_t *response, oc_client_cb_t *cb,
                          oc_endpoint_t *endpoint) OC_NONNULL();
 #endif /* OC_BLOCK_WISE */
 
+/** @brief Update the message ID of the client callback. */
+void oc_client_cb_set_mid(oc_client_cb_t *cb, uint16_t mid) OC_NONNULL();
+
+/** @brief Update the token of the client callback. */
+void oc_client_cb_set_token(oc_client_cb_t *cb, const uint8_t *token,
+                            uint8_t token_len) OC_NONNULL();
+
 /** @brief Initialize client callbacks. */
 void oc_client_cbs_init(void);
 
@@ -27,12 +27,18 @@
 #include "port/oc_random.h"
 #include "tests/gtest/Device.h"
 #include "tests/gtest/Endpoint.h"
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+#include "tests/gtest/Benchmark.h"
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 
 #include <array>
 #include <gtest/gtest.h>
 #include <cstdint>
 #include <limits>
 #include <string>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -173,6 +179,32 @@ TEST_F(TestClientCB, FindByMid)
   EXPECT_EQ(cb2, cb);
 }
 
+TEST_F(TestClientCB, SetMidAndToken)
+{
+  oc_client_cb_t *cb = allocDummyClientCB("/set");
+  ASSERT_NE(nullptr, cb);
+  uint16_t mid = cb->mid;
+  std::array<uint8_t, COAP_TOKEN_LEN> token{};
+  memcpy(token.data(), cb->token, cb->token_len);
+
+  auto newMid = static_cast<uint16_t>(mid + 1);
+  oc_client_cb_set_mid(cb, newMid);
+  EXPECT_EQ(nullptr, oc_ri_find_client_cb_by_mid(mid));
+  EXPECT_EQ(cb, oc_ri_find_client_cb_by_mid(newMid));
+
+  std::array<uint8_t, COAP_TOKEN_LEN> newToken{};
+  oc_random_buffer(newToken.data(), newToken.size());
+  oc_client_cb_set_token(cb, newToken.data(), newToken.size());
+  EXPECT_EQ(nullptr, oc_ri_find_client_cb_by_token(token.data(), token.size()));
+  EXPECT_EQ(cb,
+            oc_ri_find_client_cb_by_token(newToken.data(), newToken.size()));
+
+  oc_client_cb_free(cb);
+  EXPECT_EQ(nullptr, oc_ri_find_client_cb_by_mid(newMid));
+  EXPECT_EQ(nullptr,
+            oc_ri_find_client_cb_by_token(newToken.data(), newToken.size()));
+}
+
 TEST_F(TestClientCB, GetClientCB)
 {
   std::string uri{ "/1" };
@@ -234,6 +266,49 @@ TEST_F(TestClientCB, RemoveByEndpoint)
   EXPECT_NE(nullptr, oc_ri_find_client_cb_by_mid(mid3));
 }
 
+#if defined(OC_HAS_FEATURE_REQUEST_INDEX) && defined(OC_DYNAMIC_ALLOCATION)
+
+class TestClientCBBenchmark : public TestClientCB,
+                              public testing::WithParamInterface<size_t> {};
+
+INSTANTIATE_TEST_SUITE_P(OutstandingRequests, TestClientCBBenchmark,
+                         testing::Values(100, 1000, 10000));
+
+/** lookup cost must not grow with the number of outstanding requests */
+TEST_P(TestClientCBBenchmark, Lookup)
+{
+  size_t count = GetParam();
+  std::vector<const oc_client_cb_t *> cbs{};
+  cbs.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const oc_client_cb_t *cb = allocDummyClientCB("/bench");
+    ASSERT_NE(nullptr, cb);
+    cbs.push_back(cb);
+  }
+
+  constexpr size_t kLookups = 100000;
+  oc::Benchmark("find by mid, " + std::to_string(count) + " client callbacks",
+                kLookups, [count, &cbs](size_t i) {
+                  const oc_client_cb_t *cb = cbs[i % count];
+                  ASSERT_EQ(cb, oc_ri_find_client_cb_by_mid(cb->mid));
+                });
+  oc::Benchmark("find by token, " + std::to_string(count) +
+                  " client callbacks",
+                kLookups, [count, &cbs](size_t i) {
+                  const oc_client_cb_t *cb = cbs[i % count];
+                  ASSERT_EQ(cb, oc_ri_find_client_cb_by_token(cb->token,
+                                                              cb->token_len));
+                });
+  oc::Benchmark("free by mid, " + std::to_string(count) + " client callbacks",
+                count, [&cbs](size_t i) {
+                  uint16_t mid = cbs[i]->mid;
+                  oc_ri_free_client_cbs_by_mid(mid);
+                  ASSERT_EQ(nullptr, oc_ri_find_client_cb_by_mid(mid));
+                });
+}
+
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX && OC_DYNAMIC_ALLOCATION */
+
 class TestClientCBWithServer : public testing::Test {
 public:
   static void SetUpTestCase() { ASSERT_TRUE(oc::TestDevice::StartServer()); }
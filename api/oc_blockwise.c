@@ -26,11 +26,21 @@
 #include "oc_endpoint.h"
 #include "port/oc_connectivity.h"
 #include "port/oc_log_internal.h"
+#include "util/oc_features.h"
 #include "util/oc_list.h"
 #include "util/oc_macros_internal.h"
 #include "util/oc_memb.h"
 #include <inttypes.h>
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+#include "api/oc_blockwise_stream_internal.h"
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+#include "util/oc_hash_index_internal.h"
+#include "util/oc_hash_internal.h"
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
+
 OC_MEMB(oc_blockwise_request_states_s, oc_blockwise_request_state_t,
         OC_MAX_NUM_CONCURRENT_REQUESTS);
 OC_MEMB(oc_blockwise_response_states_s, oc_blockwise_response_state_t,
@@ -46,23 +56,137 @@ typedef struct oc_app_data_buffer_t
 OC_MEMB_STATIC(oc_app_data_s, oc_app_data_buffer_t, OC_APP_DATA_BUFFER_POOL);
 #endif /* OC_APP_DATA_BUFFER_POOL */
 
-static oc_blockwise_state_t *
-blockwise_init_buffer(struct oc_memb *pool, const char *href, size_t href_len,
-                      const oc_endpoint_t *endpoint, oc_method_t method,
-                      oc_blockwise_role_t role, uint32_t buffer_size)
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+/* Client buffers of a list indexed by the message ID and by the token */
+typedef struct blockwise_index_t
 {
-  if (href_len == 0) {
-    OC_DBG("empty href");
-    return NULL;
+  oc_hash_index_t by_mid;
+  oc_hash_index_t by_token;
+} blockwise_index_t;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static blockwise_index_t g_blockwise_requests_index;
+static blockwise_index_t g_blockwise_responses_index;
+#else /* !OC_DYNAMIC_ALLOCATION */
+#define BLOCKWISE_INDEX_SIZE (2 * OC_MAX_NUM_CONCURRENT_REQUESTS + 1)
+static oc_hash_index_entry_t
+  g_blockwise_requests_by_mid_entries[BLOCKWISE_INDEX_SIZE];
+static oc_hash_index_entry_t
+  g_blockwise_requests_by_token_entries[BLOCKWISE_INDEX_SIZE];
+static oc_hash_index_entry_t
+  g_blockwise_responses_by_mid_entries[BLOCKWISE_INDEX_SIZE];
+static oc_hash_index_entry_t
+  g_blockwise_responses_by_token_entries[BLOCKWISE_INDEX_SIZE];
+static blockwise_index_t g_blockwise_requests_index = {
+  OC_HASH_INDEX_STATIC_INIT(g_blockwise_requests_by_mid_entries),
+  OC_HASH_INDEX_STATIC_INIT(g_blockwise_requests_by_token_entries),
+};
+static blockwise_index_t g_blockwise_responses_index = {
+  OC_HASH_INDEX_STATIC_INIT(g_blockwise_responses_by_mid_entries),
+  OC_HASH_INDEX_STATIC_INIT(g_blockwise_responses_by_token_entries),
+};
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+typedef struct blockwise_match_token_t
+{
+  const uint8_t *data;
+  uint8_t length;
+} blockwise_match_token_t;
+
+static uint32_t
+blockwise_mid_hash(uint16_t mid)
+{
+  return oc_hash_fnv1a_uint(OC_HASH_FNV1A_INIT, mid);
+}
+
+static uint32_t
+blockwise_token_hash(const uint8_t *token, uint8_t token_len)
+{
+  return oc_hash_fnv1a(OC_HASH_FNV1A_INIT, token, token_len);
+}
+
+static bool
+blockwise_match_buffer(const void *item, const void *key)
+{
+  return item == key;
+}
+
+static bool
+blockwise_match_mid(const void *item, const void *key)
+{
+  const oc_blockwise_state_t *buffer = (const oc_blockwise_state_t *)item;
+  return buffer->mid == *(const uint16_t *)key &&
+         buffer->role == OC_BLOCKWISE_CLIENT;
+}
+
+static bool
+blockwise_match_token(const void *item, const void *key)
+{
+  const oc_blockwise_state_t *buffer = (const oc_blockwise_state_t *)item;
+  const blockwise_match_token_t *token = (const blockwise_match_token_t *)key;
+  return buffer->role == OC_BLOCKWISE_CLIENT &&
+         buffer->token_len == token->length &&
+         memcmp(buffer->token, token->data, token->length) == 0;
+}
+
+/* Only client buffers are looked up by the message ID and the token, buffers
+ * without a token are not indexed by token */
+static bool
+blockwise_index_add(blockwise_index_t *index, oc_blockwise_state_t *buffer)
+{
+  if (buffer->role != OC_BLOCKWISE_CLIENT) {
+    return true;
+  }
+  if (!oc_hash_index_insert(&index->by_mid, blockwise_mid_hash(buffer->mid),
+                            buffer)) {
+    return false;
+  }
+  if (buffer->token_len > 0 &&
+      !oc_hash_index_insert(
+        &index->by_token,
+        blockwise_token_hash(buffer->token, buffer->token_len), buffer)) {
+    oc_hash_index_remove(&index->by_mid, blockwise_mid_hash(buffer->mid),
+                         buffer);
+    return false;
   }
+  return true;
+}
 
-  oc_blockwise_state_t *buffer = (oc_blockwise_state_t *)oc_memb_alloc(pool);
+static void
+blockwise_index_remove(blockwise_index_t *index,
+                       const oc_blockwise_state_t *buffer)
+{
   if (buffer == NULL) {
-    OC_WRN("block-wise buffers exhausted");
-    return NULL;
+    return;
   }
+  // not conditioned by the role, it might have changed after the insertion
+  oc_hash_index_remove(&index->by_mid, blockwise_mid_hash(buffer->mid),
+                       buffer);
+  if (buffer->token_len > 0) {
+    oc_hash_index_remove(
+      &index->by_token, blockwise_token_hash(buffer->token, buffer->token_len),
+      buffer);
+  }
+}
+
+static blockwise_index_t *
+blockwise_index_of(const oc_blockwise_state_t *buffer)
+{
+  // every client buffer is indexed by the message ID
+  if (oc_hash_index_find(&g_blockwise_requests_index.by_mid,
+                         blockwise_mid_hash(buffer->mid),
+                         blockwise_match_buffer, buffer) != NULL) {
+    return &g_blockwise_requests_index;
+  }
+  return &g_blockwise_responses_index;
+}
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
 
 #ifdef OC_DYNAMIC_ALLOCATION
+static bool
+blockwise_alloc_payload_buffer(oc_blockwise_state_t *buffer,
+                               uint32_t buffer_size)
+{
 #ifdef OC_APP_DATA_BUFFER_POOL
   oc_app_data_buffer_t *app_buffer =
     (oc_app_data_buffer_t *)oc_memb_alloc(&oc_app_data_s);
@@ -77,7 +201,29 @@ blockwise_init_buffer(struct oc_memb *pool, const char *href, size_t href_len,
     buffer->buffer_size = buffer_size;
     OC_DBG("block-wise buffer allocated with size %" PRIu32, buffer_size);
   }
-  if (buffer->buffer == NULL) {
+  return buffer->buffer != NULL;
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static oc_blockwise_state_t *
+blockwise_init_buffer(struct oc_memb *pool, const char *href, size_t href_len,
+                      const oc_endpoint_t *endpoint, oc_method_t method,
+                      oc_blockwise_role_t role, uint32_t buffer_size)
+{
+  if (href_len == 0) {
+    OC_DBG("empty href");
+    return NULL;
+  }
+
+  oc_blockwise_state_t *buffer = (oc_blockwise_state_t *)oc_memb_alloc(pool);
+  if (buffer == NULL) {
+    OC_WRN("block-wise buffers exhausted");
+    return NULL;
+  }
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  // a buffer of size 0 is requested for a message that is not stored
+  if (buffer_size > 0 && !blockwise_alloc_payload_buffer(buffer, buffer_size)) {
     OC_ERR("cannot allocate block-wise buffer");
     oc_memb_free(pool, buffer);
     return NULL;
@@ -96,6 +242,9 @@ blockwise_init_buffer(struct oc_memb *pool, const char *href, size_t href_len,
   oc_new_string(&buffer->href, href, href_len);
   buffer->next = NULL;
   buffer->finish_cb = NULL;
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  buffer->stream = NULL;
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
 #ifdef OC_CLIENT
   buffer->mid = 0;
   buffer->client_cb = NULL;
@@ -147,6 +296,10 @@ blockwise_get_buffer_size(const oc_blockwise_state_t *buffer)
 static oc_event_callback_retval_t
 blockwise_free_request_async(void *data)
 {
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+  blockwise_index_remove(&g_blockwise_requests_index,
+                         (const oc_blockwise_state_t *)data);
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
   blockwise_free_buffer(oc_blockwise_requests, &oc_blockwise_request_states_s,
                         (oc_blockwise_state_t *)data);
   return OC_EVENT_DONE;
@@ -155,6 +308,10 @@ blockwise_free_request_async(void *data)
 static oc_event_callback_retval_t
 blockwise_free_response_async(void *data)
 {
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+  blockwise_index_remove(&g_blockwise_responses_index,
+                         (const oc_blockwise_state_t *)data);
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
   blockwise_free_buffer(oc_blockwise_responses, &oc_blockwise_response_states_s,
                         (oc_blockwise_state_t *)data);
   return OC_EVENT_DONE;
@@ -174,6 +331,15 @@ oc_blockwise_alloc_request_buffer(const char *href, size_t href_len,
     OC_ERR("cannot allocate block-wise request buffer");
     return NULL;
   }
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+  if (!blockwise_index_add(&g_blockwise_requests_index,
+                           (oc_blockwise_state_t *)buffer)) {
+    OC_ERR("cannot index block-wise request buffer");
+    blockwise_free_buffer(oc_blockwise_requests, &oc_blockwise_request_states_s,
+                          (oc_blockwise_state_t *)buffer);
+    return NULL;
+  }
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
   oc_ri_add_timed_event_callback_seconds(buffer, blockwise_free_request_async,
                                          OC_EXCHANGE_LIFETIME);
   oc_list_add(oc_blockwise_requests, buffer);
@@ -195,6 +361,16 @@ oc_blockwise_alloc_response_buffer(const char *href, size_t href_len,
     OC_ERR("cannot allocate block-wise response buffer");
     return NULL;
   }
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+  if (!blockwise_index_add(&g_blockwise_responses_index,
+                           (oc_blockwise_state_t *)buffer)) {
+    OC_ERR("cannot index block-wise response buffer");
+    blockwise_free_buffer(oc_blockwise_responses,
+                          &oc_blockwise_response_states_s,
+                          (oc_blockwise_state_t *)buffer);
+    return NULL;
+  }
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
   buffer->code = code;
   if (generate_etag) {
     oc_random_buffer(buffer->etag.value, sizeof(buffer->etag.value));
@@ -235,6 +411,12 @@ oc_blockwise_free_all_request_buffers(bool all)
     }
     buffer = next;
   }
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+  if (all) {
+    oc_hash_index_deinit(&g_blockwise_requests_index.by_mid);
+    oc_hash_index_deinit(&g_blockwise_requests_index.by_token);
+  }
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 void
@@ -249,6 +431,12 @@ oc_blockwise_free_all_response_buffers(bool all)
     }
     buffer = next;
   }
+#if defined(OC_CLIENT) && defined(OC_HAS_FEATURE_REQUEST_INDEX)
+  if (all) {
+    oc_hash_index_deinit(&g_blockwise_responses_index.by_mid);
+    oc_hash_index_deinit(&g_blockwise_responses_index.by_token);
+  }
+#endif /* OC_CLIENT && OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 void
@@ -258,6 +446,33 @@ oc_blockwise_free_all_buffers(bool all)
   oc_blockwise_free_all_response_buffers(all);
 }
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+void
+oc_blockwise_scrub_buffers_for_stream(const oc_blockwise_stream_t *stream)
+{
+  oc_blockwise_state_t *buffer =
+    (oc_blockwise_state_t *)oc_list_head(oc_blockwise_requests);
+  while (buffer != NULL) {
+    oc_blockwise_state_t *next = buffer->next;
+    if (buffer->stream == stream) {
+      oc_blockwise_free_request_buffer(buffer);
+    }
+    buffer = next;
+  }
+
+  buffer = (oc_blockwise_state_t *)oc_list_head(oc_blockwise_responses);
+  while (buffer != NULL) {
+    oc_blockwise_state_t *next = buffer->next;
+    if (buffer->stream == stream) {
+      oc_blockwise_free_response_buffer(buffer);
+    }
+    buffer = next;
+  }
+}
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 #ifdef OC_CLIENT
 
 void
@@ -283,6 +498,106 @@ oc_blockwise_scrub_buffers_for_client_cb(const void *cb)
   }
 }
 
+void
+oc_blockwise_set_mid(oc_blockwise_state_t *buffer, uint16_t mid)
+{
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (buffer->role == OC_BLOCKWISE_CLIENT) {
+    blockwise_index_t *index = blockwise_index_of(buffer);
+    oc_hash_index_remove(&index->by_mid, blockwise_mid_hash(buffer->mid),
+                         buffer);
+    buffer->mid = mid;
+    // cannot fail, a slot was freed by the removal
+    oc_hash_index_insert(&index->by_mid, blockwise_mid_hash(buffer->mid),
+                         buffer);
+    return;
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+  buffer->mid = mid;
+}
+
+void
+oc_blockwise_set_token(oc_blockwise_state_t *buffer, const uint8_t *token,
+                       uint8_t token_len)
+{
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  blockwise_index_t *index = NULL;
+  if (buffer->role == OC_BLOCKWISE_CLIENT) {
+    index = blockwise_index_of(buffer);
+    if (buffer->token_len > 0) {
+      oc_hash_index_remove(
+        &index->by_token,
+        blockwise_token_hash(buffer->token, buffer->token_len), buffer);
+    }
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+  memcpy(buffer->token, token, token_len);
+  buffer->token_len = token_len;
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (index != NULL && buffer->token_len > 0 &&
+      !oc_hash_index_insert(
+        &index->by_token,
+        blockwise_token_hash(buffer->token, buffer->token_len), buffer)) {
+    OC_ERR("cannot index block-wise buffer by token");
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+}
+
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+
+static oc_blockwise_state_t *
+blockwise_find_buffer_by_token(const blockwise_index_t *index,
+                               const uint8_t *token, uint8_t token_len)
+{
+  if (token_len == 0) {
+    return NULL;
+  }
+  blockwise_match_token_t key = {
+    .data = token,
+    .length = token_len,
+  };
+  return (oc_blockwise_state_t *)oc_hash_index_find(
+    &index->by_token, blockwise_token_hash(token, token_len),
+    blockwise_match_token, &key);
+}
+
+oc_blockwise_state_t *
+oc_blockwise_find_request_buffer_by_token(const uint8_t *token,
+                                          uint8_t token_len)
+{
+  return blockwise_find_buffer_by_token(&g_blockwise_requests_index, token,
+                                        token_len);
+}
+
+oc_blockwise_state_t *
+oc_blockwise_find_response_buffer_by_token(const uint8_t *token,
+                                           uint8_t token_len)
+{
+  return blockwise_find_buffer_by_token(&g_blockwise_responses_index, token,
+                                        token_len);
+}
+
+static oc_blockwise_state_t *
+blockwise_find_buffer_by_mid(const blockwise_index_t *index, uint16_t mid)
+{
+  return (oc_blockwise_state_t *)oc_hash_index_find(
+    &index->by_mid, blockwise_mid_hash(mid), blockwise_match_mid, &mid);
+}
+
+oc_blockwise_state_t *
+oc_blockwise_find_request_buffer_by_mid(uint16_t mid)
+{
+  return blockwise_find_buffer_by_mid(&g_blockwise_requests_index, mid);
+}
+
+oc_blockwise_state_t *
+oc_blockwise_find_response_buffer_by_mid(uint16_t mid)
+{
+  return blockwise_find_buffer_by_mid(&g_blockwise_responses_index, mid);
+}
+
+#else /* !OC_HAS_FEATURE_REQUEST_INDEX */
+
 static oc_blockwise_state_t *
 blockwise_find_buffer_by_token(oc_list_t list, const uint8_t *token,
                                uint8_t token_len)
@@ -339,6 +654,8 @@ oc_blockwise_find_response_buffer_by_mid(uint16_t mid)
   return blockwise_find_buffer_by_mid(oc_blockwise_responses, mid);
 }
 
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 static oc_blockwise_state_t *
 blockwise_find_buffer_by_client_cb(oc_list_t list,
                                    const oc_endpoint_t *endpoint,
@@ -412,11 +729,78 @@ oc_blockwise_find_response_buffer(const char *href, size_t href_len,
                                oc_string_view(query, query_len), role);
 }
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+static void *
+blockwise_stream_dispatch_block(oc_blockwise_state_t *buffer,
+                                uint32_t block_offset,
+                                uint32_t requested_block_size,
+                                uint32_t *payload_size)
+{
+  const oc_blockwise_stream_t *stream = buffer->stream;
+  // blocks after the end of the message are not produced
+  if (stream->handler.read == NULL ||
+      (block_offset > 0 && block_offset >= buffer->payload_size)) {
+    return NULL;
+  }
+  uint32_t block_size =
+    MIN(requested_block_size, blockwise_get_buffer_size(buffer));
+  bool more = false;
+  long size =
+    stream->handler.read(&buffer->endpoint, block_offset, buffer->buffer,
+                         block_size, &more, stream->handler.user_data);
+  if (size < 0 || (uint32_t)size > block_size ||
+      (more && (uint32_t)size != block_size)) {
+    OC_ERR("block-wise stream failed to produce block at offset %" PRIu32,
+           block_offset);
+    return NULL;
+  }
+  *payload_size = (uint32_t)size;
+  buffer->next_block_offset = block_offset + *payload_size;
+  // the size of the message is unknown until its last block is produced, it
+  // is kept past the produced blocks so the transfer continues
+  buffer->payload_size = buffer->next_block_offset + (more ? 1 : 0);
+  return buffer->buffer;
+}
+
+static bool
+blockwise_stream_handle_block(oc_blockwise_state_t *buffer,
+                              uint32_t incoming_block_offset,
+                              const uint8_t *incoming_block,
+                              uint32_t incoming_block_size)
+{
+  const oc_blockwise_stream_t *stream = buffer->stream;
+  if (stream->handler.write == NULL ||
+      incoming_block_offset > buffer->next_block_offset) {
+    return false;
+  }
+  // a retransmitted block was already passed to the stream
+  if (buffer->next_block_offset == incoming_block_offset) {
+    if (!stream->handler.write(&buffer->endpoint, incoming_block_offset,
+                               incoming_block, incoming_block_size,
+                               stream->handler.user_data)) {
+      OC_ERR("block-wise stream failed to consume block at offset %" PRIu32,
+             incoming_block_offset);
+      return false;
+    }
+    buffer->next_block_offset += incoming_block_size;
+  }
+  return true;
+}
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 void *
 oc_blockwise_dispatch_block(oc_blockwise_state_t *buffer, uint32_t block_offset,
                             uint32_t requested_block_size,
                             uint32_t *payload_size)
 {
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (buffer->stream != NULL) {
+    return blockwise_stream_dispatch_block(buffer, block_offset,
+                                           requested_block_size, payload_size);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   if (block_offset < buffer->payload_size) {
     if (buffer->payload_size < requested_block_size) {
       *payload_size = buffer->payload_size;
@@ -436,6 +820,12 @@ oc_blockwise_handle_block(oc_blockwise_state_t *buffer,
                           const uint8_t *incoming_block,
                           uint32_t incoming_block_size)
 {
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (buffer->stream != NULL) {
+    return blockwise_stream_handle_block(buffer, incoming_block_offset,
+                                         incoming_block, incoming_block_size);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   if (incoming_block_offset >= blockwise_get_buffer_size(buffer) ||
       incoming_block_size >
         (blockwise_get_buffer_size(buffer) - incoming_block_offset) ||
@@ -452,4 +842,16 @@ oc_blockwise_handle_block(oc_blockwise_state_t *buffer,
 
   return true;
 }
+
+void
+oc_blockwise_finish_receive(oc_blockwise_state_t *buffer)
+{
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (buffer->stream != NULL) {
+    buffer->payload_size = 0;
+    return;
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+  buffer->payload_size = buffer->next_block_offset;
+}
 #endif /* OC_BLOCK_WISE */
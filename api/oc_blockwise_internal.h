@@ -31,6 +31,7 @@
 #include "oc_ri.h"
 #include "port/oc_connectivity.h"
 #include "util/oc_compiler.h"
+#include "util/oc_features.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -50,6 +51,10 @@ typedef enum {
 
 typedef void oc_blockwise_finish_cb_t(void);
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+struct oc_blockwise_stream_t;
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 typedef struct oc_blockwise_state_s
 {
   struct oc_blockwise_state_s *next;
@@ -72,6 +77,9 @@ typedef struct oc_blockwise_state_s
 #endif                   /* !OC_DYNAMIC_ALLOCATION */
   oc_string_t uri_query; ///< the query
   oc_blockwise_finish_cb_t *finish_cb;
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  const struct oc_blockwise_stream_t *stream; ///< stream of the body
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
 #ifdef OC_CLIENT
   uint8_t token[COAP_TOKEN_LEN]; ///< the token
   uint8_t token_len;             ///< token length
@@ -209,6 +217,25 @@ oc_blockwise_state_t *oc_blockwise_find_response_buffer(
  */
 void oc_blockwise_scrub_buffers_for_client_cb(const void *cb);
 
+/**
+ * @brief update the message id of a client blockwise buffer
+ *
+ * @param buffer the blocktransfer (cannot be NULL)
+ * @param mid the message id
+ */
+void oc_blockwise_set_mid(oc_blockwise_state_t *buffer, uint16_t mid)
+  OC_NONNULL();
+
+/**
+ * @brief update the token of a client blockwise buffer
+ *
+ * @param buffer the blocktransfer (cannot be NULL)
+ * @param token the token
+ * @param token_len the token length
+ */
+void oc_blockwise_set_token(oc_blockwise_state_t *buffer, const uint8_t *token,
+                            uint8_t token_len) OC_NONNULL(1);
+
 /**
  * @brief find client blockwise request based on mid
  *
@@ -296,6 +323,24 @@ bool oc_blockwise_handle_block(oc_blockwise_state_t *buffer,
                                const uint8_t *incoming_block,
                                uint32_t incoming_block_size) OC_NONNULL();
 
+/**
+ * @brief mark the whole message as received, the payload size of a streamed
+ * message is 0 because the message was passed to the stream
+ *
+ * @param buffer the whole message (cannot be NULL)
+ */
+void oc_blockwise_finish_receive(oc_blockwise_state_t *buffer) OC_NONNULL();
+
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+/**
+ * @brief free all request and response blocks of a stream
+ *
+ * @param stream the stream
+ */
+void oc_blockwise_scrub_buffers_for_stream(
+  const struct oc_blockwise_stream_t *stream);
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 #ifdef __cplusplus
 }
 #endif
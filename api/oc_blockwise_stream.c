@@ -0,0 +1,192 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+#include "api/oc_blockwise_stream_internal.h"
+#include "port/oc_log_internal.h"
+#include "util/oc_list.h"
+#include "util/oc_memb.h"
+
+#include <assert.h>
+
+OC_LIST(g_streams);
+OC_MEMB(g_streams_s, oc_blockwise_stream_t, OC_MAX_BLOCKWISE_STREAMS);
+
+static oc_blockwise_stream_t *
+blockwise_stream_find(const void *owner)
+{
+  for (oc_blockwise_stream_t *s =
+         (oc_blockwise_stream_t *)oc_list_head(g_streams);
+       s != NULL; s = s->next) {
+    if (s->owner == owner) {
+      return s;
+    }
+  }
+  return NULL;
+}
+
+oc_blockwise_stream_t *
+oc_blockwise_stream_add(const void *owner,
+                        oc_blockwise_stream_handler_t handler)
+{
+  oc_blockwise_stream_t *s = blockwise_stream_find(owner);
+  if (s != NULL) {
+    // transfers of the previous callbacks cannot continue with the new ones
+    oc_blockwise_scrub_buffers_for_stream(s);
+    s->handler = handler;
+    return s;
+  }
+  s = (oc_blockwise_stream_t *)oc_memb_alloc(&g_streams_s);
+  if (s == NULL) {
+    OC_WRN("insufficient memory to add block-wise stream");
+    return NULL;
+  }
+  s->owner = owner;
+  s->handler = handler;
+  oc_list_add(g_streams, s);
+  return s;
+}
+
+const oc_blockwise_stream_t *
+oc_blockwise_stream_find(const void *owner)
+{
+  return blockwise_stream_find(owner);
+}
+
+const oc_blockwise_stream_t *
+oc_blockwise_stream_find_by_method(const oc_resource_t *resource,
+                                   oc_method_t method,
+                                   const oc_endpoint_t *endpoint)
+{
+#ifdef OC_TCP
+  if ((endpoint->flags & TCP) != 0) {
+    return NULL;
+  }
+#else  /* !OC_TCP */
+  (void)endpoint;
+#endif /* OC_TCP */
+  const oc_blockwise_stream_t *s = blockwise_stream_find(resource);
+  if (s == NULL) {
+    return NULL;
+  }
+  if (method == OC_GET) {
+    return s->handler.read != NULL ? s : NULL;
+  }
+  if (method == OC_POST || method == OC_PUT) {
+    return s->handler.write != NULL ? s : NULL;
+  }
+  return NULL;
+}
+
+oc_content_format_t
+oc_blockwise_stream_content_format(const oc_blockwise_stream_t *stream)
+{
+  if (stream->handler.content_format == APPLICATION_NOT_DEFINED) {
+    return APPLICATION_VND_OCF_CBOR;
+  }
+  return stream->handler.content_format;
+}
+
+void
+oc_blockwise_stream_remove(const void *owner)
+{
+  oc_blockwise_stream_t *s = blockwise_stream_find(owner);
+  if (s == NULL) {
+    return;
+  }
+  oc_blockwise_scrub_buffers_for_stream(s);
+  oc_list_remove(g_streams, s);
+  oc_memb_free(&g_streams_s, s);
+}
+
+void
+oc_blockwise_stream_free_all(void)
+{
+  oc_blockwise_stream_t *s = (oc_blockwise_stream_t *)oc_list_pop(g_streams);
+  while (s != NULL) {
+    oc_blockwise_scrub_buffers_for_stream(s);
+    oc_memb_free(&g_streams_s, s);
+    s = (oc_blockwise_stream_t *)oc_list_pop(g_streams);
+  }
+}
+
+oc_blockwise_state_t *
+oc_blockwise_stream_alloc_request_buffer(const oc_blockwise_stream_t *stream,
+                                         const char *href, size_t href_len,
+                                         const oc_endpoint_t *endpoint,
+                                         oc_method_t method,
+                                         oc_blockwise_role_t role,
+                                         uint32_t block_size)
+{
+  // the client sends the body of a request, the server receives it
+  oc_blockwise_state_t *buffer = oc_blockwise_alloc_request_buffer(
+    href, href_len, endpoint, method, role,
+    role == OC_BLOCKWISE_CLIENT ? block_size : 0);
+  if (buffer != NULL) {
+    buffer->stream = stream;
+  }
+  return buffer;
+}
+
+oc_blockwise_state_t *
+oc_blockwise_stream_alloc_response_buffer(const oc_blockwise_stream_t *stream,
+                                          const char *href, size_t href_len,
+                                          const oc_endpoint_t *endpoint,
+                                          oc_method_t method,
+                                          oc_blockwise_role_t role,
+                                          uint32_t block_size)
+{
+  // the server sends the body of a response, the client receives it
+  oc_blockwise_state_t *buffer = oc_blockwise_alloc_response_buffer(
+    href, href_len, endpoint, method, role,
+    role == OC_BLOCKWISE_SERVER ? block_size : 0, CONTENT_2_05,
+    role == OC_BLOCKWISE_SERVER);
+  if (buffer != NULL) {
+    buffer->stream = stream;
+  }
+  return buffer;
+}
+
+#ifdef OC_SERVER
+
+bool
+oc_resource_set_blockwise_stream(oc_resource_t *resource,
+                                 oc_blockwise_stream_handler_t handler)
+{
+  assert(resource != NULL);
+  if (handler.read == NULL && handler.write == NULL) {
+    OC_ERR("block-wise stream of resource(%s) has no callbacks",
+           oc_string(resource->uri));
+    return false;
+  }
+  return oc_blockwise_stream_add(resource, handler) != NULL;
+}
+
+void
+oc_resource_remove_blockwise_stream(const oc_resource_t *resource)
+{
+  assert(resource != NULL);
+  oc_blockwise_stream_remove(resource);
+}
+
+#endif /* OC_SERVER */
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
@@ -0,0 +1,126 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef OC_BLOCKWISE_STREAM_INTERNAL_H
+#define OC_BLOCKWISE_STREAM_INTERNAL_H
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+#include "api/oc_blockwise_internal.h"
+#include "oc_blockwise_stream.h"
+#include "oc_config.h"
+#include "oc_endpoint.h"
+#include "oc_ri.h"
+#include "util/oc_compiler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OC_DYNAMIC_ALLOCATION
+/** Maximal number of streamed resources and client requests */
+#ifndef OC_MAX_BLOCKWISE_STREAMS
+#define OC_MAX_BLOCKWISE_STREAMS                                               \
+  (OC_MAX_APP_RESOURCES + OC_MAX_NUM_CONCURRENT_REQUESTS)
+#endif /* !OC_MAX_BLOCKWISE_STREAMS */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+/** @brief Callbacks streaming the bodies of a resource or a client request */
+typedef struct oc_blockwise_stream_t
+{
+  struct oc_blockwise_stream_t *next;
+  const void *owner; ///< the resource or the client callback
+  oc_blockwise_stream_handler_t handler;
+} oc_blockwise_stream_t;
+
+/**
+ * @brief Set the stream of an owner, the previous stream of the owner is
+ * replaced.
+ *
+ * @param owner the resource or the client callback (cannot be NULL)
+ * @param handler the callbacks
+ * @return the stream on success
+ * @return NULL the stream could not be allocated
+ */
+oc_blockwise_stream_t *oc_blockwise_stream_add(
+  const void *owner, oc_blockwise_stream_handler_t handler) OC_NONNULL();
+
+/** @brief Find the stream of an owner */
+const oc_blockwise_stream_t *oc_blockwise_stream_find(const void *owner)
+  OC_NONNULL();
+
+/**
+ * @brief Find the stream of a resource that streams the body of a request or
+ * of its response.
+ *
+ * @param resource the resource (cannot be NULL)
+ * @param method the method of the request
+ * @param endpoint the endpoint of the request (cannot be NULL)
+ * @return the stream
+ * @return NULL the bodies of the request and of the response are not streamed
+ */
+const oc_blockwise_stream_t *oc_blockwise_stream_find_by_method(
+  const oc_resource_t *resource, oc_method_t method,
+  const oc_endpoint_t *endpoint) OC_NONNULL();
+
+/** @brief Content format of the body produced by the stream */
+oc_content_format_t oc_blockwise_stream_content_format(
+  const oc_blockwise_stream_t *stream) OC_NONNULL();
+
+/** @brief Remove the stream of an owner and abort its transfers */
+void oc_blockwise_stream_remove(const void *owner) OC_NONNULL();
+
+/** @brief Remove all streams */
+void oc_blockwise_stream_free_all(void);
+
+/**
+ * @brief Allocate a request buffer of a streamed body.
+ *
+ * A received body is passed to the stream and it is not stored in the buffer,
+ * the buffer of a sent body holds one block.
+ *
+ * @see oc_blockwise_alloc_request_buffer
+ */
+oc_blockwise_state_t *oc_blockwise_stream_alloc_request_buffer(
+  const oc_blockwise_stream_t *stream, const char *href, size_t href_len,
+  const oc_endpoint_t *endpoint, oc_method_t method, oc_blockwise_role_t role,
+  uint32_t block_size) OC_NONNULL(1, 4);
+
+/**
+ * @brief Allocate a response buffer of a streamed body.
+ *
+ * @see oc_blockwise_stream_alloc_request_buffer
+ * @see oc_blockwise_alloc_response_buffer
+ */
+oc_blockwise_state_t *oc_blockwise_stream_alloc_response_buffer(
+  const oc_blockwise_stream_t *stream, const char *href, size_t href_len,
+  const oc_endpoint_t *endpoint, oc_method_t method, oc_blockwise_role_t role,
+  uint32_t block_size) OC_NONNULL(1, 4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
+#endif /* OC_BLOCKWISE_STREAM_INTERNAL_H */
@@ -42,6 +42,10 @@
 #include "security/oc_tls_internal.h"
 #endif /* OC_SECURITY */
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+#include "api/oc_blockwise_stream_internal.h"
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 #include <assert.h>
 
 typedef struct oc_dispatch_context_t
@@ -68,10 +72,39 @@ static oc_dispatch_request_t g_request;
 static oc_message_t *g_multicast_update = NULL;
 #endif /* OC_OSCORE */
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+static bool
+dispatch_coap_request_set_stream_payload(oc_dispatch_request_t *request)
+{
+  uint32_t block_size = 0;
+  void *payload = oc_blockwise_dispatch_block(
+    request->buffer, 0, (uint32_t)OC_BLOCK_SIZE, &block_size);
+  if (payload == NULL) {
+    return false;
+  }
+  coap_set_payload(&request->packet, payload, block_size);
+  if (request->buffer->next_block_offset < request->buffer->payload_size) {
+    coap_options_set_block1(&request->packet, 0, 1, (uint16_t)block_size, 0);
+  } else {
+    request->buffer->ref_count = 0;
+  }
+  coap_options_set_content_format(&request->packet,
+                                  request->buffer->content_format);
+  return true;
+}
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 static bool
 dispatch_coap_request_set_payload(oc_dispatch_request_t *request,
                                   const oc_dispatch_context_t *dispatch)
 {
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (request->buffer != NULL && request->buffer->stream != NULL) {
+    return dispatch_coap_request_set_stream_payload(request);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   int payload_size = oc_rep_get_encoded_payload_size();
 
   if ((dispatch->client_cb->method == OC_PUT ||
@@ -208,32 +241,29 @@ oc_request_set_packet_options(coap_packet_t *packet, oc_content_format_t accept,
   }
 }
 
+#ifdef OC_BLOCK_WISE
 static bool
-prepare_coap_request(oc_client_cb_t *cb, coap_configure_request_fn_t configure,
-                     const void *configure_data)
+prepare_coap_request_buffer(oc_client_cb_t *cb)
 {
-  coap_message_type_t type = COAP_TYPE_NON;
-  if (cb->qos == HIGH_QOS) {
-    type = COAP_TYPE_CON;
-  }
-
-  coap_transaction_t *transaction =
-    coap_new_transaction(cb->mid, cb->token, cb->token_len, &cb->endpoint);
-  if (transaction == NULL) {
-    return false;
-  }
-
-  oc_rep_new_v1(transaction->message->data + COAP_MAX_HEADER_SIZE,
-                OC_BLOCK_SIZE);
-
-#ifdef OC_BLOCK_WISE
-  if (cb->method == OC_PUT || cb->method == OC_POST) {
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  const oc_blockwise_stream_t *stream = oc_blockwise_stream_find(cb);
+  if (stream != NULL) {
+    // the payload is produced by the stream one block at a time
+    g_request.buffer = oc_blockwise_stream_alloc_request_buffer(
+      stream, oc_string(cb->uri) + 1, oc_string_len(cb->uri) - 1,
+      &cb->endpoint, cb->method, OC_BLOCKWISE_CLIENT, (uint32_t)OC_BLOCK_SIZE);
+    if (g_request.buffer == NULL) {
+      return false;
+    }
+    g_request.buffer->content_format =
+      oc_blockwise_stream_content_format(stream);
+  } else
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+  {
     g_request.buffer = oc_blockwise_alloc_request_buffer(
       oc_string(cb->uri) + 1, oc_string_len(cb->uri) - 1, &cb->endpoint,
       cb->method, OC_BLOCKWISE_CLIENT, (uint32_t)OC_MIN_APP_DATA_SIZE);
     if (g_request.buffer == NULL) {
-      OC_ERR("global request_buffer is NULL");
-      coap_clear_transaction(transaction);
       return false;
     }
 #ifdef OC_DYNAMIC_ALLOCATION
@@ -250,8 +280,37 @@ prepare_coap_request(oc_client_cb_t *cb, coap_configure_request_fn_t configure,
 #else  /* OC_DYNAMIC_ALLOCATION */
     oc_rep_new_v1(g_request.buffer->buffer, OC_MIN_APP_DATA_SIZE);
 #endif /* !OC_DYNAMIC_ALLOCATION */
-    g_request.buffer->mid = cb->mid;
-    g_request.buffer->client_cb = cb;
+  }
+  oc_blockwise_set_mid(g_request.buffer, cb->mid);
+  g_request.buffer->client_cb = cb;
+  return true;
+}
+#endif /* OC_BLOCK_WISE */
+
+static bool
+prepare_coap_request(oc_client_cb_t *cb, coap_configure_request_fn_t configure,
+                     const void *configure_data)
+{
+  coap_message_type_t type = COAP_TYPE_NON;
+  if (cb->qos == HIGH_QOS) {
+    type = COAP_TYPE_CON;
+  }
+
+  coap_transaction_t *transaction =
+    coap_new_transaction(cb->mid, cb->token, cb->token_len, &cb->endpoint);
+  if (transaction == NULL) {
+    return false;
+  }
+
+  oc_rep_new_v1(transaction->message->data + COAP_MAX_HEADER_SIZE,
+                OC_BLOCK_SIZE);
+
+#ifdef OC_BLOCK_WISE
+  if ((cb->method == OC_PUT || cb->method == OC_POST) &&
+      !prepare_coap_request_buffer(cb)) {
+    OC_ERR("global request_buffer is NULL");
+    coap_clear_transaction(transaction);
+    return false;
   }
 #endif /* OC_BLOCK_WISE */
 
@@ -585,6 +644,94 @@ oc_do_post_with_timeout(uint16_t timeout_seconds)
   return oc_do_async_request_with_timeout(timeout_seconds, OC_POST);
 }
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+static bool
+do_stream_request(oc_method_t method, const char *uri,
+                  const oc_endpoint_t *endpoint, const char *query,
+                  oc_blockwise_stream_handler_t stream,
+                  oc_response_handler_t handler, oc_qos_t qos,
+                  void *user_data)
+{
+#ifdef OC_TCP
+  if ((endpoint->flags & TCP) != 0) {
+    OC_ERR("streamed requests are not supported over TCP");
+    return false;
+  }
+#endif /* OC_TCP */
+  oc_client_handler_t client_handler = {
+    .response = handler,
+    .discovery = NULL,
+    .discovery_all = NULL,
+  };
+
+  oc_client_cb_t *cb = oc_ri_alloc_client_cb(uri, endpoint, method, query,
+                                             client_handler, qos, user_data);
+  if (cb == NULL) {
+    return false;
+  }
+
+  if (oc_blockwise_stream_add(cb, stream) == NULL ||
+      !prepare_coap_request(cb, NULL, NULL)) {
+    oc_client_cb_free(cb);
+    return false;
+  }
+  return dispatch_coap_request();
+}
+
+bool
+oc_do_get_stream(const char *uri, const oc_endpoint_t *endpoint,
+                 const char *query, oc_blockwise_stream_write_fn_t write,
+                 oc_response_handler_t handler, oc_qos_t qos, void *user_data)
+{
+  assert(write != NULL);
+  oc_blockwise_stream_handler_t stream = {
+    .read = NULL,
+    .write = write,
+    .content_format = APPLICATION_NOT_DEFINED,
+    .user_data = user_data,
+  };
+  return do_stream_request(OC_GET, uri, endpoint, query, stream, handler, qos,
+                           user_data);
+}
+
+bool
+oc_do_post_stream(const char *uri, const oc_endpoint_t *endpoint,
+                  const char *query, oc_blockwise_stream_read_fn_t read,
+                  oc_content_format_t content_format,
+                  oc_response_handler_t handler, void *user_data)
+{
+  assert(read != NULL);
+  oc_blockwise_stream_handler_t stream = {
+    .read = read,
+    .write = NULL,
+    .content_format = content_format,
+    .user_data = user_data,
+  };
+  // the blocks of the payload are sent as confirmable messages
+  return do_stream_request(OC_POST, uri, endpoint, query, stream, handler,
+                           HIGH_QOS, user_data);
+}
+
+bool
+oc_do_put_stream(const char *uri, const oc_endpoint_t *endpoint,
+                 const char *query, oc_blockwise_stream_read_fn_t read,
+                 oc_content_format_t content_format,
+                 oc_response_handler_t handler, void *user_data)
+{
+  assert(read != NULL);
+  oc_blockwise_stream_handler_t stream = {
+    .read = read,
+    .write = NULL,
+    .content_format = content_format,
+    .user_data = user_data,
+  };
+  return do_stream_request(OC_PUT, uri, endpoint, query, stream, handler,
+                           HIGH_QOS, user_data);
+}
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 bool
 oc_do_observe(const char *uri, const oc_endpoint_t *endpoint, const char *query,
               oc_response_handler_t handler, oc_qos_t qos, void *user_data)
@@ -623,7 +770,7 @@ oc_stop_observe(const char *uri, const oc_endpoint_t *endpoint)
     OC_ERR("cannot stop observation: no client callback found");
     return false;
   }
-  cb->mid = coap_get_mid();
+  oc_client_cb_set_mid(cb, coap_get_mid());
   cb->observe_seq = OC_COAP_OPTION_OBSERVE_UNREGISTER;
 
   if (!prepare_coap_request(cb, NULL, NULL)) {
@@ -720,8 +867,8 @@ multi_scope_ipv6_multicast(const oc_client_cb_t *cb4, uint8_t scope,
     return false;
   }
   if (cb4 != NULL) {
-    cb->mid = cb4->mid;
-    memcpy(cb->token, cb4->token, cb4->token_len);
+    oc_client_cb_set_mid(cb, cb4->mid);
+    oc_client_cb_set_token(cb, cb4->token, cb4->token_len);
   }
 
   if (!prepare_coap_request(cb, NULL, NULL)) {
@@ -778,8 +925,8 @@ dispatch_ip_discovery(const oc_client_cb_t *cb4, const char *query,
     return false;
   }
   if (cb4 != NULL) {
-    cb->mid = cb4->mid;
-    memcpy(cb->token, cb4->token, cb4->token_len);
+    oc_client_cb_set_mid(cb, cb4->mid);
+    oc_client_cb_set_token(cb, cb4->token, cb4->token_len);
   }
 
   if (!prepare_coap_request(cb, NULL, NULL)) {
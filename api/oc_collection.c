@@ -46,6 +46,10 @@
 #include "api/oc_etag_internal.h"
 #endif /* OC_HAS_FEATURE_ETAG */
 
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+#include "api/oc_ri_resource_index_internal.h"
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
+
 #include <assert.h>
 
 OC_MEMB(g_collections_s, oc_collection_t, OC_MAX_NUM_COLLECTIONS);
@@ -118,6 +122,9 @@ static void
 collection_free(oc_collection_t *collection, bool notify)
 {
   bool removed = oc_list_remove2(g_collections, collection) != NULL;
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  oc_ri_resource_index_remove(&collection->res);
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 
   oc_link_t *link;
   while ((link = (oc_link_t *)oc_list_pop(collection->links)) != NULL) {
@@ -256,6 +263,10 @@ oc_get_collection_by_uri(const char *uri_path, size_t uri_path_len,
                          size_t device)
 {
   assert(uri_path != NULL);
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  return (oc_collection_t *)oc_ri_resource_index_find(
+    uri_path, uri_path_len, device, OC_RI_RESOURCE_INDEX_KIND_COLLECTION);
+#else  /* !OC_HAS_FEATURE_RESOURCE_INDEX */
   while (uri_path[0] == '/') {
     uri_path++;
     uri_path_len--;
@@ -270,6 +281,7 @@ oc_get_collection_by_uri(const char *uri_path, size_t uri_path_len,
     collection = collection->next;
   }
   return (oc_collection_t *)collection;
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 }
 
 oc_link_t *
@@ -330,7 +342,14 @@ oc_collection_add(oc_collection_t *collection)
                           oc_string_len(collection->res.uri))) {
     return false;
   }
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  if (!oc_ri_resource_index_add(&collection->res,
+                                OC_RI_RESOURCE_INDEX_KIND_COLLECTION)) {
+    return false;
+  }
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
   oc_list_add(g_collections, collection);
+  oc_discovery_cache_invalidate();
   return true;
 }
 
@@ -18,6 +18,7 @@
 
 #include "api/oc_con_resource_internal.h"
 #include "api/oc_core_res_internal.h"
+#include "api/oc_discovery_internal.h"
 #include "api/oc_rep_internal.h"
 #include "api/oc_server_api_internal.h"
 #include "oc_api.h"
@@ -41,6 +42,7 @@ void
 oc_set_con_res_announced(bool announce)
 {
   g_announce_con_res = announce;
+  oc_discovery_cache_invalidate();
 }
 
 static void
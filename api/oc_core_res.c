@@ -256,6 +256,7 @@ void
 oc_core_set_latency(int latency)
 {
   g_res_latency = latency;
+  oc_discovery_cache_invalidate();
 }
 
 int
@@ -433,6 +434,7 @@ oc_device_bind_rt(size_t device_index, const char *rt)
                              oc_string_array_get_item(types, (i - 1)));
   }
   oc_free_string_array(&types);
+  oc_discovery_cache_invalidate();
 }
 
 void
@@ -545,6 +547,7 @@ oc_core_populate_resource(int core_resource, size_t device_index,
 #ifdef OC_HAS_FEATURE_ETAG
   r->etag = oc_etag_get();
 #endif /* OC_HAS_FEATURE_ETAG */
+  oc_discovery_cache_invalidate();
 }
 
 oc_uuid_t *
@@ -59,6 +59,15 @@
 #include "api/oc_etag_internal.h"
 #endif /* OC_HAS_FEATURE_ETAG */
 
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+#include "util/oc_hash_internal.h"
+#include "util/oc_list.h"
+#include "util/oc_memb.h"
+
+#include <stdlib.h>
+#include <string.h>
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
+
 #ifdef _WIN32
 #include <windows.h>
 #else /* !_WIN32 */
@@ -1126,6 +1135,228 @@ discovery_encode(const oc_request_t *request, oc_interface_mask_t iface)
   return -1;
 }
 
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+
+/* Properties of a request and of the device that select the encoded response,
+ * two requests with equal keys get the same payload */
+typedef struct discovery_cache_key_t
+{
+  size_t device;
+  oc_interface_mask_t iface;
+  oc_content_format_t accept;
+  bool has_origin;
+  transport_flags origin_flags;    ///< IP family of the origin
+  unsigned origin_interface_index; ///< interface of the origin
+  uint32_t endpoints_hash;         ///< fingerprint of the device endpoints
+#ifdef OC_SECURITY
+  oc_dostype_t dos;      ///< device onboarding state
+  bool has_peers;        ///< (D)TLS peers are connected to the device
+#endif                   /* OC_SECURITY */
+  oc_uuid_t di;          ///< anchor of the links
+#ifdef OC_HAS_FEATURE_ETAG
+  uint64_t etag;         ///< ETag of the discovery resource
+#endif                   /* OC_HAS_FEATURE_ETAG */
+  const char *query;
+  size_t query_len;
+} discovery_cache_key_t;
+
+/* Encoded response to a discovery request */
+typedef struct discovery_cache_entry_t
+{
+  struct discovery_cache_entry_t *next;
+  uint32_t generation; ///< cache generation when the entry was stored
+  discovery_cache_key_t key;
+  int code;
+  uint8_t *data; ///< the query followed by the payload
+  size_t payload_size;
+} discovery_cache_entry_t;
+
+/* Entries ordered from the most recently used, the least recently used entry
+ * is replaced when the cache is full. Entries of an older generation are
+ * invalid. */
+OC_LIST(g_discovery_cache);
+OC_MEMB(g_discovery_cache_s, discovery_cache_entry_t, OC_DISCOVERY_CACHE_SIZE);
+static uint32_t g_discovery_cache_generation = 1;
+
+static uint32_t
+discovery_cache_endpoints_hash(size_t device)
+{
+  uint32_t hash = OC_HASH_FNV1A_INIT;
+  for (const oc_endpoint_t *ep = oc_connectivity_get_endpoints(device);
+       ep != NULL; ep = ep->next) {
+    hash = oc_hash_fnv1a_uint(hash, oc_endpoint_hash(ep));
+    hash = oc_hash_fnv1a_uint(hash, ep->interface_index);
+  }
+  return hash;
+}
+
+static bool
+discovery_cache_key_init(discovery_cache_key_t *key,
+                         const oc_request_t *request, oc_interface_mask_t iface)
+{
+  if (iface != OC_IF_LL && iface != OC_IF_BASELINE
+#ifdef OC_HAS_FEATURE_ETAG_INTERFACE
+      && iface != PLGD_IF_ETAG
+#endif /* OC_HAS_FEATURE_ETAG_INTERFACE */
+  ) {
+    return false;
+  }
+  // payloads of other encoders (e.g. the checksum of the payload) are not
+  // responses
+  if (oc_rep_encoder_get_type() != OC_REP_CBOR_ENCODER) {
+    return false;
+  }
+  memset(key, 0, sizeof(*key));
+  size_t device = request->resource->device;
+  key->device = device;
+  key->iface = iface;
+  key->accept = request->accept;
+  if (request->origin != NULL) {
+    key->has_origin = true;
+    key->origin_flags = request->origin->flags & (IPV4 | IPV6);
+    key->origin_interface_index = request->origin->interface_index;
+  }
+  key->endpoints_hash = discovery_cache_endpoints_hash(device);
+#ifdef OC_SECURITY
+  key->dos = oc_sec_get_pstat(device)->s;
+  key->has_peers = oc_tls_num_peers(device) != 0;
+#endif /* OC_SECURITY */
+  memcpy(&key->di, oc_core_get_device_id(device), sizeof(key->di));
+#ifdef OC_HAS_FEATURE_ETAG
+  key->etag = oc_resource_get_etag(request->resource);
+#endif /* OC_HAS_FEATURE_ETAG */
+  key->query = request->query;
+  key->query_len = request->query_len;
+  return true;
+}
+
+static bool
+discovery_cache_key_is_equal(const discovery_cache_key_t *key1,
+                             const discovery_cache_key_t *key2)
+{
+  return key1->device == key2->device && key1->iface == key2->iface &&
+         key1->accept == key2->accept &&
+         key1->has_origin == key2->has_origin &&
+         key1->origin_flags == key2->origin_flags &&
+         key1->origin_interface_index == key2->origin_interface_index &&
+         key1->endpoints_hash == key2->endpoints_hash &&
+#ifdef OC_SECURITY
+         key1->dos == key2->dos && key1->has_peers == key2->has_peers &&
+#endif /* OC_SECURITY */
+#ifdef OC_HAS_FEATURE_ETAG
+         key1->etag == key2->etag &&
+#endif /* OC_HAS_FEATURE_ETAG */
+         memcmp(key1->di.id, key2->di.id, sizeof(key1->di.id)) == 0 &&
+         key1->query_len == key2->query_len &&
+         (key1->query_len == 0 ||
+          memcmp(key1->query, key2->query, key1->query_len) == 0);
+}
+
+static void
+discovery_cache_entry_free(discovery_cache_entry_t *entry)
+{
+  oc_list_remove(g_discovery_cache, entry);
+  free(entry->data);
+  oc_memb_free(&g_discovery_cache_s, entry);
+}
+
+static discovery_cache_entry_t *
+discovery_cache_find(const discovery_cache_key_t *key)
+{
+  discovery_cache_entry_t *entry =
+    (discovery_cache_entry_t *)oc_list_head(g_discovery_cache);
+  while (entry != NULL) {
+    discovery_cache_entry_t *next = entry->next;
+    if (entry->generation != g_discovery_cache_generation) {
+      discovery_cache_entry_free(entry);
+    } else if (discovery_cache_key_is_equal(&entry->key, key)) {
+      // move to the front, so the least recently used entry is the last one
+      oc_list_remove(g_discovery_cache, entry);
+      oc_list_push(g_discovery_cache, entry);
+      return entry;
+    }
+    entry = next;
+  }
+  return NULL;
+}
+
+static void
+discovery_cache_store(const discovery_cache_key_t *key, int code,
+                      const uint8_t *payload, size_t payload_size)
+{
+  if (oc_list_length(g_discovery_cache) >= OC_DISCOVERY_CACHE_SIZE) {
+    discovery_cache_entry_t *last =
+      (discovery_cache_entry_t *)oc_list_tail(g_discovery_cache);
+    discovery_cache_entry_free(last);
+  }
+  uint8_t *data = (uint8_t *)malloc(key->query_len + payload_size + 1);
+  if (data == NULL) {
+    OC_WRN("oc_discovery: cannot allocate cached response");
+    return;
+  }
+  discovery_cache_entry_t *entry =
+    (discovery_cache_entry_t *)oc_memb_alloc(&g_discovery_cache_s);
+  if (entry == NULL) {
+    OC_WRN("oc_discovery: cannot allocate cache entry");
+    free(data);
+    return;
+  }
+  if (key->query_len > 0) {
+    memcpy(data, key->query, key->query_len);
+  }
+  if (payload_size > 0) {
+    memcpy(data + key->query_len, payload, payload_size);
+  }
+  entry->generation = g_discovery_cache_generation;
+  memcpy(&entry->key, key, sizeof(*key));
+  entry->key.query = (const char *)data;
+  entry->code = code;
+  entry->data = data;
+  entry->payload_size = payload_size;
+  oc_list_push(g_discovery_cache, entry);
+}
+
+void
+oc_discovery_cache_free_all(void)
+{
+  discovery_cache_entry_t *entry =
+    (discovery_cache_entry_t *)oc_list_head(g_discovery_cache);
+  while (entry != NULL) {
+    discovery_cache_entry_t *next = entry->next;
+    discovery_cache_entry_free(entry);
+    entry = next;
+  }
+}
+
+size_t
+oc_discovery_cache_size(void)
+{
+  size_t count = 0;
+  for (const discovery_cache_entry_t *entry =
+         (discovery_cache_entry_t *)oc_list_head(g_discovery_cache);
+       entry != NULL; entry = entry->next) {
+    if (entry->generation == g_discovery_cache_generation) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
+
+void
+oc_discovery_cache_invalidate(void)
+{
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+  ++g_discovery_cache_generation;
+  if (g_discovery_cache_generation == 0) {
+    // wrapped around, drop the entries so no old entry becomes valid
+    oc_discovery_cache_free_all();
+    g_discovery_cache_generation = 1;
+  }
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
+}
+
 static void
 discovery_resource_get(oc_request_t *request, oc_interface_mask_t iface,
                        void *data)
@@ -1149,11 +1380,30 @@ discovery_resource_get(oc_request_t *request, oc_interface_mask_t iface,
   }
 #endif /* OC_SECURITY */
 
-  int code = discovery_encode(request, iface);
-  if (code < 0) {
-    code = OC_IGNORE;
+  int code;
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+  discovery_cache_key_t key;
+  bool cacheable = discovery_cache_key_init(&key, request, iface);
+  const discovery_cache_entry_t *entry =
+    cacheable ? discovery_cache_find(&key) : NULL;
+  if (entry != NULL) {
+    oc_rep_encode_raw(entry->data + entry->key.query_len, entry->payload_size);
+    code = entry->code;
+  } else
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
+  {
+    code = discovery_encode(request, iface);
+    if (code < 0) {
+      code = OC_IGNORE;
+    }
   }
   int response_length = oc_rep_get_encoded_payload_size();
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+  if (entry == NULL && cacheable && response_length >= 0) {
+    discovery_cache_store(&key, code, oc_rep_get_encoder_buf(),
+                          (size_t)response_length);
+  }
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
   bool has_data = (code == OC_STATUS_OK);
   send_response(request, APPLICATION_VND_OCF_CBOR, !has_data, code,
                 response_length < 0 ? 0 : (size_t)response_length);
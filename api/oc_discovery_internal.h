@@ -96,6 +96,32 @@ bool oc_filter_out_ep_for_resource(const oc_endpoint_t *ep,
                                    const oc_endpoint_t *request_origin,
                                    size_t device_index, bool owned_for_SVRs);
 
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+#ifndef OC_DISCOVERY_CACHE_SIZE
+/** Maximal number of cached discovery responses */
+#define OC_DISCOVERY_CACHE_SIZE (8)
+#endif /* !OC_DISCOVERY_CACHE_SIZE */
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
+
+/**
+ * @brief Drop all cached discovery responses.
+ *
+ * Called when a resource is added or removed and when a property listed in
+ * the discovery response changes. Does nothing if the discovery cache is
+ * disabled.
+ */
+void oc_discovery_cache_invalidate(void);
+
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+
+/** @brief Free all cached discovery responses */
+void oc_discovery_cache_free_all(void);
+
+/** @brief Number of cached discovery responses */
+size_t oc_discovery_cache_size(void);
+
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
+
 #ifdef OC_RES_BATCH_SUPPORT
 
 /**
@@ -24,6 +24,7 @@
 #include "port/oc_connectivity.h"
 #include "port/oc_ip_internal.h"
 #include "port/oc_log_internal.h"
+#include "util/oc_hash_internal.h"
 #include "util/oc_macros_internal.h"
 #include "util/oc_memb.h"
 
@@ -707,6 +708,28 @@ oc_endpoint_compare(const oc_endpoint_t *ep1, const oc_endpoint_t *ep2)
   return -1;
 }
 
+uint32_t
+oc_endpoint_hash(const oc_endpoint_t *endpoint)
+{
+  // hash only the fields checked by oc_endpoint_compare
+  uint32_t hash = oc_hash_fnv1a_uint(
+    OC_HASH_FNV1A_INIT, (uint64_t)(endpoint->flags & ~(MULTICAST | ACCEPTED)));
+  hash = oc_hash_fnv1a_uint(hash, (uint64_t)endpoint->device);
+  if (endpoint->flags & IPV6) {
+    hash = oc_hash_fnv1a(hash, endpoint->addr.ipv6.address,
+                         sizeof(endpoint->addr.ipv6.address));
+    return oc_hash_fnv1a_uint(hash, endpoint->addr.ipv6.port);
+  }
+#ifdef OC_IPV4
+  if (endpoint->flags & IPV4) {
+    hash = oc_hash_fnv1a(hash, endpoint->addr.ipv4.address,
+                         sizeof(endpoint->addr.ipv4.address));
+    return oc_hash_fnv1a_uint(hash, endpoint->addr.ipv4.port);
+  }
+#endif /* OC_IPV4 */
+  return hash;
+}
+
 bool
 oc_endpoint_is_empty(const oc_endpoint_t *endpoint)
 {
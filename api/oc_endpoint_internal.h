@@ -103,6 +103,16 @@ bool oc_endpoint_is_multicast(const oc_endpoint_t *endpoint);
  */
 bool oc_endpoint_is_unicast(const oc_endpoint_t *endpoint);
 
+/**
+ * @brief Calculate hash of the endpoint.
+ *
+ * Endpoints equal by oc_endpoint_compare have equal hashes.
+ *
+ * @param endpoint the endpoint (cannot be NULL)
+ * @return hash of the endpoint
+ */
+uint32_t oc_endpoint_hash(const oc_endpoint_t *endpoint) OC_NONNULL();
+
 typedef struct oc_string64_s
 {
   size_t size;
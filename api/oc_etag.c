@@ -48,6 +48,10 @@
 #include "api/oc_storage_internal.h"
 #include "util/oc_crc_internal.h"
 
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+#include "api/oc_main_internal.h"
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+
 #ifdef OC_COLLECTIONS
 #include "api/oc_collection_internal.h"
 #endif /* OC_COLLECTIONS */
@@ -228,6 +232,16 @@ oc_etag_dump_ignore_resource(const char *uri, size_t uri_len)
   return false;
 }
 
+static oc_resource_crc64_status_t
+etag_resource_crc64(oc_resource_t *resource, uint64_t *crc64)
+{
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+  return oc_resource_get_cached_crc64(resource, crc64);
+#else  /* !OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+  return oc_resource_get_crc64(resource, crc64);
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+}
+
 oc_resource_encode_status_t
 oc_etag_encode_resource_etag(CborEncoder *encoder, oc_resource_t *resource)
 {
@@ -239,7 +253,7 @@ oc_etag_encode_resource_etag(CborEncoder *encoder, oc_resource_t *resource)
   }
 
   uint64_t crc64 = 0;
-  if (oc_resource_get_crc64(resource, &crc64) != OC_RESOURCE_CRC64_OK) {
+  if (etag_resource_crc64(resource, &crc64) != OC_RESOURCE_CRC64_OK) {
     OC_DBG("cannot calculate crc64 for device(%zu) resource(%s)",
            resource->device, uri.data);
     return OC_RESOURCE_ENCODE_SKIPPED;
@@ -279,6 +293,14 @@ etag_iterate_encode_resource(oc_resource_t *resource, void *data)
          OC_RESOURCE_ENCODE_ERROR;
 }
 
+static void
+etag_store_iterate(size_t device, bool platform_only,
+                   oc_resource_iterate_fn_t fn, void *data)
+{
+  oc_resources_iterate(device, platform_only, !platform_only, !platform_only,
+                       !platform_only, fn, data);
+}
+
 typedef struct etag_encode_data_t
 {
   bool platform_only;
@@ -287,44 +309,152 @@ typedef struct etag_encode_data_t
 static int
 etag_store_encode(size_t device, void *data)
 {
-  etag_encode_data_t *encode_data = (etag_encode_data_t *)data;
+  const etag_encode_data_t *encode_data = (etag_encode_data_t *)data;
   oc_rep_start_root_object();
-  oc_resources_iterate(device, encode_data->platform_only,
-                       !encode_data->platform_only, !encode_data->platform_only,
-                       !encode_data->platform_only,
-                       etag_iterate_encode_resource, NULL);
+  etag_store_iterate(device, encode_data->platform_only,
+                     etag_iterate_encode_resource, NULL);
   oc_rep_end_root_object();
   return oc_rep_get_cbor_errno();
 }
 
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+
 static bool
-etag_dump_platform_resources(void)
+etag_iterate_clear_store_pending(oc_resource_t *resource, void *data)
 {
-  etag_encode_data_t encode_data = { true };
-  long ret = oc_storage_data_save(OC_ETAG_PLATFORM_STORE_NAME, 0,
-                                  etag_store_encode, &encode_data);
+  (void)data;
+  resource->etag_flags &= (uint8_t)~OC_ETAG_FLAG_STORE_PENDING;
+  return true;
+}
+
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+
+static bool
+etag_dump_store(const char *name, size_t device, bool platform_only)
+{
+  etag_encode_data_t encode_data = { platform_only };
+  // the stores are dumped also from the event loop, where the global encoder
+  // keeps the type of the last response
+  oc_rep_encoder_type_t prev_type = oc_rep_encoder_get_type();
+  oc_rep_encoder_set_type(OC_REP_CBOR_ENCODER);
+  long ret =
+    oc_storage_data_save(name, device, etag_store_encode, &encode_data);
+  oc_rep_encoder_set_type(prev_type);
   if (ret <= 0) {
+    return false;
+  }
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+  etag_store_iterate(device, platform_only, etag_iterate_clear_store_pending,
+                     NULL);
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+  return true;
+}
+
+static bool
+etag_dump_platform_resources(void)
+{
+  if (!etag_dump_store(OC_ETAG_PLATFORM_STORE_NAME, 0, true)) {
     OC_ERR("failed to dump etag for platform resources");
     return false;
   }
   return true;
 }
 
+static bool
+etag_dump_device_resources(size_t device)
+{
+  if (!etag_dump_store(OC_ETAG_STORE_NAME, device, false)) {
+    OC_ERR("failed to dump etag for device %zu", device);
+    return false;
+  }
+  return true;
+}
+
 bool
 oc_etag_dump(void)
 {
   bool success = etag_dump_platform_resources();
   for (size_t i = 0; i < oc_core_get_num_devices(); ++i) {
-    etag_encode_data_t encode_data = { false };
-    if (oc_storage_data_save(OC_ETAG_STORE_NAME, i, etag_store_encode,
-                             &encode_data) <= 0) {
-      OC_ERR("failed to dump etag for device %zu", i);
-      success = false;
+    success = etag_dump_device_resources(i) && success;
+  }
+  return success;
+}
+
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+
+static bool
+etag_iterate_find_store_pending(oc_resource_t *resource, void *data)
+{
+  if ((resource->etag_flags & OC_ETAG_FLAG_STORE_PENDING) != 0) {
+    *(bool *)data = true;
+    return false;
+  }
+  return true;
+}
+
+static bool
+etag_store_is_pending(size_t device, bool platform_only)
+{
+  bool pending = false;
+  etag_store_iterate(device, platform_only, etag_iterate_find_store_pending,
+                     &pending);
+  return pending;
+}
+
+bool
+oc_etag_dump_dirty(void)
+{
+  bool success = true;
+  if (etag_store_is_pending(0, true)) {
+    success = etag_dump_platform_resources();
+  }
+  for (size_t i = 0; i < oc_core_get_num_devices(); ++i) {
+    if (etag_store_is_pending(i, false)) {
+      success = etag_dump_device_resources(i) && success;
     }
   }
   return success;
 }
 
+static oc_event_callback_retval_t
+etag_dump_dirty_async(void *data)
+{
+  (void)data;
+  oc_etag_dump_dirty();
+  return OC_EVENT_DONE;
+}
+
+void
+oc_resource_etag_set_dirty(oc_resource_t *resource)
+{
+  assert(resource != NULL);
+  resource->etag_flags = (uint8_t)((resource->etag_flags &
+                                    ~OC_ETAG_FLAG_CRC64_CACHED) |
+                                   OC_ETAG_FLAG_STORE_PENDING);
+  if (!oc_main_initialized()) {
+    // written by the next dump
+    return;
+  }
+  // all changes of the poll cycle are written by a single dump
+  if (!oc_ri_has_timed_event_callback(NULL, etag_dump_dirty_async, false)) {
+    oc_ri_add_timed_event_callback_ticks(NULL, etag_dump_dirty_async, 0);
+  }
+}
+
+oc_resource_crc64_status_t
+oc_resource_get_cached_crc64(oc_resource_t *resource, uint64_t *crc64)
+{
+  assert(resource != NULL);
+  assert(crc64 != NULL);
+  if ((resource->etag_flags & OC_ETAG_FLAG_CRC64_CACHED) != 0) {
+    *crc64 = resource->crc64;
+    return OC_RESOURCE_CRC64_OK;
+  }
+  return oc_resource_get_crc64(resource, crc64);
+}
+
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+
 bool
 oc_etag_decode_resource_etag(oc_resource_t *resource, const oc_rep_t *rep,
                              uint64_t *etag)
@@ -344,6 +474,8 @@ oc_etag_decode_resource_etag(oc_resource_t *resource, const oc_rep_t *rep,
     return false;
   }
 
+  // the payload might have changed without a report, the checksum of the
+  // current payload is calculated
   uint64_t crc64 = 0;
   if (oc_resource_get_crc64(resource, &crc64) != OC_RESOURCE_CRC64_OK) {
     OC_DBG("cannot calculate crc64 for resource %zu:%s", resource->device,
@@ -365,16 +497,46 @@ oc_etag_decode_resource_etag(oc_resource_t *resource, const oc_rep_t *rep,
 typedef struct etag_update_from_rep_data_t
 {
   const oc_rep_t *rep;
+  const oc_rep_t *next; ///< representation following the last found one
   uint64_t *etag;
   bool update_device_resources;
 } etag_update_from_rep_data_t;
 
+static bool
+etag_rep_is_resource(const oc_rep_t *rep, oc_string_view_t uri)
+{
+  return rep->type == OC_REP_OBJECT && oc_string_len(rep->name) == uri.length &&
+         memcmp(oc_string(rep->name), uri.data, uri.length) == 0;
+}
+
+static const oc_rep_t *
+etag_find_resource_rep(etag_update_from_rep_data_t *rep_data,
+                       const oc_resource_t *resource)
+{
+  oc_string_view_t uri = oc_string_view2(&resource->uri);
+  // the store is written in the order of iteration, so the representation of
+  // the resource usually follows the representation of the previous one
+  const oc_rep_t *rep = rep_data->next;
+  if (rep == NULL || !etag_rep_is_resource(rep, uri)) {
+    for (rep = rep_data->rep; rep != NULL; rep = rep->next) {
+      if (etag_rep_is_resource(rep, uri)) {
+        break;
+      }
+    }
+  }
+  if (rep == NULL) {
+    return NULL;
+  }
+  rep_data->next = rep->next;
+  return rep->value.object;
+}
+
 static bool
 etag_iterate_update_resources_by_rep(oc_resource_t *resource, void *data)
 {
   etag_update_from_rep_data_t *rep_data = (etag_update_from_rep_data_t *)data;
-  oc_rep_t *res_rep;
-  if (!oc_rep_get_object(rep_data->rep, oc_string(resource->uri), &res_rep)) {
+  const oc_rep_t *res_rep = etag_find_resource_rep(rep_data, resource);
+  if (res_rep == NULL) {
     OC_DBG("no representation for resource %zu:%s", resource->device,
            oc_string(resource->uri));
     return true;
@@ -418,12 +580,10 @@ etag_store_decode_etags(const oc_rep_t *rep, size_t device, void *data)
   // rep
   etag_decode_data_t *decode_data = (etag_decode_data_t *)data;
   etag_update_from_rep_data_t rep_data = {
-    rep, decode_data->etag, decode_data->update_device_resources
+    rep, rep, decode_data->etag, decode_data->update_device_resources
   };
-  oc_resources_iterate(device, decode_data->platform_only,
-                       !decode_data->platform_only, !decode_data->platform_only,
-                       !decode_data->platform_only,
-                       etag_iterate_update_resources_by_rep, &rep_data);
+  etag_store_iterate(device, decode_data->platform_only,
+                     etag_iterate_update_resources_by_rep, &rep_data);
   return 0;
 }
 
@@ -649,6 +809,7 @@ oc_resource_get_crc64(oc_resource_t *resource, uint64_t *crc64)
   response_buffer.buffer_size = OC_ARRAY_SIZE(buffer);
   if (!resource_get_payload_by_encoder(OC_REP_CRC_ENCODER, resource, iface,
                                        &response_buffer, 0)) {
+    oc_rep_global_encoder_reset(&prevEncoder);
     return OC_RESOURCE_CRC64_ERROR;
   }
 
@@ -668,6 +829,10 @@ oc_resource_get_crc64(oc_resource_t *resource, uint64_t *crc64)
     return -1;
   }
   memcpy(crc64, buffer, sizeof(*crc64));
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+  resource->crc64 = *crc64;
+  resource->etag_flags |= OC_ETAG_FLAG_CRC64_CACHED;
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
 
   oc_rep_global_encoder_reset(&prevEncoder);
   return OC_RESOURCE_CRC64_OK;
@@ -718,6 +883,9 @@ void
 oc_resource_update_etag(oc_resource_t *resource)
 {
   oc_resource_set_etag(resource, oc_etag_get());
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+  oc_resource_etag_set_dirty(resource);
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
 }
 
 #endif /* OC_HAS_FEATURE_ETAG */
@@ -165,6 +165,45 @@ oc_resource_encode_status_t oc_etag_encode_resource_etag(
 bool oc_etag_decode_resource_etag(oc_resource_t *resource, const oc_rep_t *rep,
                                   uint64_t *etag) OC_NONNULL();
 
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+
+enum {
+  /// resource->crc64 is the checksum of the current payload
+  OC_ETAG_FLAG_CRC64_CACHED = 1 << 0,
+  /// the ETag changed after the store of the resource was written
+  OC_ETAG_FLAG_STORE_PENDING = 1 << 1,
+};
+
+/**
+ * @brief Mark the payload of the resource as changed.
+ *
+ * The cached checksum is dropped and the store of the resource is written at
+ * the end of the poll cycle, together with the stores of all other resources
+ * changed in the cycle.
+ *
+ * @param resource the changed resource (cannot be NULL)
+ */
+void oc_resource_etag_set_dirty(oc_resource_t *resource) OC_NONNULL();
+
+/**
+ * @brief Get the checksum of the payload of the resource, the checksum is
+ * calculated only if it is not cached.
+ *
+ * @see oc_resource_get_crc64
+ */
+oc_resource_crc64_status_t oc_resource_get_cached_crc64(
+  oc_resource_t *resource, uint64_t *crc64) OC_NONNULL();
+
+/**
+ * @brief Write the stores which contain a resource marked as changed.
+ *
+ * @return true all such stores were written
+ * @return false otherwise
+ */
+bool oc_etag_dump_dirty(void);
+
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+
 #endif /* OC_STORAGE */
 
 #ifdef OC_SECURITY
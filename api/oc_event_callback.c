@@ -26,6 +26,7 @@
 #include "util/oc_list.h"
 #include "util/oc_memb.h"
 #include "util/oc_process.h"
+#include "util/oc_timer_internal.h"
 
 #ifdef OC_SERVER
 #include "messaging/coap/observe_internal.h"
@@ -34,34 +35,83 @@
 #include <assert.h>
 #include <stdbool.h>
 
+static oc_event_callback_t *
+event_callback_from_node(const oc_heap_node_t *node)
+{
+  return OC_HEAP_ENTRY(node, oc_event_callback_t, node);
+}
+
+static bool
+event_callback_expires_before(const oc_heap_node_t *a, const oc_heap_node_t *b)
+{
+  return oc_timer_expiration_time(&event_callback_from_node(a)->timer) <
+         oc_timer_expiration_time(&event_callback_from_node(b)->timer);
+}
+
+/* Each queue of callbacks is kept in a list for lookups and in a heap ordered
+ * by the expiration time. A single event timer of the queue is armed to the
+ * first expiring callback. */
 OC_LIST(g_timed_callbacks);
+static oc_heap_t g_timed_callbacks_queue =
+  OC_HEAP_INIT(event_callback_expires_before);
+static struct oc_etimer g_timed_callbacks_timer;
+
 OC_MEMB(g_event_callbacks_s, oc_event_callback_t, OC_MAX_EVENT_CALLBACKS);
 static oc_event_callback_t *g_currently_processed_event_cb = NULL;
 static bool g_currently_processed_event_cb_delete = false;
 static oc_ri_timed_event_on_delete_t g_currently_processed_event_on_delete =
   NULL;
+/* Incremented by each poll of a queue, a callback is invoked at most once per
+ * poll even if it is rescheduled to the past */
+static uint32_t g_poll_generation = 0;
 
 OC_PROCESS(oc_timed_callback_events, "OC timed callbacks");
 
 #ifdef OC_SERVER
 OC_LIST(g_observe_callbacks);
+static oc_heap_t g_observe_callbacks_queue =
+  OC_HEAP_INIT(event_callback_expires_before);
+static struct oc_etimer g_observe_callbacks_timer;
 #endif /* OC_SERVER */
 
 void
 oc_event_callbacks_init(void)
 {
   oc_list_init(g_timed_callbacks);
+  g_timed_callbacks_queue.root = NULL;
 #ifdef OC_SERVER
   oc_list_init(g_observe_callbacks);
+  g_observe_callbacks_queue.root = NULL;
 #endif /* OC_SERVER */
 }
 
+/* Arm the event timer of the queue to the expiration of the first callback */
 static void
-event_callbacks_free_event_timers(oc_list_t timers)
+event_callbacks_schedule(const oc_heap_t *queue, struct oc_etimer *timer)
 {
+  const oc_heap_node_t *top = oc_heap_top(queue);
+  if (top == NULL) {
+    oc_etimer_stop(timer);
+    return;
+  }
+  const struct oc_timer *first = &event_callback_from_node(top)->timer;
+  if (!oc_etimer_expired(timer) &&
+      oc_etimer_expiration_time(timer) == oc_timer_expiration_time(first)) {
+    return;
+  }
+  OC_PROCESS_CONTEXT_BEGIN(&oc_timed_callback_events)
+  oc_etimer_set(timer, oc_timer_remaining(first));
+  OC_PROCESS_CONTEXT_END(&oc_timed_callback_events)
+}
+
+static void
+event_callbacks_free_event_timers(oc_list_t timers, oc_heap_t *queue,
+                                  struct oc_etimer *timer)
+{
+  oc_etimer_stop(timer);
+  queue->root = NULL;
   oc_event_callback_t *event_cb = (oc_event_callback_t *)oc_list_pop(timers);
   while (event_cb != NULL) {
-    oc_etimer_stop(&event_cb->timer);
     oc_memb_free(&g_event_callbacks_s, event_cb);
     event_cb = (oc_event_callback_t *)oc_list_pop(timers);
   }
@@ -71,9 +121,11 @@ void
 oc_event_callbacks_shutdown(void)
 {
 #ifdef OC_SERVER
-  event_callbacks_free_event_timers(g_observe_callbacks);
+  event_callbacks_free_event_timers(
+    g_observe_callbacks, &g_observe_callbacks_queue, &g_observe_callbacks_timer);
 #endif /* OC_SERVER */
-  event_callbacks_free_event_timers(g_timed_callbacks);
+  event_callbacks_free_event_timers(
+    g_timed_callbacks, &g_timed_callbacks_queue, &g_timed_callbacks_timer);
 }
 
 void
@@ -121,6 +173,7 @@ oc_ri_remove_timed_event_callback_by_filter(
   bool match_all, oc_ri_timed_event_on_delete_t on_delete)
 {
   bool want_to_delete_currently_processed_event_cb = false;
+  bool removed = false;
   oc_event_callback_t *event_cb =
     (oc_event_callback_t *)oc_list_head(g_timed_callbacks);
   while (event_cb != NULL) {
@@ -133,9 +186,7 @@ oc_ri_remove_timed_event_callback_by_filter(
     if (g_currently_processed_event_cb == event_cb) {
       want_to_delete_currently_processed_event_cb = true;
     } else {
-      OC_PROCESS_CONTEXT_BEGIN(&oc_timed_callback_events)
-      oc_etimer_stop(&event_cb->timer);
-      OC_PROCESS_CONTEXT_END(&oc_timed_callback_events)
+      oc_heap_remove(&g_timed_callbacks_queue, &event_cb->node);
       oc_list_remove(g_timed_callbacks, event_cb);
       if (on_delete != NULL) {
         on_delete(event_cb->data);
@@ -143,12 +194,17 @@ oc_ri_remove_timed_event_callback_by_filter(
       OC_DBG("oc_event_callback: timed callback(%p) removed", (void *)event_cb);
       oc_memb_free(&g_event_callbacks_s, event_cb);
       want_to_delete_currently_processed_event_cb = false;
+      removed = true;
     }
     if (!match_all) {
       break;
     }
     event_cb = next;
   }
+  if (removed) {
+    event_callbacks_schedule(&g_timed_callbacks_queue,
+                             &g_timed_callbacks_timer);
+  }
   if (want_to_delete_currently_processed_event_cb) {
     // We can't remove the currently processed delayed callback because when
     // the callback returns OC_EVENT_DONE, a double release occurs. So we
@@ -172,6 +228,19 @@ oc_ri_remove_timed_event_callback(const void *cb_data,
     event_callback, timed_event_is_identical_filter, cb_data, false, NULL);
 }
 
+static void
+event_callbacks_enqueue(oc_list_t list, oc_heap_t *queue,
+                        struct oc_etimer *timer, oc_event_callback_t *event_cb,
+                        oc_clock_time_t ticks)
+{
+  oc_timer_set(&event_cb->timer, ticks);
+  event_cb->generation = g_poll_generation;
+  oc_heap_insert(queue, &event_cb->node);
+  // recent callbacks are usually removed first, keep them at the head
+  oc_list_push(list, event_cb);
+  event_callbacks_schedule(queue, timer);
+}
+
 void
 oc_ri_add_timed_event_callback_ticks(void *cb_data, oc_trigger_t event_callback,
                                      oc_clock_time_t ticks)
@@ -186,22 +255,24 @@ oc_ri_add_timed_event_callback_ticks(void *cb_data, oc_trigger_t event_callback,
   OC_DBG("oc_event_callback: timed callback(%p) added", (void *)event_cb);
   event_cb->data = cb_data;
   event_cb->callback = event_callback;
-  OC_PROCESS_CONTEXT_BEGIN(&oc_timed_callback_events)
-  oc_etimer_set(&event_cb->timer, ticks);
-  OC_PROCESS_CONTEXT_END(&oc_timed_callback_events)
-  oc_list_add(g_timed_callbacks, event_cb);
+  event_callbacks_enqueue(g_timed_callbacks, &g_timed_callbacks_queue,
+                          &g_timed_callbacks_timer, event_cb, ticks);
 }
 
 static void
-event_callbacks_poll_timers(oc_list_t list, struct oc_memb *cb_pool)
+event_callbacks_poll_timers(oc_list_t list, oc_heap_t *queue,
+                            struct oc_etimer *timer, struct oc_memb *cb_pool)
 {
-  oc_event_callback_t *event_cb = (oc_event_callback_t *)oc_list_head(list);
-  while (event_cb != NULL) {
-    oc_event_callback_t *next = event_cb->next;
-    if (!oc_etimer_expired(&event_cb->timer)) {
-      event_cb = next;
-      continue;
+  uint32_t generation = ++g_poll_generation;
+  const oc_heap_node_t *top = oc_heap_top(queue);
+  while (top != NULL) {
+    oc_event_callback_t *event_cb = event_callback_from_node(top);
+    if (event_cb->generation == generation ||
+        !oc_timer_expired(&event_cb->timer)) {
+      break;
     }
+    // the callback may add or remove other callbacks of the queue
+    oc_heap_pop(queue);
     g_currently_processed_event_cb = event_cb;
     g_currently_processed_event_cb_delete = false;
     if ((event_cb->callback(event_cb->data) == OC_EVENT_DONE) ||
@@ -212,19 +283,20 @@ event_callbacks_poll_timers(oc_list_t list, struct oc_memb *cb_pool)
       }
       OC_DBG("oc_event_callback: callback(%p) done", (void *)event_cb);
       oc_memb_free(cb_pool, event_cb);
-      event_cb = (oc_event_callback_t *)oc_list_head(list);
-      continue;
+    } else {
+      oc_timer_restart(&event_cb->timer);
+      event_cb->generation = generation;
+      oc_heap_insert(queue, &event_cb->node);
     }
-    OC_PROCESS_CONTEXT_BEGIN(&oc_timed_callback_events)
-    oc_etimer_restart(&event_cb->timer);
-    OC_PROCESS_CONTEXT_END(&oc_timed_callback_events)
-    event_cb = (oc_event_callback_t *)oc_list_head(list);
-    continue;
+    g_currently_processed_event_cb = NULL;
+    g_currently_processed_event_on_delete = NULL;
+    top = oc_heap_top(queue);
   }
 
   g_currently_processed_event_cb = NULL;
   g_currently_processed_event_cb_delete = false;
   g_currently_processed_event_on_delete = NULL;
+  event_callbacks_schedule(queue, timer);
 }
 
 #ifdef OC_SERVER
@@ -261,11 +333,9 @@ oc_periodic_observe_callback_add(oc_resource_t *resource)
          (void *)event_cb, oc_string(resource->uri));
   event_cb->data = resource;
   event_cb->callback = periodic_observe_callback_handler;
-  OC_PROCESS_CONTEXT_BEGIN(&oc_timed_callback_events)
-  oc_etimer_set(&event_cb->timer,
-                resource->observe_period_seconds * OC_CLOCK_SECOND);
-  OC_PROCESS_CONTEXT_END(&oc_timed_callback_events)
-  oc_list_add(g_observe_callbacks, event_cb);
+  event_callbacks_enqueue(g_observe_callbacks, &g_observe_callbacks_queue,
+                          &g_observe_callbacks_timer, event_cb,
+                          resource->observe_period_seconds * OC_CLOCK_SECOND);
   return true;
 }
 
@@ -277,11 +347,13 @@ oc_periodic_observe_callback_remove(const oc_resource_t *resource)
   if (event_cb == NULL) {
     return false;
   }
-  oc_etimer_stop(&event_cb->timer);
+  oc_heap_remove(&g_observe_callbacks_queue, &event_cb->node);
   oc_list_remove(g_observe_callbacks, event_cb);
   OC_DBG("oc_event_callback: observe callback(%p) for resource(%s) removed",
          (void *)event_cb, oc_string(resource->uri));
   oc_memb_free(&g_event_callbacks_s, event_cb);
+  event_callbacks_schedule(&g_observe_callbacks_queue,
+                           &g_observe_callbacks_timer);
   return true;
 }
 
@@ -310,9 +382,11 @@ static void
 event_callbacks_check(void)
 {
 #ifdef OC_SERVER
-  event_callbacks_poll_timers(g_observe_callbacks, &g_event_callbacks_s);
+  event_callbacks_poll_timers(g_observe_callbacks, &g_observe_callbacks_queue,
+                              &g_observe_callbacks_timer, &g_event_callbacks_s);
 #endif /* OC_SERVER */
-  event_callbacks_poll_timers(g_timed_callbacks, &g_event_callbacks_s);
+  event_callbacks_poll_timers(g_timed_callbacks, &g_timed_callbacks_queue,
+                              &g_timed_callbacks_timer, &g_event_callbacks_s);
 }
 
 OC_PROCESS_THREAD(oc_timed_callback_events, ev, data)
@@ -25,7 +25,8 @@
 #include "oc_ri_internal.h"
 #include "util/oc_compiler.h"
 #include "util/oc_process.h"
-#include "util/oc_etimer_internal.h"
+#include "util/oc_heap_internal.h"
+#include "util/oc_timer_internal.h"
 
 #include <stdbool.h>
 
@@ -39,7 +40,9 @@ extern "C" {
 typedef struct oc_event_callback_s
 {
   struct oc_event_callback_s *next; ///< next callback
-  struct oc_etimer timer;           ///< timer
+  struct oc_timer timer;            ///< timer
+  oc_heap_node_t node;              ///< node in the expiration queue
+  uint32_t generation;              ///< last poll that invoked the callback
   oc_trigger_t callback;            ///< callback to be invoked
   void *data;                       ///< data for the callback
 } oc_event_callback_t;
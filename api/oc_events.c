@@ -51,6 +51,11 @@ oc_process_event_name(oc_process_event_t event)
   if (event == oc_event_to_oc_process_event(OUTBOUND_NETWORK_EVENT)) {
     return OC_STRING_VIEW("outbound-message");
   }
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  if (event == oc_event_to_oc_process_event(OUTBOUND_NETWORK_FLUSH)) {
+    return OC_STRING_VIEW("outbound-message-flush");
+  }
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
   if (event == oc_event_to_oc_process_event(UDP_TO_TLS_EVENT)) {
     return OC_STRING_VIEW("inbound-tls-message");
   }
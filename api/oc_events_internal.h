@@ -35,6 +35,9 @@ typedef enum {
   RI_TO_TLS_EVENT,
   INBOUND_RI_EVENT,
   OUTBOUND_NETWORK_EVENT,
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  OUTBOUND_NETWORK_FLUSH, /* send the batch of queued UDP messages */
+#endif                    /* OC_HAS_FEATURE_UDP_BATCH */
   TLS_READ_DECRYPTED_DATA,
 #ifdef OC_CLIENT
   TLS_WRITE_APPLICATION_DATA,
@@ -75,6 +75,10 @@
 #include "api/plgd/plgd_time_internal.h"
 #endif /* OC_HAS_FEATURE_PLGD_TIME */
 
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+#include "port/oc_storage_internal.h"
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -460,6 +464,13 @@ oc_main_shutdown(void)
 
   oc_shutdown_all_devices();
 
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+  // write the stores dumped before and during the shutdown
+  if (oc_storage_shutdown() != 0) {
+    OC_ERR("failed to write the storage");
+  }
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
   g_app_callbacks = NULL;
 
 #ifdef OC_MEMORY_TRACE
@@ -166,6 +166,21 @@ oc_message_allocate_with_size(size_t size)
   return message_allocate_with_size(&oc_incoming_buffers, size);
 }
 
+#ifndef OC_DYNAMIC_ALLOCATION
+size_t
+oc_message_incoming_numfree(void)
+{
+#ifdef OC_HAS_FEATURE_ALLOCATOR_MUTEX
+  oc_allocator_mutex_lock();
+#endif /* OC_HAS_FEATURE_ALLOCATOR_MUTEX */
+  int numfree = oc_memb_numfree(&oc_incoming_buffers);
+#ifdef OC_HAS_FEATURE_ALLOCATOR_MUTEX
+  oc_allocator_mutex_unlock();
+#endif /* OC_HAS_FEATURE_ALLOCATOR_MUTEX */
+  return numfree > 0 ? (size_t)numfree : 0;
+}
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
 oc_message_t *
 oc_message_allocate_outgoing(void)
 {
@@ -23,6 +23,7 @@
 #include "oc_signal_event_loop.h"
 #include "oc_buffer.h"
 #include "port/oc_connectivity.h"
+#include "port/oc_connectivity_internal.h"
 #include "util/oc_features.h"
 #include "util/oc_process.h"
 
@@ -41,6 +42,10 @@
 
 OC_PROCESS(oc_message_buffer_handler, "OC Message Buffer Handler");
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+static bool g_outbound_flush_scheduled = false;
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
 void
 oc_recv_message(oc_message_t *message)
 {
@@ -109,6 +114,33 @@ handle_inbound_network_event(oc_process_data_t data)
                   oc_event_to_oc_process_event(INBOUND_RI_EVENT), data);
 }
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+/* The flush event is processed after all events that are already queued, so
+ * all unicast messages posted in the meantime are sent in a single batch. */
+static void
+schedule_outbound_flush(void)
+{
+  if (g_outbound_flush_scheduled) {
+    return;
+  }
+  if (oc_process_post(&oc_message_buffer_handler,
+                      oc_event_to_oc_process_event(OUTBOUND_NETWORK_FLUSH),
+                      NULL) == OC_PROCESS_ERR_FULL) {
+    OC_DBG("Outbound network event: cannot schedule flush, sending batch");
+    oc_send_buffer_batch_flush();
+    return;
+  }
+  g_outbound_flush_scheduled = true;
+}
+
+static void
+handle_outbound_network_flush(void)
+{
+  g_outbound_flush_scheduled = false;
+  oc_send_buffer_batch_flush();
+}
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
 static void
 handle_outbound_network_event(oc_process_data_t data)
 {
@@ -148,6 +180,18 @@ handle_outbound_network_event(oc_process_data_t data)
 #endif /* OC_OSCORE */
 #endif /* OC_SECURITY */
   OC_DBG("Outbound network event: unicast message");
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  if (oc_send_buffer_batch_add(message)) {
+    if (oc_process_nevents() == 0) {
+      // no other queued event can add a message to the batch
+      oc_send_buffer_batch_flush();
+    } else {
+      schedule_outbound_flush();
+    }
+    oc_message_unref(message);
+    return;
+  }
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
   if (oc_send_buffer(message) < 0) {
     OC_ERR("failed to send unicast message");
   }
@@ -182,6 +226,12 @@ OC_PROCESS_THREAD(oc_message_buffer_handler, ev, data)
       handle_outbound_network_event(data);
       continue;
     }
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+    if (ev == oc_event_to_oc_process_event(OUTBOUND_NETWORK_FLUSH)) {
+      handle_outbound_network_flush();
+      continue;
+    }
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
 #ifdef OC_SECURITY
     if (ev == oc_event_to_oc_process_event(TLS_CLOSE_ALL_SESSIONS)) {
       OC_DBG("Signaling to close all TLS sessions from this device");
@@ -204,11 +254,18 @@ OC_PROCESS_THREAD(oc_message_buffer_handler, ev, data)
 void
 oc_message_buffer_handler_start(void)
 {
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  g_outbound_flush_scheduled = false;
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
   oc_process_start(&oc_message_buffer_handler, NULL);
 }
 
 void
 oc_message_buffer_handler_stop(void)
 {
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  oc_send_buffer_batch_flush();
+  g_outbound_flush_scheduled = false;
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
   oc_process_exit(&oc_message_buffer_handler);
 }
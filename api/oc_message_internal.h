@@ -39,6 +39,12 @@ extern "C" {
  */
 oc_message_t *oc_message_allocate_with_size(size_t size);
 
+#ifndef OC_DYNAMIC_ALLOCATION
+/** @brief Get the number of free messages in the static pool of incoming
+ * messages */
+size_t oc_message_incoming_numfree(void);
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
 /**
  * @brief Allocate message.
  *
@@ -34,12 +34,179 @@
 #include "util/oc_features.h"
 #include "util/oc_list.h"
 
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+#include "util/oc_atomic.h"
+#include "util/oc_mpsc_queue_internal.h"
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
+
 #include <assert.h>
 
 OC_LIST(g_network_events);
 #ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
 OC_LIST(g_network_tcp_connect_events);
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+
+/* Events are added to the lock-free queues. An event which does not fit into
+ * its queue is added to the list of the queue (g_network_events or
+ * g_network_tcp_connect_events) guarded by the network event handler mutex. */
+OC_MPSC_QUEUE(g_network_events_queue, OC_NETWORK_EVENT_QUEUE_SIZE);
+static OC_ATOMIC_UINT32_T g_network_events_overflow;
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+OC_MPSC_QUEUE(g_network_tcp_connect_events_queue, OC_NETWORK_EVENT_QUEUE_SIZE);
+static OC_ATOMIC_UINT32_T g_network_tcp_connect_events_overflow;
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+
+static struct
+{
+  OC_ATOMIC_UINT32_T queued;
+  OC_ATOMIC_UINT32_T overflowed;
+  uint32_t max_queued; ///< updated only by the event loop
+} g_network_events_stats;
+
+#ifdef OC_NETWORK_MONITOR
+static OC_ATOMIC_UINT8_T g_interface_up;
+static OC_ATOMIC_UINT8_T g_interface_down;
+#endif /* OC_NETWORK_MONITOR */
+
+static void
+network_event_push(oc_mpsc_queue_t *queue, oc_list_t overflow,
+                   OC_ATOMIC_UINT32_T *overflow_size, void *event)
+{
+  // once an event is added to the overflow list, the following events are
+  // added to it too until it is drained, so the events of a thread stay in
+  // order
+  if (OC_ATOMIC_LOAD32(*overflow_size) == 0 &&
+      oc_mpsc_queue_push(queue, event)) {
+    OC_ATOMIC_INCREMENT32(g_network_events_stats.queued);
+    return;
+  }
+  oc_network_event_handler_mutex_lock();
+  oc_list_add(overflow, event);
+  OC_ATOMIC_INCREMENT32(*overflow_size);
+  oc_network_event_handler_mutex_unlock();
+  OC_ATOMIC_INCREMENT32(g_network_events_stats.overflowed);
+}
+
+typedef void (*network_event_process_fn_t)(void *event);
+
+static void *
+network_event_pop_overflow(oc_mpsc_queue_t *queue, oc_list_t overflow,
+                           OC_ATOMIC_UINT32_T *overflow_size)
+{
+  oc_network_event_handler_mutex_lock();
+  // the events in the queue were pushed before the overflow list was drained
+  // by the threads which pushed them, so they precede all events in the list
+  void *prev = NULL;
+  for (void *event = oc_mpsc_queue_pop_wait(queue); event != NULL;
+       event = oc_mpsc_queue_pop_wait(queue)) {
+    oc_list_insert(overflow, prev, event);
+    OC_ATOMIC_INCREMENT32(*overflow_size);
+    prev = event;
+  }
+  void *event = oc_list_pop(overflow);
+  if (event != NULL) {
+    OC_ATOMIC_DECREMENT32(*overflow_size);
+  }
+  oc_network_event_handler_mutex_unlock();
+  return event;
+}
+
+static void
+network_events_process(oc_mpsc_queue_t *queue, oc_list_t overflow,
+                       OC_ATOMIC_UINT32_T *overflow_size,
+                       network_event_process_fn_t process)
+{
+  uint32_t queued = oc_mpsc_queue_size(queue);
+  if (queued > g_network_events_stats.max_queued) {
+    g_network_events_stats.max_queued = queued;
+  }
+  // events added during the processing are processed on the next poll
+  uint32_t pending = queued + OC_ATOMIC_LOAD32(*overflow_size);
+  for (; pending > 0; --pending) {
+    if (oc_process_is_event_queue_full()) {
+      // keep the events queued until the event loop catches up
+      oc_process_poll(&oc_network_events);
+      return;
+    }
+    void *event;
+    if (OC_ATOMIC_LOAD32(*overflow_size) == 0) {
+      event = oc_mpsc_queue_pop(queue);
+    } else {
+      event = network_event_pop_overflow(queue, overflow, overflow_size);
+    }
+    if (event == NULL) {
+      return;
+    }
+    process(event);
+  }
+}
+
+static void
+network_message_process(void *event)
+{
+  oc_recv_message((oc_message_t *)event);
+}
+
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+static void
+network_tcp_connect_event_process(void *event)
+{
+  oc_tcp_connect_session((oc_tcp_on_connect_event_t *)event);
+}
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+
+static void
+oc_process_network_event(void)
+{
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+  network_events_process(&g_network_tcp_connect_events_queue,
+                         g_network_tcp_connect_events,
+                         &g_network_tcp_connect_events_overflow,
+                         network_tcp_connect_event_process);
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+  network_events_process(&g_network_events_queue, g_network_events,
+                         &g_network_events_overflow, network_message_process);
+#ifdef OC_NETWORK_MONITOR
+  bool interface_up = false;
+  uint8_t expected = 1;
+  OC_ATOMIC_COMPARE_AND_SWAP8(g_interface_up, expected, 0, interface_up);
+  bool interface_down = false;
+  expected = 1;
+  OC_ATOMIC_COMPARE_AND_SWAP8(g_interface_down, expected, 0, interface_down);
+  if (interface_up) {
+    oc_process_post(&oc_network_events,
+                    oc_event_to_oc_process_event(INTERFACE_UP), NULL);
+  }
+  if (interface_down) {
+    oc_process_post(&oc_network_events,
+                    oc_event_to_oc_process_event(INTERFACE_DOWN), NULL);
+  }
+#endif /* OC_NETWORK_MONITOR */
+}
+
+oc_network_events_stats_t
+oc_network_events_get_stats(void)
+{
+  oc_network_events_stats_t stats = {
+    .queued = OC_ATOMIC_LOAD32(g_network_events_stats.queued),
+    .overflowed = OC_ATOMIC_LOAD32(g_network_events_stats.overflowed),
+    .max_queued = g_network_events_stats.max_queued,
+  };
+  return stats;
+}
+
+void
+oc_network_events_reset_stats(void)
+{
+  OC_ATOMIC_STORE32(g_network_events_stats.queued, 0);
+  OC_ATOMIC_STORE32(g_network_events_stats.overflowed, 0);
+  g_network_events_stats.max_queued = 0;
+}
+
+#else /* !OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
+
 #ifdef OC_NETWORK_MONITOR
 static bool g_interface_up;
 static bool g_interface_down;
@@ -91,6 +258,8 @@ oc_process_network_event(void)
 #endif /* OC_NETWORK_MONITOR */
 }
 
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
+
 OC_PROCESS(oc_network_events, "");
 OC_PROCESS_THREAD(oc_network_events, ev, data)
 {
@@ -128,9 +297,14 @@ oc_network_receive_event(oc_message_t *message)
 #ifdef OC_HAS_FEATURE_MESSAGE_DYNAMIC_BUFFER
   oc_message_shrink_buffer(message, message->length);
 #endif /* OC_HAS_FEATURE_MESSAGE_DYNAMIC_BUFFER */
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+  network_event_push(&g_network_events_queue, g_network_events,
+                     &g_network_events_overflow, message);
+#else  /* !OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
   oc_network_event_handler_mutex_lock();
   oc_list_add(g_network_events, message);
   oc_network_event_handler_mutex_unlock();
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
 
   oc_process_poll(&oc_network_events);
   _oc_signal_event_loop();
@@ -144,36 +318,66 @@ oc_network_tcp_connect_event(oc_tcp_on_connect_event_t *event)
     oc_tcp_on_connect_event_free(event);
     return;
   }
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+  network_event_push(&g_network_tcp_connect_events_queue,
+                     g_network_tcp_connect_events,
+                     &g_network_tcp_connect_events_overflow, event);
+#else  /* !OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
   oc_network_event_handler_mutex_lock();
   oc_list_add(g_network_tcp_connect_events, event);
   oc_network_event_handler_mutex_unlock();
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
 
   oc_process_poll(&oc_network_events);
   _oc_signal_event_loop();
 }
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
 
+static void
+network_drop_receive_event(oc_message_t *message)
+{
+#if OC_DBG_IS_ENABLED
+  // GCOVR_EXCL_START
+  oc_process_event_t ev = oc_event_to_oc_process_event(INBOUND_NETWORK_EVENT);
+  oc_string_view_t ev_name = oc_process_event_name(ev);
+  oc_string64_t endpoint_str;
+  OC_DBG("oc_network_events: dropping %s for endpoint(%s)", ev_name.data,
+         oc_string(endpoint_str));
+  // GCOVR_EXCL_STOP
+#endif /* OC_DBG_IS_ENABLED */
+  oc_message_unref(message);
+}
+
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+static bool
+network_drop_queued_receive_event(void *item, const void *data)
+{
+  oc_message_t *message = (oc_message_t *)item;
+  if (oc_endpoint_compare(&message->endpoint, (const oc_endpoint_t *)data) !=
+      0) {
+    return false;
+  }
+  network_drop_receive_event(message);
+  return true;
+}
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
+
 int
 oc_network_drop_receive_events(const oc_endpoint_t *endpoint)
 {
   int dropped = 0;
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+  dropped += oc_mpsc_queue_remove_if(&g_network_events_queue,
+                                     network_drop_queued_receive_event,
+                                     endpoint);
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
   oc_network_event_handler_mutex_lock();
   for (oc_message_t *message = (oc_message_t *)oc_list_head(g_network_events);
        message != NULL;) {
     oc_message_t *next = message->next;
     if (oc_endpoint_compare(&message->endpoint, endpoint) == 0) {
       oc_list_remove(g_network_events, message);
-#if OC_DBG_IS_ENABLED
-      // GCOVR_EXCL_START
-      oc_process_event_t ev =
-        oc_event_to_oc_process_event(INBOUND_NETWORK_EVENT);
-      oc_string_view_t ev_name = oc_process_event_name(ev);
-      oc_string64_t endpoint_str;
-      OC_DBG("oc_network_events: dropping %s for endpoint(%s)", ev_name.data,
-             oc_string(endpoint_str));
-      // GCOVR_EXCL_STOP
-#endif /* OC_DBG_IS_ENABLED */
-      oc_message_unref(message);
+      network_drop_receive_event(message);
       ++dropped;
     }
     message = next;
@@ -192,6 +396,13 @@ oc_network_interface_event(oc_interface_event_t event)
   if (event != NETWORK_INTERFACE_DOWN && event != NETWORK_INTERFACE_UP) {
     return;
   }
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+  if (event == NETWORK_INTERFACE_DOWN) {
+    OC_ATOMIC_STORE8(g_interface_down, 1);
+  } else {
+    OC_ATOMIC_STORE8(g_interface_up, 1);
+  }
+#else  /* !OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
   oc_network_event_handler_mutex_lock();
   if (event == NETWORK_INTERFACE_DOWN) {
     g_interface_down = true;
@@ -199,6 +410,7 @@ oc_network_interface_event(oc_interface_event_t event)
     g_interface_up = true;
   }
   oc_network_event_handler_mutex_unlock();
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
 
   oc_process_poll(&oc_network_events);
   _oc_signal_event_loop();
@@ -26,10 +26,38 @@
 #include "util/oc_features.h"
 #include "util/oc_process.h"
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+
+#ifndef OC_NETWORK_EVENT_QUEUE_SIZE
+/// Number of events held by the lock-free queue of received messages and of
+/// TCP connect events, must be a power of two
+#define OC_NETWORK_EVENT_QUEUE_SIZE (32)
+#endif /* !OC_NETWORK_EVENT_QUEUE_SIZE */
+
+/** @brief Statistics of the queues of network events */
+typedef struct oc_network_events_stats_t
+{
+  uint32_t queued;     ///< events passed through the lock-free queues
+  uint32_t overflowed; ///< events which did not fit into the lock-free queues
+                       ///< and were added to a list guarded by a mutex
+  uint32_t max_queued; ///< highest number of events found in a queue by the
+                       ///< event loop
+} oc_network_events_stats_t;
+
+/** @brief Get the statistics of the queues of network events */
+oc_network_events_stats_t oc_network_events_get_stats(void);
+
+/** @brief Reset the statistics of the queues of network events */
+void oc_network_events_reset_stats(void);
+
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
+
 /**
  * @brief process network events
  */
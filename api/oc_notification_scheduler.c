@@ -0,0 +1,320 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+
+#include "api/oc_notification_scheduler_internal.h"
+#include "messaging/coap/observe_internal.h"
+#include "oc_api.h"
+#include "port/oc_log_internal.h"
+#include "util/oc_list.h"
+#include "util/oc_memb.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* Notifications of a resource queued by the scheduler, a time of 0 means that
+ * nothing is queued */
+typedef struct oc_notification_schedule_t
+{
+  struct oc_notification_schedule_t *next;
+  oc_resource_t *resource;
+  oc_notification_policy_t policy;
+  bool has_policy;
+  oc_clock_time_t change_due;   ///< notification of a change
+  oc_clock_time_t deferred_due; ///< notification of postponed observers
+  oc_clock_time_t periodic_due; ///< periodic notification (pmax)
+  oc_clock_time_t last_sent;    ///< time of the last notification of a change
+} oc_notification_schedule_t;
+
+OC_LIST(g_schedules);
+OC_MEMB(g_schedules_s, oc_notification_schedule_t,
+        OC_MAX_NOTIFICATION_SCHEDULES);
+
+static oc_notification_metrics_t g_metrics;
+static oc_clock_time_t g_armed_due; ///< due time of the drain callback
+static bool g_draining;
+
+static oc_event_callback_retval_t scheduler_drain_async(void *data);
+
+static oc_clock_time_t
+ms_to_ticks(uint32_t ms)
+{
+  return (oc_clock_time_t)ms * OC_CLOCK_SECOND / 1000;
+}
+
+/* The earliest due time of the schedule, 0 if nothing is queued */
+static oc_clock_time_t
+schedule_due(const oc_notification_schedule_t *s)
+{
+  oc_clock_time_t due = 0;
+  const oc_clock_time_t times[] = { s->change_due, s->deferred_due,
+                                    s->periodic_due };
+  for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+    if (times[i] != 0 && (due == 0 || times[i] < due)) {
+      due = times[i];
+    }
+  }
+  return due;
+}
+
+static void
+scheduler_arm(oc_clock_time_t due)
+{
+  if (g_draining || due == 0) {
+    // the drain rearms the callback when it finishes
+    return;
+  }
+  if (g_armed_due != 0 && g_armed_due <= due) {
+    return;
+  }
+  oc_clock_time_t now = oc_clock_time();
+  if (g_armed_due != 0) {
+    oc_remove_delayed_callback(NULL, &scheduler_drain_async);
+  }
+  oc_ri_add_timed_event_callback_ticks(NULL, &scheduler_drain_async,
+                                       due > now ? due - now : 0);
+  g_armed_due = due;
+}
+
+static oc_notification_schedule_t *
+scheduler_find(const oc_resource_t *resource)
+{
+  for (oc_notification_schedule_t *s =
+         (oc_notification_schedule_t *)oc_list_head(g_schedules);
+       s != NULL; s = s->next) {
+    if (s->resource == resource) {
+      return s;
+    }
+  }
+  return NULL;
+}
+
+static oc_notification_schedule_t *
+scheduler_get_or_add(oc_resource_t *resource)
+{
+  oc_notification_schedule_t *s = scheduler_find(resource);
+  if (s != NULL) {
+    return s;
+  }
+  s = (oc_notification_schedule_t *)oc_memb_alloc(&g_schedules_s);
+  if (s == NULL) {
+    OC_WRN("insufficient memory to schedule notifications of resource(%s)",
+           oc_string(resource->uri));
+    return NULL;
+  }
+  s->resource = resource;
+  oc_list_add(g_schedules, s);
+  return s;
+}
+
+static void
+scheduler_free(oc_notification_schedule_t *s)
+{
+  oc_list_remove(g_schedules, s);
+  oc_memb_free(&g_schedules_s, s);
+}
+
+bool
+oc_resource_set_notification_policy(oc_resource_t *resource,
+                                    oc_notification_policy_t policy)
+{
+  assert(resource != NULL);
+  oc_notification_schedule_t *s = scheduler_get_or_add(resource);
+  if (s == NULL) {
+    return false;
+  }
+  s->policy = policy;
+  s->has_policy = true;
+  s->periodic_due =
+    policy.pmax_ms > 0 ? oc_clock_time() + ms_to_ticks(policy.pmax_ms) : 0;
+  scheduler_arm(s->periodic_due);
+  return true;
+}
+
+void
+oc_resource_remove_notification_policy(const oc_resource_t *resource)
+{
+  assert(resource != NULL);
+  oc_notification_schedule_t *s = scheduler_find(resource);
+  if (s == NULL) {
+    return;
+  }
+  s->has_policy = false;
+  s->change_due = 0;
+  s->periodic_due = 0;
+  if (s->deferred_due == 0) {
+    scheduler_free(s);
+  }
+}
+
+oc_notification_metrics_t
+oc_notification_scheduler_get_metrics(void)
+{
+  return g_metrics;
+}
+
+void
+oc_notification_scheduler_reset_metrics(void)
+{
+  memset(&g_metrics, 0, sizeof(g_metrics));
+}
+
+bool
+oc_notification_scheduler_schedule(oc_resource_t *resource)
+{
+  oc_notification_schedule_t *s = scheduler_find(resource);
+  if (s == NULL || !s->has_policy) {
+    return false;
+  }
+  if (s->change_due != 0) {
+    ++g_metrics.coalesced;
+    return true;
+  }
+  ++g_metrics.scheduled;
+  oc_clock_time_t due = oc_clock_time() + ms_to_ticks(s->policy.coalesce_ms);
+  if (s->last_sent != 0) {
+    oc_clock_time_t pmin_due = s->last_sent + ms_to_ticks(s->policy.pmin_ms);
+    if (pmin_due > due) {
+      due = pmin_due;
+    }
+  }
+  s->change_due = due;
+  scheduler_arm(due);
+  return true;
+}
+
+bool
+oc_notification_scheduler_defer(oc_resource_t *resource, oc_clock_time_t due)
+{
+  ++g_metrics.deferred;
+  oc_notification_schedule_t *s = scheduler_get_or_add(resource);
+  if (s == NULL) {
+    ++g_metrics.dropped;
+    return false;
+  }
+  if (s->deferred_due == 0 || due < s->deferred_due) {
+    s->deferred_due = due;
+  }
+  scheduler_arm(due);
+  return true;
+}
+
+void
+oc_notification_scheduler_remove(const oc_resource_t *resource)
+{
+  oc_notification_schedule_t *s = scheduler_find(resource);
+  if (s != NULL) {
+    scheduler_free(s);
+  }
+}
+
+void
+oc_notification_scheduler_free_all(void)
+{
+  oc_notification_schedule_t *s =
+    (oc_notification_schedule_t *)oc_list_pop(g_schedules);
+  while (s != NULL) {
+    oc_memb_free(&g_schedules_s, s);
+    s = (oc_notification_schedule_t *)oc_list_pop(g_schedules);
+  }
+  oc_remove_delayed_callback(NULL, &scheduler_drain_async);
+  g_armed_due = 0;
+}
+
+/* Send the due notifications of the schedule, return false if nothing was
+ * due */
+static bool
+scheduler_send(oc_notification_schedule_t *s, oc_clock_time_t now)
+{
+  bool change = s->change_due != 0 && s->change_due <= now;
+  bool periodic = !change && s->periodic_due != 0 && s->periodic_due <= now;
+  bool deferred = s->deferred_due != 0 && s->deferred_due <= now;
+  if (!change && !periodic && !deferred) {
+    return false;
+  }
+  if (deferred) {
+    s->deferred_due = 0;
+  }
+  if (change || periodic) {
+    s->change_due = 0;
+    s->periodic_due = 0;
+    if (s->policy.pmax_ms > 0) {
+      s->periodic_due = now + ms_to_ticks(s->policy.pmax_ms);
+    }
+    if (change || coap_resource_is_observed(s->resource)) {
+      OC_DBG("notification scheduler: notify observers of resource(%s)",
+             oc_string(s->resource->uri));
+      coap_notify_observers(s->resource, NULL, NULL);
+      s->last_sent = now;
+      if (change) {
+        ++g_metrics.sent;
+      } else {
+        ++g_metrics.periodic;
+      }
+    }
+    return true;
+  }
+  OC_DBG("notification scheduler: notify postponed observers of resource(%s)",
+         oc_string(s->resource->uri));
+  coap_notify_pending_observers(s->resource);
+  return true;
+}
+
+static oc_event_callback_retval_t
+scheduler_drain_async(void *data)
+{
+  (void)data;
+  g_armed_due = 0;
+  g_draining = true;
+  oc_clock_time_t now = oc_clock_time();
+  size_t sent = 0;
+  oc_notification_schedule_t *s =
+    (oc_notification_schedule_t *)oc_list_head(g_schedules);
+  while (s != NULL && sent < OC_NOTIFICATION_SCHEDULER_BATCH) {
+    oc_notification_schedule_t *next = s->next;
+    if (scheduler_send(s, now)) {
+      ++sent;
+      if (!s->has_policy && s->deferred_due == 0) {
+        scheduler_free(s);
+      }
+    }
+    s = next;
+  }
+  g_draining = false;
+
+  oc_clock_time_t due = 0;
+  if (s != NULL) {
+    // the batch is full, continue in the next run of the event loop
+    due = now;
+  } else {
+    for (s = (oc_notification_schedule_t *)oc_list_head(g_schedules);
+         s != NULL; s = s->next) {
+      oc_clock_time_t s_due = schedule_due(s);
+      if (s_due != 0 && (due == 0 || s_due < due)) {
+        due = s_due;
+      }
+    }
+  }
+  scheduler_arm(due);
+  return OC_EVENT_DONE;
+}
+
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
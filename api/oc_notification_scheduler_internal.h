@@ -0,0 +1,91 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef OC_NOTIFICATION_SCHEDULER_INTERNAL_H
+#define OC_NOTIFICATION_SCHEDULER_INTERNAL_H
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+
+#include "api/oc_ri_internal.h"
+#include "oc_config.h"
+#include "oc_notification_scheduler.h"
+#include "oc_ri.h"
+#include "port/oc_clock.h"
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OC_DYNAMIC_ALLOCATION
+/** Maximal number of resources with a policy or with postponed notifications
+ * of observers */
+#ifndef OC_MAX_NOTIFICATION_SCHEDULES
+#define OC_MAX_NOTIFICATION_SCHEDULES                                          \
+  (OC_MAX_APP_RESOURCES +                                                      \
+   OC_NUM_CORE_LOGICAL_DEVICE_RESOURCES * OC_MAX_NUM_DEVICES)
+#endif /* !OC_MAX_NOTIFICATION_SCHEDULES */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+/** Maximal number of notifications sent by one run of the scheduler, the
+ * remaining due notifications are sent by the next run of the event loop */
+#ifndef OC_NOTIFICATION_SCHEDULER_BATCH
+#define OC_NOTIFICATION_SCHEDULER_BATCH (8)
+#endif /* !OC_NOTIFICATION_SCHEDULER_BATCH */
+
+/**
+ * @brief Queue a notification of a changed resource.
+ *
+ * @param resource the changed resource (cannot be NULL)
+ * @return true the notification was queued or coalesced with a queued
+ * notification
+ * @return false the resource has no policy, the observers should be notified
+ * immediately
+ */
+bool oc_notification_scheduler_schedule(oc_resource_t *resource) OC_NONNULL();
+
+/**
+ * @brief Queue a notification of the observers of the resource postponed by
+ * their minimal interval.
+ *
+ * @param resource the resource (cannot be NULL)
+ * @param due time when the first postponed observer can be notified
+ * @return true the notification was queued
+ * @return false the notification could not be queued
+ */
+bool oc_notification_scheduler_defer(oc_resource_t *resource,
+                                     oc_clock_time_t due) OC_NONNULL();
+
+/** @brief Remove the policy and queued notifications of a resource */
+void oc_notification_scheduler_remove(const oc_resource_t *resource)
+  OC_NONNULL();
+
+/** @brief Remove all policies and queued notifications */
+void oc_notification_scheduler_free_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
+#endif /* OC_NOTIFICATION_SCHEDULER_INTERNAL_H */
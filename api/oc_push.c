@@ -29,6 +29,7 @@
 #include "api/oc_helpers_internal.h"
 #include "api/oc_rep_internal.h"
 #include "api/oc_endpoint_internal.h"
+#include "api/oc_ri_resource_index_internal.h"
 #include "oc_api.h"
 #include "oc_core_res.h"
 #include "oc_core_res_internal.h"
@@ -1856,9 +1857,19 @@ _update_recv_obj(oc_recv_t *recv_obj, const oc_recvs_t *recvs_instance,
             OC_PUSH_DBG("pushed resource representation (\"%s\") is found",
                         oc_string(pushd_rsc_rep->resource->uri));
 
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+            bool indexed =
+              oc_ri_resource_index_remove(pushd_rsc_rep->resource);
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
             oc_free_string(&pushd_rsc_rep->resource->uri);
             oc_store_uri(oc_string(rep->value.string),
                          &pushd_rsc_rep->resource->uri);
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+            if (indexed) {
+              oc_ri_resource_index_add(pushd_rsc_rep->resource,
+                                       OC_RI_RESOURCE_INDEX_KIND_APP);
+            }
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
           }
         }
 
@@ -0,0 +1,280 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "oc_rep_view.h"
+
+#include <string.h>
+
+bool
+oc_rep_view_init(oc_rep_view_t *view, const uint8_t *payload,
+                 size_t payload_size)
+{
+  CborParser parser;
+  CborValue root;
+  if (cbor_parser_init(payload, payload_size, 0, &parser, &root) !=
+        CborNoError ||
+      (!cbor_value_is_map(&root) && !cbor_value_is_array(&root))) {
+    return false;
+  }
+  view->data = payload;
+  view->size = payload_size;
+  return true;
+}
+
+bool
+oc_rep_view_is_object(const oc_rep_view_t *view)
+{
+  // the major type of a map is 5
+  return view->size > 0 && (view->data[0] >> 5) == 5;
+}
+
+static CborError
+rep_view_enter(const oc_rep_view_t *view, CborParser *parser,
+               CborValue *container, CborValue *it)
+{
+  CborError err =
+    cbor_parser_init(view->data, view->size, 0, parser, container);
+  if (err != CborNoError) {
+    return err;
+  }
+  if (!cbor_value_is_map(container) && !cbor_value_is_array(container)) {
+    return CborErrorIllegalType;
+  }
+  return cbor_value_enter_container(container, it);
+}
+
+static CborError
+rep_view_get_string(const CborValue *it, const char **data, size_t *size)
+{
+  if (!cbor_value_is_length_known(it)) {
+    return CborErrorUnknownLength;
+  }
+  return cbor_value_get_text_string_chunk(it, data, size, NULL);
+}
+
+/* Decode the value at the iterator and advance the iterator past it */
+static CborError
+rep_view_decode_value(CborValue *it, oc_rep_view_value_t *value)
+{
+  CborError err = CborNoError;
+  switch (cbor_value_get_type(it)) {
+  case CborNullType:
+    value->type = OC_REP_NIL;
+    break;
+  case CborIntegerType:
+    value->type = OC_REP_INT;
+    err = cbor_value_get_int64(it, &value->value.integer);
+    break;
+  case CborBooleanType:
+    value->type = OC_REP_BOOL;
+    err = cbor_value_get_boolean(it, &value->value.boolean);
+    break;
+  case CborDoubleType:
+    value->type = OC_REP_DOUBLE;
+    err = cbor_value_get_double(it, &value->value.double_p);
+    break;
+  case CborTextStringType:
+    value->type = OC_REP_STRING;
+    err = rep_view_get_string(it, &value->value.string.data,
+                              &value->value.string.size);
+    break;
+  case CborByteStringType:
+    value->type = OC_REP_BYTE_STRING;
+    if (!cbor_value_is_length_known(it)) {
+      return CborErrorUnknownLength;
+    }
+    err = cbor_value_get_byte_string_chunk(it, &value->value.byte_string.data,
+                                           &value->value.byte_string.size,
+                                           NULL);
+    break;
+  case CborMapType:
+  case CborArrayType: {
+    value->type = cbor_value_is_map(it) ? OC_REP_OBJECT : OC_REP_ARRAY;
+    // the extent of a container is known only after it is skipped
+    const uint8_t *start = cbor_value_get_next_byte(it);
+    err = cbor_value_advance(it);
+    if (err != CborNoError) {
+      return err;
+    }
+    value->value.container.data = start;
+    value->value.container.size =
+      (size_t)(cbor_value_get_next_byte(it) - start);
+    return CborNoError;
+  }
+  default:
+    return CborErrorIllegalType;
+  }
+  if (err != CborNoError) {
+    return err;
+  }
+  return cbor_value_advance(it);
+}
+
+bool
+oc_rep_view_find(const oc_rep_view_t *object, const char *key,
+                 oc_rep_view_value_t *value)
+{
+  CborParser parser;
+  CborValue map;
+  CborValue it;
+  if (rep_view_enter(object, &parser, &map, &it) != CborNoError ||
+      !cbor_value_is_map(&map)) {
+    return false;
+  }
+  size_t key_len = strlen(key);
+  while (!cbor_value_at_end(&it)) {
+    const char *k;
+    size_t k_len;
+    if (!cbor_value_is_text_string(&it) ||
+        rep_view_get_string(&it, &k, &k_len) != CborNoError ||
+        cbor_value_advance(&it) != CborNoError || cbor_value_at_end(&it)) {
+      return false;
+    }
+    if (k_len == key_len && memcmp(k, key, key_len) == 0) {
+      return rep_view_decode_value(&it, value) == CborNoError;
+    }
+    if (cbor_value_advance(&it) != CborNoError) {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool
+oc_rep_view_iterate(const oc_rep_view_t *view, oc_rep_view_iterate_fn_t fn,
+                    void *data)
+{
+  CborParser parser;
+  CborValue container;
+  CborValue it;
+  if (rep_view_enter(view, &parser, &container, &it) != CborNoError) {
+    return false;
+  }
+  bool is_object = cbor_value_is_map(&container);
+  while (!cbor_value_at_end(&it)) {
+    const char *key = NULL;
+    size_t key_len = 0;
+    if (is_object &&
+        (!cbor_value_is_text_string(&it) ||
+         rep_view_get_string(&it, &key, &key_len) != CborNoError ||
+         cbor_value_advance(&it) != CborNoError || cbor_value_at_end(&it))) {
+      return false;
+    }
+    oc_rep_view_value_t value;
+    if (rep_view_decode_value(&it, &value) != CborNoError) {
+      return false;
+    }
+    if (!fn(key, key_len, &value, data)) {
+      return true;
+    }
+  }
+  return true;
+}
+
+static bool
+rep_view_find_type(const oc_rep_view_t *object, const char *key,
+                   oc_rep_value_type_t type, oc_rep_view_value_t *value)
+{
+  return oc_rep_view_find(object, key, value) && value->type == type;
+}
+
+bool
+oc_rep_view_get_int(const oc_rep_view_t *object, const char *key,
+                    int64_t *value)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_INT, &v)) {
+    return false;
+  }
+  *value = v.value.integer;
+  return true;
+}
+
+bool
+oc_rep_view_get_bool(const oc_rep_view_t *object, const char *key,
+                     bool *value)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_BOOL, &v)) {
+    return false;
+  }
+  *value = v.value.boolean;
+  return true;
+}
+
+bool
+oc_rep_view_get_double(const oc_rep_view_t *object, const char *key,
+                       double *value)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_DOUBLE, &v)) {
+    return false;
+  }
+  *value = v.value.double_p;
+  return true;
+}
+
+bool
+oc_rep_view_get_string(const oc_rep_view_t *object, const char *key,
+                       const char **value, size_t *size)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_STRING, &v)) {
+    return false;
+  }
+  *value = v.value.string.data;
+  *size = v.value.string.size;
+  return true;
+}
+
+bool
+oc_rep_view_get_byte_string(const oc_rep_view_t *object, const char *key,
+                            const uint8_t **value, size_t *size)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_BYTE_STRING, &v)) {
+    return false;
+  }
+  *value = v.value.byte_string.data;
+  *size = v.value.byte_string.size;
+  return true;
+}
+
+bool
+oc_rep_view_get_object(const oc_rep_view_t *object, const char *key,
+                       oc_rep_view_t *value)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_OBJECT, &v)) {
+    return false;
+  }
+  *value = v.value.container;
+  return true;
+}
+
+bool
+oc_rep_view_get_array(const oc_rep_view_t *object, const char *key,
+                      oc_rep_view_t *value)
+{
+  oc_rep_view_value_t v;
+  if (!rep_view_find_type(object, key, OC_REP_ARRAY, &v)) {
+    return false;
+  }
+  *value = v.value.container;
+  return true;
+}
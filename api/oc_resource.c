@@ -17,6 +17,7 @@
  ****************************************************************************/
 
 #include "api/oc_core_res_internal.h"
+#include "api/oc_discovery_internal.h"
 #include "api/oc_enums_internal.h"
 #include "api/oc_ri_internal.h"
 #include "oc_api.h"
@@ -197,6 +198,7 @@ void
 oc_resource_tag_pos_desc(oc_resource_t *resource, oc_pos_description_t pos)
 {
   resource->tag_pos_desc = pos;
+  oc_discovery_cache_invalidate();
 }
 
 void
@@ -205,6 +207,7 @@ oc_resource_tag_pos_rel(oc_resource_t *resource, double x, double y, double z)
   resource->tag_pos_rel[0] = x;
   resource->tag_pos_rel[1] = y;
   resource->tag_pos_rel[2] = z;
+  oc_discovery_cache_invalidate();
 }
 
 bool
@@ -218,12 +221,14 @@ void
 oc_resource_tag_func_desc(oc_resource_t *resource, oc_enum_t func)
 {
   resource->tag_func_desc = func;
+  oc_discovery_cache_invalidate();
 }
 
 void
 oc_resource_tag_locn(oc_resource_t *resource, oc_locn_t locn)
 {
   resource->tag_locn = locn;
+  oc_discovery_cache_invalidate();
 }
 
 static void
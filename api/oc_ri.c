@@ -16,6 +16,7 @@
  *
  ***************************************************************************/
 
+#include "api/oc_discovery_internal.h"
 #include "api/oc_endpoint_internal.h"
 #include "api/oc_event_callback_internal.h"
 #include "api/oc_events_internal.h"
@@ -28,6 +29,7 @@
 #include "api/oc_resource_internal.h"
 #include "api/oc_ri_internal.h"
 #include "api/oc_ri_preparsed_request_internal.h"
+#include "api/oc_ri_resource_index_internal.h"
 #include "messaging/coap/coap_internal.h"
 #include "messaging/coap/options_internal.h"
 #include "messaging/coap/constants.h"
@@ -73,10 +75,17 @@
 #endif /* OC_SERVER */
 
 #ifdef OC_HAS_FEATURE_ETAG
-#include "api/oc_discovery_internal.h"
 #include "api/oc_etag_internal.h"
 #endif /* OC_HAS_FEATURE_ETAG */
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+#include "api/oc_notification_scheduler_internal.h"
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+#include "api/oc_blockwise_stream_internal.h"
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 #ifdef OC_HAS_FEATURE_PUSH
 #include "oc_push_internal.h"
 #endif /*OC_HAS_FEATURE_PUSH  */
@@ -259,6 +268,16 @@ oc_ri_URI_is_in_use(size_t device, const char *uri, size_t uri_len)
   if (oc_core_get_resource_by_uri_v1(uri, uri_len, device) != NULL) {
     return true;
   }
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  // dynamic resources and collections
+  if (oc_ri_resource_index_find(uri, uri_len, device,
+                                OC_RI_RESOURCE_INDEX_KIND_ANY) != NULL) {
+    return true;
+  }
+  // dynamic resources scheduled to be deleted
+  return ri_uri_is_in_list(g_app_resources_to_be_deleted, uri, uri_len,
+                           device);
+#else  /* !OC_HAS_FEATURE_RESOURCE_INDEX */
   // dynamic resources / dynamic resources scheduled to be deleted
   if (ri_uri_is_in_list(g_app_resources, uri, uri_len, device) ||
       ri_uri_is_in_list(g_app_resources_to_be_deleted, uri, uri_len, device)) {
@@ -272,12 +291,16 @@ oc_ri_URI_is_in_use(size_t device, const char *uri, size_t uri_len)
   }
 #endif /* OC_COLLECTIONS */
   return false;
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 }
 
 static void
 ri_app_resource_to_be_deleted(oc_resource_t *resource)
 {
   oc_list_remove2(g_app_resources, resource);
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  oc_ri_resource_index_remove(resource);
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
   if (!oc_ri_is_app_resource_to_be_deleted(resource)) {
     oc_list_add(g_app_resources_to_be_deleted, resource);
   }
@@ -451,6 +474,10 @@ oc_ri_get_app_resource_by_uri(const char *uri, size_t uri_len, size_t device)
     return NULL;
   }
 
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  return oc_ri_resource_index_find(uri, uri_len, device,
+                                   OC_RI_RESOURCE_INDEX_KIND_ANY);
+#else  /* !OC_HAS_FEATURE_RESOURCE_INDEX */
   int skip = 0;
   if (uri[0] != '/') {
     skip = 1;
@@ -472,6 +499,7 @@ oc_ri_get_app_resource_by_uri(const char *uri, size_t uri_len, size_t device)
   }
 #endif /* OC_COLLECTIONS */
   return NULL;
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 }
 #endif /* OC_SERVER */
 
@@ -483,6 +511,9 @@ oc_ri_init(void)
 #ifdef OC_SERVER
   oc_list_init(g_app_resources);
   oc_list_init(g_app_resources_to_be_deleted);
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  oc_ri_resource_index_init();
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 #endif /* OC_SERVER */
 
 #ifdef OC_CLIENT
@@ -588,9 +619,15 @@ ri_delete_resource(oc_resource_t *resource, bool notify)
   bool removed = oc_list_remove2(g_app_resources, resource) != NULL;
   removed =
     oc_list_remove2(g_app_resources_to_be_deleted, resource) != NULL || removed;
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  oc_ri_resource_index_remove(resource);
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 
   oc_remove_delayed_callback(resource, oc_delayed_delete_resource_cb);
   oc_notify_clear(resource);
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  oc_blockwise_stream_remove(resource);
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
 
   if (resource->num_observers > 0) {
     int removed_num = coap_remove_observers_by_resource(resource);
@@ -665,7 +702,14 @@ oc_ri_add_resource(oc_resource_t *resource)
     return false;
   }
 
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  if (!oc_ri_resource_index_add(resource, OC_RI_RESOURCE_INDEX_KIND_APP)) {
+    OC_ERR("failed to index resource(%s)", oc_string(resource->uri));
+    return false;
+  }
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
   oc_list_add(g_app_resources, resource);
+  oc_discovery_cache_invalidate();
   oc_notify_resource_added(resource);
   return true;
 }
@@ -691,6 +735,7 @@ ri_delete_all_app_resources(void)
 void
 oc_ri_free_resource_properties(oc_resource_t *resource)
 {
+  oc_discovery_cache_invalidate();
   oc_free_string(&(resource->name));
   oc_free_string(&(resource->uri));
   if (oc_string_array_get_allocated_size(resource->types) > 0) {
@@ -890,6 +935,29 @@ ri_add_collection_observation(oc_collection_t *collection,
 
 #endif /* OC_COLLECTIONS */
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+/* Minimal interval between notifications in seconds requested by the pmin
+ * query parameter of the observe registration, 0 if not requested */
+static oc_clock_time_t
+ri_observe_get_pmin(const coap_packet_t *request)
+{
+  const char *value = NULL;
+  int value_len = oc_ri_get_query_value_v1(
+    request->uri_query, request->uri_query_len, "pmin", 4, &value);
+  if (value_len <= 0 || value_len > 9) {
+    return 0;
+  }
+  uint32_t seconds = 0;
+  for (int i = 0; i < value_len; ++i) {
+    if (value[i] < '0' || value[i] > '9') {
+      return 0;
+    }
+    seconds = seconds * 10 + (uint32_t)(value[i] - '0');
+  }
+  return (oc_clock_time_t)seconds * OC_CLOCK_SECOND;
+}
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
 static int
 ri_observe_handler(const coap_packet_t *request, const coap_packet_t *response,
                    oc_resource_t *resource, uint16_t block2_size,
@@ -901,13 +969,16 @@ ri_observe_handler(const coap_packet_t *request, const coap_packet_t *response,
     return -1;
   }
   if (request->observe == OC_COAP_OPTION_OBSERVE_REGISTER) {
-    if (NULL == coap_add_observer(resource, block2_size, endpoint,
-                                  request->token, request->token_len,
-                                  request->uri_path, request->uri_path_len,
-                                  iface_mask)) {
+    coap_observer_t *obs = coap_add_observer(
+      resource, block2_size, endpoint, request->token, request->token_len,
+      request->uri_path, request->uri_path_len, iface_mask);
+    if (obs == NULL) {
       OC_ERR("failed to add observer");
       return -1;
     }
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+    obs->pmin = ri_observe_get_pmin(request);
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
     return 0;
   }
   if (request->observe == OC_COAP_OPTION_OBSERVE_UNREGISTER) {
@@ -1223,6 +1294,18 @@ ri_invoke_coap_entity_set_response(coap_packet_t *response,
   coap_set_status_code(response, response_buffer->code);
 }
 
+static bool
+ri_request_payload_view_only(const oc_ri_preparsed_request_obj_t *obj)
+{
+#if defined(OC_COLLECTIONS) && defined(OC_SERVER)
+  if (obj->resource_is_collection) {
+    return false;
+  }
+#endif /* OC_COLLECTIONS && OC_SERVER */
+  return obj->cur_resource != NULL &&
+         (obj->cur_resource->properties & OC_REQUEST_PAYLOAD_VIEW) != 0;
+}
+
 static oc_status_t
 ri_invoke_coap_entity_get_payload_rep(const uint8_t *payload,
                                       size_t payload_len,
@@ -1359,8 +1442,10 @@ ri_invoke_handler(coap_make_response_ctx_t *ctx,
   OC_MEMB_LOCAL(rep_objects, oc_rep_t, OC_MAX_NUM_REP_OBJECTS);
   struct oc_memb *prev_rep_objects = oc_rep_reset_pool(&rep_objects);
 
-  // we need to check only for bad request
-  if (!bitmask_code) {
+  // we need to check only for bad request, handlers reading the payload by
+  // the view don't need the parsed tree
+  if (!bitmask_code &&
+      !ri_request_payload_view_only(in->preparsed_request_obj)) {
     oc_status_t status = ri_invoke_coap_entity_get_payload_rep(
       in->payload, in->payload_len, in->preparsed_request_obj->cf,
       &in->request_obj->request_payload);
@@ -1596,13 +1681,24 @@ ri_parse_coap_request_header(coap_make_response_ctx_t *ctx,
     bitmask_code |= BITMASK_CODE_NOT_FOUND;
   }
 
-  if (!bitmask_code && !oc_rep_decoder_is_supported_content_format(
-                         ctx->preparsed_request_obj->cf)) {
+  // a streamed body is not decoded, a streamed GET response is produced
+  // without the handler
+  bool streamed = false;
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  streamed = cur_resource != NULL &&
+             oc_blockwise_stream_find_by_method(cur_resource, method,
+                                                endpoint) != NULL;
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
+  if (!bitmask_code && !streamed &&
+      !oc_rep_decoder_is_supported_content_format(
+        ctx->preparsed_request_obj->cf)) {
     bitmask_code |= BITMASK_CODE_BAD_REQUEST;
   }
 
   if (!bitmask_code && cur_resource &&
       (!get_resource_is_collection(ctx->preparsed_request_obj)) &&
+      !(streamed && method == OC_GET) &&
       !oc_resource_get_method_handler(cur_resource, method, NULL)) {
     bitmask_code |= BITMASK_CODE_METHOD_NOT_ALLOWED;
   }
@@ -1911,6 +2007,9 @@ oc_ri_reset(void)
   coap_free_all_discovery_batch_observers();
 #endif /* OC_RES_BATCH_SUPPORT && OC_DISCOVERY_RESOURCE_OBSERVABLE */
   coap_free_all_observers();
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+  oc_notification_scheduler_free_all();
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
 #endif /* OC_SERVER */
   coap_free_all_transactions();
   oc_event_callbacks_shutdown();
@@ -1920,6 +2019,12 @@ oc_ri_reset(void)
 #ifdef OC_BLOCK_WISE
   oc_blockwise_free_all_buffers(true);
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  oc_blockwise_stream_free_all();
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+  oc_discovery_cache_free_all();
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
 }
 
 void
@@ -1943,5 +2048,9 @@ oc_ri_shutdown(void)
 #endif /* OC_COLLECTIONS */
 
   ri_delete_all_app_resources();
+
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+  oc_ri_resource_index_deinit();
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
 #endif /* OC_SERVER */
 }
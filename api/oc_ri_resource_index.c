@@ -0,0 +1,271 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+
+#include "api/oc_ri_internal.h"
+#include "api/oc_ri_resource_index_internal.h"
+#include "port/oc_log_internal.h"
+#include "util/oc_hash_internal.h"
+#include "util/oc_memb.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef OC_COLLECTIONS
+#include "api/oc_collection_internal.h"
+#endif /* OC_COLLECTIONS */
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#include <stdlib.h>
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+typedef struct ri_resource_index_entry_t
+{
+  struct ri_resource_index_entry_t *next; ///< next entry in the bucket
+  oc_resource_t *resource;                ///< indexed resource
+  uint32_t hash;                          ///< hash of the (device, URI) key
+  oc_ri_resource_index_kind_t kind;       ///< kind of the resource
+} ri_resource_index_entry_t;
+
+OC_MEMB(g_resource_index_entries_s, ri_resource_index_entry_t,
+        OC_RI_RESOURCE_INDEX_MAX_ENTRIES);
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#define RI_RESOURCE_INDEX_MIN_BUCKETS (16)
+static ri_resource_index_entry_t **g_resource_index_buckets = NULL;
+static size_t g_resource_index_num_buckets = 0;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+static ri_resource_index_entry_t
+  *g_resource_index_buckets[OC_RI_RESOURCE_INDEX_MAX_ENTRIES];
+static const size_t g_resource_index_num_buckets =
+  OC_RI_RESOURCE_INDEX_MAX_ENTRIES;
+#endif /* OC_DYNAMIC_ALLOCATION */
+static size_t g_resource_index_count = 0;
+
+static void
+ri_resource_index_uri_trim(const char **uri, size_t *uri_len)
+{
+  while (*uri_len > 0 && (*uri)[0] == '/') {
+    ++(*uri);
+    --(*uri_len);
+  }
+}
+
+static uint32_t
+ri_resource_index_hash(const char *uri, size_t uri_len, size_t device)
+{
+  uint32_t hash = oc_hash_fnv1a_uint(OC_HASH_FNV1A_INIT, device);
+  return oc_hash_fnv1a(hash, uri, uri_len);
+}
+
+static bool
+ri_resource_index_entry_match(const ri_resource_index_entry_t *entry,
+                              uint32_t hash, const char *uri, size_t uri_len,
+                              size_t device)
+{
+  if (entry->hash != hash || entry->resource->device != device) {
+    return false;
+  }
+  const char *res_uri = oc_string(entry->resource->uri);
+  size_t res_uri_len = oc_string_len(entry->resource->uri);
+  ri_resource_index_uri_trim(&res_uri, &res_uri_len);
+  return res_uri_len == uri_len && memcmp(res_uri, uri, uri_len) == 0;
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static bool
+ri_resource_index_rehash(size_t num_buckets)
+{
+  ri_resource_index_entry_t **buckets = (ri_resource_index_entry_t **)calloc(
+    num_buckets, sizeof(ri_resource_index_entry_t *));
+  if (buckets == NULL) {
+    OC_ERR("insufficient memory to resize resource index");
+    return false;
+  }
+  for (size_t i = 0; i < g_resource_index_num_buckets; ++i) {
+    ri_resource_index_entry_t *entry = g_resource_index_buckets[i];
+    while (entry != NULL) {
+      ri_resource_index_entry_t *next = entry->next;
+      size_t idx = entry->hash % num_buckets;
+      entry->next = buckets[idx];
+      buckets[idx] = entry;
+      entry = next;
+    }
+  }
+  free(g_resource_index_buckets);
+  g_resource_index_buckets = buckets;
+  g_resource_index_num_buckets = num_buckets;
+  return true;
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+void
+oc_ri_resource_index_deinit(void)
+{
+  for (size_t i = 0; i < g_resource_index_num_buckets; ++i) {
+    ri_resource_index_entry_t *entry = g_resource_index_buckets[i];
+    while (entry != NULL) {
+      ri_resource_index_entry_t *next = entry->next;
+      oc_memb_free(&g_resource_index_entries_s, entry);
+      entry = next;
+    }
+    g_resource_index_buckets[i] = NULL;
+  }
+#ifdef OC_DYNAMIC_ALLOCATION
+  free(g_resource_index_buckets);
+  g_resource_index_buckets = NULL;
+  g_resource_index_num_buckets = 0;
+#endif /* OC_DYNAMIC_ALLOCATION */
+  g_resource_index_count = 0;
+}
+
+void
+oc_ri_resource_index_init(void)
+{
+  // collections can be added before the initialization of the stack and stay
+  // in their list, so the index is rebuilt from the lists
+  oc_ri_resource_index_deinit();
+  for (oc_resource_t *res = oc_ri_get_app_resources(); res != NULL;
+       res = res->next) {
+    oc_ri_resource_index_add(res, OC_RI_RESOURCE_INDEX_KIND_APP);
+  }
+#ifdef OC_COLLECTIONS
+  for (oc_collection_t *col = oc_collection_get_all(); col != NULL;
+       col = (oc_collection_t *)col->res.next) {
+    oc_ri_resource_index_add(&col->res, OC_RI_RESOURCE_INDEX_KIND_COLLECTION);
+  }
+#endif /* OC_COLLECTIONS */
+}
+
+static ri_resource_index_entry_t **
+ri_resource_index_find_entry(const oc_resource_t *resource)
+{
+  if (g_resource_index_num_buckets == 0) {
+    return NULL;
+  }
+  const char *uri = oc_string(resource->uri);
+  size_t uri_len = oc_string_len(resource->uri);
+  ri_resource_index_uri_trim(&uri, &uri_len);
+  uint32_t hash = ri_resource_index_hash(uri, uri_len, resource->device);
+  ri_resource_index_entry_t **entry =
+    &g_resource_index_buckets[hash % g_resource_index_num_buckets];
+  for (; *entry != NULL; entry = &(*entry)->next) {
+    if ((*entry)->resource == resource) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+bool
+oc_ri_resource_index_add(oc_resource_t *resource,
+                         oc_ri_resource_index_kind_t kind)
+{
+  if (oc_string(resource->uri) == NULL) {
+    OC_ERR("cannot index resource without URI");
+    return false;
+  }
+  if (ri_resource_index_find_entry(resource) != NULL) {
+    OC_DBG("resource(%s) already indexed", oc_string(resource->uri));
+    return false;
+  }
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  // keep the load factor <= 1
+  if (g_resource_index_count + 1 > g_resource_index_num_buckets) {
+    size_t num_buckets = g_resource_index_num_buckets * 2;
+    if (num_buckets < RI_RESOURCE_INDEX_MIN_BUCKETS) {
+      num_buckets = RI_RESOURCE_INDEX_MIN_BUCKETS;
+    }
+    if (!ri_resource_index_rehash(num_buckets)) {
+      return false;
+    }
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+  ri_resource_index_entry_t *entry = (ri_resource_index_entry_t *)oc_memb_alloc(
+    &g_resource_index_entries_s);
+  if (entry == NULL) {
+    OC_ERR("insufficient memory to index resource(%s)",
+           oc_string(resource->uri));
+    return false;
+  }
+  const char *uri = oc_string(resource->uri);
+  size_t uri_len = oc_string_len(resource->uri);
+  ri_resource_index_uri_trim(&uri, &uri_len);
+  entry->resource = resource;
+  entry->kind = kind;
+  entry->hash = ri_resource_index_hash(uri, uri_len, resource->device);
+  size_t idx = entry->hash % g_resource_index_num_buckets;
+  entry->next = g_resource_index_buckets[idx];
+  g_resource_index_buckets[idx] = entry;
+  ++g_resource_index_count;
+  return true;
+}
+
+bool
+oc_ri_resource_index_remove(const oc_resource_t *resource)
+{
+  ri_resource_index_entry_t **entry = ri_resource_index_find_entry(resource);
+  if (entry == NULL) {
+    return false;
+  }
+  ri_resource_index_entry_t *to_free = *entry;
+  *entry = to_free->next;
+  oc_memb_free(&g_resource_index_entries_s, to_free);
+  --g_resource_index_count;
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (g_resource_index_count == 0) {
+    free(g_resource_index_buckets);
+    g_resource_index_buckets = NULL;
+    g_resource_index_num_buckets = 0;
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+  return true;
+}
+
+oc_resource_t *
+oc_ri_resource_index_find(const char *uri, size_t uri_len, size_t device,
+                          unsigned kind)
+{
+  if (g_resource_index_num_buckets == 0) {
+    return NULL;
+  }
+  ri_resource_index_uri_trim(&uri, &uri_len);
+  uint32_t hash = ri_resource_index_hash(uri, uri_len, device);
+  const ri_resource_index_entry_t *entry =
+    g_resource_index_buckets[hash % g_resource_index_num_buckets];
+  for (; entry != NULL; entry = entry->next) {
+    if ((entry->kind & kind) != 0 &&
+        ri_resource_index_entry_match(entry, hash, uri, uri_len, device)) {
+      return entry->resource;
+    }
+  }
+  return NULL;
+}
+
+size_t
+oc_ri_resource_index_count(void)
+{
+  return g_resource_index_count;
+}
+
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
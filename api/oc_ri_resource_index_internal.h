@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef OC_RI_RESOURCE_INDEX_INTERNAL_H
+#define OC_RI_RESOURCE_INDEX_INTERNAL_H
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+
+#include "oc_config.h"
+#include "oc_ri.h"
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OC_DYNAMIC_ALLOCATION
+
+#ifdef OC_COLLECTIONS
+#define OC_RI_RESOURCE_INDEX_MAX_ENTRIES                                       \
+  (OC_MAX_APP_RESOURCES + OC_MAX_NUM_COLLECTIONS)
+#else /* !OC_COLLECTIONS */
+#define OC_RI_RESOURCE_INDEX_MAX_ENTRIES (OC_MAX_APP_RESOURCES)
+#endif /* OC_COLLECTIONS */
+
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+/**
+ * @brief Kind of the indexed resource.
+ */
+typedef enum oc_ri_resource_index_kind_t {
+  OC_RI_RESOURCE_INDEX_KIND_APP = 1 << 0,        ///< application resource
+  OC_RI_RESOURCE_INDEX_KIND_COLLECTION = 1 << 1, ///< collection
+  OC_RI_RESOURCE_INDEX_KIND_ANY =
+    OC_RI_RESOURCE_INDEX_KIND_APP | OC_RI_RESOURCE_INDEX_KIND_COLLECTION,
+} oc_ri_resource_index_kind_t;
+
+/**
+ * @brief Initialize the (device, URI) index of application resources, the
+ * application resources and collections already in their lists are indexed
+ */
+void oc_ri_resource_index_init(void);
+
+/** @brief Remove all entries and release memory used by the index */
+void oc_ri_resource_index_deinit(void);
+
+/**
+ * @brief Add resource to the index.
+ *
+ * The resource is keyed by its device and URI, the URI must not change while
+ * the resource is indexed (use oc_ri_resource_index_remove before updating the
+ * URI and oc_ri_resource_index_add to index the resource again).
+ *
+ * @param resource resource to add (cannot be NULL)
+ * @param kind kind of the resource (OC_RI_RESOURCE_INDEX_KIND_APP or
+ * OC_RI_RESOURCE_INDEX_KIND_COLLECTION)
+ * @return true resource was added
+ * @return false otherwise (resource already indexed or allocation failure)
+ */
+bool oc_ri_resource_index_add(oc_resource_t *resource,
+                              oc_ri_resource_index_kind_t kind) OC_NONNULL();
+
+/**
+ * @brief Remove resource from the index.
+ *
+ * @param resource resource to remove (cannot be NULL)
+ * @return true resource was removed
+ * @return false resource was not found in the index
+ */
+bool oc_ri_resource_index_remove(const oc_resource_t *resource) OC_NONNULL();
+
+/**
+ * @brief Find indexed resource by URI and device.
+ *
+ * @param uri URI of the resource, leading slashes are ignored (cannot be NULL)
+ * @param uri_len length of the URI
+ * @param device device index
+ * @param kind mask of resource kinds to search for
+ * @return oc_resource_t* found resource
+ * @return NULL resource was not found
+ */
+oc_resource_t *oc_ri_resource_index_find(const char *uri, size_t uri_len,
+                                         size_t device,
+                                         unsigned kind) OC_NONNULL();
+
+/** @brief Get the number of indexed resources */
+size_t oc_ri_resource_index_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
+
+#endif /* OC_RI_RESOURCE_INDEX_INTERNAL_H */
@@ -17,6 +17,7 @@
  ****************************************************************************/
 
 #include "api/oc_core_res_internal.h"
+#include "api/oc_discovery_internal.h"
 #include "api/oc_main_internal.h"
 #include "api/oc_message_internal.h"
 #include "api/oc_platform_internal.h"
@@ -46,6 +47,10 @@
 #include "api/oc_etag_internal.h"
 #endif /* OC_HAS_FEATURE_ETAG */
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+#include "api/oc_notification_scheduler_internal.h"
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
 #ifdef OC_SECURITY
 #include "oc_store.h"
 #endif /* OC_SECURITY */
@@ -306,6 +311,27 @@ oc_get_request_payload_raw(const oc_request_t *request, const uint8_t **payload,
   return false;
 }
 
+bool
+oc_get_request_payload_view(const oc_request_t *request, oc_rep_view_t *view)
+{
+  if (request->_payload == NULL || request->_payload_len == 0 ||
+      (request->content_format != APPLICATION_NOT_DEFINED &&
+       request->content_format != APPLICATION_CBOR &&
+       request->content_format != APPLICATION_VND_OCF_CBOR)) {
+    return false;
+  }
+  return oc_rep_view_init(view, request->_payload, request->_payload_len);
+}
+
+void
+oc_resource_set_request_payload_view(oc_resource_t *resource, bool state)
+{
+  if (state)
+    resource->properties |= OC_REQUEST_PAYLOAD_VIEW;
+  else
+    resource->properties &= ~OC_REQUEST_PAYLOAD_VIEW;
+}
+
 void
 oc_send_response_raw(oc_request_t *request, const uint8_t *payload, size_t size,
                      oc_content_format_t content_format,
@@ -444,6 +470,7 @@ oc_resource_bind_resource_interface(oc_resource_t *resource,
                                     oc_interface_mask_t iface_mask)
 {
   resource->interfaces |= iface_mask;
+  oc_discovery_cache_invalidate();
 }
 
 void
@@ -457,6 +484,7 @@ void
 oc_resource_bind_resource_type(oc_resource_t *resource, const char *type)
 {
   oc_string_array_add_item(resource->types, type);
+  oc_discovery_cache_invalidate();
 }
 
 #ifdef OC_SECURITY
@@ -464,6 +492,7 @@ void
 oc_resource_make_public(oc_resource_t *resource)
 {
   resource->properties &= ~OC_SECURE;
+  oc_discovery_cache_invalidate();
 }
 #endif /* OC_SECURITY */
 
@@ -474,6 +503,7 @@ oc_resource_set_discoverable(oc_resource_t *resource, bool state)
     resource->properties |= OC_DISCOVERABLE;
   else
     resource->properties &= ~OC_DISCOVERABLE;
+  oc_discovery_cache_invalidate();
 }
 
 #ifdef OC_HAS_FEATURE_PUSH
@@ -484,6 +514,7 @@ oc_resource_set_pushable(oc_resource_t *resource, bool state)
     resource->properties |= OC_PUSHABLE;
   else
     resource->properties &= ~OC_PUSHABLE;
+  oc_discovery_cache_invalidate();
 }
 #endif /* OC_HAS_FEATURE_PUSH */
 
@@ -494,6 +525,7 @@ oc_resource_set_observable(oc_resource_t *resource, bool state)
     resource->properties |= OC_OBSERVABLE;
   else
     resource->properties &= ~(OC_OBSERVABLE | OC_PERIODIC);
+  oc_discovery_cache_invalidate();
 }
 
 void
@@ -501,6 +533,7 @@ oc_resource_set_periodic_observable(oc_resource_t *resource, uint16_t seconds)
 {
   resource->properties |= OC_OBSERVABLE | OC_PERIODIC;
   resource->observe_period_seconds = seconds;
+  oc_discovery_cache_invalidate();
 }
 
 static oc_request_handler_t *
@@ -543,6 +576,7 @@ oc_resource_set_secure_mcast(oc_resource_t *resource, bool supported)
     } else {
       resource->properties &= ~OC_SECURE_MCAST;
     }
+    oc_discovery_cache_invalidate();
   }
 }
 #endif /* OC_OSCORE */
@@ -729,6 +763,11 @@ oc_notify_observers(oc_resource_t *resource)
   if (!oc_main_initialized()) {
     return 0;
   }
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+  if (oc_notification_scheduler_schedule(resource)) {
+    return 0;
+  }
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
   return coap_notify_observers(resource, NULL, NULL);
 }
 
@@ -884,6 +923,9 @@ oc_notify_clear(const oc_resource_t *resource)
   assert(resource != NULL);
   oc_remove_delayed_callback(resource, &notify_resource_changed_async);
   oc_remove_delayed_callback(resource, &notify_observers_async);
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+  oc_notification_scheduler_remove(resource);
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
 }
 
 #endif /* OC_SERVER */
@@ -0,0 +1,481 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "util/oc_features.h"
+
+#if defined(OC_HAS_FEATURE_BLOCKWISE_STREAM) && defined(OC_SERVER) &&          \
+  defined(OC_CLIENT) &&                                                        \
+  (!defined(OC_SECURITY) || defined(OC_HAS_FEATURE_RESOURCE_ACCESS_IN_RFOTM))
+
+#include "api/oc_blockwise_stream_internal.h"
+#include "messaging/coap/transactions_internal.h"
+#include "oc_api.h"
+#include "oc_blockwise_stream.h"
+#include "port/oc_connectivity.h"
+#include "tests/gtest/Benchmark.h"
+#include "tests/gtest/Device.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static constexpr size_t kDeviceID{ 0 };
+
+namespace {
+
+/** Deterministic body of given size, a byte is derived from its offset */
+struct Body
+{
+  size_t size{};
+  size_t max_buffer_size{}; ///< largest buffer passed to a callback
+  size_t received{};
+  bool valid{ true };
+  bool verify{ true }; ///< compare the written data with the body
+  std::vector<uint8_t> content{}; ///< produced instead of the generated body
+
+  static uint8_t At(size_t offset)
+  {
+    return static_cast<uint8_t>((offset * 31) ^ (offset >> 8));
+  }
+
+  long Read(uint32_t offset, uint8_t *buffer, size_t buffer_size, bool *more)
+  {
+    max_buffer_size = std::max(max_buffer_size, buffer_size);
+    if (offset > size) {
+      return -1;
+    }
+    size_t len = std::min(buffer_size, size - offset);
+    for (size_t i = 0; i < len; ++i) {
+      buffer[i] = content.empty() ? At(offset + i) : content[offset + i];
+    }
+    *more = offset + len < size;
+    return static_cast<long>(len);
+  }
+
+  bool Write(uint32_t offset, const uint8_t *data, size_t size)
+  {
+    max_buffer_size = std::max(max_buffer_size, size);
+    if (offset != received) {
+      valid = false;
+      return false;
+    }
+    for (size_t i = 0; verify && i < size; ++i) {
+      if (data[i] != At(offset + i)) {
+        valid = false;
+        return false;
+      }
+    }
+    received += size;
+    return true;
+  }
+
+  static long OnRead(const oc_endpoint_t *, uint32_t offset, uint8_t *buffer,
+                     size_t buffer_size, bool *more, void *user_data)
+  {
+    return static_cast<Body *>(user_data)->Read(offset, buffer, buffer_size,
+                                                more);
+  }
+
+  static bool OnWrite(const oc_endpoint_t *, uint32_t offset,
+                      const uint8_t *data, size_t size, void *user_data)
+  {
+    return static_cast<Body *>(user_data)->Write(offset, data, size);
+  }
+};
+
+/** Body produced or consumed by a client request */
+struct ClientRequest
+{
+  Body body;
+  oc_status_t code{ OC_STATUS_INTERNAL_SERVER_ERROR };
+  bool done{};
+  int *pending{};
+
+  static void OnResponse(oc_client_response_t *data)
+  {
+    auto *req = static_cast<ClientRequest *>(data->user_data);
+    req->code = data->code;
+    req->done = true;
+    if (req->pending != nullptr && --(*req->pending) > 0) {
+      return;
+    }
+    oc::TestDevice::Terminate();
+  }
+
+  static long OnRead(const oc_endpoint_t *, uint32_t offset, uint8_t *buffer,
+                     size_t buffer_size, bool *more, void *user_data)
+  {
+    return static_cast<ClientRequest *>(user_data)->body.Read(
+      offset, buffer, buffer_size, more);
+  }
+
+  static bool OnWrite(const oc_endpoint_t *, uint32_t offset,
+                      const uint8_t *data, size_t size, void *user_data)
+  {
+    return static_cast<ClientRequest *>(user_data)->body.Write(offset, data,
+                                                               size);
+  }
+};
+
+} // namespace
+
+class TestBlockwiseStream : public testing::Test {
+public:
+  static void SetUpTestCase() { ASSERT_TRUE(oc::TestDevice::StartServer()); }
+
+  static void TearDownTestCase() { oc::TestDevice::StopServer(); }
+
+  void SetUp() override
+  {
+    oc::DynamicResourceHandler handlers{};
+    handlers.onGet = onGet;
+    handlers.onPost = onPost;
+    handlers.onPut = onPost;
+    auto dr = oc::makeDynamicResourceToAdd(
+      "Stream", "/stream", { "oic.r.stream" }, { OC_IF_BASELINE, OC_IF_RW },
+      handlers);
+    resource_ = oc::TestDevice::AddDynamicResource(dr, kDeviceID);
+    ASSERT_NE(nullptr, resource_);
+    oc_resource_set_default_interface(resource_, OC_IF_RW);
+    get_count_ = 0;
+    post_count_ = 0;
+    post_has_payload_ = false;
+    server_body_ = Body{};
+
+    auto epOpt = oc::TestDevice::GetEndpoint(kDeviceID, 0, SECURED | TCP);
+    ASSERT_TRUE(epOpt.has_value());
+    ep_ = *epOpt;
+  }
+
+  void TearDown() override
+  {
+    oc::TestDevice::DropOutgoingMessages();
+    coap_free_all_transactions();
+    oc::TestDevice::ClearDynamicResource(resource_);
+    oc::TestDevice::Reset();
+  }
+
+  static void onGet(oc_request_t *request, oc_interface_mask_t, void *)
+  {
+    // the checksum of the payload for the ETag store is calculated by a GET
+    // request without an origin, count only the requests of clients
+    if (request->origin != nullptr) {
+      ++get_count_;
+    }
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, 42);
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+  }
+
+  static void onPost(oc_request_t *request, oc_interface_mask_t, void *)
+  {
+    ++post_count_;
+    post_has_payload_ = request->request_payload != nullptr;
+    oc_send_response(request, OC_STATUS_CHANGED);
+  }
+
+  static void setServerStream(bool read, bool write,
+                              oc_content_format_t cf = APPLICATION_NOT_DEFINED)
+  {
+    oc_blockwise_stream_handler_t handler{};
+    handler.read = read ? Body::OnRead : nullptr;
+    handler.write = write ? Body::OnWrite : nullptr;
+    handler.content_format = cf;
+    handler.user_data = &server_body_;
+    ASSERT_TRUE(oc_resource_set_blockwise_stream(resource_, handler));
+  }
+
+  static oc_resource_t *resource_;
+  static oc_endpoint_t ep_;
+  static int get_count_;
+  static int post_count_;
+  static bool post_has_payload_;
+  static Body server_body_;
+};
+
+oc_resource_t *TestBlockwiseStream::resource_{};
+oc_endpoint_t TestBlockwiseStream::ep_{};
+int TestBlockwiseStream::get_count_{ 0 };
+int TestBlockwiseStream::post_count_{ 0 };
+bool TestBlockwiseStream::post_has_payload_{ false };
+Body TestBlockwiseStream::server_body_{};
+
+TEST_F(TestBlockwiseStream, SetStream_F)
+{
+  oc_blockwise_stream_handler_t handler{};
+  EXPECT_FALSE(oc_resource_set_blockwise_stream(resource_, handler));
+  EXPECT_EQ(nullptr, oc_blockwise_stream_find(resource_));
+}
+
+TEST_F(TestBlockwiseStream, FindByMethod)
+{
+  setServerStream(/*read*/ true, /*write*/ false);
+  EXPECT_NE(nullptr,
+            oc_blockwise_stream_find_by_method(resource_, OC_GET, &ep_));
+  EXPECT_EQ(nullptr,
+            oc_blockwise_stream_find_by_method(resource_, OC_POST, &ep_));
+  EXPECT_EQ(nullptr,
+            oc_blockwise_stream_find_by_method(resource_, OC_DELETE, &ep_));
+#ifdef OC_TCP
+  oc_endpoint_t tcp = ep_;
+  tcp.flags = static_cast<transport_flags>(tcp.flags | TCP);
+  EXPECT_EQ(nullptr,
+            oc_blockwise_stream_find_by_method(resource_, OC_GET, &tcp));
+#endif /* OC_TCP */
+
+  oc_resource_remove_blockwise_stream(resource_);
+  EXPECT_EQ(nullptr,
+            oc_blockwise_stream_find_by_method(resource_, OC_GET, &ep_));
+}
+
+// a regular GET request receives the body produced by the stream
+TEST_F(TestBlockwiseStream, ServerRead)
+{
+  setServerStream(/*read*/ true, /*write*/ false, APPLICATION_VND_OCF_CBOR);
+  // the client parses the payload, so the stream produces an encoded document
+  std::vector<uint8_t> data(
+    std::min<size_t>(OC_MAX_APP_DATA_SIZE, 2 * OC_BLOCK_SIZE) - 32);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = Body::At(i);
+  }
+  std::vector<uint8_t> encoded(data.size() + 32);
+  oc_rep_new_v1(encoded.data(), encoded.size());
+  oc_rep_start_root_object();
+  oc_rep_set_byte_string(root, data, data.data(), data.size());
+  oc_rep_end_root_object();
+  int size = oc_rep_get_encoded_payload_size();
+  ASSERT_LT(0, size);
+  encoded.resize(static_cast<size_t>(size));
+  server_body_.content = encoded;
+  server_body_.size = encoded.size();
+
+  struct
+  {
+    std::vector<uint8_t> data;
+    oc_content_format_t cf;
+    oc_status_t code;
+  } result{ {}, APPLICATION_NOT_DEFINED, OC_STATUS_INTERNAL_SERVER_ERROR };
+  auto onGetResponse = [](oc_client_response_t *data) {
+    auto *res = static_cast<decltype(result) *>(data->user_data);
+    res->code = data->code;
+    res->cf = data->content_format;
+    char *value = nullptr;
+    size_t value_size = 0;
+    if (oc_rep_get_byte_string(data->payload, "data", &value, &value_size)) {
+      res->data.assign(value, value + value_size);
+    }
+    oc::TestDevice::Terminate();
+  };
+  ASSERT_TRUE(oc_do_get(oc_string(resource_->uri), &ep_, nullptr,
+                        onGetResponse, HIGH_QOS, &result));
+  oc::TestDevice::PoolEventsMsV1(2s);
+
+  EXPECT_EQ(OC_STATUS_OK, result.code);
+  EXPECT_EQ(APPLICATION_VND_OCF_CBOR, result.cf);
+  EXPECT_EQ(data, result.data);
+  // the handler is replaced by the stream
+  EXPECT_EQ(0, get_count_);
+}
+
+// a regular POST request passes its payload to the stream
+TEST_F(TestBlockwiseStream, ServerWrite)
+{
+  setServerStream(/*read*/ false, /*write*/ true);
+  server_body_.verify = false;
+
+  ClientRequest req{};
+  ASSERT_TRUE(oc_init_post(oc_string(resource_->uri), &ep_, nullptr,
+                           ClientRequest::OnResponse, HIGH_QOS, &req));
+  oc_rep_start_root_object();
+  oc_rep_set_int(root, value, 42);
+  oc_rep_end_root_object();
+  int size = oc_rep_get_encoded_payload_size();
+  ASSERT_LT(0, size);
+  std::vector<uint8_t> payload(oc_rep_get_encoder_buf(),
+                               oc_rep_get_encoder_buf() + size);
+  ASSERT_TRUE(oc_do_post());
+  oc::TestDevice::PoolEventsMsV1(2s);
+
+  EXPECT_TRUE(req.done);
+  EXPECT_EQ(OC_STATUS_CHANGED, req.code);
+  EXPECT_EQ(1, post_count_);
+  // the payload was passed to the stream, the handler gets none
+  EXPECT_FALSE(post_has_payload_);
+  EXPECT_EQ(payload.size(), server_body_.received);
+}
+
+TEST_F(TestBlockwiseStream, ClientGet)
+{
+  setServerStream(/*read*/ true, /*write*/ false);
+  // larger than the buffers of a reassembled payload
+  server_body_.size = 16 * OC_MAX_APP_DATA_SIZE + 5;
+
+  ClientRequest req{};
+  ASSERT_TRUE(oc_do_get_stream(oc_string(resource_->uri), &ep_, nullptr,
+                               ClientRequest::OnWrite,
+                               ClientRequest::OnResponse, HIGH_QOS, &req));
+  oc::TestDevice::PoolEventsMsV1(5s);
+
+  EXPECT_TRUE(req.done);
+  EXPECT_EQ(OC_STATUS_OK, req.code);
+  EXPECT_TRUE(req.body.valid);
+  EXPECT_EQ(server_body_.size, req.body.received);
+  EXPECT_GE(static_cast<size_t>(OC_BLOCK_SIZE), req.body.max_buffer_size);
+  EXPECT_GE(static_cast<size_t>(OC_BLOCK_SIZE), server_body_.max_buffer_size);
+  EXPECT_EQ(0, get_count_);
+}
+
+TEST_F(TestBlockwiseStream, ClientPost)
+{
+  setServerStream(/*read*/ false, /*write*/ true);
+
+  ClientRequest req{};
+  req.body.size = 16 * OC_MAX_APP_DATA_SIZE + 5;
+  ASSERT_TRUE(oc_do_post_stream(oc_string(resource_->uri), &ep_, nullptr,
+                                ClientRequest::OnRead, APPLICATION_NOT_DEFINED,
+                                ClientRequest::OnResponse, &req));
+  oc::TestDevice::PoolEventsMsV1(5s);
+
+  EXPECT_TRUE(req.done);
+  EXPECT_EQ(OC_STATUS_CHANGED, req.code);
+  EXPECT_TRUE(server_body_.valid);
+  EXPECT_EQ(req.body.size, server_body_.received);
+  EXPECT_EQ(1, post_count_);
+  EXPECT_FALSE(post_has_payload_);
+}
+
+TEST_F(TestBlockwiseStream, ClientPut)
+{
+  setServerStream(/*read*/ false, /*write*/ true);
+
+  ClientRequest req{};
+  req.body.size = 2 * OC_BLOCK_SIZE;
+  ASSERT_TRUE(oc_do_put_stream(oc_string(resource_->uri), &ep_, nullptr,
+                               ClientRequest::OnRead, APPLICATION_NOT_DEFINED,
+                               ClientRequest::OnResponse, &req));
+  oc::TestDevice::PoolEventsMsV1(2s);
+
+  EXPECT_TRUE(req.done);
+  EXPECT_EQ(OC_STATUS_CHANGED, req.code);
+  EXPECT_EQ(req.body.size, server_body_.received);
+}
+
+// the handlers are invoked again once the stream is removed
+TEST_F(TestBlockwiseStream, RemoveStream)
+{
+  setServerStream(/*read*/ true, /*write*/ true);
+  oc_resource_remove_blockwise_stream(resource_);
+
+  ClientRequest req{};
+  ASSERT_TRUE(oc_do_get(oc_string(resource_->uri), &ep_, nullptr,
+                        ClientRequest::OnResponse, HIGH_QOS, &req));
+  oc::TestDevice::PoolEventsMsV1(2s);
+
+  EXPECT_EQ(OC_STATUS_OK, req.code);
+  EXPECT_EQ(1, get_count_);
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+// Transfer a multi-MB body to and from concurrent peers, each transfer holds a
+// single block instead of the whole body, run with
+// --gtest_also_run_disabled_tests
+TEST_F(TestBlockwiseStream, DISABLED_Benchmark)
+{
+  setServerStream(/*read*/ true, /*write*/ true);
+  constexpr size_t kBodySize = 2 * 1024 * 1024;
+  constexpr int kPeers = 8;
+  server_body_.size = kBodySize;
+
+  std::vector<ClientRequest> requests(kPeers);
+  std::vector<std::string> queries;
+  for (int i = 0; i < kPeers; ++i) {
+    queries.push_back("peer=" + std::to_string(i));
+  }
+  int pending = kPeers;
+  auto download = oc::Benchmark("StreamGet", 1, [&](size_t) {
+    for (int i = 0; i < kPeers; ++i) {
+      requests[i].pending = &pending;
+      ASSERT_TRUE(oc_do_get_stream(oc_string(resource_->uri), &ep_,
+                                   queries[i].c_str(), ClientRequest::OnWrite,
+                                   ClientRequest::OnResponse, HIGH_QOS,
+                                   &requests[i]));
+    }
+    oc::TestDevice::PoolEventsMsV1(60s);
+  });
+  for (const auto &req : requests) {
+    EXPECT_EQ(OC_STATUS_OK, req.code);
+    EXPECT_TRUE(req.body.valid);
+    EXPECT_EQ(kBodySize, req.body.received);
+    EXPECT_GE(static_cast<size_t>(OC_BLOCK_SIZE), req.body.max_buffer_size);
+  }
+  double seconds = download.NsPerOp() / 1e9;
+  printf("[ BENCH    ] StreamGet: %d peers x %zu bytes, %.1f MB/s, %zu bytes "
+         "buffered per transfer\n",
+         kPeers, kBodySize, kPeers * kBodySize / 1e6 / seconds,
+         server_body_.max_buffer_size);
+
+  // the server consumes the uploads of all peers in a single body
+  server_body_ = Body{};
+  server_body_.size = kBodySize;
+  auto onWrite = [](const oc_endpoint_t *, uint32_t, const uint8_t *,
+                    size_t size, void *user_data) {
+    auto *body = static_cast<Body *>(user_data);
+    body->received += size;
+    body->max_buffer_size = std::max(body->max_buffer_size, size);
+    return true;
+  };
+  oc_blockwise_stream_handler_t handler{};
+  handler.write = onWrite;
+  handler.user_data = &server_body_;
+  ASSERT_TRUE(oc_resource_set_blockwise_stream(resource_, handler));
+
+  requests = std::vector<ClientRequest>(kPeers);
+  pending = kPeers;
+  auto upload = oc::Benchmark("StreamPost", 1, [&](size_t) {
+    for (int i = 0; i < kPeers; ++i) {
+      requests[i].pending = &pending;
+      requests[i].body.size = kBodySize;
+      ASSERT_TRUE(oc_do_post_stream(
+        oc_string(resource_->uri), &ep_, queries[i].c_str(),
+        ClientRequest::OnRead, APPLICATION_NOT_DEFINED,
+        ClientRequest::OnResponse, &requests[i]));
+    }
+    oc::TestDevice::PoolEventsMsV1(60s);
+  });
+  for (const auto &req : requests) {
+    EXPECT_EQ(OC_STATUS_CHANGED, req.code);
+  }
+  EXPECT_EQ(kPeers * kBodySize, server_body_.received);
+  seconds = upload.NsPerOp() / 1e9;
+  printf("[ BENCH    ] StreamPost: %d peers x %zu bytes, %.1f MB/s, %zu bytes "
+         "buffered per transfer\n",
+         kPeers, kBodySize, kPeers * kBodySize / 1e6 / seconds,
+         server_body_.max_buffer_size);
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM && OC_SERVER && OC_CLIENT &&       \
+          (!OC_SECURITY || OC_HAS_FEATURE_RESOURCE_ACCESS_IN_RFOTM) */
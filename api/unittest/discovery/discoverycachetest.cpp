@@ -0,0 +1,305 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_DISCOVERY_CACHE
+
+#include "discovery.h"
+
+#include "api/oc_discovery_internal.h"
+#include "api/oc_rep_encode_internal.h"
+#include "api/oc_ri_internal.h"
+#include "oc_api.h"
+#include "oc_buffer_settings.h"
+#include "oc_core_res.h"
+#include "oc_rep.h"
+#include "tests/gtest/Benchmark.h"
+#include "tests/gtest/Device.h"
+#include "util/oc_macros_internal.h"
+
+#ifdef OC_HAS_FEATURE_ETAG
+#include "api/oc_etag_internal.h"
+#include "oc_etag.h"
+#endif /* OC_HAS_FEATURE_ETAG */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+class TestDiscoveryCache : public TestDiscoveryWithServer {
+public:
+  void SetUp() override
+  {
+    TestDiscoveryWithServer::SetUp();
+    oc_discovery_cache_invalidate();
+  }
+
+  void TearDown() override
+  {
+    for (oc_resource_t *res : added_) {
+      oc::TestDevice::ClearDynamicResource(res);
+    }
+    added_.clear();
+    if (max_app_data_size_ > 0) {
+      oc_set_max_app_data_size(static_cast<size_t>(max_app_data_size_));
+      max_app_data_size_ = -1;
+    }
+    oc_discovery_cache_invalidate();
+    TestDiscoveryWithServer::TearDown();
+  }
+
+  struct Response
+  {
+    int code;
+    std::vector<uint8_t> payload;
+  };
+
+  // invoke the GET handler of /oic/res directly, without the network stack
+  static Response Get(const std::string &query = "",
+                      oc_interface_mask_t iface = OC_IF_LL)
+  {
+    oc_resource_t *res = oc_core_get_resource_by_index(OCF_RES, kDeviceID);
+    EXPECT_NE(nullptr, res);
+
+    oc_rep_encoder_set_type(OC_REP_CBOR_ENCODER);
+    oc_response_buffer_t rb{};
+    rb.buffer_size = 256;
+    rb.buffer = static_cast<uint8_t *>(malloc(rb.buffer_size));
+    oc_request_t request{};
+    oc_response_t response{};
+    response.response_buffer = &rb;
+    request.response = &response;
+    request.resource = res;
+    request.method = OC_GET;
+    request.query = query.empty() ? nullptr : query.c_str();
+    request.query_len = query.length();
+    oc_rep_new_realloc_v1(&rb.buffer, rb.buffer_size,
+                          static_cast<size_t>(oc_get_max_app_data_size()));
+    res->get_handler.cb(&request, iface, res->get_handler.user_data);
+
+    Response r{};
+    r.code = rb.code;
+    int size = oc_rep_get_encoded_payload_size();
+    if (size > 0) {
+      const uint8_t *payload = oc_rep_get_encoder_buf();
+      r.payload.assign(payload, payload + size);
+    }
+    // might have been reallocated by the handler
+    free(rb.buffer);
+    return r;
+  }
+
+  static bool HasLink(const Response &r, const std::string &uri)
+  {
+    std::string payload(r.payload.begin(), r.payload.end());
+    return payload.find(uri) != std::string::npos;
+  }
+
+  oc_resource_t *AddResource(const std::string &uri)
+  {
+    oc::DynamicResourceHandler handlers{};
+    handlers.onGet = oc::TestDevice::DummyHandler;
+    oc_resource_t *res = oc::TestDevice::AddDynamicResource(
+      oc::makeDynamicResourceToAdd("cached", uri, { "oic.d.cached" },
+                                   { OC_IF_BASELINE, OC_IF_R }, handlers),
+      kDeviceID);
+    if (res != nullptr) {
+      added_.push_back(res);
+    }
+    return res;
+  }
+
+  void RemoveResource(oc_resource_t *res)
+  {
+    auto it = std::find(added_.begin(), added_.end(), res);
+    ASSERT_NE(added_.end(), it);
+    added_.erase(it);
+    ASSERT_TRUE(oc::TestDevice::ClearDynamicResource(res));
+  }
+
+  void SetMaxAppDataSize(size_t size)
+  {
+    max_app_data_size_ = oc_get_max_app_data_size();
+    oc_set_max_app_data_size(size);
+  }
+
+private:
+  std::vector<oc_resource_t *> added_{};
+  long max_app_data_size_{ -1 };
+};
+
+TEST_F(TestDiscoveryCache, Hit)
+{
+  Response r1 = Get();
+  ASSERT_FALSE(r1.payload.empty());
+  EXPECT_EQ(1, oc_discovery_cache_size());
+
+  Response r2 = Get();
+  EXPECT_EQ(r1.code, r2.code);
+  EXPECT_EQ(r1.payload, r2.payload);
+  EXPECT_EQ(1, oc_discovery_cache_size());
+}
+
+TEST_F(TestDiscoveryCache, SeparateEntries)
+{
+  Response ll = Get();
+  Response baseline = Get("", OC_IF_BASELINE);
+  Response rt = Get("rt=oic.wk.d");
+  EXPECT_EQ(3, oc_discovery_cache_size());
+  EXPECT_NE(ll.payload, baseline.payload);
+  EXPECT_NE(ll.payload, rt.payload);
+
+  EXPECT_EQ(baseline.payload, Get("", OC_IF_BASELINE).payload);
+  EXPECT_EQ(rt.payload, Get("rt=oic.wk.d").payload);
+  EXPECT_EQ(ll.payload, Get().payload);
+  EXPECT_EQ(3, oc_discovery_cache_size());
+}
+
+TEST_F(TestDiscoveryCache, NotCachedInterface)
+{
+  // only the interfaces of /oic/res producing links are cached
+  Get("", OC_IF_R);
+  EXPECT_EQ(0, oc_discovery_cache_size());
+}
+
+TEST_F(TestDiscoveryCache, InvalidateOnAddAndRemove)
+{
+  const std::string uri = "/cached/1";
+  Response r1 = Get();
+  ASSERT_FALSE(HasLink(r1, uri));
+  EXPECT_EQ(1, oc_discovery_cache_size());
+
+  oc_resource_t *res = AddResource(uri);
+  ASSERT_NE(nullptr, res);
+  EXPECT_EQ(0, oc_discovery_cache_size());
+  Response r2 = Get();
+  EXPECT_TRUE(HasLink(r2, uri));
+  EXPECT_EQ(1, oc_discovery_cache_size());
+
+  RemoveResource(res);
+  EXPECT_EQ(0, oc_discovery_cache_size());
+  Response r3 = Get();
+  EXPECT_FALSE(HasLink(r3, uri));
+  EXPECT_EQ(r1.payload.size(), r3.payload.size());
+}
+
+TEST_F(TestDiscoveryCache, InvalidateOnPropertyChange)
+{
+  const std::string uri = "/cached/2";
+  oc_resource_t *res = AddResource(uri);
+  ASSERT_NE(nullptr, res);
+
+  Get();
+  EXPECT_EQ(1, oc_discovery_cache_size());
+  oc_resource_tag_locn(res, OCF_LOCN_KITCHEN);
+  EXPECT_EQ(0, oc_discovery_cache_size());
+  EXPECT_TRUE(HasLink(Get(), "kitchen"));
+
+  EXPECT_EQ(1, oc_discovery_cache_size());
+  oc_resource_set_discoverable(res, false);
+  EXPECT_EQ(0, oc_discovery_cache_size());
+  EXPECT_FALSE(HasLink(Get(), uri));
+
+  EXPECT_EQ(1, oc_discovery_cache_size());
+  oc_resource_bind_resource_type(res, "oic.d.cached.other");
+  EXPECT_EQ(0, oc_discovery_cache_size());
+}
+
+#ifdef OC_HAS_FEATURE_ETAG
+
+TEST_F(TestDiscoveryCache, MissOnETagChange)
+{
+  Response r1 = Get();
+  EXPECT_EQ(1, oc_discovery_cache_size());
+
+  oc_resource_t *res = oc_core_get_resource_by_index(OCF_RES, kDeviceID);
+  ASSERT_NE(nullptr, res);
+  oc_resource_update_etag(res);
+
+  // the entry of the previous etag is not matched, a new entry is stored
+  Get();
+  EXPECT_EQ(2, oc_discovery_cache_size());
+}
+
+#ifdef OC_HAS_FEATURE_CRC_ENCODER
+
+TEST_F(TestDiscoveryCache, NotCachedChecksum)
+{
+  oc_resource_t *res = oc_core_get_resource_by_index(OCF_RES, kDeviceID);
+  ASSERT_NE(nullptr, res);
+
+  uint64_t crc64_1 = 0;
+  ASSERT_EQ(OC_RESOURCE_CRC64_OK, oc_resource_get_crc64(res, &crc64_1));
+  EXPECT_EQ(0, oc_discovery_cache_size());
+  uint64_t crc64_2 = 0;
+  ASSERT_EQ(OC_RESOURCE_CRC64_OK, oc_resource_get_crc64(res, &crc64_2));
+  EXPECT_EQ(crc64_1, crc64_2);
+
+  // a checksum does not change the cached response
+  Response r1 = Get();
+  ASSERT_EQ(OC_RESOURCE_CRC64_OK, oc_resource_get_crc64(res, &crc64_2));
+  EXPECT_EQ(crc64_1, crc64_2);
+  EXPECT_EQ(r1.payload, Get().payload);
+}
+
+#endif /* OC_HAS_FEATURE_CRC_ENCODER */
+
+#endif /* OC_HAS_FEATURE_ETAG */
+
+TEST_F(TestDiscoveryCache, Eviction)
+{
+  for (int i = 0; i < OC_DISCOVERY_CACHE_SIZE + 4; ++i) {
+    Get("rt=oic.wk.d" + std::to_string(i));
+  }
+  EXPECT_EQ(OC_DISCOVERY_CACHE_SIZE, oc_discovery_cache_size());
+
+  // the most recently used entry is kept
+  Get("rt=oic.wk.d" + std::to_string(OC_DISCOVERY_CACHE_SIZE + 3));
+  EXPECT_EQ(OC_DISCOVERY_CACHE_SIZE, oc_discovery_cache_size());
+}
+
+// measures the speed only, run with --gtest_also_run_disabled_tests
+TEST_F(TestDiscoveryCache, DISABLED_Benchmark)
+{
+  // the links of all resources must fit into the payload
+  SetMaxAppDataSize(128 * 1024);
+  constexpr int kResources = 200;
+  for (int i = 0; i < kResources; ++i) {
+    ASSERT_NE(nullptr, AddResource("/cached/bench/" + std::to_string(i)));
+  }
+
+  constexpr size_t kIterations = 200;
+  auto cold = oc::Benchmark("DiscoveryCache.Cold", kIterations, [](size_t) {
+    oc_discovery_cache_invalidate();
+    Get();
+  });
+  Response r = Get();
+  ASSERT_FALSE(r.payload.empty());
+  ASSERT_EQ(1, oc_discovery_cache_size());
+  auto hot =
+    oc::Benchmark("DiscoveryCache.Hot", kIterations, [](size_t) { Get(); });
+  printf("[ BENCH    ] cached discovery response is %.1fx faster\n",
+         cold.NsPerOp() / hot.NsPerOp());
+}
+
+#endif /* OC_HAS_FEATURE_DISCOVERY_CACHE */
@@ -101,8 +101,7 @@ TestEncoderBuffer::SetRepBuffer(size_t size, size_t max_size)
   (void)size;
   buffer_.resize(max_size);
   oc_rep_new_v1(buffer_.data(), buffer_.size());
-  memset(&rep_objects_alloc_[0], 0, OC_MAX_NUM_REP_OBJECTS * sizeof(char));
-  memset(&rep_objects_pool_[0], 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
+  oc_memb_init(&rep_objects_);
 #endif /* OC_DYNAMIC_ALLOCATION */
 }
 
@@ -60,13 +60,14 @@ private:
 
 #ifdef OC_DYNAMIC_ALLOCATION
   uint8_t *buffer_{ nullptr };
-  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr };
+  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr,
+                        OC_MEMB_STATE_INIT };
 #else  /* !OC_DYNAMIC_ALLOCATION */
   std::vector<uint8_t> buffer_{};
   std::array<char, OC_MAX_NUM_REP_OBJECTS> rep_objects_alloc_{};
   std::array<oc_rep_t, OC_MAX_NUM_REP_OBJECTS> rep_objects_pool_{};
   oc_memb rep_objects_{ sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                         rep_objects_alloc_.data(), rep_objects_pool_.data(),
-                        nullptr };
+                        nullptr, OC_MEMB_STATE_INIT };
 #endif /* OC_DYNAMIC_ALLOCATION */
 };
@@ -793,6 +793,32 @@ TEST_F(TestEndpoint, ComparePv4)
 }
 #endif /* OC_IPV4 */
 
+TEST_F(TestEndpoint, Hash)
+{
+  auto hash = [](const std::string &addr) {
+    oc_endpoint_t ep = oc::endpoint::FromString(addr);
+    return oc_endpoint_hash(&ep);
+  };
+  EXPECT_EQ(hash("coap://[fe80::]:1337"), hash("coap://[fe80::]:1337"));
+  EXPECT_NE(hash("coap://[fe80::]:1337"), hash("coap://[fe80::]:1338"));
+  EXPECT_NE(hash("coap://[fe80::]:1337"), hash("coap://[fe80::1]:1337"));
+  EXPECT_NE(hash("coap://[fe80::]:1337"), hash("coaps://[fe80::]:1337"));
+#ifdef OC_IPV4
+  EXPECT_EQ(hash("coap://127.0.0.1:1337"), hash("coap://127.0.0.1:1337"));
+  EXPECT_NE(hash("coap://127.0.0.1:1337"), hash("coap://127.0.0.2:1337"));
+#endif /* OC_IPV4 */
+
+  // flags ignored by oc_endpoint_compare are ignored by the hash
+  oc_endpoint_t ep1 = oc::endpoint::FromString("coap://[fe80::]:1337");
+  oc_endpoint_t ep2 = ep1;
+  ep2.flags = static_cast<transport_flags>(ep2.flags | ACCEPTED);
+  ep2.interface_index = 42;
+  ASSERT_EQ(0, oc_endpoint_compare(&ep1, &ep2));
+  EXPECT_EQ(oc_endpoint_hash(&ep1), oc_endpoint_hash(&ep2));
+  ep2.device = 1;
+  EXPECT_NE(oc_endpoint_hash(&ep1), oc_endpoint_hash(&ep2));
+}
+
 TEST_F(TestEndpoint, ListCopy)
 {
   oc_endpoint_t *eps_copy = nullptr;
@@ -32,6 +32,7 @@
 #include "oc_config.h"
 #include "oc_core_res.h"
 #include "port/oc_log_internal.h"
+#include "tests/gtest/Benchmark.h"
 #include "tests/gtest/Device.h"
 #include "tests/gtest/RepPool.h"
 #include "tests/gtest/Resource.h"
@@ -980,6 +981,141 @@ TEST_F(TestETagWithServer, LoadAndClear_Fail)
   ASSERT_EQ(0, oc::TestStorage.Config());
 }
 
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+
+TEST_F(TestETagWithServer, CachedCRC64)
+{
+  oc_resource_t *plt = oc_core_get_resource_by_index(OCF_P, 0);
+  ASSERT_NE(nullptr, plt);
+  oc_platform_info_t *plti = oc_core_get_platform_info();
+  ASSERT_NE(nullptr, plti);
+  oc_uuid_t pi = plti->pi;
+
+  uint64_t crc64_1 = 0;
+  ASSERT_EQ(OC_RESOURCE_CRC64_OK, oc_resource_get_cached_crc64(plt, &crc64_1));
+  EXPECT_NE(0, plt->etag_flags & OC_ETAG_FLAG_CRC64_CACHED);
+
+  // the payload changed without a report, the cached checksum is used
+  do {
+    oc_gen_uuid(&plti->pi);
+  } while (oc_uuid_is_equal(pi, plti->pi));
+  uint64_t crc64_2 = 0;
+  ASSERT_EQ(OC_RESOURCE_CRC64_OK, oc_resource_get_cached_crc64(plt, &crc64_2));
+  EXPECT_EQ(crc64_1, crc64_2);
+
+  // the change is reported, the checksum is calculated again
+  oc_resource_update_etag(plt);
+  EXPECT_EQ(0, plt->etag_flags & OC_ETAG_FLAG_CRC64_CACHED);
+  EXPECT_NE(0, plt->etag_flags & OC_ETAG_FLAG_STORE_PENDING);
+  uint64_t crc64_3 = 0;
+  ASSERT_EQ(OC_RESOURCE_CRC64_OK, oc_resource_get_cached_crc64(plt, &crc64_3));
+  EXPECT_NE(crc64_1, crc64_3);
+
+  plti->pi = pi;
+  oc_resource_update_etag(plt);
+}
+
+TEST_F(TestETagWithServer, DumpDirty)
+{
+  ASSERT_TRUE(oc_etag_dump());
+  ASSERT_TRUE(oc_etag_clear_storage());
+
+  // nothing has changed, nothing is written
+  EXPECT_TRUE(oc_etag_dump_dirty());
+  for (size_t i = 0; i < oc_core_get_num_devices(); ++i) {
+    EXPECT_TRUE(isETagStorageEmpty(i));
+  }
+  EXPECT_TRUE(isETagStorageEmpty(0, true));
+
+  // only the store of the changed resource is written
+  oc_resource_t *dev = oc_core_get_resource_by_index(OCF_D, kDeviceID1);
+  ASSERT_NE(nullptr, dev);
+  oc_resource_update_etag(dev);
+  EXPECT_TRUE(oc_etag_dump_dirty());
+  EXPECT_FALSE(isETagStorageEmpty(kDeviceID1));
+  EXPECT_TRUE(isETagStorageEmpty(0, true));
+  EXPECT_EQ(0, dev->etag_flags & OC_ETAG_FLAG_STORE_PENDING);
+#ifdef OC_DYNAMIC_ALLOCATION
+  EXPECT_TRUE(isETagStorageEmpty(kDeviceID2));
+#endif // OC_DYNAMIC_ALLOCATION
+}
+
+TEST_F(TestETagWithServer, DumpDirtyAtEndOfPollCycle)
+{
+  ASSERT_TRUE(oc_etag_clear_storage());
+
+  oc_resource_t *plt = oc_core_get_resource_by_index(OCF_P, 0);
+  ASSERT_NE(nullptr, plt);
+  oc_resource_update_etag(plt);
+  oc_resource_update_etag(plt);
+  EXPECT_TRUE(isETagStorageEmpty(0, true));
+
+  oc::TestDevice::PoolEventsMsV1(10ms);
+  EXPECT_FALSE(isETagStorageEmpty(0, true));
+  EXPECT_EQ(0, plt->etag_flags & OC_ETAG_FLAG_STORE_PENDING);
+}
+
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+TEST_F(TestETagWithServer, BenchmarkStartup)
+{
+  // the stores of all resources must fit into the storage buffer
+  oc_set_max_app_data_size(1024 * 1024);
+
+  constexpr int kResources = 5000;
+  std::vector<oc_resource_t *> dynResources{};
+  dynResources.reserve(kResources);
+  for (int i = 0; i < kResources; ++i) {
+    auto *dyn = addDynamicResource("Bench", "/bench/" + std::to_string(i),
+                                   { "oic.d.bench" },
+                                   { OC_IF_BASELINE, OC_IF_R }, kDeviceID1);
+    ASSERT_NE(nullptr, dyn);
+    dynResources.push_back(dyn);
+  }
+
+  auto dropCachedCRC64 = []() {
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+    // nothing is cached at startup
+    oc::IterateAllResources(
+      [](oc_resource_t *resource) { resource->etag_flags = 0; });
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+  };
+
+  oc::Benchmark("ETag.Dump", 3, [&dropCachedCRC64](size_t) {
+    dropCachedCRC64();
+    EXPECT_TRUE(oc_etag_dump());
+  });
+  std::vector<uint64_t> etags{};
+  for (const auto *dyn : dynResources) {
+    etags.push_back(oc_resource_get_etag(dyn));
+  }
+  oc::Benchmark("ETag.LoadFromStorage", 3, [&dropCachedCRC64](size_t) {
+    dropCachedCRC64();
+    EXPECT_TRUE(oc_etag_load_from_storage(false));
+  });
+  for (size_t i = 0; i < dynResources.size(); ++i) {
+    EXPECT_EQ(etags[i], oc_resource_get_etag(dynResources[i]));
+  }
+
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+  // a change of a single resource rewrites the store with cached checksums
+  oc::Benchmark("ETag.DumpDirty", 3, [&dynResources](size_t i) {
+    oc_resource_update_etag(dynResources[i]);
+    EXPECT_TRUE(oc_etag_dump_dirty());
+  });
+#endif /* OC_HAS_FEATURE_ETAG_DIRTY_TRACKING */
+
+  // clean-up
+  for (auto *dr : dynResources) {
+    ASSERT_TRUE(oc::TestDevice::ClearDynamicResource(dr, true));
+  }
+  oc_set_max_app_data_size(16384);
+}
+
+#endif // OC_DYNAMIC_ALLOCATION
+
 #endif // OC_STORAGE
 
 #ifdef OC_HAS_FEATURE_CRC_ENCODER
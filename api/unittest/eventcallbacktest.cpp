@@ -33,6 +33,7 @@
 #include "util/oc_etimer_internal.h"
 #include "util/oc_features.h"
 #include "util/oc_process_internal.h"
+#include "tests/gtest/Benchmark.h"
 #include "tests/gtest/Clock.h"
 #include "tests/gtest/Device.h"
 #include "tests/gtest/RepPool.h"
@@ -321,6 +322,39 @@ TEST_F(TestTimedEventCallback, RemoveProcessedCallbackByFilter)
   EXPECT_FALSE(oc_ri_has_timed_event_callback(&ctx, callback_with_ctx, false));
 }
 
+#ifdef OC_DYNAMIC_ALLOCATION
+
+/** dispatch of an expired callback must not walk all pending callbacks */
+TEST_F(TestTimedEventCallback, Benchmark)
+{
+  constexpr size_t kCallbacks = 100000;
+  std::vector<char> data(kCallbacks, '\0');
+  oc::Benchmark("add " + std::to_string(kCallbacks) + " callbacks", kCallbacks,
+                [&data](size_t i) {
+                  oc_ri_add_timed_event_callback_ticks(
+                    &data[i], stopCallback,
+                    oc::DurationToTicks(1h) + i);
+                });
+
+  constexpr size_t kDispatched = 1000;
+  size_t invoked = 0;
+  oc::Benchmark("dispatch with " + std::to_string(kCallbacks) +
+                  " pending callbacks",
+                kDispatched, [&invoked](size_t) {
+                  bool done = false;
+                  oc_ri_add_timed_event_callback_ticks(&done, stopCallback, 0);
+                  Poll();
+                  if (done) {
+                    ++invoked;
+                  }
+                });
+  EXPECT_EQ(kDispatched, invoked);
+  EXPECT_TRUE(oc_ri_has_timed_event_callback(&data[kCallbacks - 1],
+                                             stopCallback, false));
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
 #ifdef OC_SERVER
 
 static constexpr size_t kDeviceID{ 0 };
@@ -466,7 +500,7 @@ public:
     oc_resource_bind_resource_interface(
       res, static_cast<oc_interface_mask_t>(OC_IF_BASELINE | OC_IF_R));
     oc_resource_set_default_interface(res, OC_IF_R);
-    oc_resource_set_request_handler(res, OC_GET, onGet, res);
+    oc_resource_set_request_handler(res, OC_GET, onGet, &get_count_);
 #ifdef OC_SECURITY
     oc_resource_make_public(res);
 #ifdef OC_HAS_FEATURE_RESOURCE_ACCESS_IN_RFOTM
@@ -516,11 +550,13 @@ public:
 
 #if defined(OC_SERVER) && defined(OC_COLLECTIONS)
   static Switches switches_;
+  static int get_count_;
 #endif // OC_SERVER && OC_COLLECTIONS
 };
 
 #if defined(OC_SERVER) && defined(OC_COLLECTIONS)
 Switches TestObserveCallbackWithServer::switches_{};
+int TestObserveCallbackWithServer::get_count_{ 0 };
 #endif // OC_SERVER && OC_COLLECTIONS
 
 TEST_F(TestObserveCallbackWithServer, Observe)
@@ -0,0 +1,117 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+
+#include "api/oc_network_events_internal.h"
+#include "api/oc_ri_internal.h"
+#include "api/oc_runtime_internal.h"
+#include "oc_buffer.h"
+#include "port/oc_network_event_handler_internal.h"
+#include "tests/gtest/Endpoint.h"
+#include "util/oc_memb.h"
+
+#include <array>
+#include <cstring>
+#include <gtest/gtest.h>
+
+constexpr size_t kTestMessagesPoolSize = OC_NETWORK_EVENT_QUEUE_SIZE + 16;
+OC_MEMB(oc_network_events_test_messages, oc_message_t, kTestMessagesPoolSize);
+
+class TestNetworkEvents : public testing::Test {
+public:
+  static void SetUpTestCase()
+  {
+    oc_memb_init(&oc_network_events_test_messages);
+  }
+
+  void SetUp() override
+  {
+    oc_network_event_handler_mutex_init();
+    oc_runtime_init();
+    oc_ri_init();
+    oc_network_events_reset_stats();
+  }
+
+  void TearDown() override
+  {
+    oc_ri_shutdown();
+    oc_runtime_shutdown();
+    oc_network_event_handler_mutex_destroy();
+  }
+
+  static oc_message_t *NewMessage(const oc_endpoint_t &endpoint)
+  {
+    oc_message_t *message =
+      oc_allocate_message_from_pool(&oc_network_events_test_messages);
+    if (message == nullptr) {
+      return nullptr;
+    }
+    // NON GET request with message ID 1
+    std::array<uint8_t, 4> header{ 0x50, 0x01, 0x00, 0x01 };
+    memcpy(message->data, header.data(), header.size());
+    message->length = header.size();
+    memcpy(&message->endpoint, &endpoint, sizeof(oc_endpoint_t));
+    return message;
+  }
+};
+
+TEST_F(TestNetworkEvents, Overflow)
+{
+  oc_endpoint_t ep1 = oc::endpoint::FromString("coap://[::1]:42");
+  oc_endpoint_t ep2 = oc::endpoint::FromString("coap://[::1]:43");
+
+  // the events which do not fit into the queue are kept in the overflow list
+  for (size_t i = 0; i < kTestMessagesPoolSize; ++i) {
+    oc_message_t *message = NewMessage(i % 2 == 0 ? ep1 : ep2);
+    ASSERT_NE(nullptr, message);
+    oc_network_receive_event(message);
+  }
+  oc_network_events_stats_t stats = oc_network_events_get_stats();
+  EXPECT_EQ(OC_NETWORK_EVENT_QUEUE_SIZE, stats.queued);
+  EXPECT_EQ(kTestMessagesPoolSize - OC_NETWORK_EVENT_QUEUE_SIZE,
+            stats.overflowed);
+
+  // events are dropped both from the queue and from the overflow list
+  EXPECT_EQ(kTestMessagesPoolSize / 2, oc_network_drop_receive_events(&ep1));
+  EXPECT_EQ(0, oc_network_drop_receive_events(&ep1));
+  EXPECT_EQ(kTestMessagesPoolSize / 2, oc_network_drop_receive_events(&ep2));
+  EXPECT_EQ(0, oc_memb_get_stats(&oc_network_events_test_messages).in_use);
+
+  oc_network_events_reset_stats();
+  stats = oc_network_events_get_stats();
+  EXPECT_EQ(0, stats.queued);
+  EXPECT_EQ(0, stats.overflowed);
+  EXPECT_EQ(0, stats.max_queued);
+}
+
+TEST_F(TestNetworkEvents, NotRunning)
+{
+  oc_ri_shutdown();
+  oc_endpoint_t ep = oc::endpoint::FromString("coap://[::1]:42");
+  oc_message_t *message = NewMessage(ep);
+  ASSERT_NE(nullptr, message);
+  oc_network_receive_event(message);
+  EXPECT_EQ(0, oc_network_events_get_stats().queued);
+  EXPECT_EQ(0, oc_memb_get_stats(&oc_network_events_test_messages).in_use);
+  oc_ri_init();
+}
+
+#endif /* OC_HAS_FEATURE_NETWORK_EVENT_QUEUE */
@@ -0,0 +1,287 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+
+#include "api/oc_notification_scheduler_internal.h"
+#include "api/oc_server_api_internal.h"
+#include "messaging/coap/observe_internal.h"
+#include "messaging/coap/transactions_internal.h"
+#include "oc_api.h"
+#include "oc_notification_scheduler.h"
+#include "port/oc_random.h"
+#include "tests/gtest/Benchmark.h"
+#include "tests/gtest/Device.h"
+
+#ifdef OC_SECURITY
+#include "security/oc_security_internal.h"
+#endif /* OC_SECURITY */
+
+#include <array>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace std::chrono_literals;
+
+static constexpr size_t kDeviceID{ 0 };
+
+class TestNotificationScheduler : public testing::Test {
+public:
+  static void SetUpTestCase() { ASSERT_TRUE(oc::TestDevice::StartServer()); }
+
+  static void TearDownTestCase() { oc::TestDevice::StopServer(); }
+
+  void SetUp() override
+  {
+    oc::DynamicResourceHandler handlers{};
+    handlers.onGet = onGet;
+    auto dr = oc::makeDynamicResourceToAdd(
+      "Sensor", "/sensor", { "oic.r.sensor" }, { OC_IF_BASELINE, OC_IF_R },
+      handlers, OC_OBSERVABLE);
+    resource_ = oc::TestDevice::AddDynamicResource(dr, kDeviceID);
+    ASSERT_NE(nullptr, resource_);
+    oc_resource_set_default_interface(resource_, OC_IF_R);
+    get_count_ = 0;
+    oc_notification_scheduler_reset_metrics();
+#ifdef OC_SECURITY
+    // must be in RFNOP to send notifications
+    oc_sec_self_own(kDeviceID);
+#endif /* OC_SECURITY */
+  }
+
+  void TearDown() override
+  {
+    oc_notification_scheduler_free_all();
+    coap_free_all_observers();
+    coap_free_all_transactions();
+#ifdef OC_SECURITY
+    oc_sec_self_disown(kDeviceID);
+#endif /* OC_SECURITY */
+    oc::TestDevice::ClearDynamicResource(resource_);
+    oc::TestDevice::Reset();
+  }
+
+  static void onGet(oc_request_t *request, oc_interface_mask_t, void *)
+  {
+    // the checksum of the payload for the ETag store is calculated by a GET
+    // request without an origin, count only the requests of observers
+    if (request->origin != nullptr) {
+      ++get_count_;
+    }
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, 42);
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+  }
+
+  /** add an observer from a client at given port of the device's endpoint */
+  coap_observer_t *addObserver(uint16_t port = 40000)
+  {
+    auto epOpt = oc::TestDevice::GetEndpoint(kDeviceID);
+    if (!epOpt.has_value()) {
+      return nullptr;
+    }
+    if ((epOpt->flags & IPV6) != 0) {
+      epOpt->addr.ipv6.port = port;
+    }
+#ifdef OC_IPV4
+    if ((epOpt->flags & IPV4) != 0) {
+      epOpt->addr.ipv4.port = port;
+    }
+#endif /* OC_IPV4 */
+    std::array<uint8_t, COAP_TOKEN_LEN> token;
+    oc_random_buffer(token.data(), token.size());
+    std::string uri = &oc_string(resource_->uri)[1];
+    return coap_add_observer(resource_, 1024, &*epOpt, token.data(),
+                             token.size(), uri.c_str(), uri.length(), OC_IF_R);
+  }
+
+  oc_resource_t *resource_{};
+  static int get_count_;
+};
+
+int TestNotificationScheduler::get_count_{ 0 };
+
+TEST_F(TestNotificationScheduler, NoPolicy)
+{
+  ASSERT_NE(nullptr, addObserver());
+  EXPECT_EQ(1, oc_notify_observers(resource_));
+  EXPECT_EQ(1, get_count_);
+  oc_notification_metrics_t metrics = oc_notification_scheduler_get_metrics();
+  EXPECT_EQ(0, metrics.scheduled);
+  EXPECT_EQ(0, metrics.sent);
+}
+
+TEST_F(TestNotificationScheduler, Coalesce)
+{
+  ASSERT_NE(nullptr, addObserver());
+  oc_notification_policy_t policy{};
+  policy.coalesce_ms = 50;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+
+  constexpr int kChanges = 10;
+  for (int i = 0; i < kChanges; ++i) {
+    EXPECT_EQ(0, oc_notify_observers(resource_));
+  }
+  EXPECT_EQ(0, get_count_);
+  oc_notification_metrics_t metrics = oc_notification_scheduler_get_metrics();
+  EXPECT_EQ(1, metrics.scheduled);
+  EXPECT_EQ(kChanges - 1, metrics.coalesced);
+
+  oc::TestDevice::PoolEventsMsV1(200ms);
+  EXPECT_EQ(1, get_count_);
+  metrics = oc_notification_scheduler_get_metrics();
+  EXPECT_EQ(1, metrics.sent);
+}
+
+TEST_F(TestNotificationScheduler, MinimalInterval)
+{
+  ASSERT_NE(nullptr, addObserver());
+  oc_notification_policy_t policy{};
+  policy.pmin_ms = 300;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+
+  oc_notify_observers(resource_);
+  oc::TestDevice::PoolEventsMsV1(50ms);
+  EXPECT_EQ(1, get_count_);
+
+  // the second change is sent after pmin elapses
+  oc_notify_observers(resource_);
+  oc::TestDevice::PoolEventsMsV1(50ms);
+  EXPECT_EQ(1, get_count_);
+  oc::TestDevice::PoolEventsMsV1(400ms);
+  EXPECT_EQ(2, get_count_);
+  oc::TestDevice::DropOutgoingMessages();
+}
+
+TEST_F(TestNotificationScheduler, MaximalInterval)
+{
+  ASSERT_NE(nullptr, addObserver());
+  oc_notification_policy_t policy{};
+  policy.pmax_ms = 100;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+
+  oc::TestDevice::PoolEventsMsV1(250ms);
+  oc::TestDevice::DropOutgoingMessages();
+  oc_notification_metrics_t metrics = oc_notification_scheduler_get_metrics();
+  EXPECT_LE(1, metrics.periodic);
+  EXPECT_EQ(static_cast<int>(metrics.periodic), get_count_);
+}
+
+TEST_F(TestNotificationScheduler, MaximalIntervalNotObserved)
+{
+  oc_notification_policy_t policy{};
+  policy.pmax_ms = 50;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+
+  oc::TestDevice::PoolEventsMsV1(200ms);
+  EXPECT_EQ(0, get_count_);
+  EXPECT_EQ(0, oc_notification_scheduler_get_metrics().periodic);
+}
+
+TEST_F(TestNotificationScheduler, ObserverMinimalInterval)
+{
+  coap_observer_t *obs = addObserver();
+  ASSERT_NE(nullptr, obs);
+  obs->pmin = 300 * OC_CLOCK_SECOND / 1000;
+
+  // the response to the registration was the last notification
+  oc_notify_observers(resource_);
+  EXPECT_EQ(0, get_count_);
+  oc_notification_metrics_t metrics = oc_notification_scheduler_get_metrics();
+  EXPECT_EQ(1, metrics.deferred);
+  EXPECT_TRUE(obs->pending);
+
+  oc::TestDevice::PoolEventsMsV1(500ms);
+  EXPECT_EQ(1, get_count_);
+  EXPECT_FALSE(obs->pending);
+  oc::TestDevice::DropOutgoingMessages();
+}
+
+TEST_F(TestNotificationScheduler, RemovePolicy)
+{
+  ASSERT_NE(nullptr, addObserver());
+  oc_notification_policy_t policy{};
+  policy.coalesce_ms = 1000;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+  EXPECT_EQ(0, oc_notify_observers(resource_));
+  EXPECT_EQ(0, get_count_);
+
+  oc_resource_remove_notification_policy(resource_);
+  EXPECT_EQ(1, oc_notify_observers(resource_));
+  EXPECT_EQ(1, get_count_);
+}
+
+TEST_F(TestNotificationScheduler, ClearResource)
+{
+  ASSERT_NE(nullptr, addObserver());
+  oc_notification_policy_t policy{};
+  policy.coalesce_ms = 50;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+  EXPECT_EQ(0, oc_notify_observers(resource_));
+
+  // queued notifications and the policy are removed
+  oc_notify_clear(resource_);
+  oc::TestDevice::PoolEventsMsV1(200ms);
+  EXPECT_EQ(0, get_count_);
+  EXPECT_EQ(1, oc_notify_observers(resource_));
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+/** a burst of changes of an observed resource, with the policy the observers
+ * get a single notification per coalescing window */
+TEST_F(TestNotificationScheduler, Benchmark)
+{
+  constexpr int kObservers = 10;
+  for (int i = 0; i < kObservers; ++i) {
+    ASSERT_NE(nullptr, addObserver(static_cast<uint16_t>(40000 + i)));
+  }
+  constexpr size_t kChanges = 1000;
+  auto immediate =
+    oc::Benchmark("notify change", kChanges, [this, kObservers](size_t) {
+      ASSERT_EQ(kObservers, oc_notify_observers(resource_));
+      oc::TestDevice::DropOutgoingMessages();
+      coap_free_all_transactions();
+    });
+  int immediate_gets = get_count_;
+
+  oc_notification_policy_t policy{};
+  policy.coalesce_ms = 10;
+  ASSERT_TRUE(oc_resource_set_notification_policy(resource_, policy));
+  get_count_ = 0;
+  auto scheduled = oc::Benchmark("schedule change", kChanges, [this](size_t) {
+    ASSERT_EQ(0, oc_notify_observers(resource_));
+  });
+  oc::TestDevice::PoolEventsMsV1(100ms);
+  oc::TestDevice::DropOutgoingMessages();
+  oc_notification_metrics_t metrics = oc_notification_scheduler_get_metrics();
+  EXPECT_EQ(kChanges, metrics.scheduled + metrics.coalesced);
+  printf("[ BENCH    ] %zu changes: %d GET handler calls immediately, %d "
+         "scheduled (%u notifications, %u coalesced), %.0fx less time per "
+         "change\n",
+         kChanges, immediate_gets, get_count_, metrics.sent,
+         metrics.coalesced, immediate.NsPerOp() / scheduled.NsPerOp());
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
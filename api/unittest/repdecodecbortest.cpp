@@ -22,8 +22,10 @@
 #include "oc_config.h"
 #include "oc_helpers.h"
 #include "port/oc_log_internal.h"
+#include "tests/gtest/Benchmark.h"
 #include "tests/gtest/RepPool.h"
 #include "tests/gtest/Utility.h"
+#include "util/oc_features.h"
 
 #include <array>
 #include <gtest/gtest.h>
@@ -35,20 +37,20 @@ public:
   {
     oc_rep_set_pool(&rep_objects_);
 #ifndef OC_DYNAMIC_ALLOCATION
-    memset(rep_objects_alloc_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(char));
-    memset(rep_objects_pool_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
+    oc_memb_init(&rep_objects_);
 #endif /* !OC_DYNAMIC_ALLOCATION */
   }
 
 private:
 #ifdef OC_DYNAMIC_ALLOCATION
-  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr };
+  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr,
+                        OC_MEMB_STATE_INIT };
 #else  /* !OC_DYNAMIC_ALLOCATION */
   char rep_objects_alloc_[OC_MAX_NUM_REP_OBJECTS];
   oc_rep_t rep_objects_pool_[OC_MAX_NUM_REP_OBJECTS];
   oc_memb rep_objects_{ sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                         rep_objects_alloc_, (void *)rep_objects_pool_,
-                        nullptr };
+                        nullptr, OC_MEMB_STATE_INIT };
 #endif /* OC_DYNAMIC_ALLOCATION */
 };
 
@@ -100,3 +102,42 @@ TEST_F(TestRepDecodeCbor, DecodeRootEmptyObject)
   EXPECT_EQ(OC_REP_PARSE_RESULT_REP, result.type);
   EXPECT_EQ(nullptr, result.rep);
 }
+
+/** parse and free a payload that takes a large part of the byte pool */
+TEST_F(TestRepDecodeCbor, Benchmark)
+{
+  CborEncoder encoder;
+  std::array<uint8_t, 2048> buffer{};
+  cbor_encoder_init(&encoder, &buffer[0], buffer.size(), 0);
+  CborEncoder object;
+  ASSERT_EQ(CborNoError,
+            cbor_encoder_create_map(&encoder, &object, CborIndefiniteLength));
+  constexpr int kEntries = 50;
+  for (int i = 0; i < kEntries; ++i) {
+    std::string key = "key" + std::to_string(i);
+    std::string value = "value-" + std::to_string(1000000 + i);
+    ASSERT_EQ(CborNoError, cbor_encode_text_stringz(&object, key.c_str()));
+    ASSERT_EQ(CborNoError, cbor_encode_text_stringz(&object, value.c_str()));
+  }
+  ASSERT_EQ(CborNoError, cbor_encoder_close_container(&encoder, &object));
+  const uint8_t *payload = &buffer[0];
+  size_t size = cbor_encoder_get_buffer_size(&encoder, &buffer[0]);
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  std::string backend = "malloc";
+#elif defined(OC_HAS_FEATURE_MMEM_TLSF)
+  std::string backend = "tlsf";
+#else  /* !OC_DYNAMIC_ALLOCATION && !OC_HAS_FEATURE_MMEM_TLSF */
+  std::string backend = "compacting";
+#endif /* OC_DYNAMIC_ALLOCATION */
+  oc::Benchmark("parse and free " + std::to_string(kEntries) +
+                  " strings, " + backend + " pool",
+                10000, [payload, size](size_t) {
+                  oc_rep_parse_result_t result{};
+                  ASSERT_EQ(CborNoError,
+                            oc_rep_parse_cbor(payload, size, &result));
+                  ASSERT_EQ(OC_REP_PARSE_RESULT_REP, result.type);
+                  ASSERT_NE(nullptr, result.rep);
+                  oc_free_rep(result.rep);
+                });
+}
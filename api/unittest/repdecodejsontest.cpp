@@ -37,20 +37,20 @@ public:
   {
     oc_rep_set_pool(&rep_objects_);
 #ifndef OC_DYNAMIC_ALLOCATION
-    memset(rep_objects_alloc_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(char));
-    memset(rep_objects_pool_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
+    oc_memb_init(&rep_objects_);
 #endif /* !OC_DYNAMIC_ALLOCATION */
   }
 
 private:
 #ifdef OC_DYNAMIC_ALLOCATION
-  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr };
+  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr,
+                        OC_MEMB_STATE_INIT };
 #else  /* !OC_DYNAMIC_ALLOCATION */
   char rep_objects_alloc_[OC_MAX_NUM_REP_OBJECTS];
   oc_rep_t rep_objects_pool_[OC_MAX_NUM_REP_OBJECTS];
   oc_memb rep_objects_{ sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                         rep_objects_alloc_, (void *)rep_objects_pool_,
-                        nullptr };
+                        nullptr, OC_MEMB_STATE_INIT };
 #endif /* OC_DYNAMIC_ALLOCATION */
 };
 
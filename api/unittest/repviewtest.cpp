@@ -0,0 +1,449 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "api/oc_rep_decode_internal.h"
+#include "api/oc_rep_encode_internal.h"
+#include "oc_api.h"
+#include "oc_rep_view.h"
+#include "tests/gtest/Benchmark.h"
+#include "tests/gtest/RepPool.h"
+
+#if defined(OC_SERVER) && defined(OC_CLIENT)
+#include "messaging/coap/transactions_internal.h"
+#include "tests/gtest/Device.h"
+#endif /* OC_SERVER && OC_CLIENT */
+
+#include <array>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+static const oc_rep_encoder_type_t g_rep_default_encoder =
+  oc_rep_encoder_get_type();
+static const oc_rep_decoder_type_t g_rep_default_decoder =
+  oc_rep_decoder_get_type();
+
+class TestRepView : public testing::Test {
+public:
+  static void SetUpTestCase()
+  {
+    oc_rep_encoder_set_type(OC_REP_CBOR_ENCODER);
+    oc_rep_decoder_set_type(OC_REP_CBOR_DECODER);
+  }
+
+  static void TearDownTestCase()
+  {
+    oc_rep_encoder_set_type(g_rep_default_encoder);
+    oc_rep_decoder_set_type(g_rep_default_decoder);
+  }
+
+  static std::vector<uint8_t> encodedPayload()
+  {
+    const uint8_t *payload = oc_rep_get_encoder_buf();
+    int size = oc_rep_get_encoded_payload_size();
+    EXPECT_LT(0, size);
+    return std::vector<uint8_t>(payload, payload + size);
+  }
+
+  /** {"int":-42,"bool":true,"double":3.5,"str":"hello","bstr":h'0102',
+   * "null":null,"obj":{"a":1,"s":"nested"},"arr":[1,"two",{"x":3}]} */
+  std::vector<uint8_t> encodeExample()
+  {
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, int, -42);
+    oc_rep_set_boolean(root, bool, true);
+    oc_rep_set_double(root, double, 3.5);
+    oc_rep_set_text_string(root, str, "hello");
+    std::array<uint8_t, 2> bstr{ 1, 2 };
+    oc_rep_set_byte_string(root, bstr, bstr.data(), bstr.size());
+    oc_rep_set_null(root, null);
+    oc_rep_set_object(root, obj);
+    oc_rep_set_int(obj, a, 1);
+    oc_rep_set_text_string(obj, s, "nested");
+    oc_rep_close_object(root, obj);
+    oc_rep_open_array(root, arr);
+    oc_rep_add_int(arr, 1);
+    oc_rep_add_text_string(arr, "two");
+    oc_rep_object_array_begin_item(arr);
+    oc_rep_set_int(arr, x, 3);
+    oc_rep_object_array_end_item(arr);
+    oc_rep_close_array(root, arr);
+    oc_rep_end_root_object();
+    EXPECT_EQ(CborNoError, oc_rep_get_cbor_errno());
+    return encodedPayload();
+  }
+
+  oc::RepPool pool_{};
+};
+
+TEST_F(TestRepView, Init)
+{
+  oc_rep_view_t view;
+  std::array<uint8_t, 1> integer{ 0x01 };
+  EXPECT_FALSE(oc_rep_view_init(&view, integer.data(), integer.size()));
+  std::array<uint8_t, 1> truncated{ 0xa1 };
+  std::vector<uint8_t> payload = encodeExample();
+  // the map header is valid, but the first key is missing
+  if (oc_rep_view_init(&view, truncated.data(), truncated.size())) {
+    int64_t value;
+    EXPECT_FALSE(oc_rep_view_get_int(&view, "int", &value));
+  }
+
+  ASSERT_TRUE(oc_rep_view_init(&view, payload.data(), payload.size()));
+  EXPECT_TRUE(oc_rep_view_is_object(&view));
+}
+
+TEST_F(TestRepView, Get)
+{
+  std::vector<uint8_t> payload = encodeExample();
+  oc_rep_view_t view;
+  ASSERT_TRUE(oc_rep_view_init(&view, payload.data(), payload.size()));
+
+  int64_t i;
+  ASSERT_TRUE(oc_rep_view_get_int(&view, "int", &i));
+  EXPECT_EQ(-42, i);
+  bool b;
+  ASSERT_TRUE(oc_rep_view_get_bool(&view, "bool", &b));
+  EXPECT_TRUE(b);
+  double d;
+  ASSERT_TRUE(oc_rep_view_get_double(&view, "double", &d));
+  EXPECT_EQ(3.5, d);
+  const char *str;
+  size_t str_size;
+  ASSERT_TRUE(oc_rep_view_get_string(&view, "str", &str, &str_size));
+  EXPECT_EQ("hello", std::string(str, str_size));
+  // the string points to the payload
+  EXPECT_LE(payload.data(), reinterpret_cast<const uint8_t *>(str));
+  EXPECT_GT(payload.data() + payload.size(),
+            reinterpret_cast<const uint8_t *>(str));
+  const uint8_t *bstr;
+  size_t bstr_size;
+  ASSERT_TRUE(oc_rep_view_get_byte_string(&view, "bstr", &bstr, &bstr_size));
+  ASSERT_EQ(2, bstr_size);
+  EXPECT_EQ(1, bstr[0]);
+  EXPECT_EQ(2, bstr[1]);
+  oc_rep_view_value_t value;
+  ASSERT_TRUE(oc_rep_view_find(&view, "null", &value));
+  EXPECT_EQ(OC_REP_NIL, value.type);
+
+  oc_rep_view_t obj;
+  ASSERT_TRUE(oc_rep_view_get_object(&view, "obj", &obj));
+  EXPECT_TRUE(oc_rep_view_is_object(&obj));
+  ASSERT_TRUE(oc_rep_view_get_int(&obj, "a", &i));
+  EXPECT_EQ(1, i);
+  ASSERT_TRUE(oc_rep_view_get_string(&obj, "s", &str, &str_size));
+  EXPECT_EQ("nested", std::string(str, str_size));
+  // properties of the parent are not visible
+  EXPECT_FALSE(oc_rep_view_get_int(&obj, "int", &i));
+
+  oc_rep_view_t arr;
+  ASSERT_TRUE(oc_rep_view_get_array(&view, "arr", &arr));
+  EXPECT_FALSE(oc_rep_view_is_object(&arr));
+  EXPECT_FALSE(oc_rep_view_find(&arr, "x", &value));
+}
+
+TEST_F(TestRepView, GetFail)
+{
+  std::vector<uint8_t> payload = encodeExample();
+  oc_rep_view_t view;
+  ASSERT_TRUE(oc_rep_view_init(&view, payload.data(), payload.size()));
+
+  int64_t i;
+  EXPECT_FALSE(oc_rep_view_get_int(&view, "missing", &i));
+  EXPECT_FALSE(oc_rep_view_get_int(&view, "in", &i));
+  EXPECT_FALSE(oc_rep_view_get_int(&view, "str", &i));
+  bool b;
+  EXPECT_FALSE(oc_rep_view_get_bool(&view, "int", &b));
+  double d;
+  EXPECT_FALSE(oc_rep_view_get_double(&view, "int", &d));
+  const char *str;
+  size_t str_size;
+  EXPECT_FALSE(oc_rep_view_get_string(&view, "bstr", &str, &str_size));
+  const uint8_t *bstr;
+  size_t bstr_size;
+  EXPECT_FALSE(oc_rep_view_get_byte_string(&view, "str", &bstr, &bstr_size));
+  oc_rep_view_t container;
+  EXPECT_FALSE(oc_rep_view_get_object(&view, "arr", &container));
+  EXPECT_FALSE(oc_rep_view_get_array(&view, "obj", &container));
+}
+
+TEST_F(TestRepView, IndefiniteLengthString)
+{
+  // {"s": (_ "a", "b")}
+  std::vector<uint8_t> data{ 0xa1, 0x61, 's',  0x7f, 0x61,
+                             'a',  0x61, 'b', 0xff };
+  oc_rep_view_t view;
+  ASSERT_TRUE(oc_rep_view_init(&view, data.data(), data.size()));
+  const char *str;
+  size_t str_size;
+  EXPECT_FALSE(oc_rep_view_get_string(&view, "s", &str, &str_size));
+}
+
+struct IterateData
+{
+  std::vector<std::string> keys;
+  std::vector<oc_rep_value_type_t> types;
+  size_t stop_after;
+};
+
+static bool
+iterate(const char *key, size_t key_size, const oc_rep_view_value_t *value,
+        void *data)
+{
+  auto *id = static_cast<IterateData *>(data);
+  id->keys.emplace_back(key != nullptr ? std::string(key, key_size) : "");
+  id->types.push_back(value->type);
+  return id->keys.size() < id->stop_after;
+}
+
+TEST_F(TestRepView, Iterate)
+{
+  std::vector<uint8_t> payload = encodeExample();
+  oc_rep_view_t view;
+  ASSERT_TRUE(oc_rep_view_init(&view, payload.data(), payload.size()));
+
+  IterateData data{};
+  data.stop_after = SIZE_MAX;
+  ASSERT_TRUE(oc_rep_view_iterate(&view, iterate, &data));
+  std::vector<std::string> keys{ "int",  "bool", "double", "str",
+                                 "bstr", "null", "obj",    "arr" };
+  EXPECT_EQ(keys, data.keys);
+  std::vector<oc_rep_value_type_t> types{ OC_REP_INT,         OC_REP_BOOL,
+                                          OC_REP_DOUBLE,      OC_REP_STRING,
+                                          OC_REP_BYTE_STRING, OC_REP_NIL,
+                                          OC_REP_OBJECT,      OC_REP_ARRAY };
+  EXPECT_EQ(types, data.types);
+
+  oc_rep_view_t arr;
+  ASSERT_TRUE(oc_rep_view_get_array(&view, "arr", &arr));
+  data = {};
+  data.stop_after = SIZE_MAX;
+  ASSERT_TRUE(oc_rep_view_iterate(&arr, iterate, &data));
+  std::vector<std::string> arr_keys{ "", "", "" };
+  EXPECT_EQ(arr_keys, data.keys);
+  std::vector<oc_rep_value_type_t> arr_types{ OC_REP_INT, OC_REP_STRING,
+                                              OC_REP_OBJECT };
+  EXPECT_EQ(arr_types, data.types);
+
+  // stop the iteration
+  data = {};
+  data.stop_after = 2;
+  ASSERT_TRUE(oc_rep_view_iterate(&view, iterate, &data));
+  EXPECT_EQ(2, data.keys.size());
+}
+
+#ifdef OC_SERVER
+
+TEST_F(TestRepView, RequestPayloadView)
+{
+  std::vector<uint8_t> payload = encodeExample();
+  oc_request_t request{};
+  oc_rep_view_t view;
+  EXPECT_FALSE(oc_get_request_payload_view(&request, &view));
+
+  request._payload = payload.data();
+  request._payload_len = payload.size();
+  request.content_format = APPLICATION_JSON;
+  EXPECT_FALSE(oc_get_request_payload_view(&request, &view));
+
+  request.content_format = APPLICATION_VND_OCF_CBOR;
+  ASSERT_TRUE(oc_get_request_payload_view(&request, &view));
+  int64_t i;
+  ASSERT_TRUE(oc_rep_view_get_int(&view, "int", &i));
+  EXPECT_EQ(-42, i);
+}
+
+#endif /* OC_SERVER */
+
+/** memory taken by a parsed oc_rep_t tree */
+static size_t
+repTreeSize(const oc_rep_t *rep)
+{
+  size_t size = 0;
+  for (; rep != nullptr; rep = rep->next) {
+    size += sizeof(oc_rep_t) + oc_string_len(rep->name) + 1;
+    if (rep->type == OC_REP_STRING || rep->type == OC_REP_BYTE_STRING) {
+      size += oc_string_len(rep->value.string) + 1;
+    }
+    if (rep->type == OC_REP_OBJECT) {
+      size += repTreeSize(rep->value.object);
+    }
+  }
+  return size;
+}
+
+/** read 3 properties of a large payload */
+TEST_F(TestRepView, Benchmark)
+{
+  oc_rep_start_root_object();
+  constexpr int kEntries = 40;
+  for (int i = 0; i < kEntries; ++i) {
+    std::string key = "key" + std::to_string(i);
+    std::string value = "value-" + std::to_string(1000000 + i);
+    oc_rep_encode_text_string(oc_rep_object(root), key.c_str(), key.length());
+    oc_rep_encode_text_string(oc_rep_object(root), value.c_str(),
+                              value.length());
+  }
+  oc_rep_set_int(root, power, 42);
+  oc_rep_set_boolean(root, on, true);
+  oc_rep_set_text_string(root, name, "lamp");
+  oc_rep_end_root_object();
+  ASSERT_EQ(CborNoError, oc_rep_get_cbor_errno());
+  std::vector<uint8_t> payload = encodedPayload();
+
+  oc_rep_set_pool(pool_.GetRepObjectsPool());
+  size_t tree_size = 0;
+  auto tree = oc::Benchmark(
+    "parse oc_rep_t and read 3 properties", 10000,
+    [&payload, &tree_size](size_t) {
+      oc_rep_parse_result_t result{};
+      ASSERT_EQ(CborNoError, oc_rep_parse_payload(payload.data(),
+                                                  payload.size(), &result));
+      ASSERT_EQ(OC_REP_PARSE_RESULT_REP, result.type);
+      int64_t power;
+      bool on;
+      char *name;
+      size_t name_size;
+      ASSERT_TRUE(oc_rep_get_int(result.rep, "power", &power));
+      ASSERT_TRUE(oc_rep_get_bool(result.rep, "on", &on));
+      ASSERT_TRUE(oc_rep_get_string(result.rep, "name", &name, &name_size));
+      tree_size = repTreeSize(result.rep);
+      oc_free_rep(result.rep);
+    });
+  auto view = oc::Benchmark(
+    "view and read 3 properties", 10000, [&payload](size_t) {
+      oc_rep_view_t v;
+      ASSERT_TRUE(oc_rep_view_init(&v, payload.data(), payload.size()));
+      int64_t power;
+      bool on;
+      const char *name;
+      size_t name_size;
+      ASSERT_TRUE(oc_rep_view_get_int(&v, "power", &power));
+      ASSERT_TRUE(oc_rep_view_get_bool(&v, "on", &on));
+      ASSERT_TRUE(oc_rep_view_get_string(&v, "name", &name, &name_size));
+    });
+  printf("[ BENCH    ] %zu bytes payload: oc_rep_t tree takes %zu bytes of "
+         "the pools, the view takes 0 bytes and is %.1fx faster\n",
+         payload.size(), tree_size, tree.NsPerOp() / view.NsPerOp());
+}
+
+#if defined(OC_SERVER) && defined(OC_CLIENT) &&                                \
+  (!defined(OC_SECURITY) || defined(OC_HAS_FEATURE_RESOURCE_ACCESS_IN_RFOTM))
+
+using namespace std::chrono_literals;
+
+static constexpr size_t kDeviceID{ 0 };
+
+class TestRepViewWithServer : public testing::Test {
+public:
+  static void SetUpTestCase() { ASSERT_TRUE(oc::TestDevice::StartServer()); }
+
+  static void TearDownTestCase() { oc::TestDevice::StopServer(); }
+
+  void SetUp() override
+  {
+    oc::DynamicResourceHandler handlers{};
+    handlers.onPost = onPost;
+    auto dr = oc::makeDynamicResourceToAdd(
+      "View", "/view", { "oic.r.view" }, { OC_IF_BASELINE, OC_IF_RW },
+      handlers);
+    resource_ = oc::TestDevice::AddDynamicResource(dr, kDeviceID);
+    ASSERT_NE(nullptr, resource_);
+    oc_resource_set_default_interface(resource_, OC_IF_RW);
+    post_has_payload_ = false;
+    post_value_ = 0;
+
+    auto epOpt = oc::TestDevice::GetEndpoint(kDeviceID);
+    ASSERT_TRUE(epOpt.has_value());
+    ep_ = *epOpt;
+  }
+
+  void TearDown() override
+  {
+    oc::TestDevice::DropOutgoingMessages();
+    coap_free_all_transactions();
+    oc::TestDevice::ClearDynamicResource(resource_);
+    oc::TestDevice::Reset();
+  }
+
+  static void onPost(oc_request_t *request, oc_interface_mask_t, void *)
+  {
+    post_has_payload_ = request->request_payload != nullptr;
+    oc_rep_view_t view;
+    if (!oc_get_request_payload_view(request, &view) ||
+        !oc_rep_view_get_int(&view, "value", &post_value_)) {
+      oc_send_response(request, OC_STATUS_BAD_REQUEST);
+      return;
+    }
+    oc_send_response(request, OC_STATUS_CHANGED);
+  }
+
+  static void onResponse(oc_client_response_t *data)
+  {
+    *static_cast<oc_status_t *>(data->user_data) = data->code;
+    oc::TestDevice::Terminate();
+  }
+
+  static oc_status_t post(int64_t value)
+  {
+    oc_status_t code = OC_STATUS_INTERNAL_SERVER_ERROR;
+    EXPECT_TRUE(oc_init_post(oc_string(resource_->uri), &ep_, nullptr,
+                             onResponse, HIGH_QOS, &code));
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, value);
+    oc_rep_end_root_object();
+    EXPECT_TRUE(oc_do_post());
+    oc::TestDevice::PoolEventsMsV1(2s);
+    return code;
+  }
+
+  static oc_resource_t *resource_;
+  static oc_endpoint_t ep_;
+  static bool post_has_payload_;
+  static int64_t post_value_;
+};
+
+oc_resource_t *TestRepViewWithServer::resource_{};
+oc_endpoint_t TestRepViewWithServer::ep_{};
+bool TestRepViewWithServer::post_has_payload_{ false };
+int64_t TestRepViewWithServer::post_value_{ 0 };
+
+TEST_F(TestRepViewWithServer, Post)
+{
+  EXPECT_EQ(OC_STATUS_CHANGED, post(42));
+  EXPECT_TRUE(post_has_payload_);
+  EXPECT_EQ(42, post_value_);
+}
+
+// the payload of a resource read by the view is not parsed into a tree
+TEST_F(TestRepViewWithServer, PostWithoutTree)
+{
+  oc_resource_set_request_payload_view(resource_, true);
+  EXPECT_EQ(OC_STATUS_CHANGED, post(42));
+  EXPECT_FALSE(post_has_payload_);
+  EXPECT_EQ(42, post_value_);
+
+  oc_resource_set_request_payload_view(resource_, false);
+  EXPECT_EQ(OC_STATUS_CHANGED, post(7));
+  EXPECT_TRUE(post_has_payload_);
+  EXPECT_EQ(7, post_value_);
+}
+
+#endif /* OC_SERVER && OC_CLIENT && (!OC_SECURITY ||                         \
+          OC_HAS_FEATURE_RESOURCE_ACCESS_IN_RFOTM) */
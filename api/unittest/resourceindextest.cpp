@@ -0,0 +1,255 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_RESOURCE_INDEX
+
+#include "api/oc_ri_internal.h"
+#include "api/oc_ri_resource_index_internal.h"
+#include "api/oc_runtime_internal.h"
+#include "oc_api.h"
+#include "oc_collection.h"
+#include "oc_ri.h"
+#include "port/oc_network_event_handler_internal.h"
+#include "port/oc_random.h"
+#include "tests/gtest/Benchmark.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+static constexpr size_t kDeviceID = 0;
+
+class TestResourceIndex : public testing::Test {
+public:
+  void SetUp() override
+  {
+    oc_network_event_handler_mutex_init();
+    oc_runtime_init();
+    oc_ri_init();
+  }
+
+  void TearDown() override
+  {
+    oc_ri_shutdown();
+    oc_runtime_shutdown();
+    oc_network_event_handler_mutex_destroy();
+  }
+
+  static void dummyRequestHandler(oc_request_t *, oc_interface_mask_t, void *)
+  {
+    // no-op
+  }
+
+  static oc_resource_t *addResource(const std::string &uri,
+                                    size_t device = kDeviceID)
+  {
+    oc_resource_t *res = oc_new_resource(nullptr, uri.c_str(), 1, device);
+    if (res == nullptr) {
+      return nullptr;
+    }
+    oc_resource_set_request_handler(res, OC_GET, dummyRequestHandler, nullptr);
+    if (!oc_ri_add_resource(res)) {
+      oc_ri_delete_resource(res);
+      return nullptr;
+    }
+    return res;
+  }
+
+  static oc_resource_t *find(const std::string &uri, size_t device = kDeviceID)
+  {
+    return oc_ri_get_app_resource_by_uri(uri.c_str(), uri.length(), device);
+  }
+};
+
+TEST_F(TestResourceIndex, AddFindRemove)
+{
+  oc_resource_t *res = addResource("/a");
+  ASSERT_NE(nullptr, res);
+  EXPECT_EQ(1, oc_ri_resource_index_count());
+  // leading slash is optional
+  EXPECT_EQ(res, find("/a"));
+  EXPECT_EQ(res, find("a"));
+  EXPECT_EQ(nullptr, find("/b"));
+  EXPECT_EQ(nullptr, find("/a", kDeviceID + 1));
+
+  // resource cannot be indexed twice
+  EXPECT_FALSE(oc_ri_resource_index_add(res, OC_RI_RESOURCE_INDEX_KIND_APP));
+  EXPECT_EQ(1, oc_ri_resource_index_count());
+
+  EXPECT_TRUE(oc_ri_delete_resource(res));
+  EXPECT_EQ(0, oc_ri_resource_index_count());
+  EXPECT_EQ(nullptr, find("/a"));
+  EXPECT_FALSE(oc_ri_resource_index_remove(res));
+}
+
+TEST_F(TestResourceIndex, SameURIDifferentDevice)
+{
+  oc_resource_t *res0 = addResource("/light", 0);
+  ASSERT_NE(nullptr, res0);
+  oc_resource_t *res1 = addResource("/light", 1);
+  ASSERT_NE(nullptr, res1);
+  EXPECT_EQ(res0, find("/light", 0));
+  EXPECT_EQ(res1, find("/light", 1));
+
+  // duplicate URI on the same device is rejected
+  oc_resource_t *dup = oc_new_resource(nullptr, "/light", 1, 0);
+  ASSERT_NE(nullptr, dup);
+  EXPECT_FALSE(oc_ri_add_resource(dup));
+  oc_ri_delete_resource(dup);
+  EXPECT_EQ(res0, find("/light", 0));
+
+  EXPECT_TRUE(oc_ri_delete_resource(res0));
+  EXPECT_EQ(nullptr, find("/light", 0));
+  EXPECT_EQ(res1, find("/light", 1));
+}
+
+TEST_F(TestResourceIndex, DelayedDelete)
+{
+  oc_resource_t *res = addResource("/delayed");
+  ASSERT_NE(nullptr, res);
+  oc_delayed_delete_resource(res);
+  // resource scheduled for deletion is not found, but its URI stays reserved
+  EXPECT_EQ(nullptr, find("/delayed"));
+  EXPECT_TRUE(oc_ri_URI_is_in_use(kDeviceID, "/delayed", strlen("/delayed")));
+}
+
+TEST_F(TestResourceIndex, Rehash)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  constexpr size_t kCount = 100;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  constexpr size_t kCount = OC_MAX_APP_RESOURCES;
+#endif /* OC_DYNAMIC_ALLOCATION */
+  std::vector<oc_resource_t *> resources{};
+  for (size_t i = 0; i < kCount; ++i) {
+    oc_resource_t *res = addResource("/r/" + std::to_string(i));
+    ASSERT_NE(nullptr, res);
+    resources.push_back(res);
+  }
+  EXPECT_EQ(resources.size(), oc_ri_resource_index_count());
+  for (size_t i = 0; i < resources.size(); ++i) {
+    EXPECT_EQ(resources[i], find("/r/" + std::to_string(i)));
+  }
+  for (size_t i = 0; i < resources.size(); i += 2) {
+    EXPECT_TRUE(oc_ri_delete_resource(resources[i]));
+  }
+  for (size_t i = 0; i < resources.size(); ++i) {
+    EXPECT_EQ(i % 2 == 0 ? nullptr : resources[i],
+              find("/r/" + std::to_string(i)));
+  }
+}
+
+#ifdef OC_COLLECTIONS
+
+TEST_F(TestResourceIndex, Collection)
+{
+  oc_resource_t *col = oc_new_collection(nullptr, "/col", 1, kDeviceID);
+  ASSERT_NE(nullptr, col);
+  ASSERT_TRUE(oc_add_collection_v1(col));
+  EXPECT_EQ(col, find("/col"));
+  EXPECT_EQ(reinterpret_cast<oc_collection_t *>(col),
+            oc_get_collection_by_uri("/col", strlen("/col"), kDeviceID));
+  // collections are not returned for the application resources kind
+  EXPECT_EQ(nullptr,
+            oc_ri_resource_index_find("/col", strlen("/col"), kDeviceID,
+                                      OC_RI_RESOURCE_INDEX_KIND_APP));
+
+  oc_resource_t *res = addResource("/res");
+  ASSERT_NE(nullptr, res);
+  EXPECT_EQ(nullptr,
+            oc_get_collection_by_uri("/res", strlen("/res"), kDeviceID));
+
+  oc_delete_collection(col);
+  EXPECT_EQ(nullptr, find("/col"));
+}
+
+TEST(TestResourceIndexWithoutRI, CollectionBeforeInit)
+{
+  // collections can be indexed without initialization of the stack
+  oc_random_init();
+  oc_resource_t *col = oc_new_collection(nullptr, "/col", 1, kDeviceID);
+  ASSERT_NE(nullptr, col);
+  ASSERT_TRUE(oc_add_collection_v1(col));
+  EXPECT_EQ(1, oc_ri_resource_index_count());
+  oc_delete_collection(col);
+  EXPECT_EQ(0, oc_ri_resource_index_count());
+
+  col = oc_new_collection(nullptr, "/col2", 1, kDeviceID);
+  ASSERT_NE(nullptr, col);
+  ASSERT_TRUE(oc_add_collection_v1(col));
+
+  // the collection stays in its list, so it is indexed again on
+  // initialization
+  oc_ri_resource_index_init();
+  EXPECT_EQ(1, oc_ri_resource_index_count());
+  EXPECT_EQ(reinterpret_cast<oc_collection_t *>(col),
+            oc_get_collection_by_uri("/col2", strlen("/col2"), kDeviceID));
+  EXPECT_TRUE(oc_ri_URI_is_in_use(kDeviceID, "/col2", strlen("/col2")));
+  oc_delete_collection(col);
+  EXPECT_EQ(0, oc_ri_resource_index_count());
+  oc_ri_resource_index_deinit();
+  oc_random_destroy();
+}
+
+#endif /* OC_COLLECTIONS */
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+class TestResourceIndexBenchmark : public TestResourceIndex,
+                                   public testing::WithParamInterface<size_t> {
+};
+
+INSTANTIATE_TEST_SUITE_P(ResourceCount, TestResourceIndexBenchmark,
+                         testing::Values(10, 1000, 10000));
+
+TEST_P(TestResourceIndexBenchmark, FindByURI)
+{
+  size_t count = GetParam();
+  std::vector<std::string> uris{};
+  uris.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    uris.push_back("/bench/resource/" + std::to_string(i));
+    ASSERT_NE(nullptr, addResource(uris.back()));
+  }
+
+  constexpr size_t kLookups = 100000;
+  size_t found = 0;
+  oc::Benchmark("find " + std::to_string(count) + " resources", kLookups,
+                [&uris, &found](size_t i) {
+                  const std::string &uri = uris[(i * 7919) % uris.size()];
+                  if (oc_ri_get_app_resource_by_uri(uri.c_str(), uri.length(),
+                                                    kDeviceID) != nullptr) {
+                    ++found;
+                  }
+                });
+  EXPECT_EQ(kLookups, found);
+
+  const std::string missing = "/bench/missing";
+  oc::Benchmark("miss " + std::to_string(count) + " resources", kLookups,
+                [&missing](size_t) {
+                  EXPECT_EQ(nullptr, oc_ri_get_app_resource_by_uri(
+                                       missing.c_str(), missing.length(),
+                                       kDeviceID));
+                });
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#endif /* OC_HAS_FEATURE_RESOURCE_INDEX */
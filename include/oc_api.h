@@ -38,6 +38,7 @@
 #include "oc_export.h"
 #include "oc_link.h"
 #include "oc_rep.h"
+#include "oc_rep_view.h"
 #include "oc_ri.h"
 #include "oc_role.h"
 #include "oc_signal_event_loop.h"
@@ -1601,6 +1602,53 @@ bool oc_get_request_payload_raw(const oc_request_t *request,
                                 const uint8_t **payload, size_t *size,
                                 oc_content_format_t *content_format);
 
+/**
+ * @brief get a read-only view of the CBOR encoded payload of the request
+ *
+ * Properties are read directly from the payload of the request, unlike the
+ * request_payload tree no memory is allocated.
+ *
+ * Example:
+ * ~~~{.c}
+ *     oc_rep_view_t view;
+ *     int64_t value;
+ *     if (oc_get_request_payload_view(request, &view) &&
+ *         oc_rep_view_get_int(&view, "value", &value)) {
+ *         printf("value: %" PRId64 "\n", value);
+ *     }
+ * ~~~
+ *
+ * @param request the request (cannot be NULL)
+ * @param view the view of the payload (cannot be NULL)
+ * @return true on success
+ * @return false the request has no payload or the payload is not a CBOR
+ * encoded object or array
+ *
+ * @see oc_rep_view.h
+ */
+OC_API
+bool oc_get_request_payload_view(const oc_request_t *request,
+                                 oc_rep_view_t *view) OC_NONNULL();
+
+/**
+ * @brief specify that the request handlers of the resource read the payload
+ * only by oc_get_request_payload_view
+ *
+ * The payload of requests to the resource is not parsed into the
+ * request_payload tree, request_payload is always NULL in the request handlers.
+ *
+ * @note the flag is ignored for collections
+ *
+ * @param resource the resource (cannot be NULL)
+ * @param state true to skip parsing of the request_payload tree, false to
+ * parse it (default)
+ *
+ * @see oc_get_request_payload_view
+ */
+OC_API
+void oc_resource_set_request_payload_view(oc_resource_t *resource, bool state)
+  OC_NONNULL();
+
 /**
  * @brief send the request, no processing
  *
@@ -1765,6 +1813,10 @@ void oc_send_separate_response(oc_separate_response_t *handle,
  * @note no need to call oc_notify_observers about resource changes that
  *       result from a PUT, or POST oc_request_callback_t.
  *
+ * @note if the resource has a notification policy (see
+ *       oc_resource_set_notification_policy) the notification is queued and
+ *       `0` is returned
+ *
  * @param[in] resource the oc_resource_t that has a modified property (cannot be
  * NULL)
  *
@@ -0,0 +1,205 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+/**
+ * @file oc_blockwise_stream.h
+ *
+ * @brief Streaming of bodies of block-wise transfers.
+ *
+ * By default the body of a block-wise transfer is reassembled in a buffer of
+ * up to OC_MAX_APP_DATA_SIZE bytes before it is passed to the handler, or it
+ * is encoded to such buffer before its first block is sent. A streamed body is
+ * consumed or produced one block at a time by callbacks instead, so a transfer
+ * holds at most one block in memory regardless of the size of the body.
+ *
+ * The content format of a streamed body is not interpreted by the stack, but
+ * it must be one accepted by the CoAP layer (see coap_udp_parse_message).
+ */
+
+#ifndef OC_BLOCKWISE_STREAM_H
+#define OC_BLOCKWISE_STREAM_H
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+#include "oc_client_state.h"
+#include "oc_endpoint.h"
+#include "oc_export.h"
+#include "oc_ri.h"
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Callback consuming a received body.
+ *
+ * The blocks are passed in order, a retransmitted block is passed only once.
+ *
+ * @param endpoint the peer of the transfer
+ * @param offset offset of the data in the body
+ * @param data the data
+ * @param size size of the data
+ * @param user_data user data
+ * @return true to continue the transfer
+ * @return false to abort the transfer
+ */
+typedef bool (*oc_blockwise_stream_write_fn_t)(const oc_endpoint_t *endpoint,
+                                               uint32_t offset,
+                                               const uint8_t *data,
+                                               size_t size, void *user_data);
+
+/**
+ * @brief Callback producing a sent body.
+ *
+ * The buffer must be filled completely unless it holds the end of the body. A
+ * block can be requested again by the peer, so the callback must be able to
+ * produce the data at any offset it has already produced.
+ *
+ * @param endpoint the peer of the transfer
+ * @param offset offset of the data in the body
+ * @param buffer the buffer to fill
+ * @param buffer_size size of the buffer
+ * @param[out] more set to true if the body continues after the data
+ * @param user_data user data
+ * @return number of bytes written to the buffer
+ * @return -1 to abort the transfer
+ */
+typedef long (*oc_blockwise_stream_read_fn_t)(const oc_endpoint_t *endpoint,
+                                              uint32_t offset, uint8_t *buffer,
+                                              size_t buffer_size, bool *more,
+                                              void *user_data);
+
+/** @brief Callbacks of a streamed body */
+typedef struct oc_blockwise_stream_handler_t
+{
+  oc_blockwise_stream_read_fn_t read;   ///< produce the sent body
+  oc_blockwise_stream_write_fn_t write; ///< consume the received body
+  oc_content_format_t content_format;   ///< content format of the sent body,
+                                        ///< APPLICATION_NOT_DEFINED for
+                                        ///< APPLICATION_VND_OCF_CBOR
+  void *user_data;                      ///< user data of the callbacks
+} oc_blockwise_stream_handler_t;
+
+#ifdef OC_SERVER
+
+/**
+ * @brief Stream the bodies of requests to a resource and of its responses.
+ *
+ * If the write callback is set, the payloads of POST and PUT requests are
+ * passed to it and the POST or PUT handler of the resource is invoked without
+ * a payload once the last block is received. The handler sends the response.
+ *
+ * If the read callback is set, the payload of the response to a GET request
+ * is produced by it and the GET handler of the resource is not invoked. The
+ * response is not observable.
+ *
+ * Bodies are streamed only over UDP, the regular handlers are invoked for
+ * requests received over TCP.
+ *
+ * @param resource the resource (cannot be NULL)
+ * @param handler the callbacks, at least one must be set
+ * @return true on success
+ * @return false the callbacks could not be set
+ */
+OC_API
+bool oc_resource_set_blockwise_stream(oc_resource_t *resource,
+                                      oc_blockwise_stream_handler_t handler)
+  OC_NONNULL();
+
+/**
+ * @brief Stop streaming the bodies of a resource, ongoing transfers are
+ * aborted.
+ *
+ * @param resource the resource (cannot be NULL)
+ */
+OC_API
+void oc_resource_remove_blockwise_stream(const oc_resource_t *resource)
+  OC_NONNULL();
+
+#endif /* OC_SERVER */
+
+#ifdef OC_CLIENT
+
+/**
+ * @brief Issue a GET request and stream the payload of the response.
+ *
+ * The payload is passed to the write callback, the response handler is
+ * invoked without a payload once the last block is received. Streamed
+ * requests are sent only over UDP.
+ *
+ * @param uri the uri of the resource (cannot be NULL)
+ * @param endpoint the endpoint of the server (cannot be NULL)
+ * @param query the query of the request
+ * @param write callback consuming the payload (cannot be NULL)
+ * @param handler the response handler (cannot be NULL)
+ * @param qos the quality of service
+ * @param user_data user data passed to the callback and the handler
+ * @return true the request was dispatched
+ */
+OC_API
+bool oc_do_get_stream(const char *uri, const oc_endpoint_t *endpoint,
+                      const char *query, oc_blockwise_stream_write_fn_t write,
+                      oc_response_handler_t handler, oc_qos_t qos,
+                      void *user_data) OC_NONNULL(1, 2, 4, 5);
+
+/**
+ * @brief Issue a POST request with a streamed payload.
+ *
+ * The payload is produced by the read callback block by block. Streamed
+ * payloads are sent only over UDP.
+ *
+ * @param uri the uri of the resource (cannot be NULL)
+ * @param endpoint the endpoint of the server (cannot be NULL)
+ * @param query the query of the request
+ * @param read callback producing the payload (cannot be NULL)
+ * @param content_format content format of the payload
+ * @param handler the response handler (cannot be NULL)
+ * @param user_data user data passed to the callback and the handler
+ * @return true the request was dispatched
+ */
+OC_API
+bool oc_do_post_stream(const char *uri, const oc_endpoint_t *endpoint,
+                       const char *query, oc_blockwise_stream_read_fn_t read,
+                       oc_content_format_t content_format,
+                       oc_response_handler_t handler, void *user_data)
+  OC_NONNULL(1, 2, 4, 6);
+
+/** @brief Issue a PUT request with a streamed payload, see oc_do_post_stream */
+OC_API
+bool oc_do_put_stream(const char *uri, const oc_endpoint_t *endpoint,
+                      const char *query, oc_blockwise_stream_read_fn_t read,
+                      oc_content_format_t content_format,
+                      oc_response_handler_t handler, void *user_data)
+  OC_NONNULL(1, 2, 4, 6);
+
+#endif /* OC_CLIENT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
+#endif /* OC_BLOCKWISE_STREAM_H */
@@ -37,6 +37,12 @@ extern "C" {
 /**
  * @brief update the ETag value for the resource based on the global ETag value
  *
+ * If the ETag dirty tracking is enabled (OC_ETAG_DIRTY_TRACKING) the cached
+ * checksum of the payload of the resource is dropped and the ETag store of the
+ * resource is written at the end of the poll cycle. The checksum is calculated
+ * by the GET handler of the resource, invoked from the event loop with a
+ * request without an origin.
+ *
  * @param resource resource to update (cannot be NULL)
  */
 OC_API
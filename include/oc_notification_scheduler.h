@@ -0,0 +1,103 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef OC_NOTIFICATION_SCHEDULER_H
+#define OC_NOTIFICATION_SCHEDULER_H
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+
+#include "oc_export.h"
+#include "oc_ri.h"
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Notification policy of a resource.
+ *
+ * Changes of a resource with a policy reported by oc_notify_observers or
+ * oc_notify_resource_changed are not sent immediately. The first change is
+ * queued and all changes until the notification is sent are coalesced into
+ * it. The queue is drained from the event loop.
+ */
+typedef struct oc_notification_policy_t
+{
+  uint32_t coalesce_ms; ///< delay of the notification after the first change
+  uint32_t pmin_ms;     ///< minimal interval between two notifications
+  uint32_t pmax_ms; ///< maximal interval between two notifications of an
+                    ///< observed resource, 0 for no periodic notifications
+} oc_notification_policy_t;
+
+/** @brief Counters of the notification scheduler */
+typedef struct oc_notification_metrics_t
+{
+  uint32_t scheduled; ///< changes queued for a notification
+  uint32_t coalesced; ///< changes merged into an already queued notification
+  uint32_t sent;      ///< notifications of changes sent by the scheduler
+  uint32_t periodic;  ///< notifications sent because pmax elapsed
+  uint32_t deferred;  ///< notifications of an observer postponed by the
+                      ///< minimal interval of the observer
+  uint32_t dropped;   ///< changes and postponed notifications that could not
+                      ///< be queued and were sent immediately
+} oc_notification_metrics_t;
+
+/**
+ * @brief Set the notification policy of a resource.
+ *
+ * @param resource resource (cannot be NULL)
+ * @param policy the policy
+ * @return true on success
+ * @return false the policy could not be allocated
+ */
+OC_API
+bool oc_resource_set_notification_policy(oc_resource_t *resource,
+                                         oc_notification_policy_t policy)
+  OC_NONNULL();
+
+/**
+ * @brief Remove the notification policy of a resource, a queued notification
+ * is dropped and changes are notified immediately again.
+ *
+ * @param resource resource (cannot be NULL)
+ */
+OC_API
+void oc_resource_remove_notification_policy(const oc_resource_t *resource)
+  OC_NONNULL();
+
+/** @brief Get the counters of the notification scheduler */
+OC_API
+oc_notification_metrics_t oc_notification_scheduler_get_metrics(void);
+
+/** @brief Reset the counters of the notification scheduler */
+OC_API
+void oc_notification_scheduler_reset_metrics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
+#endif /* OC_NOTIFICATION_SCHEDULER_H */
@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file oc_rep_view.h
+ *
+ * @brief Read-only view of a CBOR encoded payload.
+ *
+ * Unlike oc_parse_rep the view does not decode the payload to a tree of
+ * oc_rep_t structures. A value is located by walking the encoded payload when
+ * it is requested, nothing is allocated and strings point to the payload
+ * buffer. The buffer must outlive the view.
+ *
+ * Strings encoded in chunks (indefinite length) are not supported by the view.
+ */
+
+#ifndef OC_REP_VIEW_H
+#define OC_REP_VIEW_H
+
+#include "oc_export.h"
+#include "oc_rep.h"
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief View of an encoded object or array */
+typedef struct oc_rep_view_t
+{
+  const uint8_t *data; ///< the encoded container
+  size_t size;         ///< size of the encoded container
+} oc_rep_view_t;
+
+/** @brief Value of a property or of an array item */
+typedef struct oc_rep_view_value_t
+{
+  oc_rep_value_type_t type; ///< OC_REP_NIL, OC_REP_INT, OC_REP_DOUBLE,
+                            ///< OC_REP_BOOL, OC_REP_BYTE_STRING,
+                            ///< OC_REP_STRING, OC_REP_OBJECT or OC_REP_ARRAY
+  union {
+    int64_t integer;
+    bool boolean;
+    double double_p;
+    struct
+    {
+      const char *data; ///< not NUL-terminated
+      size_t size;
+    } string;
+    struct
+    {
+      const uint8_t *data;
+      size_t size;
+    } byte_string;
+    oc_rep_view_t container; ///< object or array
+  } value;
+} oc_rep_view_value_t;
+
+/**
+ * @brief Initialize a view of an encoded object or array.
+ *
+ * @param view view to initialize (cannot be NULL)
+ * @param payload the CBOR encoded payload (cannot be NULL)
+ * @param payload_size size of the payload
+ * @return true on success
+ * @return false the payload does not start with an object or an array
+ */
+OC_API
+bool oc_rep_view_init(oc_rep_view_t *view, const uint8_t *payload,
+                      size_t payload_size) OC_NONNULL();
+
+/** @brief Check if the view is a view of an object */
+OC_API
+bool oc_rep_view_is_object(const oc_rep_view_t *view) OC_NONNULL();
+
+/**
+ * @brief Find a property of an object.
+ *
+ * @param object view of an object (cannot be NULL)
+ * @param key the key of the property (cannot be NULL)
+ * @param[out] value the value of the property (cannot be NULL)
+ * @return true the property was found
+ * @return false the property was not found, the value has an unsupported type
+ * or the payload is malformed
+ */
+OC_API
+bool oc_rep_view_find(const oc_rep_view_t *object, const char *key,
+                      oc_rep_view_value_t *value) OC_NONNULL();
+
+/**
+ * @brief Callback invoked for each property of an object or item of an array
+ *
+ * @param key the key of the property (not NUL-terminated), NULL for an item of
+ * an array
+ * @param key_size size of the key
+ * @param value the value
+ * @param data user data
+ * @return true to continue the iteration
+ * @return false to stop the iteration
+ */
+typedef bool (*oc_rep_view_iterate_fn_t)(const char *key, size_t key_size,
+                                         const oc_rep_view_value_t *value,
+                                         void *data);
+
+/**
+ * @brief Iterate over the properties of an object or the items of an array.
+ *
+ * @param view view of an object or an array (cannot be NULL)
+ * @param fn callback invoked for each property or item (cannot be NULL)
+ * @param data user data passed to the callback
+ * @return true the iteration finished or was stopped by the callback
+ * @return false the payload is malformed or a value has an unsupported type
+ */
+OC_API
+bool oc_rep_view_iterate(const oc_rep_view_t *view, oc_rep_view_iterate_fn_t fn,
+                         void *data) OC_NONNULL(1, 2);
+
+/** @brief Read an integer property, see oc_rep_get_int */
+OC_API
+bool oc_rep_view_get_int(const oc_rep_view_t *object, const char *key,
+                         int64_t *value) OC_NONNULL();
+
+/** @brief Read a boolean property, see oc_rep_get_bool */
+OC_API
+bool oc_rep_view_get_bool(const oc_rep_view_t *object, const char *key,
+                          bool *value) OC_NONNULL();
+
+/** @brief Read a double property, see oc_rep_get_double */
+OC_API
+bool oc_rep_view_get_double(const oc_rep_view_t *object, const char *key,
+                            double *value) OC_NONNULL();
+
+/**
+ * @brief Read a text string property, see oc_rep_get_string
+ *
+ * @note the string points to the payload and it is not NUL-terminated
+ */
+OC_API
+bool oc_rep_view_get_string(const oc_rep_view_t *object, const char *key,
+                            const char **value, size_t *size) OC_NONNULL();
+
+/**
+ * @brief Read a byte string property, see oc_rep_get_byte_string
+ *
+ * @note the byte string points to the payload
+ */
+OC_API
+bool oc_rep_view_get_byte_string(const oc_rep_view_t *object, const char *key,
+                                 const uint8_t **value, size_t *size)
+  OC_NONNULL();
+
+/** @brief Get a view of an object property, see oc_rep_get_object */
+OC_API
+bool oc_rep_view_get_object(const oc_rep_view_t *object, const char *key,
+                            oc_rep_view_t *value) OC_NONNULL();
+
+/** @brief Get a view of an array property */
+OC_API
+bool oc_rep_view_get_array(const oc_rep_view_t *object, const char *key,
+                           oc_rep_view_t *value) OC_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_REP_VIEW_H */
@@ -63,9 +63,11 @@ typedef enum {
   OC_PERIODIC = (1 << 6),     ///< periodical update
   OC_SECURE_MCAST = (1 << 8), ///< secure multicast (oscore)
 #ifdef OC_HAS_FEATURE_RESOURCE_ACCESS_IN_RFOTM
-  OC_ACCESS_IN_RFOTM = (1 << 9) ///< allow access to resource in ready for
-                                ///< ownership transfer method(RFOTM) state
+  OC_ACCESS_IN_RFOTM = (1 << 9), ///< allow access to resource in ready for
+                                 ///< ownership transfer method(RFOTM) state
 #endif
+  OC_REQUEST_PAYLOAD_VIEW = (1 << 10), ///< request payload is read by
+                                       ///< oc_get_request_payload_view
 } oc_resource_properties_t;
 
 /**
@@ -345,6 +347,9 @@ struct oc_resource_s
   oc_enum_t tag_func_desc;           ///< tag (value) for function description
   oc_locn_t tag_locn;                ///< tag (value) for location description
   uint8_t num_observers;             ///< amount of observers
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  struct coap_observer *observers; ///< list of observers of the resource
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
 #ifdef OC_COLLECTIONS
   uint8_t num_links; ///< number of links in the collection
 #ifdef OC_HAS_FEATURE_PUSH
@@ -360,6 +365,10 @@ struct oc_resource_s
 #ifdef OC_HAS_FEATURE_ETAG
   uint64_t etag; ///< entity tag (ETag) for the resource
 #endif
+#ifdef OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+  uint64_t crc64;     ///< cached checksum of the payload
+  uint8_t etag_flags; ///< state of the cached checksum and of the stored ETag
+#endif
 };
 
 typedef struct oc_collection_s oc_collection_t;
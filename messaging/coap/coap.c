@@ -355,8 +355,11 @@ coap_merge_multi_option(char **dst, size_t *dst_len, uint8_t *option,
     (*dst)[*dst_len] = separator;
     *dst_len += 1;
 
-    /* memmove handles 2-byte option headers */
-    memmove((*dst) + (*dst_len), option, option_len);
+    /* the separator replaced a 1-byte option header, the option follows it,
+     * memmove handles longer option headers */
+    if ((uint8_t *)(*dst) + (*dst_len) != option) {
+      memmove((*dst) + (*dst_len), option, option_len);
+    }
 
     *dst_len += option_len;
   } else {
@@ -896,20 +899,16 @@ coap_oscore_parse_outer_option(coap_packet_t *packet,
   return BAD_OPTION_4_02;
 }
 
+/* parse an option of a message which is not a signal message */
 static coap_status_t
-coap_oscore_parse_option(coap_packet_t *packet, uint8_t *current_option,
-                         bool inner, bool outer, bool oscore, bool validate,
-                         unsigned int option_number, size_t option_length)
+coap_oscore_parse_regular_option(coap_packet_t *packet,
+                                 uint8_t *current_option, bool inner,
+                                 bool outer, bool oscore, bool validate,
+                                 unsigned int option_number,
+                                 size_t option_length)
 {
   (void)oscore;
 
-#ifdef OC_TCP
-  if (coap_check_signal_message(packet->code)) {
-    return coap_parse_signal_options(packet, option_number, current_option,
-                                     option_length, inner);
-  }
-#endif /* OC_TCP */
-
   switch (option_number) {
   case COAP_OPTION_CONTENT_FORMAT:
   case COAP_OPTION_ETAG:
@@ -995,22 +994,53 @@ coap_oscore_parse_option(coap_packet_t *packet, uint8_t *current_option,
   return COAP_NO_ERROR;
 }
 
-coap_status_t
-coap_oscore_parse_options(coap_packet_t *packet, const uint8_t *data,
-                          size_t data_len, uint8_t *current_option, bool inner,
-                          bool outer, bool oscore, bool validate)
+static coap_status_t
+coap_oscore_parse_option(coap_packet_t *packet, uint8_t *current_option,
+                         bool inner, bool outer, bool oscore, bool validate,
+                         unsigned int option_number, size_t option_length)
 {
-  if (data_len > UINT32_MAX) {
-    COAP_WRN("message size(%zu) exceeds limit for coap message(%lu)", data_len,
-             (long unsigned)UINT32_MAX);
-    return BAD_REQUEST_4_00;
+#ifdef OC_TCP
+  if (coap_check_signal_message(packet->code)) {
+    return coap_parse_signal_options(packet, option_number, current_option,
+                                     option_length, inner);
   }
+#endif /* OC_TCP */
+  return coap_oscore_parse_regular_option(packet, current_option, inner,
+                                          outer, oscore, validate,
+                                          option_number, option_length);
+}
 
-  /* parse options */
-  memset(packet->options, 0, sizeof(packet->options));
+static bool
+coap_parse_option_extended_field(const uint8_t **current_option,
+                                 const uint8_t *end, size_t *value)
+{
+  if (*value == 13) {
+    if (*current_option + 1 > end) {
+      return false;
+    }
+    *value += (*current_option)[0];
+    *current_option += 1;
+    return true;
+  }
+  if (*value == 14) {
+    if (*current_option + 2 > end) {
+      return false;
+    }
+    *value += 255 + ((size_t)(*current_option)[0] << 8) + (*current_option)[1];
+    *current_option += 2;
+    return true;
+  }
+  return true;
+}
 
+static coap_status_t
+coap_parse_options_sequential(coap_packet_t *packet, const uint8_t *data,
+                              size_t data_len, uint8_t *current_option,
+                              bool inner, bool outer, bool oscore,
+                              bool validate)
+{
   unsigned int option_number = 0;
-  unsigned int option_delta = 0;
+  size_t option_delta = 0;
   size_t option_length = 0;
   coap_status_t last_error = COAP_NO_ERROR;
 
@@ -1032,32 +1062,18 @@ coap_oscore_parse_options(coap_packet_t *packet, const uint8_t *data,
     option_length = current_option[0] & 0x0F;
     ++current_option;
 
-    if (option_delta == 13) {
-      option_delta += current_option[0];
-      ++current_option;
-    } else if (option_delta == 14) {
-      option_delta += 255;
-      option_delta += current_option[0] << 8;
-      ++current_option;
-      option_delta += current_option[0];
-      ++current_option;
-    }
-
-    if (option_length == 13) {
-      option_length += current_option[0];
-      ++current_option;
-    } else if (option_length == 14) {
-      option_length += 255;
-      option_length += current_option[0] << 8;
-      ++current_option;
-      option_length += current_option[0];
-      ++current_option;
+    if (!coap_parse_option_extended_field((const uint8_t **)&current_option,
+                                          data + data_len, &option_delta) ||
+        !coap_parse_option_extended_field((const uint8_t **)&current_option,
+                                          data + data_len, &option_length)) {
+      COAP_WRN("Invalid option - option header exceeds packet length");
+      return BAD_REQUEST_4_00;
     }
 
-    option_number += option_delta;
+    option_number += (unsigned int)option_delta;
 
     if (option_number <= COAP_OPTION_SIZE1) {
-      COAP_DBG("OPTION %u (delta %u, len %zu):", option_number, option_delta,
+      COAP_DBG("OPTION %u (delta %zu, len %zu):", option_number, option_delta,
                option_length);
       SET_OPTION(packet, option_number);
     }
@@ -1086,6 +1102,199 @@ coap_oscore_parse_options(coap_packet_t *packet, const uint8_t *data,
   return last_error;
 }
 
+#ifdef OC_HAS_FEATURE_COAP_FAST_PARSER
+
+/// Number of options indexed by a single pass
+#define COAP_OPTION_INDEX_SIZE (16)
+
+typedef struct
+{
+  unsigned int number;
+  size_t length;
+  uint8_t *value; ///< the value in the message
+} coap_option_entry_t;
+
+typedef struct
+{
+  coap_option_entry_t entries[COAP_OPTION_INDEX_SIZE];
+  size_t count;
+  unsigned int last_number; ///< number of the last indexed option
+  bool invalid;             ///< indexing stopped at an invalid option
+  bool payload;             ///< indexing stopped at the payload marker
+} coap_option_index_t;
+
+/* Find the boundaries of the options without decoding them. Stops at the end
+ * of the options, at an invalid option or when the index is full. Returns the
+ * position following the last indexed option. */
+static uint8_t *
+coap_options_index(coap_option_index_t *index, uint8_t *current_option,
+                   const uint8_t *end)
+{
+  index->count = 0;
+  unsigned int number = index->last_number;
+  while (current_option < end && index->count < COAP_OPTION_INDEX_SIZE) {
+    uint8_t header = current_option[0];
+    if ((header & 0xF0) == 0xF0) {
+      index->payload = true;
+      return current_option + 1;
+    }
+    ++current_option;
+    size_t delta = header >> 4;
+    size_t length = header & 0x0F;
+    // extended fields are rare, so both are checked by a single branch
+    if ((header >= 0xD0 || length >= 13) &&
+        (!coap_parse_option_extended_field((const uint8_t **)&current_option,
+                                           end, &delta) ||
+         !coap_parse_option_extended_field((const uint8_t **)&current_option,
+                                           end, &length))) {
+      index->invalid = true;
+      break;
+    }
+    if (length > (size_t)(end - current_option)) {
+      index->invalid = true;
+      break;
+    }
+    number += (unsigned int)delta;
+    coap_option_entry_t *entry = &index->entries[index->count];
+    entry->number = number;
+    entry->length = length;
+    entry->value = current_option;
+    ++index->count;
+    current_option += length;
+  }
+  index->last_number = number;
+  return current_option;
+}
+
+/* Join a run of indexed options with the same number, the joined value is a
+ * view into the message. Returns the number of joined options. */
+static size_t
+coap_join_indexed_options(const coap_option_entry_t *entries, size_t count,
+                          const char **dst, size_t *dst_len, char separator)
+{
+  char *joined = (char *)*dst;
+  size_t joined_len = *dst_len;
+  unsigned int number = entries[0].number;
+  size_t i = 0;
+  for (; i < count && entries[i].number == number; ++i) {
+    coap_merge_multi_option(&joined, &joined_len, entries[i].value,
+                            entries[i].length, separator);
+  }
+  *dst = joined;
+  *dst_len = joined_len;
+  return i;
+}
+
+static coap_status_t
+coap_parse_options_indexed(coap_packet_t *packet, const uint8_t *data,
+                           size_t data_len, uint8_t *current_option,
+                           bool inner, bool outer, bool oscore, bool validate)
+{
+  const uint8_t *end = data + data_len;
+  coap_option_index_t index;
+  index.last_number = 0;
+  index.invalid = false;
+  index.payload = false;
+  bool join = inner && !validate;
+#ifdef OC_TCP
+  bool is_signal = coap_check_signal_message(packet->code);
+  join = join && !is_signal;
+#endif /* OC_TCP */
+  coap_status_t last_error = COAP_NO_ERROR;
+  while (current_option < end) {
+    current_option = coap_options_index(&index, current_option, end);
+    for (size_t i = 0; i < index.count; ++i) {
+      const coap_option_entry_t *entry = &index.entries[i];
+      if (entry->number <= COAP_OPTION_SIZE1) {
+        SET_OPTION(packet, entry->number);
+      }
+      if (join && entry->number == COAP_OPTION_URI_PATH) {
+        i += coap_join_indexed_options(entry, index.count - i,
+                                       &packet->uri_path,
+                                       &packet->uri_path_len, '/') -
+             1;
+        continue;
+      }
+      if (join && entry->number == COAP_OPTION_URI_QUERY) {
+        i += coap_join_indexed_options(entry, index.count - i,
+                                       &packet->uri_query,
+                                       &packet->uri_query_len, '&') -
+             1;
+        continue;
+      }
+      coap_status_t s;
+#ifdef OC_TCP
+      if (is_signal) {
+        s = coap_parse_signal_options(packet, entry->number, entry->value,
+                                      entry->length, inner);
+      } else
+#endif /* OC_TCP */
+      {
+        s = coap_oscore_parse_regular_option(packet, entry->value, inner,
+                                             outer, oscore, validate,
+                                             entry->number, entry->length);
+      }
+      if (s != COAP_NO_ERROR) {
+        if (!validate || s == BAD_REQUEST_4_00) {
+          return s;
+        }
+        if (last_error < s) {
+          last_error = s;
+        }
+      }
+    }
+    if (index.invalid) {
+      COAP_WRN("Invalid option - option exceeds packet length");
+      return BAD_REQUEST_4_00;
+    }
+    if (index.payload) {
+      packet->payload = current_option;
+      packet->payload_len = (uint32_t)(end - current_option);
+      break;
+    }
+  }
+  return last_error;
+}
+
+coap_status_t
+coap_oscore_parse_options_sequential(coap_packet_t *packet, const uint8_t *data,
+                                     size_t data_len, uint8_t *current_option,
+                                     bool inner, bool outer, bool oscore,
+                                     bool validate)
+{
+  if (data_len > UINT32_MAX) {
+    return BAD_REQUEST_4_00;
+  }
+  memset(packet->options, 0, sizeof(packet->options));
+  return coap_parse_options_sequential(packet, data, data_len, current_option,
+                                       inner, outer, oscore, validate);
+}
+
+#endif /* OC_HAS_FEATURE_COAP_FAST_PARSER */
+
+coap_status_t
+coap_oscore_parse_options(coap_packet_t *packet, const uint8_t *data,
+                          size_t data_len, uint8_t *current_option, bool inner,
+                          bool outer, bool oscore, bool validate)
+{
+  if (data_len > UINT32_MAX) {
+    COAP_WRN("message size(%zu) exceeds limit for coap message(%lu)", data_len,
+             (long unsigned)UINT32_MAX);
+    return BAD_REQUEST_4_00;
+  }
+
+  /* parse options */
+  memset(packet->options, 0, sizeof(packet->options));
+
+#ifdef OC_HAS_FEATURE_COAP_FAST_PARSER
+  return coap_parse_options_indexed(packet, data, data_len, current_option,
+                                    inner, outer, oscore, validate);
+#else  /* !OC_HAS_FEATURE_COAP_FAST_PARSER */
+  return coap_parse_options_sequential(packet, data, data_len, current_option,
+                                       inner, outer, oscore, validate);
+#endif /* OC_HAS_FEATURE_COAP_FAST_PARSER */
+}
+
 #ifdef OC_TCP
 
 void
@@ -1443,6 +1652,216 @@ coap_serialize_message(coap_packet_t *packet, uint8_t *buffer,
                                        false);
 }
 
+#ifdef OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+
+static uint8_t
+coap_int_option_length(uint32_t value)
+{
+  uint8_t length = 0;
+  while (value != 0) {
+    ++length;
+    value >>= 8;
+  }
+  return length;
+}
+
+void
+coap_header_template_reset(coap_header_template_t *tmpl)
+{
+  tmpl->size = 0;
+}
+
+static bool
+coap_header_template_is_supported(const coap_packet_t *packet)
+{
+#ifdef OC_TCP
+  if (packet->transport_type != COAP_TRANSPORT_UDP) {
+    return false;
+  }
+#endif /* OC_TCP */
+  if (packet->code == 0) {
+    return false;
+  }
+  struct
+  {
+    uint8_t options[sizeof(packet->options)];
+  } other;
+  memcpy(other.options, packet->options, sizeof(other.options));
+  UNSET_OPTION(&other, COAP_OPTION_ETAG);
+  UNSET_OPTION(&other, COAP_OPTION_OBSERVE);
+  UNSET_OPTION(&other, COAP_OPTION_CONTENT_FORMAT);
+  for (size_t i = 0; i < sizeof(other.options); ++i) {
+    if (other.options[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool
+coap_header_template_match(const coap_header_template_t *tmpl,
+                           const coap_packet_t *packet)
+{
+  if (tmpl->size == 0 || tmpl->code != packet->code ||
+      tmpl->content_format != packet->content_format ||
+      memcmp(tmpl->options, packet->options, sizeof(tmpl->options)) != 0) {
+    return false;
+  }
+  if ((tmpl->buffer[0] & COAP_HEADER_TOKEN_LEN_MASK) != packet->token_len ||
+      memcmp(&tmpl->buffer[COAP_HEADER_LEN], packet->token,
+             packet->token_len) != 0) {
+    return false;
+  }
+  // the patched values must keep the lengths of the options
+  if (IS_OPTION(packet, COAP_OPTION_OBSERVE) &&
+      coap_int_option_length((uint32_t)packet->observe) != tmpl->observe_len) {
+    return false;
+  }
+  return !IS_OPTION(packet, COAP_OPTION_ETAG) ||
+         packet->etag_len == tmpl->etag_len;
+}
+
+static bool
+coap_header_template_read_option_field(const coap_header_template_t *tmpl,
+                                       size_t *pos, uint8_t nibble,
+                                       size_t *value)
+{
+  if (nibble < 13) {
+    *value = nibble;
+    return true;
+  }
+  if (nibble == 13 && *pos + 1 <= tmpl->size) {
+    *value = 13 + (size_t)tmpl->buffer[*pos];
+    *pos += 1;
+    return true;
+  }
+  if (nibble == 14 && *pos + 2 <= tmpl->size) {
+    *value =
+      269 + ((size_t)tmpl->buffer[*pos] << 8 | (size_t)tmpl->buffer[*pos + 1]);
+    *pos += 2;
+    return true;
+  }
+  return false;
+}
+
+/* Find the values of the patched options in the serialized options */
+static bool
+coap_header_template_find_options(coap_header_template_t *tmpl,
+                                  uint8_t token_len)
+{
+  size_t pos = COAP_HEADER_LEN + token_len;
+  size_t number = 0;
+  while (pos < tmpl->size) {
+    uint8_t header = tmpl->buffer[pos];
+    ++pos;
+    size_t delta = 0;
+    size_t length = 0;
+    if (!coap_header_template_read_option_field(tmpl, &pos, header >> 4,
+                                                &delta) ||
+        !coap_header_template_read_option_field(tmpl, &pos, header & 0x0F,
+                                                &length) ||
+        pos + length > tmpl->size) {
+      return false;
+    }
+    number += delta;
+    if (number == COAP_OPTION_ETAG) {
+      tmpl->etag_offset = (uint8_t)pos;
+      tmpl->etag_len = (uint8_t)length;
+    } else if (number == COAP_OPTION_OBSERVE) {
+      tmpl->observe_offset = (uint8_t)pos;
+      tmpl->observe_len = (uint8_t)length;
+    }
+    pos += length;
+  }
+  return true;
+}
+
+static void
+coap_header_template_set(coap_header_template_t *tmpl,
+                         const coap_packet_t *packet, size_t header_size)
+{
+  tmpl->size = 0;
+  if (header_size > COAP_HEADER_TEMPLATE_MAX_SIZE) {
+    COAP_DBG("header of size %zu cannot be kept by template", header_size);
+    return;
+  }
+  memcpy(tmpl->buffer, packet->buffer, header_size);
+  tmpl->size = (uint8_t)header_size;
+  tmpl->code = packet->code;
+  memcpy(tmpl->options, packet->options, sizeof(tmpl->options));
+  tmpl->content_format = packet->content_format;
+  tmpl->observe_offset = 0;
+  tmpl->observe_len = 0;
+  tmpl->etag_offset = 0;
+  tmpl->etag_len = 0;
+  if (!coap_header_template_find_options(tmpl, packet->token_len)) {
+    COAP_ERR("cannot set template: invalid options");
+    tmpl->size = 0;
+  }
+}
+
+static size_t
+coap_header_template_serialize(const coap_header_template_t *tmpl,
+                               coap_packet_t *packet, uint8_t *buffer,
+                               size_t buffer_size)
+{
+  size_t size = tmpl->size;
+  if (packet->payload_len > 0) {
+    size += COAP_PAYLOAD_MARKER_LEN + packet->payload_len;
+  }
+  if (size > buffer_size) {
+    COAP_ERR("cannot serialize message: no space left (required: %zu, "
+             "available: %zu)",
+             size, buffer_size);
+    packet->buffer = NULL;
+    return 0;
+  }
+  packet->buffer = buffer;
+  packet->version = 1;
+  memcpy(buffer, tmpl->buffer, tmpl->size);
+  coap_udp_set_header_fields(packet);
+  uint32_t observe = (uint32_t)packet->observe;
+  for (size_t i = tmpl->observe_len; i > 0; --i) {
+    buffer[tmpl->observe_offset + i - 1] = (uint8_t)observe;
+    observe >>= 8;
+  }
+  if (tmpl->etag_len > 0) {
+    memcpy(&buffer[tmpl->etag_offset], packet->etag, tmpl->etag_len);
+  }
+  if (packet->payload_len > 0) {
+    buffer[tmpl->size] = COAP_PAYLOAD_MARKER;
+    memmove(&buffer[tmpl->size + COAP_PAYLOAD_MARKER_LEN], packet->payload,
+            packet->payload_len);
+  }
+  COAP_DBG("-Done %zu B from template (header len %u, payload len %u)-", size,
+           (unsigned)tmpl->size, (unsigned)packet->payload_len);
+  return size;
+}
+
+size_t
+coap_serialize_message_with_template(coap_packet_t *packet,
+                                     coap_header_template_t *tmpl,
+                                     uint8_t *buffer, size_t buffer_size)
+{
+  if (!coap_header_template_is_supported(packet)) {
+    return coap_serialize_message(packet, buffer, buffer_size);
+  }
+  if (coap_header_template_match(tmpl, packet)) {
+    return coap_header_template_serialize(tmpl, packet, buffer, buffer_size);
+  }
+  size_t size = coap_serialize_message(packet, buffer, buffer_size);
+  if (size > 0) {
+    size_t header_size = size - packet->payload_len;
+    if (packet->payload_len > 0) {
+      header_size -= COAP_PAYLOAD_MARKER_LEN;
+    }
+    coap_header_template_set(tmpl, packet, header_size);
+  }
+  return size;
+}
+
+#endif /* OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
+
 coap_status_t
 coap_udp_parse_message(coap_packet_t *packet, uint8_t *data, size_t data_len,
                        bool validate)
@@ -60,6 +60,7 @@
 #include "port/oc_log_internal.h"
 #include "port/oc_random.h"
 #include "util/oc_compiler.h"
+#include "util/oc_features.h"
 
 #ifdef OC_OSCORE
 #include "oscore_constants.h"
@@ -237,6 +238,60 @@ size_t coap_oscore_serialize_message(coap_packet_t *packet, uint8_t *buffer,
 
 void coap_send_message(oc_message_t *message) OC_NONNULL();
 
+#ifdef OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+
+/// Maximal size of the header, token and options kept by a template
+#define COAP_HEADER_TEMPLATE_MAX_SIZE (40)
+
+/**
+ * @brief Serialized header, token and options of a UDP message.
+ *
+ * Messages sent repeatedly to the same peer, e.g. the notifications of an
+ * observer, differ only in the type, the message ID, the values of the Observe
+ * and ETag options and the payload. Such messages are serialized by copying
+ * the template and patching the differing fields.
+ *
+ * Only messages with the ETag, Observe and Content-Format options can be
+ * serialized from a template.
+ */
+typedef struct coap_header_template_t
+{
+  uint8_t buffer[COAP_HEADER_TEMPLATE_MAX_SIZE]; ///< header, token and options
+  uint8_t size; ///< size of the template, 0 if the template is not set
+  uint8_t code;
+  uint8_t options[COAP_OPTION_SIZE1 / OPTION_MAP_SIZE + 1];
+  uint16_t content_format;
+  uint8_t observe_offset; ///< offset of the value of the Observe option
+  uint8_t observe_len;    ///< length of the value of the Observe option
+  uint8_t etag_offset;    ///< offset of the value of the ETag option
+  uint8_t etag_len;       ///< length of the value of the ETag option
+} coap_header_template_t;
+
+/** @brief Unset the template */
+void coap_header_template_reset(coap_header_template_t *tmpl) OC_NONNULL();
+
+/**
+ * @brief Serialize the packet using the template.
+ *
+ * If the packet matches the template, it is serialized by patching a copy of
+ * the template. Otherwise it is serialized by coap_serialize_message and the
+ * template is set from the result if the packet can be serialized from a
+ * template.
+ *
+ * @param packet the packet to serialize (cannot be NULL)
+ * @param tmpl the template (cannot be NULL)
+ * @param buffer output buffer (cannot be NULL)
+ * @param buffer_size size of the output buffer
+ * @return size of the serialized message
+ * @return 0 on error
+ */
+size_t coap_serialize_message_with_template(coap_packet_t *packet,
+                                            coap_header_template_t *tmpl,
+                                            uint8_t *buffer,
+                                            size_t buffer_size) OC_NONNULL();
+
+#endif /* OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
+
 /**
  * @brief Parse CoAP message options
  *
@@ -257,6 +312,24 @@ coap_status_t coap_oscore_parse_options(coap_packet_t *packet,
                                         bool outer, bool oscore, bool validate)
   OC_NONNULL();
 
+#ifdef OC_HAS_FEATURE_COAP_FAST_PARSER
+
+/**
+ * @brief Parse CoAP message options one by one, as builds without the fast
+ * parser do.
+ *
+ * The fast parser first indexes the boundaries of the options and then decodes
+ * them. The result of both parsers must be the same.
+ *
+ * @see coap_oscore_parse_options
+ */
+coap_status_t coap_oscore_parse_options_sequential(
+  coap_packet_t *packet, const uint8_t *data, size_t data_len,
+  uint8_t *current_option, bool inner, bool outer, bool oscore, bool validate)
+  OC_NONNULL();
+
+#endif /* OC_HAS_FEATURE_COAP_FAST_PARSER */
+
 /**
  * @brief Parse UDP CoAP message
  *
@@ -72,6 +72,10 @@
 #include "api/oc_blockwise_internal.h"
 #endif /* OC_BLOCK_WISE */
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+#include "api/oc_blockwise_stream_internal.h"
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 #ifdef OC_CLIENT
 #include "api/client/oc_client_cb_internal.h"
 #include "oc_client_state.h"
@@ -281,15 +285,34 @@ coap_receive_init_response(coap_packet_t *response,
 #ifdef OC_BLOCK_WISE
 
 static oc_blockwise_state_t *
-coap_receive_create_request_buffer(const coap_packet_t *request,
+coap_receive_alloc_request_buffer(const coap_receive_ctx_t *ctx,
+                                  const char *href, size_t href_len,
+                                  const oc_endpoint_t *endpoint,
+                                  uint32_t buffer_size)
+{
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (ctx->stream != NULL) {
+    return oc_blockwise_stream_alloc_request_buffer(
+      ctx->stream, href, href_len, endpoint, ctx->message->code,
+      OC_BLOCKWISE_SERVER, ctx->block1.size);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+  return oc_blockwise_alloc_request_buffer(href, href_len, endpoint,
+                                           ctx->message->code,
+                                           OC_BLOCKWISE_SERVER, buffer_size);
+}
+
+static oc_blockwise_state_t *
+coap_receive_create_request_buffer(const coap_receive_ctx_t *ctx,
                                    const char *href, size_t href_len,
                                    const oc_endpoint_t *endpoint,
                                    uint32_t buffer_size,
                                    const uint8_t *incoming_block,
                                    uint32_t incoming_block_len)
 {
-  oc_blockwise_state_t *request_buffer = oc_blockwise_alloc_request_buffer(
-    href, href_len, endpoint, request->code, OC_BLOCKWISE_SERVER, buffer_size);
+  const coap_packet_t *request = ctx->message;
+  oc_blockwise_state_t *request_buffer = coap_receive_alloc_request_buffer(
+    ctx, href, href_len, endpoint, buffer_size);
   if (request_buffer == NULL) {
     COAP_ERR("could not create buffer to hold request payload");
     return NULL;
@@ -304,10 +327,57 @@ coap_receive_create_request_buffer(const coap_packet_t *request,
     oc_new_string(&request_buffer->uri_query, request->uri_query,
                   request->uri_query_len);
   }
-  request_buffer->payload_size = incoming_block_len;
+  oc_blockwise_finish_receive(request_buffer);
   return request_buffer;
 }
 
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+
+/* Respond with the first block of a body produced by the stream, the handler
+ * of the resource is not invoked */
+static coap_receive_status_t
+coap_receive_stream_response(coap_receive_ctx_t *ctx, const char *href,
+                             size_t href_len, const oc_endpoint_t *endpoint)
+{
+  ctx->response_buffer = oc_blockwise_stream_alloc_response_buffer(
+    ctx->stream, href, href_len, endpoint, ctx->message->code,
+    OC_BLOCKWISE_SERVER, ctx->block2.size);
+  if (ctx->response_buffer == NULL) {
+    COAP_ERR("could not create block-wise response buffer");
+    return COAP_RECEIVE_ERROR;
+  }
+  if (ctx->message->uri_query_len > 0) {
+    oc_new_string(&ctx->response_buffer->uri_query, ctx->message->uri_query,
+                  ctx->message->uri_query_len);
+  }
+  uint32_t payload_size = 0;
+  void *payload = oc_blockwise_dispatch_block(ctx->response_buffer, 0,
+                                              ctx->block2.size, &payload_size);
+  if (payload == NULL) {
+    COAP_ERR("could not dispatch block");
+    return COAP_RECEIVE_ERROR;
+  }
+  oc_content_format_t cf = oc_blockwise_stream_content_format(ctx->stream);
+  ctx->response_buffer->content_format = cf;
+  uint8_t more = (ctx->response_buffer->next_block_offset <
+                  ctx->response_buffer->payload_size)
+                   ? 1
+                   : 0;
+  coap_options_set_content_format(ctx->response, cf);
+  coap_set_payload(ctx->response, payload, payload_size);
+  if (ctx->block2.enabled || more != 0) {
+    coap_options_set_block2(ctx->response, 0, more, ctx->block2.size, 0);
+  }
+  const oc_blockwise_response_state_t *response_state =
+    (oc_blockwise_response_state_t *)ctx->response_buffer;
+  coap_options_set_etag(ctx->response, response_state->etag.value,
+                        response_state->etag.length);
+  ctx->response_buffer->ref_count = more;
+  return COAP_RECEIVE_SUCCESS;
+}
+
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+
 static coap_receive_status_t
 coap_receive_blockwise_block1(coap_receive_ctx_t *ctx, const char *href,
                               size_t href_len, const oc_endpoint_t *endpoint)
@@ -336,9 +406,8 @@ coap_receive_blockwise_block1(coap_receive_ctx_t *ctx, const char *href,
       buffer_size = (uint32_t)OC_MAX_APP_DATA_SIZE;
     }
     COAP_DBG("creating new block-wise request buffer");
-    ctx->request_buffer = oc_blockwise_alloc_request_buffer(
-      href, href_len, endpoint, ctx->message->code, OC_BLOCKWISE_SERVER,
-      buffer_size);
+    ctx->request_buffer = coap_receive_alloc_request_buffer(
+      ctx, href, href_len, endpoint, buffer_size);
 
     if (ctx->request_buffer != NULL && ctx->message->uri_query_len > 0) {
       oc_new_string(&ctx->request_buffer->uri_query, ctx->message->uri_query,
@@ -375,11 +444,11 @@ coap_receive_blockwise_block1(coap_receive_ctx_t *ctx, const char *href,
   }
   coap_udp_init_message(ctx->response, COAP_TYPE_CON, CONTENT_2_05,
                         coap_get_mid());
-  ctx->transaction->mid = ctx->response->mid;
+  coap_transaction_set_mid(ctx->transaction, ctx->response->mid);
   coap_options_set_block1(ctx->response, ctx->block1.num, ctx->block1.more,
                           ctx->block1.size, 0);
   coap_options_set_accept(ctx->response, APPLICATION_VND_OCF_CBOR);
-  ctx->request_buffer->payload_size = ctx->request_buffer->next_block_offset;
+  oc_blockwise_finish_receive(ctx->request_buffer);
   ctx->request_buffer->ref_count = 0;
   return COAP_RECEIVE_INVOKE_HANDLER;
 }
@@ -436,7 +505,7 @@ coap_receive_blockwise_block2(coap_receive_ctx_t *ctx, const char *href,
       }
       coap_udp_init_message(ctx->response, COAP_TYPE_CON,
                             (uint8_t)response_state->code, coap_get_mid());
-      ctx->transaction->mid = ctx->response->mid;
+      coap_transaction_set_mid(ctx->transaction, ctx->response->mid);
       coap_options_set_accept(ctx->response, APPLICATION_VND_OCF_CBOR);
     }
     oc_content_format_t cf = APPLICATION_VND_OCF_CBOR;
@@ -459,6 +528,11 @@ coap_receive_blockwise_block2(coap_receive_ctx_t *ctx, const char *href,
     COAP_ERR("initiating block-wise transfer with request for block_num > 0");
     return COAP_RECEIVE_ERROR;
   }
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (ctx->stream != NULL) {
+    return coap_receive_stream_response(ctx, href, href_len, endpoint);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
 
 #if 0
   COAP_DBG(
@@ -481,7 +555,7 @@ coap_receive_blockwise_block2(coap_receive_ctx_t *ctx, const char *href,
   }
 
   ctx->request_buffer = coap_receive_create_request_buffer(
-    ctx->message, href, href_len, endpoint, buffer_size, incoming_block,
+    ctx, href, href_len, endpoint, buffer_size, incoming_block,
     incoming_block_len);
   if (ctx->request_buffer == NULL) {
     return COAP_RECEIVE_ERROR;
@@ -566,7 +640,7 @@ coap_receive_method_payload(coap_receive_ctx_t *ctx, const char *href,
     }
 
     ctx->request_buffer = coap_receive_create_request_buffer(
-      ctx->message, href, href_len, endpoint, buffer_size, incoming_block,
+      ctx, href, href_len, endpoint, buffer_size, incoming_block,
       incoming_block_len);
     if (ctx->request_buffer == NULL) {
       return COAP_RECEIVE_ERROR;
@@ -589,6 +663,11 @@ coap_receive_method_payload(coap_receive_ctx_t *ctx, const char *href,
     oc_blockwise_free_response_buffer(ctx->response_buffer);
     ctx->response_buffer = NULL;
   }
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (ctx->stream != NULL && ctx->message->code == COAP_GET) {
+    return coap_receive_stream_response(ctx, href, href_len, endpoint);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   return COAP_RECEIVE_INVOKE_HANDLER;
 }
 
@@ -624,13 +703,11 @@ coap_send_response(coap_receive_ctx_t *ctx)
     ctx->response->token_len = sizeof(ctx->response->token);
     oc_random_buffer(ctx->response->token, ctx->response->token_len);
     if (ctx->request_buffer != NULL) {
-      memcpy(ctx->request_buffer->token, ctx->response->token,
-             ctx->response->token_len);
-      ctx->request_buffer->token_len = ctx->response->token_len;
+      oc_blockwise_set_token(ctx->request_buffer, ctx->response->token,
+                             ctx->response->token_len);
     }
-    memcpy(ctx->response_buffer->token, ctx->response->token,
-           ctx->response->token_len);
-    ctx->response_buffer->token_len = ctx->response->token_len;
+    oc_blockwise_set_token(ctx->response_buffer, ctx->response->token,
+                           ctx->response->token_len);
   } else {
     coap_set_token(ctx->response, ctx->message->token, ctx->message->token_len);
   }
@@ -638,9 +715,8 @@ coap_send_response(coap_receive_ctx_t *ctx)
 
 send_transaction:
   if (ctx->response->token_len > 0) {
-    memcpy(ctx->transaction->token, ctx->response->token,
-           ctx->response->token_len);
-    ctx->transaction->token_len = ctx->response->token_len;
+    coap_transaction_set_token(ctx->transaction, ctx->response->token,
+                               ctx->response->token_len);
   }
   COAP_DBG("data buffer from:%p to:%p", (void *)ctx->transaction->message->data,
            (void *)(ctx->transaction->message->data +
@@ -810,6 +886,13 @@ coap_receive_request_with_method(coap_receive_ctx_t *ctx,
 
   oc_ri_preparsed_request_obj_t preparsed_request_obj;
   oc_ri_prepare_request(ctx->message, &preparsed_request_obj, endpoint);
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  if (preparsed_request_obj.cur_resource != NULL) {
+    ctx->stream = oc_blockwise_stream_find_by_method(
+      preparsed_request_obj.cur_resource, (oc_method_t)ctx->message->code,
+      endpoint);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
 
   /* validate request
    * - check if resource is found
@@ -875,6 +958,28 @@ coap_receive_invoke_client_cb(coap_receive_ctx_t *ctx, oc_endpoint_t *endpoint,
 
 #endif /* OC_CLIENT */
 
+#if defined(OC_CLIENT) && defined(OC_BLOCK_WISE)
+
+static oc_blockwise_state_t *
+coap_receive_alloc_client_response_buffer(const oc_client_cb_t *client_cb,
+                                          const oc_endpoint_t *endpoint)
+{
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  const oc_blockwise_stream_t *stream = oc_blockwise_stream_find(client_cb);
+  if (stream != NULL && stream->handler.write != NULL) {
+    return oc_blockwise_stream_alloc_response_buffer(
+      stream, oc_string(client_cb->uri) + 1, oc_string_len(client_cb->uri) - 1,
+      endpoint, client_cb->method, OC_BLOCKWISE_CLIENT, 0);
+  }
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
+  uint32_t buffer_size = (uint32_t)OC_MAX_APP_DATA_SIZE;
+  return oc_blockwise_alloc_response_buffer(
+    oc_string(client_cb->uri) + 1, oc_string_len(client_cb->uri) - 1, endpoint,
+    client_cb->method, OC_BLOCKWISE_CLIENT, buffer_size, CONTENT_2_05, false);
+}
+
+#endif /* OC_CLIENT && OC_BLOCK_WISE */
+
 static coap_receive_status_t
 coap_receive_request_with_code(coap_receive_ctx_t *ctx, oc_endpoint_t *endpoint)
 {
@@ -972,9 +1077,12 @@ coap_receive_request_with_code(coap_receive_ctx_t *ctx, oc_endpoint_t *endpoint)
                                      oc_string_len(client_cb->query));
         }
         coap_options_set_accept(ctx->response, APPLICATION_VND_OCF_CBOR);
-        coap_options_set_content_format(ctx->response,
-                                        APPLICATION_VND_OCF_CBOR);
-        ctx->request_buffer->mid = response_mid;
+        oc_content_format_t cf = APPLICATION_VND_OCF_CBOR;
+        if (ctx->request_buffer->content_format > 0) {
+          cf = ctx->request_buffer->content_format;
+        }
+        coap_options_set_content_format(ctx->response, cf);
+        oc_blockwise_set_mid(ctx->request_buffer, response_mid);
         return COAP_RECEIVE_SUCCESS;
       }
     } else {
@@ -992,11 +1100,8 @@ coap_receive_request_with_code(coap_receive_ctx_t *ctx, oc_endpoint_t *endpoint)
     ctx->response_buffer =
       oc_blockwise_find_response_buffer_by_client_cb(endpoint, client_cb);
     if (ctx->response_buffer == NULL) {
-      uint32_t buffer_size = (uint32_t)OC_MAX_APP_DATA_SIZE;
-      ctx->response_buffer = oc_blockwise_alloc_response_buffer(
-        oc_string(client_cb->uri) + 1, oc_string_len(client_cb->uri) - 1,
-        endpoint, client_cb->method, OC_BLOCKWISE_CLIENT, buffer_size,
-        CONTENT_2_05, false);
+      ctx->response_buffer =
+        coap_receive_alloc_client_response_buffer(client_cb, endpoint);
       if (ctx->response_buffer != NULL) {
         COAP_DBG("created new response buffer for uri %s",
                  oc_string(ctx->response_buffer->href));
@@ -1035,8 +1140,8 @@ coap_receive_request_with_code(coap_receive_ctx_t *ctx, oc_endpoint_t *endpoint)
         if (ctx->transaction != NULL) {
           coap_udp_init_message(ctx->response, COAP_TYPE_CON,
                                 (uint8_t)client_cb->method, response_mid);
-          ctx->response_buffer->mid = response_mid;
-          client_cb->mid = response_mid;
+          oc_blockwise_set_mid(ctx->response_buffer, response_mid);
+          oc_client_cb_set_mid(client_cb, response_mid);
           coap_options_set_accept(ctx->response, APPLICATION_VND_OCF_CBOR);
           coap_options_set_block2(ctx->response, ctx->block2.num + 1, 0,
                                   ctx->block2.size, 0);
@@ -1050,8 +1155,7 @@ coap_receive_request_with_code(coap_receive_ctx_t *ctx, oc_endpoint_t *endpoint)
           return COAP_RECEIVE_SUCCESS;
         }
       }
-      ctx->response_buffer->payload_size =
-        ctx->response_buffer->next_block_offset;
+      oc_blockwise_finish_receive(ctx->response_buffer);
     }
   }
 
@@ -150,6 +150,9 @@ typedef struct
   oc_blockwise_state_t *request_buffer;
   oc_blockwise_state_t *response_buffer;
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+  const struct oc_blockwise_stream_t *stream; ///< stream of the bodies
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
 } coap_receive_ctx_t;
 
 /**
@@ -70,10 +70,19 @@
 #include "oc_ri.h"
 #include "util/oc_memb.h"
 
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+#include "util/oc_hash_index_internal.h"
+#include "util/oc_hash_internal.h"
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+
 #ifdef OC_HAS_FEATURE_ETAG
 #include "api/oc_etag_internal.h"
 #endif /* OC_HAS_FEATURE_ETAG */
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+#include "api/oc_notification_scheduler_internal.h"
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
 #ifdef OC_SECURITY
 #include "security/oc_acl_internal.h"
 #include "security/oc_pstat_internal.h"
@@ -199,6 +208,286 @@ coap_observe_counter_reset(void)
 OC_LIST(g_observers_list);
 OC_MEMB(g_observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
 
+typedef struct coap_endpoint_and_token_t
+{
+  const oc_endpoint_t *endpoint;
+  const uint8_t *token;
+  size_t token_len;
+} coap_endpoint_and_token_t;
+
+static bool
+coap_observer_has_matching_endpoint_and_token(const coap_observer_t *obs,
+                                              const void *data)
+{
+  const coap_endpoint_and_token_t *eat =
+    (const coap_endpoint_and_token_t *)data;
+  return oc_endpoint_compare(&obs->endpoint, eat->endpoint) == 0 &&
+         obs->token_len == eat->token_len &&
+         memcmp(obs->token, eat->token, eat->token_len) == 0;
+}
+
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+/* Each observer is linked to the list of observers of its resource and to the
+ * list of observers of its client endpoint. The first observer of each client
+ * is indexed by the endpoint, all observers are indexed by the endpoint and
+ * the token. */
+#ifdef OC_DYNAMIC_ALLOCATION
+static oc_hash_index_t g_observers_by_client;
+static oc_hash_index_t g_observers_by_token;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+static oc_hash_index_entry_t
+  g_observers_by_client_entries[2 * COAP_MAX_OBSERVERS + 1];
+static oc_hash_index_entry_t
+  g_observers_by_token_entries[2 * COAP_MAX_OBSERVERS + 1];
+static oc_hash_index_t g_observers_by_client =
+  OC_HASH_INDEX_STATIC_INIT(g_observers_by_client_entries);
+static oc_hash_index_t g_observers_by_token =
+  OC_HASH_INDEX_STATIC_INIT(g_observers_by_token_entries);
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static uint32_t
+observer_client_hash(const oc_endpoint_t *endpoint)
+{
+  return oc_endpoint_hash(endpoint);
+}
+
+static uint32_t
+observer_token_hash(const oc_endpoint_t *endpoint, const uint8_t *token,
+                    size_t token_len)
+{
+  return oc_hash_fnv1a(oc_endpoint_hash(endpoint), token, token_len);
+}
+
+static bool
+observer_match_client(const void *item, const void *key)
+{
+  return oc_endpoint_compare(&((const coap_observer_t *)item)->endpoint,
+                             (const oc_endpoint_t *)key) == 0;
+}
+
+static bool
+observer_match_token(const void *item, const void *key)
+{
+  return coap_observer_has_matching_endpoint_and_token(
+    (const coap_observer_t *)item, key);
+}
+
+static coap_observer_t *
+observer_index_find_client(const oc_endpoint_t *endpoint)
+{
+  return (coap_observer_t *)oc_hash_index_find(
+    &g_observers_by_client, observer_client_hash(endpoint),
+    observer_match_client, endpoint);
+}
+
+typedef coap_observer_link_t *(*observer_link_fn_t)(coap_observer_t *obs);
+
+static coap_observer_link_t *
+observer_resource_link(coap_observer_t *obs)
+{
+  return &obs->resource_link;
+}
+
+static coap_observer_link_t *
+observer_client_link(coap_observer_t *obs)
+{
+  return &obs->client_link;
+}
+
+/* The lists keep the order of insertion, the prev link of the first observer
+ * points to the last observer, so both append and remove are O(1) */
+static void
+observer_link_append(coap_observer_t **head, coap_observer_t *o,
+                     observer_link_fn_t link)
+{
+  link(o)->next = NULL;
+  if (*head == NULL) {
+    link(o)->prev = o;
+    *head = o;
+    return;
+  }
+  coap_observer_t *last = link(*head)->prev;
+  link(last)->next = o;
+  link(o)->prev = last;
+  link(*head)->prev = o;
+}
+
+static void
+observer_link_remove(coap_observer_t **head, coap_observer_t *o,
+                     observer_link_fn_t link)
+{
+  coap_observer_t *next = link(o)->next;
+  coap_observer_t *prev = link(o)->prev;
+  if (o == *head) {
+    *head = next;
+    if (next != NULL) {
+      link(next)->prev = prev;
+    }
+  } else {
+    link(prev)->next = next;
+    if (next != NULL) {
+      link(next)->prev = prev;
+    } else {
+      link(*head)->prev = prev;
+    }
+  }
+  link(o)->next = NULL;
+  link(o)->prev = NULL;
+}
+
+static void
+observer_list_append(coap_observer_t *o)
+{
+  coap_observer_t *head = (coap_observer_t *)oc_list_head(g_observers_list);
+  o->next = NULL;
+  if (head == NULL) {
+    o->prev = o;
+    *g_observers_list = o;
+    return;
+  }
+  head->prev->next = o;
+  o->prev = head->prev;
+  head->prev = o;
+}
+
+static void
+observer_list_remove(coap_observer_t *o)
+{
+  coap_observer_t *head = (coap_observer_t *)oc_list_head(g_observers_list);
+  if (o == head) {
+    *g_observers_list = o->next;
+    if (o->next != NULL) {
+      o->next->prev = o->prev;
+    }
+  } else {
+    o->prev->next = o->next;
+    if (o->next != NULL) {
+      o->next->prev = o->prev;
+    } else {
+      head->prev = o->prev;
+    }
+  }
+  o->next = NULL;
+  o->prev = NULL;
+}
+
+static bool
+observer_index_add(coap_observer_t *o)
+{
+  if (!oc_hash_index_insert(
+        &g_observers_by_token,
+        observer_token_hash(&o->endpoint, o->token, o->token_len), o)) {
+    return false;
+  }
+  coap_observer_t *client = observer_index_find_client(&o->endpoint);
+  if (client == NULL &&
+      !oc_hash_index_insert(&g_observers_by_client,
+                            observer_client_hash(&o->endpoint), o)) {
+    oc_hash_index_remove(
+      &g_observers_by_token,
+      observer_token_hash(&o->endpoint, o->token, o->token_len), o);
+    return false;
+  }
+  observer_link_append(&client, o, observer_client_link);
+  observer_link_append(&o->resource->observers, o, observer_resource_link);
+  observer_list_append(o);
+  return true;
+}
+
+static void
+observer_index_remove(coap_observer_t *o)
+{
+  oc_hash_index_remove(
+    &g_observers_by_token,
+    observer_token_hash(&o->endpoint, o->token, o->token_len), o);
+  coap_observer_t *client = observer_index_find_client(&o->endpoint);
+  if (client != NULL) {
+    bool is_first = client == o;
+    observer_link_remove(&client, o, observer_client_link);
+    if (is_first) {
+      uint32_t hash = observer_client_hash(&o->endpoint);
+      oc_hash_index_remove(&g_observers_by_client, hash, o);
+      if (client != NULL) {
+        // cannot fail, an entry has just been released
+        oc_hash_index_insert(&g_observers_by_client, hash, client);
+      }
+    }
+  }
+  observer_link_remove(&o->resource->observers, o, observer_resource_link);
+  observer_list_remove(o);
+}
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+
+#ifndef OC_HAS_FEATURE_OBSERVER_INDEX
+static coap_observer_t *
+observer_find_by_resource(coap_observer_t *obs, const oc_resource_t *resource)
+{
+  for (; obs != NULL; obs = obs->next) {
+    if (obs->resource == resource) {
+      return obs;
+    }
+  }
+  return NULL;
+}
+
+static coap_observer_t *
+observer_find_by_client(coap_observer_t *obs, const oc_endpoint_t *endpoint)
+{
+  for (; obs != NULL; obs = obs->next) {
+    if (oc_endpoint_compare(&obs->endpoint, endpoint) == 0) {
+      return obs;
+    }
+  }
+  return NULL;
+}
+#endif /* !OC_HAS_FEATURE_OBSERVER_INDEX */
+
+/* First observer of the resource */
+static coap_observer_t *
+observers_of_resource(const oc_resource_t *resource)
+{
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  return resource->observers;
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
+  return observer_find_by_resource(
+    (coap_observer_t *)oc_list_head(g_observers_list), resource);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+}
+
+/* Next observer of the resource of the observer */
+static coap_observer_t *
+observer_next_of_resource(const coap_observer_t *obs)
+{
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  return obs->resource_link.next;
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
+  return observer_find_by_resource(obs->next, obs->resource);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+}
+
+/* First observer of the client endpoint */
+static coap_observer_t *
+observers_of_client(const oc_endpoint_t *endpoint)
+{
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  return observer_index_find_client(endpoint);
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
+  return observer_find_by_client(
+    (coap_observer_t *)oc_list_head(g_observers_list), endpoint);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+}
+
+/* Next observer of the client endpoint of the observer */
+static coap_observer_t *
+observer_next_of_client(const coap_observer_t *obs)
+{
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  return obs->client_link.next;
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
+  return observer_find_by_client(obs->next, &obs->endpoint);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+}
+
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -229,8 +518,12 @@ coap_remove_observer(coap_observer_t *o)
   }
 #endif /* OC_BLOCK_WISE */
   o->resource->num_observers--;
-  oc_free_string(&o->url);
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  observer_index_remove(o);
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
   oc_list_remove(g_observers_list, o);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+  oc_free_string(&o->url);
 #if defined(OC_RES_BATCH_SUPPORT) && defined(OC_DISCOVERY_RESOURCE_OBSERVABLE)
   remove_discovery_batch_observers(cmp_batch_by_observer, o);
 #endif /* OC_RES_BATCH_SUPPORT && OC_DISCOVERY_RESOURCE_OBSERVABLE */
@@ -240,17 +533,22 @@ coap_remove_observer(coap_observer_t *o)
 typedef void (*coap_on_remove_observer_handle_fn_t)(const coap_observer_t *obs);
 typedef bool (*coap_on_remove_observer_filter_t)(const coap_observer_t *obs,
                                                  const void *data);
+typedef coap_observer_t *(*coap_observer_next_fn_t)(const coap_observer_t *obs);
 
+/* Remove the observers accepted by the filter from the sequence starting by
+ * the first observer and continuing by the next function */
 static int
-coap_remove_observers_by_filter(coap_on_remove_observer_filter_t filter,
+coap_remove_observers_by_filter(coap_observer_t *first,
+                                coap_observer_next_fn_t next_fn,
+                                coap_on_remove_observer_filter_t filter,
                                 const void *filter_data,
                                 coap_on_remove_observer_handle_fn_t on_remove,
                                 bool match_all)
 {
   int removed = 0;
-  coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
+  coap_observer_t *obs = first;
   while (obs != NULL) {
-    coap_observer_t *next = obs->next;
+    coap_observer_t *next = next_fn(obs);
     if (filter(obs, filter_data)) {
       if (on_remove != NULL) {
         on_remove(obs);
@@ -295,8 +593,9 @@ coap_remove_observer_duplicates(const oc_endpoint_t *endpoint, const char *uri,
     .uri_len = uri_len,
     .iface_mask = iface_mask,
   };
-  return coap_remove_observers_by_filter(coap_observer_has_matching_data, &od,
-                                         NULL, true);
+  return coap_remove_observers_by_filter(
+    observers_of_client(endpoint), observer_next_of_client,
+    coap_observer_has_matching_data, &od, NULL, true);
 }
 
 coap_observer_t *
@@ -326,6 +625,15 @@ coap_add_observer(oc_resource_t *resource, uint16_t block2_size,
 #else  /* OC_BLOCK_WISE */
   (void)block2_size;
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+  o->pmin = 0;
+  // the response to the registration is the first notification
+  o->last_notified = oc_clock_time();
+  o->pending = false;
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+#ifdef OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+  coap_header_template_reset(&o->header_template);
+#endif /* OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
   resource->num_observers++;
 #ifdef OC_DYNAMIC_ALLOCATION
   COAP_DBG("Adding observer (%u) for /%s [0x%02X%02X]",
@@ -338,7 +646,17 @@ coap_add_observer(oc_resource_t *resource, uint16_t block2_size,
 #endif /* !OC_DYNAMIC_ALLOCATION */
   COAP_DBG("Removed %d duplicate observer(s)", dup);
   (void)dup;
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  if (!observer_index_add(o)) {
+    COAP_WRN("cannot index new observer");
+    resource->num_observers--;
+    oc_free_string(&o->url);
+    oc_memb_free(&g_observers_memb, o);
+    return NULL;
+  }
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
   oc_list_add(g_observers_list, o);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
   return o;
 }
 
@@ -351,6 +669,10 @@ coap_free_all_observers(void)
     coap_remove_observer(obs);
     obs = next;
   }
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  oc_hash_index_deinit(&g_observers_by_client);
+  oc_hash_index_deinit(&g_observers_by_token);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
 }
 
 static bool
@@ -367,29 +689,12 @@ coap_remove_observers_by_client(const oc_endpoint_t *endpoint)
   COAP_DBG("Unregistering observers for client at: ");
   COAP_LOGipaddr(*endpoint);
   int removed = coap_remove_observers_by_filter(
+    observers_of_client(endpoint), observer_next_of_client,
     coap_observer_has_matching_endpoint, endpoint, NULL, true);
   COAP_DBG("Removed %d observers", removed);
   return removed;
 }
 
-typedef struct coap_endpoint_and_token_t
-{
-  const oc_endpoint_t *endpoint;
-  const uint8_t *token;
-  size_t token_len;
-} coap_endpoint_and_token_t;
-
-static bool
-coap_observer_has_matching_endpoint_and_token(const coap_observer_t *obs,
-                                              const void *data)
-{
-  const coap_endpoint_and_token_t *eat =
-    (const coap_endpoint_and_token_t *)data;
-  return oc_endpoint_compare(&obs->endpoint, eat->endpoint) == 0 &&
-         obs->token_len == eat->token_len &&
-         memcmp(obs->token, eat->token, eat->token_len) == 0;
-}
-
 bool
 coap_remove_observer_by_token(const oc_endpoint_t *endpoint,
                               const uint8_t *token, size_t token_len)
@@ -397,7 +702,15 @@ coap_remove_observer_by_token(const oc_endpoint_t *endpoint,
   COAP_DBG("Unregistering observers for request token 0x%02X%02X", token[0],
            token[1]);
   coap_endpoint_and_token_t eat = { endpoint, token, token_len };
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  coap_observer_t *first = (coap_observer_t *)oc_hash_index_find(
+    &g_observers_by_token, observer_token_hash(endpoint, token, token_len),
+    observer_match_token, &eat);
+#else  /* !OC_HAS_FEATURE_OBSERVER_INDEX */
+  coap_observer_t *first = observers_of_client(endpoint);
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
   int removed = coap_remove_observers_by_filter(
+    first, observer_next_of_client,
     coap_observer_has_matching_endpoint_and_token, &eat, NULL, false);
   COAP_DBG("Removed %d observers", removed);
   return removed > 0;
@@ -424,6 +737,7 @@ coap_remove_observer_by_mid(const oc_endpoint_t *endpoint, uint16_t mid)
   COAP_DBG("Unregistering observers for request MID %u", mid);
   coap_endpoint_and_mid_t eam = { endpoint, mid };
   int removed = coap_remove_observers_by_filter(
+    observers_of_client(endpoint), observer_next_of_client,
     coap_observer_has_matching_endpoint_and_mid, &eam, NULL, false);
   COAP_DBG("Removed %d observers", removed);
   return removed > 0;
@@ -498,6 +812,7 @@ coap_remove_observers_by_resource(const oc_resource_t *rsc)
 {
   COAP_DBG("Unregistering observers for resource %s", oc_string(rsc->uri));
   int removed = coap_remove_observers_by_filter(
+    observers_of_resource(rsc), observer_next_of_resource,
     coap_observer_match_resource, rsc, send_not_found_notification, true);
   COAP_DBG("Removed %d observers", removed);
   return removed;
@@ -505,6 +820,12 @@ coap_remove_observers_by_resource(const oc_resource_t *rsc)
 
 #ifdef OC_SECURITY
 
+static coap_observer_t *
+observer_next(const coap_observer_t *obs)
+{
+  return obs->next;
+}
+
 typedef struct device_with_dos_change_t
 {
   size_t device;
@@ -533,6 +854,7 @@ coap_remove_observers_on_dos_change(size_t device, bool reset)
            (int)reset);
   device_with_dos_change_t ddc = { device, reset };
   int removed = coap_remove_observers_by_filter(
+    (coap_observer_t *)oc_list_head(g_observers_list), observer_next,
     coap_observer_has_matching_device, &ddc,
     send_service_unavailable_notification, true);
   COAP_DBG("Removed %d observers", removed);
@@ -770,9 +1092,15 @@ coap_send_notification_internal(coap_send_notification_ctx_t ctx)
 
   ctx.obs->last_mid = transaction->mid;
   notification.mid = transaction->mid;
+#ifdef OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+  transaction->message->length = coap_serialize_message_with_template(
+    &notification, &ctx.obs->header_template, transaction->message->data,
+    oc_message_buffer_size(transaction->message));
+#else  /* !OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
   transaction->message->length =
     coap_serialize_message(&notification, transaction->message->data,
                            oc_message_buffer_size(transaction->message));
+#endif /* OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
   if (transaction->message->length > 0) {
     coap_send_transaction(transaction);
   } else {
@@ -781,10 +1109,42 @@ coap_send_notification_internal(coap_send_notification_ctx_t ctx)
   return 1;
 }
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+static bool g_notify_pending_only = false;
+
+/* Check the minimal interval of the observer, a notification sent too early
+ * is postponed to the end of the interval */
+static bool
+coap_observer_is_due(coap_observer_t *obs)
+{
+  if (g_notify_pending_only && !obs->pending) {
+    return false;
+  }
+  if (obs->pmin == 0) {
+    return true;
+  }
+  oc_clock_time_t due = obs->last_notified + obs->pmin;
+  if (oc_clock_time() < due &&
+      oc_notification_scheduler_defer(obs->resource, due)) {
+    COAP_DBG("notification of observer postponed by pmin");
+    obs->pending = true;
+    return false;
+  }
+  return true;
+}
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
 static int
 send_notification(coap_observer_t *obs, oc_response_t *response,
                   const oc_string_t *uri, bool ignore_is_revert)
 {
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+  if (!coap_observer_is_due(obs)) {
+    return 0;
+  }
+  obs->pending = false;
+  obs->last_notified = oc_clock_time();
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
   coap_send_notification_ctx_t ctx = {
     .response = response,
     .obs = obs,
@@ -807,11 +1167,8 @@ coap_notify_collection_observers(const oc_collection_t *collection,
   memset(&response, 0, sizeof(response));
   response.response_buffer = response_buf;
   /* iterate over observers */
-  for (coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
-       obs; obs = obs->next) {
-    if (obs->resource != (const oc_resource_t *)collection) {
-      continue;
-    }
+  for (coap_observer_t *obs = observers_of_resource(&collection->res); obs;
+       obs = observer_next_of_resource(obs)) {
     if (obs->iface_mask != iface_mask) {
       // use default interface if obs->iface_mask == 0
       if ((obs->iface_mask | iface_mask) != collection->res.default_interface) {
@@ -1038,6 +1395,146 @@ coap_fill_response(oc_response_t *response, oc_resource_t *resource,
   return true;
 }
 
+typedef struct
+{
+  const oc_resource_t *resource;
+  const oc_endpoint_t *endpoint;
+  const oc_resource_t *discover_resource;
+  bool resource_is_collection;
+} coap_iterate_observers_ctx_t;
+
+static bool
+coap_observer_is_notified(const coap_observer_t *obs,
+                          const coap_iterate_observers_ctx_t *ctx)
+{
+  if ((obs->resource != ctx->resource) ||
+      (ctx->endpoint != NULL &&
+       oc_endpoint_compare(&obs->endpoint, ctx->endpoint) != 0)) {
+    return false;
+  } // obs->resource != resource || endpoint != obs->endpoint
+  if (ctx->resource_is_collection && obs->iface_mask != OC_IF_BASELINE) {
+    return false;
+  }
+  if (obs->resource == ctx->discover_resource && obs->iface_mask == OC_IF_B) {
+    return false;
+  }
+  if (obs->iface_mask == OC_IF_STARTUP) {
+    COAP_DBG("Skipping startup established observe");
+    return false;
+  }
+  return true;
+}
+
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD
+
+/* The representation of a resource may depend on the origin of the request
+ * only by its OCF version (content format) and by the network interface and
+ * transport (e.g. the endpoints listed by the discovery), observers with
+ * equal variants of their endpoints get the same notification payload. */
+typedef struct
+{
+  ocf_version_t version;
+  unsigned interface_index;
+  transport_flags flags;
+} coap_notification_variant_t;
+
+enum {
+  /* Maximal number of variants encoded once per a notification of
+     a resource, the payload of other variants is encoded per observer */
+  COAP_NOTIFICATION_VARIANTS_MAX = 8,
+};
+
+static coap_notification_variant_t
+coap_notification_variant(const oc_endpoint_t *endpoint)
+{
+  coap_notification_variant_t variant = {
+    .version = endpoint->version,
+    .interface_index = endpoint->interface_index,
+    .flags = endpoint->flags & (SECURED | IPV4 | IPV6 | TCP | GATT),
+  };
+  return variant;
+}
+
+static bool
+coap_notification_variant_is_equal(const coap_notification_variant_t *a,
+                                   const coap_notification_variant_t *b)
+{
+  return a->version == b->version &&
+         a->interface_index == b->interface_index && a->flags == b->flags;
+}
+
+/* Can the response of the resource be shared by observers with the same
+ * variant */
+static bool
+coap_notification_is_shared(const oc_resource_t *resource,
+                            oc_interface_mask_t iface_mask)
+{
+  if (iface_mask == OC_IF_B) {
+    // ETag of a batch response is computed per observer
+    return false;
+  }
+#ifdef OC_SECURITY
+  if (oc_core_is_SVR(resource, resource->device)) {
+    // SVRs can encode the data of the peer (e.g. /oic/sec/roles)
+    return false;
+  }
+#else  /* !OC_SECURITY */
+  (void)resource;
+#endif /* OC_SECURITY */
+  return true;
+}
+
+/* Send the prepared response to the first observer and to all following
+ * observers with the same variant, variant is NULL if the response is not
+ * shared. */
+static bool
+coap_send_notification_variant(const coap_iterate_observers_ctx_t *ctx,
+                               coap_observer_t *first, oc_response_t *response,
+                               const coap_notification_variant_t *variant,
+                               int *num)
+{
+  // the code is rewritten for a REVERT notification
+  int code = response->response_buffer->code;
+  for (coap_observer_t *obs = first; obs != NULL;
+       obs = observer_next_of_resource(obs)) {
+    if (obs != first) {
+      if (variant == NULL) {
+        break;
+      }
+      if (!coap_observer_is_notified(obs, ctx)) {
+        continue;
+      }
+      coap_notification_variant_t obs_variant =
+        coap_notification_variant(&obs->endpoint);
+      if (!coap_notification_variant_is_equal(variant, &obs_variant)) {
+        continue;
+      }
+    }
+    response->response_buffer->code = code;
+    if (send_notification(obs, response, &ctx->resource->uri, false) < 0) {
+      return false;
+    }
+    ++(*num);
+  }
+  return true;
+}
+
+/* Was the response already sent to the observers of the variant */
+static bool
+coap_notification_variant_is_sent(const coap_notification_variant_t *variants,
+                                  size_t variants_count,
+                                  const coap_notification_variant_t *variant)
+{
+  for (size_t i = 0; i < variants_count; ++i) {
+    if (coap_notification_variant_is_equal(&variants[i], variant)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
+
 static int
 coap_iterate_observers(oc_resource_t *resource, oc_response_t *response,
                        const oc_endpoint_t *endpoint, bool prepare_response)
@@ -1059,46 +1556,88 @@ coap_iterate_observers(oc_resource_t *resource, oc_response_t *response,
     prepare_response = false;
   }
 
+  coap_iterate_observers_ctx_t ctx = {
+    .resource = resource,
+    .endpoint = endpoint,
+    .discover_resource =
+      oc_core_get_resource_by_index(OCF_RES, resource->device),
+    .resource_is_collection = resource_is_collection,
+  };
   int num = 0;
-  const oc_resource_t *discover_resource =
-    oc_core_get_resource_by_index(OCF_RES, resource->device);
-  /* iterate over observers */
-  for (coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
-       obs; obs = obs->next) {
-    if ((obs->resource != resource) ||
-        (endpoint != NULL &&
-         oc_endpoint_compare(&obs->endpoint, endpoint) != 0)) {
-      continue;
-    } // obs->resource != resource || endpoint != obs->endpoint
-    if (resource_is_collection && obs->iface_mask != OC_IF_BASELINE) {
-      continue;
+  if (!prepare_response) {
+    /* iterate over observers */
+    for (coap_observer_t *obs = observers_of_resource(resource); obs;
+         obs = observer_next_of_resource(obs)) {
+      if (!coap_observer_is_notified(obs, &ctx)) {
+        continue;
+      }
+      if (send_notification(obs, response, &resource->uri, false) < 0) {
+        return num;
+      }
+      ++num;
     }
-    if (obs->resource == discover_resource && obs->iface_mask == OC_IF_B) {
+    return num;
+  }
+
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD
+  // the response is prepared once for each variant and sent to all observers
+  // of the variant
+  bool shared = coap_notification_is_shared(resource, iface_mask);
+  coap_notification_variant_t variants[COAP_NOTIFICATION_VARIANTS_MAX];
+  size_t variants_count = 0;
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
+  for (coap_observer_t *obs = observers_of_resource(resource); obs;
+       obs = observer_next_of_resource(obs)) {
+    if (!coap_observer_is_notified(obs, &ctx)) {
       continue;
     }
-    if (obs->iface_mask == OC_IF_STARTUP) {
-      COAP_DBG("Skipping startup established observe");
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD
+    coap_notification_variant_t obs_variant = { 0 };
+    if (shared) {
+      obs_variant = coap_notification_variant(&obs->endpoint);
+      if (coap_notification_variant_is_sent(variants, variants_count,
+                                            &obs_variant)) {
+        continue;
+      }
+    }
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+    // don't prepare the response for a postponed observer
+    if (!coap_observer_is_due(obs)) {
       continue;
     }
-    if (prepare_response) {
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
 #if OC_DBG_IS_ENABLED
-      oc_string64_t ep_str;
-      const char *ep_cstr = "";
-      if (oc_endpoint_to_string64(&obs->endpoint, &ep_str)) {
-        ep_cstr = oc_string(ep_str);
-      }
-      COAP_DBG("prepare GET request to resource(%s) for endpoint %s",
-               oc_string(resource->uri), ep_cstr);
+    oc_string64_t ep_str;
+    const char *ep_cstr = "";
+    if (oc_endpoint_to_string64(&obs->endpoint, &ep_str)) {
+      ep_cstr = oc_string(ep_str);
+    }
+    COAP_DBG("prepare GET request to resource(%s) for endpoint %s",
+             oc_string(resource->uri), ep_cstr);
 #endif /* OC_DBG_IS_ENABLED */
-      if (!coap_fill_response(response, resource, &obs->endpoint, iface_mask,
-                              true)) {
-        continue;
-      }
+    if (!coap_fill_response(response, resource, &obs->endpoint, iface_mask,
+                            true)) {
+      continue;
+    }
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD
+    // the variant is recorded only for a filled response, so that other
+    // observers of the variant are not skipped if the fill fails
+    const coap_notification_variant_t *variant = NULL;
+    if (shared && variants_count < COAP_NOTIFICATION_VARIANTS_MAX) {
+      variants[variants_count] = obs_variant;
+      variant = &variants[variants_count];
+      ++variants_count;
     }
+    if (!coap_send_notification_variant(&ctx, obs, response, variant, &num)) {
+      return num;
+    }
+#else  /* !OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
     if (send_notification(obs, response, &resource->uri, false) < 0) {
       return num;
     }
     ++num;
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
   }
 
   return num;
@@ -1202,11 +1741,8 @@ notify_resource_defaults_observer(oc_resource_t *resource,
   response_buffer.content_format = APPLICATION_VND_OCF_CBOR;
   response.response_buffer = &response_buffer;
   /* iterate over observers */
-  for (coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
-       obs; obs = obs->next) {
-    if (obs->resource != resource) {
-      continue;
-    }
+  for (coap_observer_t *obs = observers_of_resource(resource); obs;
+       obs = observer_next_of_resource(obs)) {
     if (obs->iface_mask != iface_mask) {
       continue;
     }
@@ -1461,15 +1997,15 @@ coap_add_discovery_batch_observer(oc_resource_t *resource, bool removed,
   assert(resource != NULL);
   const oc_resource_t *discover_resource =
     oc_core_get_resource_by_index(OCF_RES, resource->device);
-  if (discover_resource == resource) {
+  if (discover_resource == NULL || discover_resource == resource) {
     return false;
   }
 
   /* iterate over observers */
   bool added = false;
-  for (coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
-       obs; obs = obs->next) {
-    if (obs->resource != discover_resource || obs->iface_mask != OC_IF_B) {
+  for (coap_observer_t *obs = observers_of_resource(discover_resource); obs;
+       obs = observer_next_of_resource(obs)) {
+    if (obs->iface_mask != OC_IF_B) {
       continue;
     }
     if (removed && (oc_string_len(resource->uri) == 0)) {
@@ -1553,11 +2089,8 @@ notify_discovery_observers(oc_resource_t *resource)
 
   int num = 0;
   /* iterate over observers */
-  for (coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
-       obs; obs = obs->next) {
-    if (obs->resource != resource) {
-      continue;
-    }
+  for (coap_observer_t *obs = observers_of_resource(resource); obs;
+       obs = observer_next_of_resource(obs)) {
     oc_interface_mask_t iface_mask = obs->iface_mask;
     if ((iface_mask & OC_IF_B) != 0) {
       continue;
@@ -1582,6 +2115,17 @@ notify_discovery_observers(oc_resource_t *resource)
 }
 #endif /* OC_DISCOVERY_RESOURCE_OBSERVABLE */
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+int
+coap_notify_pending_observers(oc_resource_t *resource)
+{
+  g_notify_pending_only = true;
+  int num = coap_notify_observers_internal(resource, NULL, NULL);
+  g_notify_pending_only = false;
+  return num;
+}
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
 int
 coap_notify_observers(oc_resource_t *resource,
                       oc_response_buffer_t *response_buf,
@@ -1606,36 +2150,47 @@ coap_notify_observers(oc_resource_t *resource,
   return coap_notify_observers_internal(resource, response_buf, endpoint);
 }
 
-bool
-coap_resource_is_observed(const oc_resource_t *resource)
+#if defined(OC_RES_BATCH_SUPPORT) &&                                           \
+  (defined(OC_DISCOVERY_RESOURCE_OBSERVABLE) ||                                \
+   (defined(OC_COLLECTIONS) && defined(OC_COLLECTIONS_IF_CREATE)))
+static bool
+coap_resource_is_batch_observed(const oc_resource_t *resource)
 {
-#if defined(OC_DISCOVERY_RESOURCE_OBSERVABLE) && defined(OC_RES_BATCH_SUPPORT)
-  const oc_resource_t *discover_resource =
-    oc_core_get_resource_by_index(OCF_RES, resource->device);
-#endif /* OC_DISCOVERY_RESOURCE_OBSERVABLE && OC_RES_BATCH_SUPPORT */
-  /* iterate over observers */
-  for (coap_observer_t *obs = (coap_observer_t *)oc_list_head(g_observers_list);
-       obs; obs = obs->next) {
-    if (obs->resource == resource) {
+  if (resource == NULL) {
+    return false;
+  }
+  for (const coap_observer_t *obs = observers_of_resource(resource); obs;
+       obs = observer_next_of_resource(obs)) {
+    if ((obs->iface_mask & OC_IF_B) != 0) {
       return true;
     }
+  }
+  return false;
+}
+#endif /* OC_RES_BATCH_SUPPORT && (OC_DISCOVERY_RESOURCE_OBSERVABLE ||
+          (OC_COLLECTIONS && OC_COLLECTIONS_IF_CREATE)) */
+
+bool
+coap_resource_is_observed(const oc_resource_t *resource)
+{
+  if (observers_of_resource(resource) != NULL) {
+    return true;
+  }
 #ifdef OC_RES_BATCH_SUPPORT
 #ifdef OC_DISCOVERY_RESOURCE_OBSERVABLE
-    if ((obs->resource == discover_resource) &&
-        (obs->iface_mask & OC_IF_B) != 0) {
-      return true;
-    }
+  if (coap_resource_is_batch_observed(
+        oc_core_get_resource_by_index(OCF_RES, resource->device))) {
+    return true;
+  }
 #endif /* OC_DISCOVERY_RESOURCE_OBSERVABLE */
 #if defined(OC_COLLECTIONS) && defined(OC_COLLECTIONS_IF_CREATE)
-    const oc_rt_created_t *rtc =
-      oc_rt_get_factory_create_for_resource(resource);
-    if ((rtc != NULL) && (obs->resource == (oc_resource_t *)rtc->collection) &&
-        (obs->iface_mask & OC_IF_B)) {
-      return true;
-    }
+  const oc_rt_created_t *rtc = oc_rt_get_factory_create_for_resource(resource);
+  if (rtc != NULL &&
+      coap_resource_is_batch_observed((const oc_resource_t *)rtc->collection)) {
+    return true;
+  }
 #endif /* OC_COLLECTIONS && OC_COLLECTIONS_IF_CREATE */
 #endif /* OC_RES_BATCH_SUPPORT */
-  }
   return false;
 }
 
@@ -65,9 +65,24 @@
 extern "C" {
 #endif
 
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+typedef struct coap_observer_link_t
+{
+  struct coap_observer *next; ///< next observer, NULL for the last observer
+  struct coap_observer *prev; ///< previous observer, the first observer points
+                              ///< to the last observer
+} coap_observer_link_t;
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
+
 typedef struct coap_observer
 {
   struct coap_observer *next; /* for LIST */
+#ifdef OC_HAS_FEATURE_OBSERVER_INDEX
+  struct coap_observer *prev; ///< previous observer in the global list, the
+                              ///< first observer points to the last observer
+  coap_observer_link_t resource_link; ///< list of observers of the resource
+  coap_observer_link_t client_link;   ///< list of observers of the endpoint
+#endif /* OC_HAS_FEATURE_OBSERVER_INDEX */
 
   oc_resource_t *resource;
 
@@ -85,6 +100,16 @@ typedef struct coap_observer
   oc_interface_mask_t iface_mask;
   struct oc_etimer retrans_timer;
   uint8_t retrans_counter;
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+  /* minimal interval between notifications requested by the observer, 0 for
+   * no limit */
+  oc_clock_time_t pmin;
+  oc_clock_time_t last_notified; ///< time of the last notification
+  bool pending; ///< a notification was postponed by the minimal interval
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+#ifdef OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+  coap_header_template_t header_template; ///< header of the last notification
+#endif /* OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
 } coap_observer_t;
 
 /** @brief Get global list of observers */
@@ -199,6 +224,17 @@ int coap_notify_observers(oc_resource_t *resource,
                           oc_response_buffer_t *response_buf,
                           const oc_endpoint_t *endpoint);
 
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+/**
+ * @brief Notify the observers of the resource whose notification was postponed
+ * by their minimal interval.
+ *
+ * @param resource the resource (cannot be NULL)
+ * @return number of notified observers
+ */
+int coap_notify_pending_observers(oc_resource_t *resource) OC_NONNULL();
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SCHEDULER */
+
 /** @brief Check if resource is observed. */
 bool coap_resource_is_observed(const oc_resource_t *resource);
 
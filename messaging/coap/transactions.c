@@ -54,12 +54,18 @@
 #include "observe_internal.h"
 #include "oc_buffer.h"
 #include "transactions_internal.h"
+#include "util/oc_features.h"
 #include "util/oc_list.h"
 #include "util/oc_macros_internal.h"
 #include "util/oc_memb.h"
 #include "util/oc_macros_internal.h"
 #include <string.h>
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+#include "util/oc_hash_index_internal.h"
+#include "util/oc_hash_internal.h"
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 #ifdef OC_BLOCK_WISE
 #include "api/oc_blockwise_internal.h"
 #endif /* OC_BLOCK_WISE */
@@ -77,6 +83,87 @@ OC_LIST(transactions_list);
 
 static struct oc_process *transaction_handler_process = NULL;
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+#ifdef OC_DYNAMIC_ALLOCATION
+static oc_hash_index_t g_transactions_by_mid;
+static oc_hash_index_t g_transactions_by_token;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+static oc_hash_index_entry_t
+  g_transactions_by_mid_entries[2 * COAP_MAX_OPEN_TRANSACTIONS + 1];
+static oc_hash_index_entry_t
+  g_transactions_by_token_entries[2 * COAP_MAX_OPEN_TRANSACTIONS + 1];
+static oc_hash_index_t g_transactions_by_mid =
+  OC_HASH_INDEX_STATIC_INIT(g_transactions_by_mid_entries);
+static oc_hash_index_t g_transactions_by_token =
+  OC_HASH_INDEX_STATIC_INIT(g_transactions_by_token_entries);
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+typedef struct transaction_match_token_t
+{
+  const uint8_t *data;
+  uint8_t length;
+} transaction_match_token_t;
+
+static uint32_t
+transaction_mid_hash(uint16_t mid)
+{
+  return oc_hash_fnv1a_uint(OC_HASH_FNV1A_INIT, mid);
+}
+
+static uint32_t
+transaction_token_hash(const uint8_t *token, uint8_t token_len)
+{
+  return oc_hash_fnv1a(OC_HASH_FNV1A_INIT, token, token_len);
+}
+
+static bool
+transaction_match_mid(const void *item, const void *key)
+{
+  return ((const coap_transaction_t *)item)->mid == *(const uint16_t *)key;
+}
+
+static bool
+transaction_match_token(const void *item, const void *key)
+{
+  const coap_transaction_t *t = (const coap_transaction_t *)item;
+  const transaction_match_token_t *token =
+    (const transaction_match_token_t *)key;
+  return t->token_len == token->length &&
+         memcmp(t->token, token->data, token->length) == 0;
+}
+
+/* Transactions without a token are not indexed by token, lookups of an empty
+ * token scan the list */
+static bool
+transaction_index_add(coap_transaction_t *t)
+{
+  if (!oc_hash_index_insert(&g_transactions_by_mid,
+                            transaction_mid_hash(t->mid), t)) {
+    return false;
+  }
+  if (t->token_len > 0 &&
+      !oc_hash_index_insert(&g_transactions_by_token,
+                            transaction_token_hash(t->token, t->token_len),
+                            t)) {
+    oc_hash_index_remove(&g_transactions_by_mid, transaction_mid_hash(t->mid),
+                         t);
+    return false;
+  }
+  return true;
+}
+
+static void
+transaction_index_remove(const coap_transaction_t *t)
+{
+  oc_hash_index_remove(&g_transactions_by_mid, transaction_mid_hash(t->mid),
+                       t);
+  if (t->token_len > 0) {
+    oc_hash_index_remove(&g_transactions_by_token,
+                         transaction_token_hash(t->token, t->token_len), t);
+  }
+}
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -113,6 +200,15 @@ coap_new_transaction(uint16_t mid, const uint8_t *token, uint8_t token_len,
   /* save client address */
   memcpy(&t->message->endpoint, endpoint, sizeof(oc_endpoint_t));
 
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (!transaction_index_add(t)) {
+    COAP_ERR("cannot index transaction %u", mid);
+    oc_message_unref(t->message);
+    oc_memb_free(&transactions_memb, t);
+    return NULL;
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
   oc_list_add(transactions_list,
               t); /* list itself makes sure same element is not added twice */
   return t;
@@ -208,13 +304,63 @@ coap_clear_transaction(coap_transaction_t *t)
 
     oc_etimer_stop(&t->retrans_timer);
     oc_message_unref(t->message);
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+    transaction_index_remove(t);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
     oc_list_remove(transactions_list, t);
     oc_memb_free(&transactions_memb, t);
   }
 }
+
+void
+coap_transaction_set_mid(coap_transaction_t *t, uint16_t mid)
+{
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  oc_hash_index_remove(&g_transactions_by_mid, transaction_mid_hash(t->mid),
+                       t);
+  t->mid = mid;
+  // cannot fail, a slot was freed by the removal
+  oc_hash_index_insert(&g_transactions_by_mid, transaction_mid_hash(t->mid),
+                       t);
+#else  /* !OC_HAS_FEATURE_REQUEST_INDEX */
+  t->mid = mid;
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+}
+
+void
+coap_transaction_set_token(coap_transaction_t *t, const uint8_t *token,
+                           uint8_t token_len)
+{
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (t->token_len > 0) {
+    oc_hash_index_remove(&g_transactions_by_token,
+                         transaction_token_hash(t->token, t->token_len), t);
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+  memcpy(t->token, token, token_len);
+  t->token_len = token_len;
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (t->token_len > 0 &&
+      !oc_hash_index_insert(&g_transactions_by_token,
+                            transaction_token_hash(t->token, t->token_len),
+                            t)) {
+    COAP_ERR("cannot index transaction %u by token", t->mid);
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+}
+
 coap_transaction_t *
 coap_get_transaction_by_mid(uint16_t mid)
 {
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  coap_transaction_t *t = (coap_transaction_t *)oc_hash_index_find(
+    &g_transactions_by_mid, transaction_mid_hash(mid), transaction_match_mid,
+    &mid);
+  if (t != NULL) {
+    COAP_DBG("Found transaction for MID %u: %p", t->mid, (void *)t);
+  }
+  return t;
+#else  /* !OC_HAS_FEATURE_REQUEST_INDEX */
   for (coap_transaction_t *t =
          (coap_transaction_t *)oc_list_head(transactions_list);
        t != NULL; t = t->next) {
@@ -224,11 +370,27 @@ coap_get_transaction_by_mid(uint16_t mid)
     }
   }
   return NULL;
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 coap_transaction_t *
 coap_get_transaction_by_token(const uint8_t *token, uint8_t token_len)
 {
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  if (token_len > 0) {
+    transaction_match_token_t key = {
+      .data = token,
+      .length = token_len,
+    };
+    coap_transaction_t *t = (coap_transaction_t *)oc_hash_index_find(
+      &g_transactions_by_token, transaction_token_hash(token, token_len),
+      transaction_match_token, &key);
+    if (t != NULL) {
+      COAP_DBG("Found transaction by token %p", (void *)t);
+    }
+    return t;
+  }
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
   for (coap_transaction_t *t =
          (coap_transaction_t *)oc_list_head(transactions_list);
        t != NULL; t = t->next) {
@@ -269,6 +431,10 @@ coap_free_all_transactions(void)
     coap_clear_transaction(t);
     t = next;
   }
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+  oc_hash_index_deinit(&g_transactions_by_mid);
+  oc_hash_index_deinit(&g_transactions_by_token);
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
 }
 
 void
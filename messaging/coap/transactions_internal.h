@@ -92,6 +92,14 @@ coap_transaction_t *coap_new_transaction(uint16_t mid, const uint8_t *token,
 
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
+
+/** @brief Update the message ID of the transaction */
+void coap_transaction_set_mid(coap_transaction_t *t, uint16_t mid)
+  OC_NONNULL();
+
+/** @brief Update the token of the transaction */
+void coap_transaction_set_token(coap_transaction_t *t, const uint8_t *token,
+                                uint8_t token_len) OC_NONNULL(1);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
 coap_transaction_t *coap_get_transaction_by_token(const uint8_t *token,
                                                   uint8_t token_len);
@@ -276,7 +276,7 @@ TEST_F(TestMessagingBlockwise, FindRequestByMid)
   oc_blockwise_role_t r1 = OC_BLOCKWISE_CLIENT;
   oc_blockwise_state_t *bw1 = allocBuffer(false, h1, ep1_str, m1, r1);
   ASSERT_NE(nullptr, bw1);
-  bw1->mid = mid;
+  oc_blockwise_set_mid(bw1, mid);
 
   // non-matching mid
   EXPECT_EQ(nullptr, oc_blockwise_find_request_buffer_by_mid(2));
@@ -300,7 +300,7 @@ TEST_F(TestMessagingBlockwise, FindResponseByMid)
   oc_blockwise_role_t r1 = OC_BLOCKWISE_CLIENT;
   oc_blockwise_state_t *bw1 = allocBuffer(true, h1, ep1_str, m1, r1);
   ASSERT_NE(nullptr, bw1);
-  bw1->mid = mid;
+  oc_blockwise_set_mid(bw1, mid);
 
   // non-matching mid
   EXPECT_EQ(nullptr, oc_blockwise_find_response_buffer_by_mid(2));
@@ -326,8 +326,8 @@ TEST_F(TestMessagingBlockwise, FindRequestByToken)
   oc_blockwise_role_t r1 = OC_BLOCKWISE_CLIENT;
   oc_blockwise_state_t *bw1 = allocBuffer(false, h1, ep1_str, m1, r1);
   ASSERT_NE(nullptr, bw1);
-  memcpy(&bw1->token[0], token1.data(), token1.size());
-  bw1->token_len = token1.size();
+  oc_blockwise_set_token(bw1, token1.data(),
+                         static_cast<uint8_t>(token1.size()));
 
   // shorter token
   std::array<uint8_t, 1> token2{};
@@ -363,8 +363,8 @@ TEST_F(TestMessagingBlockwise, FindResponseByToken)
   oc_blockwise_role_t r1 = OC_BLOCKWISE_CLIENT;
   oc_blockwise_state_t *bw1 = allocBuffer(true, h1, ep1_str, m1, r1);
   ASSERT_NE(nullptr, bw1);
-  memcpy(&bw1->token[0], token1.data(), token1.size());
-  bw1->token_len = token1.size();
+  oc_blockwise_set_token(bw1, token1.data(),
+                         static_cast<uint8_t>(token1.size()));
 
   // shorter token
   std::array<uint8_t, 1> token2{};
@@ -523,6 +523,9 @@ TEST_F(TestMessagingBlockwise, BlockwiseRequest)
     /*.block2 =*/coap_packet_get_block_options(&request_pkt, true),
     /*.request_buffer =*/nullptr,
     /*.response_buffer =*/nullptr,
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+    /*.stream =*/nullptr,
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   };
   bool invoked = false;
   ASSERT_EQ(COAP_RECEIVE_SUCCESS,
@@ -649,6 +652,9 @@ TEST_F(TestMessagingBlockwise, BlockwiseRequest_FailInvalidSize)
     /*.block2 =*/coap_packet_get_block_options(&request_pkt, true),
     /*.request_buffer =*/nullptr,
     /*.response_buffer =*/nullptr,
+#ifdef OC_HAS_FEATURE_BLOCKWISE_STREAM
+    /*.stream =*/nullptr,
+#endif /* OC_HAS_FEATURE_BLOCKWISE_STREAM */
   };
   EXPECT_NE(COAP_RECEIVE_SUCCESS,
             coap_receive(&ctx, &endpoint, always_valid, nullptr, skip_response,
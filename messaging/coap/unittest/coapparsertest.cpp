@@ -0,0 +1,425 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_COAP_FAST_PARSER
+
+#include "messaging/coap/coap_internal.h"
+#include "messaging/coap/constants.h"
+#include "messaging/coap/options_internal.h"
+#include "tests/gtest/Benchmark.h"
+
+#ifdef OC_TCP
+#include "messaging/coap/signal_internal.h"
+#endif /* OC_TCP */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Option
+{
+  unsigned number;
+  std::vector<uint8_t> value;
+};
+
+void
+appendExtendedField(std::vector<uint8_t> &data, size_t value)
+{
+  if (value >= 269) {
+    value -= 269;
+    data.push_back(static_cast<uint8_t>(value >> 8));
+    data.push_back(static_cast<uint8_t>(value));
+  } else if (value >= 13) {
+    data.push_back(static_cast<uint8_t>(value - 13));
+  }
+}
+
+uint8_t
+nibble(size_t value)
+{
+  if (value >= 269) {
+    return 14;
+  }
+  return value >= 13 ? 13 : static_cast<uint8_t>(value);
+}
+
+// encode a UDP message with the options in the given order
+std::vector<uint8_t>
+encodeMessage(uint8_t code, const std::vector<Option> &options,
+              const std::vector<uint8_t> &payload)
+{
+  std::vector<uint8_t> data{
+    0x52, code, 0x12, 0x34, 0xAB, 0xCD,
+  };
+  unsigned number = 0;
+  for (const auto &option : options) {
+    size_t delta = option.number - number;
+    number = option.number;
+    data.push_back(static_cast<uint8_t>(nibble(delta) << 4) |
+                   nibble(option.value.size()));
+    appendExtendedField(data, delta);
+    appendExtendedField(data, option.value.size());
+    data.insert(data.end(), option.value.begin(), option.value.end());
+  }
+  if (!payload.empty()) {
+    data.push_back(0xFF);
+    data.insert(data.end(), payload.begin(), payload.end());
+  }
+  return data;
+}
+
+constexpr size_t kTokenOffset = COAP_HEADER_LEN + 2;
+
+struct Parsed
+{
+  std::vector<uint8_t> data;
+  coap_packet_t packet;
+  coap_status_t status;
+};
+
+Parsed
+parse(const std::vector<uint8_t> &data, bool indexed, bool inner, bool outer,
+      bool oscore, bool validate)
+{
+  Parsed p{};
+  p.data = data;
+  memset(&p.packet, 0, sizeof(p.packet));
+  p.packet.code = data[1];
+  uint8_t *current_option = p.data.data() + kTokenOffset;
+  if (indexed) {
+    p.status = coap_oscore_parse_options(&p.packet, p.data.data(),
+                                         p.data.size(), current_option, inner,
+                                         outer, oscore, validate);
+  } else {
+    p.status = coap_oscore_parse_options_sequential(
+      &p.packet, p.data.data(), p.data.size(), current_option, inner, outer,
+      oscore, validate);
+  }
+  return p;
+}
+
+// offset of a view into the parsed message
+ptrdiff_t
+offset(const Parsed &p, const void *view)
+{
+  if (view == nullptr) {
+    return -1;
+  }
+  return static_cast<const uint8_t *>(view) - p.data.data();
+}
+
+void
+expectEqual(const Parsed &expected, const Parsed &p)
+{
+  ASSERT_EQ(expected.status, p.status);
+  if (expected.status == BAD_REQUEST_4_00) {
+    return;
+  }
+  const coap_packet_t &e = expected.packet;
+  const coap_packet_t &a = p.packet;
+  EXPECT_EQ(0, memcmp(e.options, a.options, sizeof(e.options)));
+  EXPECT_EQ(e.content_format, a.content_format);
+  EXPECT_EQ(e.max_age, a.max_age);
+  ASSERT_EQ(e.etag_len, a.etag_len);
+  EXPECT_EQ(0, memcmp(e.etag, a.etag, e.etag_len));
+  EXPECT_EQ(offset(expected, e.proxy_uri), offset(p, a.proxy_uri));
+  EXPECT_EQ(e.proxy_uri_len, a.proxy_uri_len);
+  EXPECT_EQ(offset(expected, e.uri_host), offset(p, a.uri_host));
+  EXPECT_EQ(e.uri_host_len, a.uri_host_len);
+  EXPECT_EQ(e.uri_port, a.uri_port);
+  EXPECT_EQ(offset(expected, e.uri_path), offset(p, a.uri_path));
+  EXPECT_EQ(e.uri_path_len, a.uri_path_len);
+  EXPECT_EQ(offset(expected, e.uri_query), offset(p, a.uri_query));
+  EXPECT_EQ(e.uri_query_len, a.uri_query_len);
+  EXPECT_EQ(e.observe, a.observe);
+  EXPECT_EQ(e.accept, a.accept);
+  EXPECT_EQ(e.block2_num, a.block2_num);
+  EXPECT_EQ(e.block2_more, a.block2_more);
+  EXPECT_EQ(e.block2_size, a.block2_size);
+  EXPECT_EQ(e.block2_offset, a.block2_offset);
+  EXPECT_EQ(e.block1_num, a.block1_num);
+  EXPECT_EQ(e.block1_more, a.block1_more);
+  EXPECT_EQ(e.block1_size, a.block1_size);
+  EXPECT_EQ(e.block1_offset, a.block1_offset);
+  EXPECT_EQ(e.size2, a.size2);
+  EXPECT_EQ(e.size1, a.size1);
+#ifdef OC_TCP
+  EXPECT_EQ(e.max_msg_size, a.max_msg_size);
+  EXPECT_EQ(e.blockwise_transfer, a.blockwise_transfer);
+  EXPECT_EQ(e.custody, a.custody);
+  EXPECT_EQ(offset(expected, e.alt_addr), offset(p, a.alt_addr));
+  EXPECT_EQ(e.alt_addr_len, a.alt_addr_len);
+  EXPECT_EQ(e.hold_off, a.hold_off);
+  EXPECT_EQ(e.bad_csm_opt, a.bad_csm_opt);
+#endif /* OC_TCP */
+#ifdef OC_OSCORE
+  EXPECT_EQ(e.oscore_flags, a.oscore_flags);
+  ASSERT_EQ(e.piv_len, a.piv_len);
+  EXPECT_EQ(0, memcmp(e.piv, a.piv, e.piv_len));
+  ASSERT_EQ(e.kid_ctx_len, a.kid_ctx_len);
+  EXPECT_EQ(0, memcmp(e.kid_ctx, a.kid_ctx, e.kid_ctx_len));
+  ASSERT_EQ(e.kid_len, a.kid_len);
+  EXPECT_EQ(0, memcmp(e.kid, a.kid, e.kid_len));
+#endif /* OC_OSCORE */
+  EXPECT_EQ(offset(expected, e.payload), offset(p, a.payload));
+  EXPECT_EQ(e.payload_len, a.payload_len);
+  // multi-value options are joined in place
+  EXPECT_EQ(expected.data, p.data);
+}
+
+void
+expectEquivalent(const std::vector<uint8_t> &data)
+{
+  for (int flags = 0; flags < 16; ++flags) {
+    bool inner = (flags & 1) != 0;
+    bool outer = (flags & 2) != 0;
+    bool oscore = (flags & 4) != 0;
+    bool validate = (flags & 8) != 0;
+    Parsed expected = parse(data, false, inner, outer, oscore, validate);
+    Parsed p = parse(data, true, inner, outer, oscore, validate);
+    expectEqual(expected, p);
+  }
+}
+
+} // namespace
+
+TEST(TestCoapParser, Empty)
+{
+  expectEquivalent(encodeMessage(COAP_GET, {}, {}));
+  expectEquivalent(encodeMessage(COAP_GET, {}, { 1, 2, 3 }));
+}
+
+TEST(TestCoapParser, UriPath)
+{
+  std::vector<Option> options{};
+  // 1-byte and 2-byte option headers
+  for (size_t len : { 1, 5, 12, 13, 40, 3 }) {
+    options.push_back({ COAP_OPTION_URI_PATH, std::vector<uint8_t>(len, 'p') });
+  }
+  options.push_back({ COAP_OPTION_URI_QUERY, { 'a', '=', '1' } });
+  options.push_back({ COAP_OPTION_URI_QUERY, { 'b', '=', '2' } });
+  std::vector<uint8_t> data = encodeMessage(COAP_GET, options, { 42 });
+  expectEquivalent(data);
+
+  Parsed p = parse(data, true, true, true, false, false);
+  ASSERT_EQ(COAP_NO_ERROR, p.status);
+  // the joined path is a view into the message
+  EXPECT_EQ(kTokenOffset + 1, offset(p, p.packet.uri_path));
+  EXPECT_EQ(1 + 5 + 12 + 13 + 40 + 3 + 5, p.packet.uri_path_len);
+  EXPECT_EQ("a=1&b=2",
+            std::string(p.packet.uri_query, p.packet.uri_query_len));
+}
+
+TEST(TestCoapParser, ManyOptions)
+{
+  // more options than are indexed by a single pass
+  std::vector<Option> options{};
+  for (int i = 0; i < 50; ++i) {
+    options.push_back(
+      { COAP_OPTION_URI_PATH, { static_cast<uint8_t>('a' + i % 26) } });
+  }
+  options.push_back({ COAP_OPTION_ACCEPT, { 0x27, 0x10 } });
+  std::vector<uint8_t> data = encodeMessage(COAP_GET, options, { 1 });
+  expectEquivalent(data);
+
+  Parsed p = parse(data, true, true, true, false, false);
+  ASSERT_EQ(COAP_NO_ERROR, p.status);
+  EXPECT_EQ(99, p.packet.uri_path_len);
+  EXPECT_EQ(APPLICATION_VND_OCF_CBOR, p.packet.accept);
+  EXPECT_EQ(1, p.packet.payload_len);
+}
+
+TEST(TestCoapParser, Truncated)
+{
+  std::vector<Option> options{
+    { COAP_OPTION_URI_PATH, std::vector<uint8_t>(300, 'p') },
+    { 2000, std::vector<uint8_t>(20, 'x') },
+  };
+  std::vector<uint8_t> data = encodeMessage(COAP_GET, options, {});
+  // the first option ends after its 3-byte header and 300 bytes of value
+  size_t boundary = kTokenOffset + 3 + 300;
+  for (size_t size = kTokenOffset + 1; size < data.size(); ++size) {
+    std::vector<uint8_t> truncated(data.begin(), data.begin() + size);
+    expectEquivalent(truncated);
+    // a truncated extended field or value must be rejected
+    EXPECT_EQ(size == boundary ? COAP_NO_ERROR : BAD_REQUEST_4_00,
+              parse(truncated, true, true, true, false, false).status);
+  }
+}
+
+TEST(TestCoapParser, FuzzEquivalence)
+{
+  std::mt19937 gen(0x0CF);
+  const std::array<unsigned, 28> numbers{
+    COAP_OPTION_IF_MATCH,
+    COAP_OPTION_URI_HOST,
+    COAP_OPTION_ETAG,
+    COAP_OPTION_IF_NONE_MATCH,
+    COAP_OPTION_OBSERVE,
+    COAP_OPTION_URI_PORT,
+    COAP_OPTION_LOCATION_PATH,
+    COAP_OPTION_OSCORE,
+    COAP_OPTION_URI_PATH,
+    COAP_OPTION_CONTENT_FORMAT,
+    COAP_OPTION_MAX_AGE,
+    COAP_OPTION_URI_QUERY,
+    COAP_OPTION_ACCEPT,
+    COAP_OPTION_LOCATION_QUERY,
+    COAP_OPTION_BLOCK2,
+    COAP_OPTION_BLOCK1,
+    COAP_OPTION_SIZE2,
+    COAP_OPTION_PROXY_URI,
+    COAP_OPTION_PROXY_SCHEME,
+    COAP_OPTION_SIZE1,
+    OCF_OPTION_ACCEPT_CONTENT_FORMAT_VER,
+    OCF_OPTION_CONTENT_FORMAT_VER,
+    // unknown elective and critical options
+    2,
+    10,
+    258,
+    1001,
+    5000,
+    65000,
+  };
+  const std::array<size_t, 12> lengths{ 0,  1,  2,  3,   4,   8,
+                                        12, 13, 14, 268, 269, 300 };
+#ifdef OC_TCP
+  const std::array<uint8_t, 5> codes{ COAP_GET, COAP_POST, CONTENT_2_05,
+                                      CSM_7_01, RELEASE_7_04 };
+#else  /* !OC_TCP */
+  const std::array<uint8_t, 3> codes{ COAP_GET, COAP_POST, CONTENT_2_05 };
+#endif /* OC_TCP */
+
+  auto pick = [&gen](size_t size) {
+    return std::uniform_int_distribution<size_t>(0, size - 1)(gen);
+  };
+  for (int i = 0; i < 3000; ++i) {
+    std::vector<Option> options{};
+    size_t count = pick(24);
+    for (size_t j = 0; j < count; ++j) {
+      Option option{};
+      option.number = numbers[pick(numbers.size())];
+      // short values are parsed as integers by most options
+      size_t length = pick(2) == 0 ? pick(5) : lengths[pick(lengths.size())];
+      for (size_t k = 0; k < length; ++k) {
+        option.value.push_back(static_cast<uint8_t>(pick(256)));
+      }
+      options.push_back(option);
+    }
+    std::stable_sort(
+      options.begin(), options.end(),
+      [](const Option &a, const Option &b) { return a.number < b.number; });
+    std::vector<uint8_t> payload(pick(2) == 0 ? 0 : pick(32));
+    std::vector<uint8_t> data =
+      encodeMessage(codes[pick(codes.size())], options, payload);
+
+    expectEquivalent(data);
+    // corrupt the message
+    size_t options_size = data.size() - kTokenOffset;
+    switch (options_size == 0 ? 2 : pick(3)) {
+    case 0:
+      data[kTokenOffset + pick(options_size)] =
+        static_cast<uint8_t>(pick(256));
+      break;
+    case 1:
+      data.resize(kTokenOffset + pick(options_size));
+      break;
+    default:
+      data.push_back(static_cast<uint8_t>(pick(256)));
+      break;
+    }
+    expectEquivalent(data);
+    if (HasFailure()) {
+      FAIL() << "iteration " << i;
+    }
+  }
+}
+
+// measures the speed only, run with --gtest_also_run_disabled_tests
+TEST(TestCoapParser, DISABLED_Benchmark)
+{
+  // a typical request of an OCF client
+  std::vector<Option> options{
+    { COAP_OPTION_OBSERVE, { 0 } },
+    { COAP_OPTION_URI_PATH, { 'a', '/', 'l', 'i', 'g', 'h', 't' } },
+    { COAP_OPTION_URI_PATH, { 'l', 'e', 'v', 'e', 'l' } },
+    { COAP_OPTION_URI_PATH, { '1' } },
+    { COAP_OPTION_CONTENT_FORMAT, { 0x27, 0x10 } },
+    { COAP_OPTION_URI_QUERY, { 'i', 'f', '=', 'o', 'i', 'c', '.', 'i', 'f',
+                               '.', 'b', 'a', 's', 'e', 'l', 'i', 'n', 'e' } },
+    { COAP_OPTION_URI_QUERY, { 'r', 't', '=', 'l', 'i', 'g', 'h', 't' } },
+    { COAP_OPTION_ACCEPT, { 0x27, 0x10 } },
+    { COAP_OPTION_BLOCK2, { 0x06 } },
+    { OCF_OPTION_ACCEPT_CONTENT_FORMAT_VER, { 0x08, 0x00 } },
+    { OCF_OPTION_CONTENT_FORMAT_VER, { 0x08, 0x00 } },
+  };
+  const std::vector<uint8_t> message =
+    encodeMessage(COAP_POST, options, std::vector<uint8_t>(64, 0xBF));
+  expectEquivalent(message);
+
+  constexpr size_t kIterations = 200000;
+  std::vector<uint8_t> data(message.size());
+  auto run = [&data, &message](bool indexed) {
+    // multi-value options are joined in place, so parse a fresh copy
+    memcpy(data.data(), message.data(), message.size());
+    coap_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.code = COAP_POST;
+    uint8_t *current_option = data.data() + kTokenOffset;
+    if (indexed) {
+      return coap_oscore_parse_options(&packet, data.data(), data.size(),
+                                       current_option, true, true, false,
+                                       false);
+    }
+    return coap_oscore_parse_options_sequential(&packet, data.data(),
+                                                data.size(), current_option,
+                                                true, true, false, false);
+  };
+  // compare the best of several alternating runs, a single run is easily
+  // skewed by other processes
+  constexpr int kRounds = 5;
+  double sequential = 0;
+  double indexed = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    auto seq = oc::Benchmark("CoAP.ParseOptions", kIterations,
+                             [&run](size_t) { run(false); });
+    auto idx = oc::Benchmark("CoAP.ParseOptionsIndexed", kIterations,
+                             [&run](size_t) { run(true); });
+    if (round == 0 || seq.NsPerOp() < sequential) {
+      sequential = seq.NsPerOp();
+    }
+    if (round == 0 || idx.NsPerOp() < indexed) {
+      indexed = idx.NsPerOp();
+    }
+  }
+  printf("[ BENCH    ] best of %d rounds: sequential %.1f ns/op, indexed %.1f "
+         "ns/op\n",
+         kRounds, sequential, indexed);
+}
+
+#endif /* OC_HAS_FEATURE_COAP_FAST_PARSER */
@@ -0,0 +1,246 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+
+#include "messaging/coap/coap_internal.h"
+#include "messaging/coap/constants.h"
+#include "messaging/coap/options_internal.h"
+#include "tests/gtest/Benchmark.h"
+
+#include <array>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+class TestHeaderTemplate : public testing::Test {
+public:
+  void SetUp() override
+  {
+    coap_header_template_reset(&tmpl_);
+    payload_.assign(64, 0xAB);
+  }
+
+  coap_packet_t MakeNotification(int32_t observe,
+                                 coap_message_type_t type = COAP_TYPE_NON,
+                                 uint16_t mid = 0x1234)
+  {
+    coap_packet_t packet;
+    coap_udp_init_message(&packet, type, CONTENT_2_05, mid);
+    coap_set_token(&packet, token_.data(), token_.size());
+    coap_options_set_observe(&packet, observe);
+    coap_options_set_content_format(&packet, APPLICATION_VND_OCF_CBOR);
+    if (!etag_.empty()) {
+      coap_options_set_etag(&packet, etag_.data(),
+                            static_cast<uint8_t>(etag_.size()));
+    }
+    coap_set_payload(&packet, payload_.data(),
+                     static_cast<uint32_t>(payload_.size()));
+    return packet;
+  }
+
+  // serialize the packet with and without the template, the results must be
+  // equal
+  void ExpectSerializedEqual(const coap_packet_t &packet)
+  {
+    coap_packet_t regular = packet;
+    std::vector<uint8_t> expected(kBufferSize);
+    size_t expected_size =
+      coap_serialize_message(&regular, expected.data(), expected.size());
+    ASSERT_LT(0, expected_size);
+    expected.resize(expected_size);
+
+    coap_packet_t templated = packet;
+    std::vector<uint8_t> buffer(kBufferSize);
+    size_t size = coap_serialize_message_with_template(
+      &templated, &tmpl_, buffer.data(), buffer.size());
+    buffer.resize(size);
+    EXPECT_EQ(expected, buffer);
+  }
+
+  static constexpr size_t kBufferSize = 1024;
+
+  std::array<uint8_t, 8> token_{ 1, 2, 3, 4, 5, 6, 7, 8 };
+  std::vector<uint8_t> etag_{ 8, 7, 6, 5, 4, 3, 2, 1 };
+  std::vector<uint8_t> payload_{};
+  coap_header_template_t tmpl_{};
+};
+
+TEST_F(TestHeaderTemplate, Set)
+{
+  EXPECT_EQ(0, tmpl_.size);
+  ExpectSerializedEqual(MakeNotification(2));
+  EXPECT_LT(0, tmpl_.size);
+  EXPECT_EQ(1, tmpl_.observe_len);
+  EXPECT_EQ(etag_.size(), tmpl_.etag_len);
+
+  coap_header_template_reset(&tmpl_);
+  EXPECT_EQ(0, tmpl_.size);
+}
+
+TEST_F(TestHeaderTemplate, PatchFields)
+{
+  ExpectSerializedEqual(MakeNotification(2));
+  uint8_t size = tmpl_.size;
+
+  // the template is patched
+  for (int32_t observe = 3; observe < 255; ++observe) {
+    etag_[0] = static_cast<uint8_t>(observe);
+    ExpectSerializedEqual(MakeNotification(
+      observe, observe % 2 == 0 ? COAP_TYPE_CON : COAP_TYPE_NON,
+      static_cast<uint16_t>(observe * 7)));
+  }
+  payload_.clear();
+  ExpectSerializedEqual(MakeNotification(255));
+  payload_.assign(512, 0xCD);
+  ExpectSerializedEqual(MakeNotification(255));
+  EXPECT_EQ(size, tmpl_.size);
+}
+
+TEST_F(TestHeaderTemplate, ChangeLength)
+{
+  // the template is set again when the length of a patched option changes
+  for (int32_t observe :
+       { 2, 255, 256, 257, 65535, 65536, 65537,
+         static_cast<int32_t>(OC_COAP_OPTION_OBSERVE_MAX_VALUE) }) {
+    ExpectSerializedEqual(MakeNotification(observe));
+  }
+  EXPECT_EQ(3, tmpl_.observe_len);
+
+  etag_.resize(4);
+  ExpectSerializedEqual(MakeNotification(2));
+  EXPECT_EQ(4, tmpl_.etag_len);
+  etag_.clear();
+  ExpectSerializedEqual(MakeNotification(2));
+  EXPECT_EQ(0, tmpl_.etag_len);
+}
+
+TEST_F(TestHeaderTemplate, ChangeFields)
+{
+  ExpectSerializedEqual(MakeNotification(2));
+
+  // the template is set again for a different token, code or content format
+  token_[7] = 42;
+  ExpectSerializedEqual(MakeNotification(3));
+  EXPECT_EQ(42, tmpl_.buffer[COAP_HEADER_LEN + 7]);
+
+  coap_packet_t packet = MakeNotification(4);
+  coap_set_status_code(&packet, VALID_2_03);
+  ExpectSerializedEqual(packet);
+  EXPECT_EQ(VALID_2_03, tmpl_.code);
+
+  packet = MakeNotification(5);
+  coap_options_set_content_format(&packet, APPLICATION_CBOR);
+  ExpectSerializedEqual(packet);
+  EXPECT_EQ(APPLICATION_CBOR, tmpl_.content_format);
+
+  packet = MakeNotification(OC_COAP_OPTION_OBSERVE_UNREGISTER);
+  UNSET_OPTION(&packet, COAP_OPTION_OBSERVE);
+  ExpectSerializedEqual(packet);
+  EXPECT_EQ(0, tmpl_.observe_len);
+}
+
+TEST_F(TestHeaderTemplate, Unsupported)
+{
+  // block-wise notifications are serialized without the template
+  coap_packet_t packet = MakeNotification(2);
+  coap_options_set_block2(&packet, 0, 1, 16, 0);
+  coap_options_set_size2(&packet, 1024);
+  ExpectSerializedEqual(packet);
+  EXPECT_EQ(0, tmpl_.size);
+
+  // empty message
+  coap_udp_init_message(&packet, COAP_TYPE_ACK, 0, 1);
+  ExpectSerializedEqual(packet);
+  EXPECT_EQ(0, tmpl_.size);
+
+#ifdef OC_TCP
+  coap_tcp_init_message(&packet, CONTENT_2_05);
+  coap_set_token(&packet, token_.data(), token_.size());
+  coap_options_set_observe(&packet, 2);
+  ExpectSerializedEqual(packet);
+  EXPECT_EQ(0, tmpl_.size);
+#endif /* OC_TCP */
+}
+
+TEST_F(TestHeaderTemplate, BufferTooSmall)
+{
+  ExpectSerializedEqual(MakeNotification(2));
+  ASSERT_LT(0, tmpl_.size);
+
+  coap_packet_t packet = MakeNotification(3);
+  std::vector<uint8_t> buffer(tmpl_.size + payload_.size());
+  EXPECT_EQ(0, coap_serialize_message_with_template(&packet, &tmpl_,
+                                                    buffer.data(),
+                                                    buffer.size()));
+  buffer.resize(buffer.size() + COAP_PAYLOAD_MARKER_LEN);
+  EXPECT_EQ(buffer.size(),
+            coap_serialize_message_with_template(&packet, &tmpl_,
+                                                 buffer.data(), buffer.size()));
+}
+
+TEST_F(TestHeaderTemplate, Parse)
+{
+  ExpectSerializedEqual(MakeNotification(256));
+  etag_[0] = 42;
+
+  coap_packet_t packet = MakeNotification(300, COAP_TYPE_CON, 0xBEEF);
+  std::vector<uint8_t> buffer(kBufferSize);
+  size_t size = coap_serialize_message_with_template(
+    &packet, &tmpl_, buffer.data(), buffer.size());
+  ASSERT_LT(0, size);
+
+  coap_packet_t parsed;
+  ASSERT_EQ(COAP_NO_ERROR, coap_udp_parse_message(&parsed, buffer.data(), size,
+                                                  /*validate*/ false));
+  EXPECT_EQ(COAP_TYPE_CON, parsed.type);
+  EXPECT_EQ(0xBEEF, parsed.mid);
+  int32_t observe = 0;
+  EXPECT_TRUE(coap_options_get_observe(&parsed, &observe));
+  EXPECT_EQ(300, observe);
+  const uint8_t *etag = nullptr;
+  ASSERT_EQ(etag_.size(), coap_options_get_etag(&parsed, &etag));
+  EXPECT_EQ(etag_, std::vector<uint8_t>(etag, etag + etag_.size()));
+  EXPECT_EQ(payload_.size(), parsed.payload_len);
+}
+
+// measures the speed only, run with --gtest_also_run_disabled_tests
+TEST_F(TestHeaderTemplate, DISABLED_Benchmark)
+{
+  constexpr size_t kIterations = 200000;
+  std::vector<uint8_t> buffer(kBufferSize);
+
+  auto observe = [](size_t i) { return static_cast<int32_t>(i % 200) + 2; };
+  auto regular = oc::Benchmark(
+    "CoAP.SerializeNotification", kIterations, [&](size_t i) {
+      coap_packet_t packet = MakeNotification(observe(i));
+      coap_serialize_message(&packet, buffer.data(), buffer.size());
+    });
+  auto templated = oc::Benchmark(
+    "CoAP.SerializeNotificationWithTemplate", kIterations, [&](size_t i) {
+      coap_packet_t packet = MakeNotification(observe(i));
+      coap_serialize_message_with_template(&packet, &tmpl_, buffer.data(),
+                                           buffer.size());
+    });
+  printf("[ BENCH    ] serialization with the template is %.1fx faster\n",
+         regular.NsPerOp() / templated.NsPerOp());
+}
+
+#endif /* OC_HAS_FEATURE_COAP_HEADER_TEMPLATE */
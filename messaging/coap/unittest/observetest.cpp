@@ -28,15 +28,21 @@
 #include "oc_core_res.h"
 #include "port/oc_allocator_internal.h"
 #include "port/oc_random.h"
+#include "tests/gtest/Benchmark.h"
 #include "tests/gtest/Device.h"
 #include "tests/gtest/Endpoint.h"
 #include "util/oc_list.h"
 #include "util/oc_mmem_internal.h"
 
+#ifdef OC_SECURITY
+#include "security/oc_security_internal.h"
+#endif /* OC_SECURITY */
+
 #include <array>
 #include <gtest/gtest.h>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class TestObserver : public testing::Test {
 public:
@@ -455,6 +461,159 @@ TEST_F(TestObserver, RemoveAllObserversByResource)
   coap_free_all_observers();
 }
 
+TEST_F(TestObserver, RemoveKeepsOrder)
+{
+  std::array<std::string, 2> uris{ "/res/1", "/res/2" };
+  std::array<oc_resource_t, 2> resources{};
+  for (size_t i = 0; i < resources.size(); ++i) {
+    resources[i].uri = OC_MMEM(&uris[i][0], uris[i].length() + 1, nullptr);
+  }
+  std::array<oc_endpoint_t, 3> endpoints{};
+  for (size_t i = 0; i < endpoints.size(); ++i) {
+    endpoints[i] = oc::endpoint::FromString("coap://[::1]:" +
+                                            std::to_string(1337 + i));
+  }
+  std::array<uint8_t, COAP_TOKEN_LEN> token;
+  oc_random_buffer(token.data(), token.size());
+
+  // observer of each resource by each client, interleaved by client
+  std::vector<coap_observer_t *> observers{};
+  for (const auto &ep : endpoints) {
+    for (size_t i = 0; i < resources.size(); ++i) {
+      coap_observer_t *obs =
+        coap_add_observer(&resources[i], 0, &ep, token.data(), token.size(),
+                          uris[i].c_str(), uris[i].length(), OC_IF_BASELINE);
+      ASSERT_NE(nullptr, obs);
+      observers.push_back(obs);
+    }
+  }
+  ASSERT_EQ(6, oc_list_length(coap_get_observers()));
+
+  auto expectObservers = [](const std::vector<coap_observer_t *> &expected) {
+    std::vector<coap_observer_t *> list{};
+    for (auto *obs = static_cast<coap_observer_t *>(
+           oc_list_head(coap_get_observers()));
+         obs != nullptr; obs = obs->next) {
+      list.push_back(obs);
+    }
+    EXPECT_EQ(expected, list);
+  };
+
+  // the first observer of the second client
+  EXPECT_TRUE(coap_remove_observer_by_token(&endpoints[1], token.data(),
+                                            token.size()));
+  expectObservers({ observers[0], observers[1], observers[3], observers[4],
+                    observers[5] });
+  EXPECT_EQ(2, resources[0].num_observers);
+  EXPECT_EQ(3, resources[1].num_observers);
+
+  // the other observer of the second client
+  EXPECT_EQ(1, coap_remove_observers_by_client(&endpoints[1]));
+  EXPECT_EQ(0, coap_remove_observers_by_client(&endpoints[1]));
+  expectObservers({ observers[0], observers[1], observers[4], observers[5] });
+
+  // the last observer of the first resource
+  observers[4]->last_mid = 42;
+  EXPECT_TRUE(coap_remove_observer_by_mid(&endpoints[2], 42));
+  expectObservers({ observers[0], observers[1], observers[5] });
+  EXPECT_EQ(1, resources[0].num_observers);
+
+  EXPECT_EQ(2, coap_remove_observers_by_resource(&resources[1]));
+  expectObservers({ observers[0] });
+  EXPECT_EQ(0, resources[1].num_observers);
+
+  // a new observer of a client is found after the removals
+  ASSERT_NE(nullptr, coap_add_observer(&resources[1], 0, &endpoints[0],
+                                       token.data(), token.size(),
+                                       uris[1].c_str(), uris[1].length(),
+                                       OC_IF_BASELINE));
+  EXPECT_EQ(2, coap_remove_observers_by_client(&endpoints[0]));
+  EXPECT_EQ(0, oc_list_length(coap_get_observers()));
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+class TestObserverBenchmark : public TestObserver,
+                              public testing::WithParamInterface<size_t> {
+public:
+  static constexpr size_t kResources = 100;
+
+  void SetUp() override
+  {
+    for (size_t i = 0; i < kResources; ++i) {
+      uris_.push_back("/res/" + std::to_string(i));
+    }
+    for (size_t i = 0; i < kResources; ++i) {
+      resources_[i].uri = OC_MMEM(&uris_[i][0], uris_[i].length() + 1, nullptr);
+    }
+  }
+
+  void TearDown() override { coap_free_all_observers(); }
+
+  oc_endpoint_t endpoint(size_t index) const
+  {
+    return oc::endpoint::FromString("coap://[::1]:" +
+                                    std::to_string(10000 + index));
+  }
+
+  coap_observer_t *addObserver(size_t index, const oc_endpoint_t &ep)
+  {
+    const auto token = static_cast<uint32_t>(index);
+    size_t r = index % kResources;
+    return coap_add_observer(&resources_[r], 0, &ep,
+                             reinterpret_cast<const uint8_t *>(&token),
+                             sizeof(token), uris_[r].c_str(),
+                             uris_[r].length(), OC_IF_BASELINE);
+  }
+
+  std::vector<std::string> uris_{};
+  std::array<oc_resource_t, kResources> resources_{};
+};
+
+INSTANTIATE_TEST_SUITE_P(Observers, TestObserverBenchmark,
+                         testing::Values(100, 1000, 5000));
+
+/** deregistration and lookups must not scan all observers */
+TEST_P(TestObserverBenchmark, Deregister)
+{
+  size_t count = GetParam();
+  // two observers per client
+  std::vector<oc_endpoint_t> endpoints{};
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 2 == 0) {
+      endpoints.push_back(endpoint(i / 2));
+    }
+    ASSERT_NE(nullptr, addObserver(i, endpoints.back()));
+  }
+
+  constexpr size_t kIterations = 10000;
+  std::string suffix = ", " + std::to_string(count) + " observers";
+  oc::Benchmark("deregister by token and register" + suffix, kIterations,
+                [this, count, &endpoints](size_t i) {
+                  size_t index = i % count;
+                  const auto token = static_cast<uint32_t>(index);
+                  const oc_endpoint_t &ep = endpoints[index / 2];
+                  ASSERT_TRUE(coap_remove_observer_by_token(
+                    &ep, reinterpret_cast<const uint8_t *>(&token),
+                    sizeof(token)));
+                  ASSERT_NE(nullptr, addObserver(index, ep));
+                });
+  oc::Benchmark("remove client and register" + suffix, kIterations,
+                [this, count, &endpoints](size_t i) {
+                  size_t index = (i % (count / 2)) * 2;
+                  const oc_endpoint_t &ep = endpoints[index / 2];
+                  ASSERT_EQ(2, coap_remove_observers_by_client(&ep));
+                  ASSERT_NE(nullptr, addObserver(index, ep));
+                  ASSERT_NE(nullptr, addObserver(index + 1, ep));
+                });
+  oc::Benchmark("is observed" + suffix, kIterations, [this](size_t i) {
+    ASSERT_TRUE(coap_resource_is_observed(&resources_[i % kResources]));
+  });
+  EXPECT_EQ(count, oc_list_length(coap_get_observers()));
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
 static constexpr size_t kDeviceID{ 0 };
 
 class TestObserverWithServer : public testing::Test {
@@ -488,6 +647,176 @@ TEST_F(TestObserverWithServer, ResourceIsObserved)
   ASSERT_FALSE(coap_resource_is_observed(con));
 }
 
+#ifdef OC_SERVER
+
+class TestObserverNotification : public TestObserverWithServer {
+public:
+  void SetUp() override
+  {
+    oc::DynamicResourceHandler handlers{};
+    handlers.onGet = onGet;
+    auto dr = oc::makeDynamicResourceToAdd(
+      "Sensor", "/sensor", { "oic.r.sensor" }, { OC_IF_BASELINE, OC_IF_R },
+      handlers, OC_OBSERVABLE);
+    resource_ = oc::TestDevice::AddDynamicResource(dr, kDeviceID);
+    ASSERT_NE(nullptr, resource_);
+    oc_resource_set_default_interface(resource_, OC_IF_R);
+    get_count_ = 0;
+    ignored_count_ = 0;
+#ifdef OC_SECURITY
+    // must be in RFNOP to send notifications
+    oc_sec_self_own(kDeviceID);
+#endif /* OC_SECURITY */
+  }
+
+  void TearDown() override
+  {
+    coap_free_all_observers();
+    coap_free_all_transactions();
+#ifdef OC_SECURITY
+    oc_sec_self_disown(kDeviceID);
+#endif /* OC_SECURITY */
+    oc::TestDevice::ClearDynamicResource(resource_);
+    TestObserverWithServer::TearDown();
+  }
+
+  static void onGet(oc_request_t *request, oc_interface_mask_t, void *)
+  {
+    ++get_count_;
+    if (get_count_ <= ignored_count_) {
+      oc_ignore_request(request);
+      return;
+    }
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, 42);
+    oc_rep_set_text_string(root, unit, "C");
+    std::array<int64_t, 32> history{};
+    for (size_t i = 0; i < history.size(); ++i) {
+      history[i] = static_cast<int64_t>(1000 + i);
+    }
+    oc_rep_set_int_array(root, history, history.data(),
+                         static_cast<int>(history.size()));
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+  }
+
+  /** add an observer from a client at given port of the device's endpoint */
+  void addObserver(uint16_t port, ocf_version_t version = OCF_VER_1_0_0)
+  {
+    auto epOpt = oc::TestDevice::GetEndpoint(kDeviceID);
+    ASSERT_TRUE(epOpt.has_value());
+    oc_endpoint_t ep = *epOpt;
+    if ((ep.flags & IPV6) != 0) {
+      ep.addr.ipv6.port = port;
+    }
+#ifdef OC_IPV4
+    if ((ep.flags & IPV4) != 0) {
+      ep.addr.ipv4.port = port;
+    }
+#endif /* OC_IPV4 */
+    ep.version = version;
+    std::array<uint8_t, COAP_TOKEN_LEN> token;
+    oc_random_buffer(token.data(), token.size());
+    std::string uri = &oc_string(resource_->uri)[1];
+    ASSERT_NE(nullptr, coap_add_observer(resource_, 1024, &ep, token.data(),
+                                         token.size(), uri.c_str(),
+                                         uri.length(), OC_IF_R));
+  }
+
+  oc_resource_t *resource_{};
+  static int get_count_;
+  static int ignored_count_; ///< number of GET requests to ignore
+};
+
+int TestObserverNotification::get_count_{ 0 };
+int TestObserverNotification::ignored_count_{ 0 };
+
+TEST_F(TestObserverNotification, EncodeOncePerVariant)
+{
+  oc::TestDevice::DropOutgoingMessages();
+  constexpr int kObservers = 2;
+  for (int i = 0; i < kObservers; ++i) {
+    addObserver(static_cast<uint16_t>(40000 + i));
+  }
+  int variants = 1;
+#ifdef OC_DYNAMIC_ALLOCATION
+  // a different OCF version gets a different content format, static builds
+  // have only OC_MAX_NUM_CONCURRENT_REQUESTS outgoing messages and transactions
+  // so the notifications are sent only to the observers of a single variant
+  addObserver(40100, OIC_VER_1_1_0);
+  ++variants;
+#endif /* OC_DYNAMIC_ALLOCATION */
+  int observers = kObservers + variants - 1;
+  ASSERT_EQ(observers, resource_->num_observers);
+
+  EXPECT_EQ(observers, coap_notify_observers(resource_, nullptr, nullptr));
+#ifdef OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD
+  EXPECT_EQ(variants, get_count_);
+#else  /* !OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
+  EXPECT_EQ(observers, get_count_);
+#endif /* OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD */
+
+  // notification for a single endpoint
+  oc::TestDevice::DropOutgoingMessages();
+  get_count_ = 0;
+  const auto *obs = static_cast<coap_observer_t *>(
+    oc_list_head(coap_get_observers()));
+  ASSERT_NE(nullptr, obs);
+  EXPECT_EQ(1, coap_notify_observers(resource_, nullptr, &obs->endpoint));
+  EXPECT_EQ(1, get_count_);
+  oc::TestDevice::DropOutgoingMessages();
+}
+
+TEST_F(TestObserverNotification, IgnoredRequestOfVariant)
+{
+  addObserver(40000);
+  addObserver(40001);
+  ASSERT_EQ(2, resource_->num_observers);
+
+  // the response for the first observer is not filled, the second observer of
+  // the same variant is notified
+  ignored_count_ = 1;
+  EXPECT_EQ(1, coap_notify_observers(resource_, nullptr, nullptr));
+  EXPECT_EQ(2, get_count_);
+  oc::TestDevice::DropOutgoingMessages();
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+class TestObserverNotificationBenchmark
+  : public TestObserverNotification,
+    public testing::WithParamInterface<size_t> {};
+
+INSTANTIATE_TEST_SUITE_P(Observers, TestObserverNotificationBenchmark,
+                         testing::Values(10, 100, 300));
+
+/** the payload is encoded once for all observers of a resource */
+TEST_P(TestObserverNotificationBenchmark, Notify)
+{
+  size_t count = GetParam();
+  for (size_t i = 0; i < count; ++i) {
+    addObserver(static_cast<uint16_t>(40000 + i));
+  }
+
+  constexpr size_t kNotifications = 100;
+  auto result =
+    oc::Benchmark("notify " + std::to_string(count) + " observers",
+                  kNotifications, [this, count](size_t) {
+                    ASSERT_EQ(count, static_cast<size_t>(coap_notify_observers(
+                                       resource_, nullptr, nullptr)));
+                    oc::TestDevice::DropOutgoingMessages();
+                    coap_free_all_transactions();
+                  });
+  printf("[ BENCH    ] %.0f notifications/s, %.1f GET handler calls per "
+         "notification\n",
+         static_cast<double>(count) * 1e9 / result.NsPerOp(),
+         static_cast<double>(get_count_) / kNotifications);
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#endif /* OC_SERVER */
+
 #ifdef OC_RES_BATCH_SUPPORT
 
 #ifdef OC_DISCOVERY_RESOURCE_OBSERVABLE
@@ -0,0 +1,176 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "messaging/coap/transactions_internal.h"
+#include "oc_config.h"
+#include "port/oc_allocator_internal.h"
+#include "tests/gtest/Endpoint.h"
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_REQUEST_INDEX
+#include "tests/gtest/Benchmark.h"
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX */
+
+#include <array>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+class TestTransactions : public testing::Test {
+public:
+  static void SetUpTestCase()
+  {
+#ifdef OC_HAS_FEATURE_ALLOCATOR_MUTEX
+    oc_allocator_mutex_init();
+#endif /* OC_HAS_FEATURE_ALLOCATOR_MUTEX */
+  }
+
+  static void TearDownTestCase()
+  {
+#ifdef OC_HAS_FEATURE_ALLOCATOR_MUTEX
+    oc_allocator_mutex_destroy();
+#endif /* OC_HAS_FEATURE_ALLOCATOR_MUTEX */
+  }
+
+  void SetUp() override
+  {
+    endpoint_ = oc::endpoint::FromString("coap://[ff02::158]:1234");
+  }
+
+  void TearDown() override { coap_free_all_transactions(); }
+
+  static std::array<uint8_t, COAP_TOKEN_LEN> makeToken(uint32_t value)
+  {
+    std::array<uint8_t, COAP_TOKEN_LEN> token{};
+    memcpy(token.data(), &value, sizeof(value));
+    return token;
+  }
+
+  coap_transaction_t *newTransaction(uint16_t mid, uint32_t token)
+  {
+    auto t = makeToken(token);
+    return coap_new_transaction(mid, t.data(), static_cast<uint8_t>(t.size()),
+                                &endpoint_);
+  }
+
+  oc_endpoint_t endpoint_{};
+};
+
+TEST_F(TestTransactions, FindByMid)
+{
+  EXPECT_EQ(nullptr, coap_get_transaction_by_mid(1));
+  coap_transaction_t *t1 = newTransaction(1, 1);
+  ASSERT_NE(nullptr, t1);
+  coap_transaction_t *t2 = newTransaction(2, 2);
+  ASSERT_NE(nullptr, t2);
+
+  EXPECT_EQ(t1, coap_get_transaction_by_mid(1));
+  EXPECT_EQ(t2, coap_get_transaction_by_mid(2));
+  EXPECT_EQ(nullptr, coap_get_transaction_by_mid(3));
+
+  coap_clear_transaction(t1);
+  EXPECT_EQ(nullptr, coap_get_transaction_by_mid(1));
+  EXPECT_EQ(t2, coap_get_transaction_by_mid(2));
+}
+
+TEST_F(TestTransactions, FindByToken)
+{
+  auto token1 = makeToken(1);
+  EXPECT_EQ(nullptr,
+            coap_get_transaction_by_token(token1.data(), token1.size()));
+  coap_transaction_t *t1 = newTransaction(1, 1);
+  ASSERT_NE(nullptr, t1);
+  // transaction without a token
+  coap_transaction_t *t2 = coap_new_transaction(2, nullptr, 0, &endpoint_);
+  ASSERT_NE(nullptr, t2);
+
+  EXPECT_EQ(t1, coap_get_transaction_by_token(token1.data(), token1.size()));
+  // shorter token
+  EXPECT_EQ(nullptr, coap_get_transaction_by_token(token1.data(), 1));
+  auto token2 = makeToken(2);
+  EXPECT_EQ(nullptr,
+            coap_get_transaction_by_token(token2.data(), token2.size()));
+  EXPECT_EQ(t2, coap_get_transaction_by_token(nullptr, 0));
+
+  coap_clear_transaction(t1);
+  EXPECT_EQ(nullptr,
+            coap_get_transaction_by_token(token1.data(), token1.size()));
+}
+
+TEST_F(TestTransactions, SetMidAndToken)
+{
+  coap_transaction_t *t = coap_new_transaction(1, nullptr, 0, &endpoint_);
+  ASSERT_NE(nullptr, t);
+
+  coap_transaction_set_mid(t, 42);
+  EXPECT_EQ(42, t->mid);
+  EXPECT_EQ(nullptr, coap_get_transaction_by_mid(1));
+  EXPECT_EQ(t, coap_get_transaction_by_mid(42));
+
+  auto token1 = makeToken(1);
+  coap_transaction_set_token(t, token1.data(), token1.size());
+  EXPECT_EQ(t, coap_get_transaction_by_token(token1.data(), token1.size()));
+  auto token2 = makeToken(2);
+  coap_transaction_set_token(t, token2.data(), token2.size());
+  EXPECT_EQ(nullptr,
+            coap_get_transaction_by_token(token1.data(), token1.size()));
+  EXPECT_EQ(t, coap_get_transaction_by_token(token2.data(), token2.size()));
+
+  coap_clear_transaction(t);
+  EXPECT_EQ(nullptr, coap_get_transaction_by_mid(42));
+  EXPECT_EQ(nullptr,
+            coap_get_transaction_by_token(token2.data(), token2.size()));
+}
+
+#if defined(OC_HAS_FEATURE_REQUEST_INDEX) && defined(OC_DYNAMIC_ALLOCATION)
+
+class TestTransactionsBenchmark : public TestTransactions,
+                                  public testing::WithParamInterface<size_t> {};
+
+INSTANTIATE_TEST_SUITE_P(OpenTransactions, TestTransactionsBenchmark,
+                         testing::Values(100, 1000, 10000));
+
+/** lookup cost must not grow with the number of outstanding transactions */
+TEST_P(TestTransactionsBenchmark, Lookup)
+{
+  size_t count = GetParam();
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_NE(nullptr, newTransaction(static_cast<uint16_t>(i),
+                                      static_cast<uint32_t>(i)));
+  }
+
+  constexpr size_t kLookups = 100000;
+  oc::Benchmark("find by mid, " + std::to_string(count) + " transactions",
+                kLookups, [count](size_t i) {
+                  auto mid = static_cast<uint16_t>(i % count);
+                  ASSERT_NE(nullptr, coap_get_transaction_by_mid(mid));
+                });
+  std::vector<std::array<uint8_t, COAP_TOKEN_LEN>> tokens{};
+  tokens.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    tokens.push_back(makeToken(static_cast<uint32_t>(i)));
+  }
+  oc::Benchmark("find by token, " + std::to_string(count) + " transactions",
+                kLookups, [count, &tokens](size_t i) {
+                  const auto &token = tokens[i % count];
+                  ASSERT_NE(nullptr, coap_get_transaction_by_token(
+                                       token.data(), token.size()));
+                });
+}
+
+#endif /* OC_HAS_FEATURE_REQUEST_INDEX && OC_DYNAMIC_ALLOCATION */
@@ -24,6 +24,11 @@
 #include "port/oc_log_internal.h"
 #include "util/oc_macros_internal.h"
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+#include "api/oc_message_internal.h"
+#include "util/oc_atomic.h"
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>
@@ -31,34 +36,43 @@
 #include <string.h>
 #include <sys/socket.h>
 
-ssize_t
-oc_ip_send_msg(int sock, struct sockaddr_storage *receiver,
-               const oc_message_t *message)
-{
-  if (sock == -1) {
-    OC_ERR("socket is disabled");
-    return -1;
-  }
-  char msg_control[CMSG_LEN(sizeof(struct sockaddr_storage))];
-  struct iovec iovec[1];
-  struct msghdr msg;
+typedef union {
+  size_t align; // ensure correct alignment of the control buffer
+  char buf[CMSG_LEN(sizeof(struct sockaddr_storage))];
+} ip_msg_control_t;
+
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+static OC_ATOMIC_UINT32_T g_recv_calls = 0;
+static OC_ATOMIC_UINT32_T g_recv_messages = 0;
+static OC_ATOMIC_UINT32_T g_recv_max_batch = 0;
+static OC_ATOMIC_UINT32_T g_send_calls = 0;
+static OC_ATOMIC_UINT32_T g_send_messages = 0;
+static OC_ATOMIC_UINT32_T g_send_max_batch = 0;
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
 
-  memset(&msg, 0, sizeof(struct msghdr));
-  msg.msg_name = (void *)receiver;
-  msg.msg_namelen = sizeof(struct sockaddr_storage);
+static bool
+ip_msg_init_send(struct msghdr *msg, struct sockaddr_storage *receiver,
+                 struct iovec *iovec, ip_msg_control_t *control,
+                 const oc_message_t *message)
+{
+  memset(msg, 0, sizeof(struct msghdr));
+  msg->msg_name = (void *)receiver;
+  msg->msg_namelen = sizeof(struct sockaddr_storage);
 
-  msg.msg_iov = iovec;
-  msg.msg_iovlen = 1;
+  iovec->iov_base = (void *)message->data;
+  iovec->iov_len = message->length;
+  msg->msg_iov = iovec;
+  msg->msg_iovlen = 1;
 
   if (message->endpoint.flags & IPV6) {
     struct cmsghdr *cmsg;
     struct in6_pktinfo *pktinfo;
 
-    msg.msg_control = msg_control;
-    msg.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
-    memset(msg.msg_control, 0, msg.msg_controllen);
+    msg->msg_control = control->buf;
+    msg->msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
+    memset(msg->msg_control, 0, msg->msg_controllen);
 
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = CMSG_FIRSTHDR(msg);
     cmsg->cmsg_level = IPPROTO_IPV6;
     cmsg->cmsg_type = IPV6_PKTINFO;
     cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
@@ -75,17 +89,18 @@ oc_ip_send_msg(int sock, struct sockaddr_storage *receiver,
      * from the endpoint's addr_local attribute.
      */
     memcpy(&pktinfo->ipi6_addr, message->endpoint.addr_local.ipv6.address, 16);
+    return true;
   }
 #ifdef OC_IPV4
-  else if (message->endpoint.flags & IPV4) {
+  if (message->endpoint.flags & IPV4) {
     struct cmsghdr *cmsg;
     struct in_pktinfo *pktinfo;
 
-    msg.msg_control = msg_control;
-    msg.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
-    memset(msg.msg_control, 0, msg.msg_controllen);
+    msg->msg_control = control->buf;
+    msg->msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
+    memset(msg->msg_control, 0, msg->msg_controllen);
 
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = CMSG_FIRSTHDR(msg);
     cmsg->cmsg_level = SOL_IP;
     cmsg->cmsg_type = IP_PKTINFO;
     cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
@@ -99,13 +114,29 @@ oc_ip_send_msg(int sock, struct sockaddr_storage *receiver,
     pktinfo->ipi_ifindex = (int)message->endpoint.interface_index;
     memcpy(&pktinfo->ipi_spec_dst, message->endpoint.addr_local.ipv4.address,
            4);
+    return true;
   }
+  return true;
 #else  /* !OC_IPV4 */
-  else {
-    OC_ERR("invalid endpoint");
+  OC_ERR("invalid endpoint");
+  return false;
+#endif /* OC_IPV4 */
+}
+
+ssize_t
+oc_ip_send_msg(int sock, struct sockaddr_storage *receiver,
+               const oc_message_t *message)
+{
+  if (sock == -1) {
+    OC_ERR("socket is disabled");
+    return -1;
+  }
+  ip_msg_control_t msg_control;
+  struct iovec iovec[1];
+  struct msghdr msg;
+  if (!ip_msg_init_send(&msg, receiver, &iovec[0], &msg_control, message)) {
     return -1;
   }
-#endif /* OC_IPV4 */
 
   size_t bytes_sent = 0;
   while (bytes_sent < message->length) {
@@ -132,49 +163,47 @@ oc_ip_send_msg(int sock, struct sockaddr_storage *receiver,
   return (ssize_t)bytes_sent;
 }
 
-int
-oc_ip_recv_msg(int sock, uint8_t *recv_buf, long recv_buf_size,
-               oc_endpoint_t *endpoint, bool multicast)
+static void
+ip_msg_init_recv(struct msghdr *msg, struct sockaddr_storage *client,
+                 struct iovec *iovec, uint8_t *recv_buf, size_t recv_buf_size,
+                 ip_msg_control_t *control)
 {
-  struct sockaddr_storage client;
-  memset(&client, 0, sizeof(client));
-  struct iovec iovec[1];
-  struct msghdr msg;
-  char msg_control[CMSG_LEN(sizeof(struct sockaddr_storage))];
+  memset(client, 0, sizeof(struct sockaddr_storage));
+  iovec->iov_base = recv_buf;
+  iovec->iov_len = recv_buf_size;
 
-  iovec[0].iov_base = recv_buf;
-  iovec[0].iov_len = (size_t)recv_buf_size;
+  msg->msg_name = client;
+  msg->msg_namelen = sizeof(struct sockaddr_storage);
 
-  msg.msg_name = &client;
-  msg.msg_namelen = sizeof(client);
+  msg->msg_iov = iovec;
+  msg->msg_iovlen = 1;
 
-  msg.msg_iov = iovec;
-  msg.msg_iovlen = 1;
+  msg->msg_control = control->buf;
+  msg->msg_controllen = sizeof(control->buf);
 
-  msg.msg_control = msg_control;
-  msg.msg_controllen = sizeof(msg_control);
-
-  msg.msg_flags = 0;
-
-  ssize_t ret;
-  do {
-    ret = recvmsg(sock, &msg, 0);
-  } while (ret < 0 && errno == EINTR);
+  msg->msg_flags = 0;
+}
 
-  if (ret < 0 || (msg.msg_flags & MSG_TRUNC) || (msg.msg_flags & MSG_CTRUNC)) {
-    OC_ERR("recvmsg failed (error %d)", (int)errno);
+static int
+ip_msg_parse_recv(struct msghdr *msg, size_t length, oc_endpoint_t *endpoint,
+                  bool multicast)
+{
+  if ((msg->msg_flags & MSG_TRUNC) || (msg->msg_flags & MSG_CTRUNC)) {
+    OC_ERR("received message truncated");
     return -1;
   }
 
+  const struct sockaddr_storage *client =
+    (const struct sockaddr_storage *)msg->msg_name;
   struct cmsghdr *cmsg;
-  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != 0; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+  for (cmsg = CMSG_FIRSTHDR(msg); cmsg != 0; cmsg = CMSG_NXTHDR(msg, cmsg)) {
     if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
-      if (msg.msg_namelen != sizeof(struct sockaddr_in6)) {
+      if (msg->msg_namelen != sizeof(struct sockaddr_in6)) {
         OC_ERR("anciliary data contains invalid source address");
         return -1;
       }
       /* Set source address of packet in endpoint structure */
-      const struct sockaddr_in6 *c6 = (struct sockaddr_in6 *)&client;
+      const struct sockaddr_in6 *c6 = (const struct sockaddr_in6 *)client;
       memcpy(endpoint->addr.ipv6.address, c6->sin6_addr.s6_addr,
              sizeof(c6->sin6_addr.s6_addr));
       endpoint->addr.ipv6.scope = c6->sin6_scope_id;
@@ -203,7 +232,7 @@ oc_ip_recv_msg(int sock, uint8_t *recv_buf, long recv_buf_size,
     }
 #ifdef OC_IPV4
     if (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_PKTINFO) {
-      if (msg.msg_namelen != sizeof(struct sockaddr_in)) {
+      if (msg->msg_namelen != sizeof(struct sockaddr_in)) {
         OC_ERR("anciliary data contains invalid source address");
         return -1;
       }
@@ -211,7 +240,7 @@ oc_ip_recv_msg(int sock, uint8_t *recv_buf, long recv_buf_size,
       CLANG_IGNORE_WARNING("-Wcast-align")
       const struct in_pktinfo *pktinfo = (struct in_pktinfo *)CMSG_DATA(cmsg);
       CLANG_IGNORE_WARNING_END
-      const struct sockaddr_in *c4 = (struct sockaddr_in *)&client;
+      const struct sockaddr_in *c4 = (const struct sockaddr_in *)client;
       memcpy(endpoint->addr.ipv4.address, &c4->sin_addr.s_addr,
              sizeof(c4->sin_addr.s_addr));
       endpoint->addr.ipv4.port = ntohs(c4->sin_port);
@@ -226,6 +255,155 @@ oc_ip_recv_msg(int sock, uint8_t *recv_buf, long recv_buf_size,
 #endif /* OC_IPV4 */
   }
 
-  assert(ret <= INT_MAX);
-  return (int)ret;
+  assert(length <= INT_MAX);
+  return (int)length;
+}
+
+int
+oc_ip_recv_msg(int sock, uint8_t *recv_buf, long recv_buf_size,
+               oc_endpoint_t *endpoint, bool multicast)
+{
+  struct sockaddr_storage client;
+  struct iovec iovec[1];
+  struct msghdr msg;
+  ip_msg_control_t msg_control;
+  ip_msg_init_recv(&msg, &client, &iovec[0], recv_buf, (size_t)recv_buf_size,
+                   &msg_control);
+
+  ssize_t ret;
+  do {
+    ret = recvmsg(sock, &msg, 0);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret < 0) {
+    OC_ERR("recvmsg failed (error %d)", (int)errno);
+    return -1;
+  }
+  return ip_msg_parse_recv(&msg, (size_t)ret, endpoint, multicast);
+}
+
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+
+static void
+ip_batch_stats_update_max(OC_ATOMIC_UINT32_T *max, uint32_t value)
+{
+  uint32_t current = OC_ATOMIC_LOAD32(*max);
+  bool swapped = false;
+  while (!swapped && value > current) {
+    OC_ATOMIC_COMPARE_AND_SWAP32(*max, current, value, swapped);
+  }
 }
+
+int
+oc_ip_recv_msgs(int sock, oc_message_t **messages, size_t count,
+                bool multicast)
+{
+  if (count > OC_UDP_BATCH_SIZE) {
+    count = OC_UDP_BATCH_SIZE;
+  }
+  struct mmsghdr msgs[OC_UDP_BATCH_SIZE];
+  struct sockaddr_storage clients[OC_UDP_BATCH_SIZE];
+  struct iovec iovecs[OC_UDP_BATCH_SIZE];
+  ip_msg_control_t controls[OC_UDP_BATCH_SIZE];
+  for (size_t i = 0; i < count; ++i) {
+    ip_msg_init_recv(&msgs[i].msg_hdr, &clients[i], &iovecs[i],
+                     messages[i]->data, oc_message_buffer_size(messages[i]),
+                     &controls[i]);
+    msgs[i].msg_len = 0;
+  }
+
+  int ret;
+  do {
+    // block only until the first datagram is available
+    ret = recvmmsg(sock, msgs, (unsigned)count, MSG_WAITFORONE, NULL);
+  } while (ret < 0 && errno == EINTR);
+  if (ret < 0) {
+    OC_ERR("recvmmsg failed (error %d)", (int)errno);
+    return -1;
+  }
+
+  for (int i = 0; i < ret; ++i) {
+    int len = ip_msg_parse_recv(&msgs[i].msg_hdr, msgs[i].msg_len,
+                                &messages[i]->endpoint, multicast);
+    messages[i]->length = len < 0 ? 0 : (size_t)len;
+  }
+  OC_ATOMIC_INCREMENT32(g_recv_calls);
+  OC_ATOMIC_ADD32(g_recv_messages, (uint32_t)ret);
+  ip_batch_stats_update_max(&g_recv_max_batch, (uint32_t)ret);
+  OC_DBG("Received %d datagrams in a batch", ret);
+  return ret;
+}
+
+int
+oc_ip_send_msgs(int sock, struct sockaddr_storage *receivers,
+                oc_message_t **messages, size_t count)
+{
+  if (sock == -1) {
+    OC_ERR("socket is disabled");
+    return -1;
+  }
+  if (count > OC_UDP_BATCH_SIZE) {
+    count = OC_UDP_BATCH_SIZE;
+  }
+  struct mmsghdr msgs[OC_UDP_BATCH_SIZE];
+  struct iovec iovecs[OC_UDP_BATCH_SIZE];
+  ip_msg_control_t controls[OC_UDP_BATCH_SIZE];
+  size_t valid = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (!ip_msg_init_send(&msgs[valid].msg_hdr, &receivers[i], &iovecs[valid],
+                          &controls[valid], messages[i])) {
+      continue;
+    }
+    msgs[valid].msg_len = 0;
+    ++valid;
+  }
+
+  size_t sent = 0;
+  size_t offset = 0;
+  while (offset < valid) {
+    int ret;
+    do {
+      ret = sendmmsg(sock, &msgs[offset], (unsigned)(valid - offset), 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+      // the first message of the batch failed, skip it and send the rest
+      OC_ERR("sendmmsg failed (error %d)", (int)errno);
+      ++offset;
+      continue;
+    }
+    OC_ATOMIC_INCREMENT32(g_send_calls);
+    OC_ATOMIC_ADD32(g_send_messages, (uint32_t)ret);
+    ip_batch_stats_update_max(&g_send_max_batch, (uint32_t)ret);
+    sent += (size_t)ret;
+    offset += (size_t)ret;
+  }
+  OC_DBG("Sent %zu datagrams out of %zu in a batch", sent, count);
+  return (int)sent;
+}
+
+oc_ip_batch_stats_t
+oc_ip_batch_stats(void)
+{
+  oc_ip_batch_stats_t stats = {
+    .recv_calls = OC_ATOMIC_LOAD32(g_recv_calls),
+    .recv_messages = OC_ATOMIC_LOAD32(g_recv_messages),
+    .recv_max_batch = OC_ATOMIC_LOAD32(g_recv_max_batch),
+    .send_calls = OC_ATOMIC_LOAD32(g_send_calls),
+    .send_messages = OC_ATOMIC_LOAD32(g_send_messages),
+    .send_max_batch = OC_ATOMIC_LOAD32(g_send_max_batch),
+  };
+  return stats;
+}
+
+void
+oc_ip_batch_stats_reset(void)
+{
+  OC_ATOMIC_STORE32(g_recv_calls, 0);
+  OC_ATOMIC_STORE32(g_recv_messages, 0);
+  OC_ATOMIC_STORE32(g_recv_max_batch, 0);
+  OC_ATOMIC_STORE32(g_send_calls, 0);
+  OC_ATOMIC_STORE32(g_send_messages, 0);
+  OC_ATOMIC_STORE32(g_send_max_batch, 0);
+}
+
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
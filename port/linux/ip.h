@@ -21,6 +21,8 @@
 
 #include "oc_endpoint.h"
 #include "port/oc_connectivity.h"
+#include "util/oc_compiler.h"
+#include "util/oc_features.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -37,6 +39,63 @@ ssize_t oc_ip_send_msg(int sock, struct sockaddr_storage *receiver,
 int oc_ip_recv_msg(int sock, uint8_t *recv_buf, long recv_buf_size,
                    oc_endpoint_t *endpoint, bool multicast);
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+
+#ifndef OC_UDP_BATCH_SIZE
+/** Maximal number of datagrams received or sent by a single system call */
+#define OC_UDP_BATCH_SIZE (16)
+#endif /* OC_UDP_BATCH_SIZE */
+
+/**
+ * @brief Receive up to count datagrams from the socket with a single call.
+ *
+ * Blocks only until the first datagram is available. The address, interface
+ * index and length of each received message is filled, messages that could
+ * not be parsed have length set to 0.
+ *
+ * @param sock UDP socket
+ * @param messages array of allocated messages (cannot be NULL)
+ * @param count number of messages in the array (capped to OC_UDP_BATCH_SIZE)
+ * @param multicast true if the socket is a multicast socket
+ * @return number of received datagrams
+ * @return -1 on error
+ */
+int oc_ip_recv_msgs(int sock, oc_message_t **messages, size_t count,
+                    bool multicast) OC_NONNULL();
+
+/**
+ * @brief Send count datagrams to the socket with as few calls as possible.
+ *
+ * @param sock UDP socket
+ * @param receivers addresses of the receivers, receivers[i] is used for
+ * messages[i] (cannot be NULL)
+ * @param messages messages to send (cannot be NULL)
+ * @param count number of messages (capped to OC_UDP_BATCH_SIZE)
+ * @return number of sent datagrams
+ * @return -1 on error
+ */
+int oc_ip_send_msgs(int sock, struct sockaddr_storage *receivers,
+                    oc_message_t **messages, size_t count) OC_NONNULL();
+
+/** Counters of the batched receive and send calls */
+typedef struct oc_ip_batch_stats_t
+{
+  uint32_t recv_calls;     ///< number of successful recvmmsg calls
+  uint32_t recv_messages;  ///< number of datagrams received by recvmmsg
+  uint32_t recv_max_batch; ///< largest number of datagrams in a single call
+  uint32_t send_calls;     ///< number of successful sendmmsg calls
+  uint32_t send_messages;  ///< number of datagrams sent by sendmmsg
+  uint32_t send_max_batch; ///< largest number of datagrams in a single call
+} oc_ip_batch_stats_t;
+
+/** @brief Get the counters of the batched receive and send calls */
+oc_ip_batch_stats_t oc_ip_batch_stats(void);
+
+/** @brief Reset the counters of the batched receive and send calls */
+void oc_ip_batch_stats_reset(void);
+
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,7 @@
 #include "ip.h"
 #include "ipadapter.h"
 #include "ipcontext.h"
+#include "netpoll.h"
 #include "netsocket.h"
 #include "oc_config.h"
 #include "oc_buffer.h"
@@ -58,6 +59,7 @@
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <net/if.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -74,6 +76,11 @@
 
 #define OCF_PORT_UNSECURED (5683)
 
+#ifdef OC_HAS_FEATURE_EPOLL
+/* Maximal number of events returned by a single epoll_wait call */
+#define OC_EPOLL_MAX_EVENTS (64)
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 static pthread_mutex_t g_mutex;
 struct sockaddr_nl g_ifchange_nl;
 static int g_ifchange_sock;
@@ -298,6 +305,17 @@ get_interface_addresses(ip_context_t *dev, unsigned char family, int port,
     break;
   } while (true);
 
+#ifdef OC_HAS_FEATURE_EPOLL
+  // the socket may be above FD_SETSIZE
+  struct pollfd pfd = {
+    .fd = nl_sock,
+    .events = POLLIN,
+  };
+  if (poll(&pfd, 1, -1) < 0) {
+    close(nl_sock);
+    return false;
+  }
+#else  /* !OC_HAS_FEATURE_EPOLL */
   fd_set rfds;
   FD_ZERO(&rfds);
   FD_SET(nl_sock, &rfds);
@@ -306,6 +324,7 @@ get_interface_addresses(ip_context_t *dev, unsigned char family, int port,
     close(nl_sock);
     return false;
   }
+#endif /* OC_HAS_FEATURE_EPOLL */
 
   long prev_interface_index = -1;
   bool done = false;
@@ -655,24 +674,33 @@ process_interface_change_event(void)
   return success ? 0 : -1;
 }
 
+static void
+udp_add_listener_to_rfd_set(ip_context_t *dev,
+                            const oc_sock_listener_t *listener)
+{
+  if (listener->sock >= 0) {
+    ip_context_rfds_fd_set(dev, listener->sock);
+  }
+}
+
 static void
 udp_add_socks_to_rfd_set(ip_context_t *dev)
 {
-  oc_sock_listener_fd_set(&dev->server, &dev->rfds);
+  udp_add_listener_to_rfd_set(dev, &dev->server);
   if (dev->mcast_sock >= 0) {
-    FD_SET(dev->mcast_sock, &dev->rfds);
+    ip_context_rfds_fd_set(dev, dev->mcast_sock);
   }
 #ifdef OC_SECURITY
-  oc_sock_listener_fd_set(&dev->secure, &dev->rfds);
+  udp_add_listener_to_rfd_set(dev, &dev->secure);
 #endif /* OC_SECURITY */
 
 #ifdef OC_IPV4
-  oc_sock_listener_fd_set(&dev->server4, &dev->rfds);
+  udp_add_listener_to_rfd_set(dev, &dev->server4);
   if (dev->mcast4_sock >= 0) {
-    FD_SET(dev->mcast4_sock, &dev->rfds);
+    ip_context_rfds_fd_set(dev, dev->mcast4_sock);
   }
 #ifdef OC_SECURITY
-  oc_sock_listener_fd_set(&dev->secure4, &dev->rfds);
+  udp_add_listener_to_rfd_set(dev, &dev->secure4);
 #endif /* OC_SECURITY */
 #endif /* OC_IPV4 */
 }
@@ -688,96 +716,332 @@ process_shutdown(const ip_context_t *dev)
   } while (len < 0 && errno == EINTR);
 }
 
+static bool
+udp_get_socket_flags(const ip_context_t *dev, int sock, transport_flags *flags,
+                     bool *multicast)
+{
+  *multicast = false;
+  if (sock == dev->server.sock) {
+    *flags = IPV6;
+    return true;
+  }
+  if (sock == dev->mcast_sock) {
+    *flags = IPV6 | MULTICAST;
+    *multicast = true;
+    return true;
+  }
+#ifdef OC_IPV4
+  if (sock == dev->server4.sock) {
+    *flags = IPV4;
+    return true;
+  }
+  if (sock == dev->mcast4_sock) {
+    *flags = IPV4 | MULTICAST;
+    *multicast = true;
+    return true;
+  }
+#endif /* OC_IPV4 */
+#ifdef OC_SECURITY
+  if (sock == dev->secure.sock) {
+    *flags = IPV6 | SECURED;
+    return true;
+  }
+#ifdef OC_IPV4
+  if (sock == dev->secure4.sock) {
+    *flags = IPV4 | SECURED;
+    return true;
+  }
+#endif /* OC_IPV4 */
+#endif /* OC_SECURITY */
+  return false;
+}
+
+static void
+udp_set_received_message_flags(oc_message_t *message, transport_flags flags)
+{
+  message->endpoint.flags = flags;
+#ifdef OC_SECURITY
+  if ((flags & SECURED) != 0) {
+    message->encrypted = 1;
+  }
+#endif /* OC_SECURITY */
+}
+
 static adapter_receive_state_t
-oc_udp_receive_message(const ip_context_t *dev, fd_set *fds,
+oc_udp_receive_message(const ip_context_t *dev, int sock,
                        oc_message_t *message)
 {
-  if (oc_sock_listener_fd_isset(&dev->server, fds)) {
-    OC_DBG("udp receive server.sock(fd=%d)", dev->server.sock);
-    FD_CLR(dev->server.sock, fds);
-    int count = oc_ip_recv_msg(dev->server.sock, message->data, OC_PDU_SIZE,
-                               &message->endpoint, false);
-    if (count < 0) {
-      return ADAPTER_STATUS_ERROR;
-    }
-    message->length = (size_t)count;
-    message->endpoint.flags = IPV6;
-    return ADAPTER_STATUS_RECEIVE;
-  }
-
-  if ((dev->mcast_sock >= 0) && FD_ISSET(dev->mcast_sock, fds)) {
-    OC_DBG("udp receive mcast_sock(fd=%d)", dev->mcast_sock);
-    FD_CLR(dev->mcast_sock, fds);
-    int count = oc_ip_recv_msg(dev->mcast_sock, message->data, OC_PDU_SIZE,
-                               &message->endpoint, true);
-    if (count < 0) {
-      return ADAPTER_STATUS_ERROR;
+  transport_flags flags;
+  bool multicast;
+  if (!udp_get_socket_flags(dev, sock, &flags, &multicast)) {
+    return ADAPTER_STATUS_NONE;
+  }
+
+  OC_DBG("udp receive sock(fd=%d)", sock);
+  int count = oc_ip_recv_msg(sock, message->data, OC_PDU_SIZE,
+                             &message->endpoint, multicast);
+  if (count < 0) {
+    return ADAPTER_STATUS_ERROR;
+  }
+  message->length = (size_t)count;
+  udp_set_received_message_flags(message, flags);
+  return ADAPTER_STATUS_RECEIVE;
+}
+
+static int
+process_received_message(oc_message_t *message, adapter_receive_state_t s)
+{
+  if (s != ADAPTER_STATUS_RECEIVE) {
+    oc_message_unref(message);
+    return s == ADAPTER_STATUS_NONE ? 0 : 1;
+  }
+
+  OC_DBG("Incoming message of size %zd bytes from", message->length);
+  OC_LOGipaddr(message->endpoint);
+  OC_DBG("%s", "");
+
+  oc_network_receive_event(message);
+  return 1;
+}
+
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+
+static oc_message_t *
+udp_batch_take_message(ip_context_t *dev)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (dev->udp_rx_spares_count > 0) {
+    --dev->udp_rx_spares_count;
+    return dev->udp_rx_spares[dev->udp_rx_spares_count];
+  }
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  (void)dev;
+#endif /* OC_DYNAMIC_ALLOCATION */
+  return oc_allocate_message();
+}
+
+static void
+udp_batch_return_message(ip_context_t *dev, oc_message_t *message)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  // keep unused messages for the next batch to avoid reallocation
+  if (dev->udp_rx_spares_count < OC_ARRAY_SIZE(dev->udp_rx_spares)) {
+    dev->udp_rx_spares[dev->udp_rx_spares_count] = message;
+    ++dev->udp_rx_spares_count;
+    return;
+  }
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  // static pools are small, do not hold messages that are not used
+  (void)dev;
+#endif /* OC_DYNAMIC_ALLOCATION */
+  oc_message_unref(message);
+}
+
+static void
+udp_batch_free_messages(ip_context_t *dev)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  for (size_t i = 0; i < dev->udp_rx_spares_count; ++i) {
+    oc_message_unref(dev->udp_rx_spares[i]);
+  }
+  dev->udp_rx_spares_count = 0;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  (void)dev;
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+/* Drain up to OC_UDP_BATCH_SIZE datagrams from a ready UDP socket */
+static int
+udp_receive_messages(ip_context_t *dev, int sock, transport_flags flags,
+                     bool multicast)
+{
+  oc_message_t *messages[OC_UDP_BATCH_SIZE];
+  size_t max_count = OC_ARRAY_SIZE(messages);
+#ifndef OC_DYNAMIC_ALLOCATION
+  // static pools are small, a batch takes at most half of the free messages so
+  // that a burst on a single socket does not starve the others
+  size_t numfree = oc_message_incoming_numfree();
+  if (max_count > numfree / 2) {
+    max_count = numfree > 1 ? numfree / 2 : numfree;
+  }
+#endif /* !OC_DYNAMIC_ALLOCATION */
+  size_t count = 0;
+  for (; count < max_count; ++count) {
+    oc_message_t *message = udp_batch_take_message(dev);
+    if (message == NULL) {
+      break;
     }
-    message->length = (size_t)count;
-    message->endpoint.flags = IPV6 | MULTICAST;
-    return ADAPTER_STATUS_RECEIVE;
+    memset(&message->endpoint, 0, sizeof(message->endpoint));
+    message->length = 0;
+    messages[count] = message;
+  }
+  if (count == 0) {
+    return -1;
   }
 
-#ifdef OC_IPV4
-  if (oc_sock_listener_fd_isset(&dev->server4, fds)) {
-    OC_DBG("udp receive server4.sock(fd=%d)", dev->server4.sock);
-    FD_CLR(dev->server4.sock, fds);
-    int count = oc_ip_recv_msg(dev->server4.sock, message->data, OC_PDU_SIZE,
-                               &message->endpoint, false);
-    if (count < 0) {
-      return ADAPTER_STATUS_ERROR;
+  OC_DBG("udp receive batch sock(fd=%d)", sock);
+  int received = oc_ip_recv_msgs(sock, messages, count, multicast);
+  for (size_t i = 0; i < count; ++i) {
+    oc_message_t *message = messages[i];
+    if ((int)i >= received || message->length == 0) {
+      udp_batch_return_message(dev, message);
+      continue;
     }
-    message->length = (size_t)count;
-    message->endpoint.flags = IPV4;
-    return ADAPTER_STATUS_RECEIVE;
-  }
-
-  if ((dev->mcast4_sock >= 0) && FD_ISSET(dev->mcast4_sock, fds)) {
-    OC_DBG("udp receive mcast4_sock(fd=%d)", dev->mcast4_sock);
-    FD_CLR(dev->mcast4_sock, fds);
-    int count = oc_ip_recv_msg(dev->mcast4_sock, message->data, OC_PDU_SIZE,
-                               &message->endpoint, true);
-    if (count < 0) {
-      return ADAPTER_STATUS_ERROR;
+    message->endpoint.device = dev->device;
+    udp_set_received_message_flags(message, flags);
+    process_received_message(message, ADAPTER_STATUS_RECEIVE);
+  }
+  return 1;
+}
+
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
+#ifdef OC_HAS_FEATURE_EPOLL
+
+static int
+process_socket_read_event(ip_context_t *dev, int sock)
+{
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  transport_flags flags;
+  bool multicast;
+  if (udp_get_socket_flags(dev, sock, &flags, &multicast)) {
+    return udp_receive_messages(dev, sock, flags, multicast);
+  }
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
+  oc_message_t *message = oc_allocate_message();
+  if (message == NULL) {
+    return -1;
+  }
+  message->endpoint.device = dev->device;
+
+  adapter_receive_state_t s = oc_udp_receive_message(dev, sock, message);
+#ifdef OC_TCP
+  if (s == ADAPTER_STATUS_NONE) {
+    s = tcp_receive_message_from_socket(dev, sock, message);
+  }
+#endif /* OC_TCP */
+  if (s == ADAPTER_STATUS_NONE) {
+    OC_DBG("no handler found for read event (fd=%d)", sock);
+  }
+  return process_received_message(message, s);
+}
+
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+static int
+process_socket_write_events(const ip_context_t *dev)
+{
+  struct epoll_event events[OC_EPOLL_MAX_EVENTS];
+  int n = epoll_wait(dev->tcp.cfds_epoll_fd, events,
+                     (int)OC_ARRAY_SIZE(events), 0);
+  int ret = 0;
+  for (int i = 0; i < n; ++i) {
+    if (tcp_process_waiting_session_socket(events[i].data.fd)) {
+      ret = 1;
+      continue;
     }
-    message->length = (size_t)count;
-    message->endpoint.flags = IPV4 | MULTICAST;
-    return ADAPTER_STATUS_RECEIVE;
+    OC_DBG("no handler found for write event (fd=%d)", events[i].data.fd);
   }
-#endif /* OC_IPV4 */
+  return ret;
+}
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
 
-#ifdef OC_SECURITY
-  if (oc_sock_listener_fd_isset(&dev->secure, fds)) {
-    OC_DBG("udp receive secure.sock(fd=%d)", dev->secure.sock);
-    FD_CLR(dev->secure.sock, fds);
-    int count = oc_ip_recv_msg(dev->secure.sock, message->data, OC_PDU_SIZE,
-                               &message->endpoint, false);
-    if (count < 0) {
-      return ADAPTER_STATUS_ERROR;
+static int
+process_event(ip_context_t *dev, int fd)
+{
+  if ((dev->device == 0) && (fd == g_ifchange_sock)) {
+    OC_DBG("interface change processed on (fd=%d)", g_ifchange_sock);
+    if (process_interface_change_event() < 0) {
+      OC_WRN("caught errors while handling a network interface change");
     }
-    message->length = (size_t)count;
-    message->endpoint.flags = IPV6 | SECURED;
-    message->encrypted = 1;
-    return ADAPTER_STATUS_RECEIVE;
+    return 1;
   }
-#ifdef OC_IPV4
-  if (oc_sock_listener_fd_isset(&dev->secure4, fds)) {
-    OC_DBG("udp receive secure4.sock(fd=%d)", dev->secure4.sock);
-    FD_CLR(dev->secure4.sock, fds);
-    int count = oc_ip_recv_msg(dev->secure4.sock, message->data, OC_PDU_SIZE,
-                               &message->endpoint, false);
-    if (count < 0) {
-      return ADAPTER_STATUS_ERROR;
+
+#ifdef OC_TCP
+  if (fd == dev->tcp.connect_pipe[0]) {
+    adapter_receive_state_t status = tcp_receive_signal(&dev->tcp);
+    OC_DBG("Signal event received(fd=%d, status=%d)", fd, status);
+#if !OC_DBG_IS_ENABLED
+    (void)status;
+#endif /* OC_DBG_IS_ENABLED */
+    return 1;
+  }
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+  if (fd == dev->tcp.cfds_epoll_fd) {
+    return process_socket_write_events(dev);
+  }
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+#endif /* OC_TCP */
+
+  return process_socket_read_event(dev, fd);
+}
+
+static void
+network_event_loop(ip_context_t *dev)
+{
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+  oc_clock_time_t expires_in = 0;
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+  struct epoll_event events[OC_EPOLL_MAX_EVENTS];
+  while (OC_ATOMIC_LOAD8(dev->terminate) != 1) {
+    int timeout = -1;
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+    timeout = oc_netpoll_timeout_ms(expires_in);
+    if (timeout >= 0) {
+      OC_DBG("network_event_thread timeout:%dms", timeout);
     }
-    message->length = (size_t)count;
-    message->endpoint.flags = IPV4 | SECURED;
-    message->encrypted = 1;
-    return ADAPTER_STATUS_RECEIVE;
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+    int n =
+      epoll_wait(dev->epoll_fd, events, (int)OC_ARRAY_SIZE(events), timeout);
+    if (n < 0) {
+      if (errno != EINTR) {
+        OC_ERR("epoll_wait failed (error: %d)", (int)errno);
+      }
+      continue;
+    }
+
+    OC_DBG("processing %d events", n);
+    for (int i = 0; i < n; ++i) {
+      if (events[i].data.fd == dev->shutdown_pipe[0]) {
+        process_shutdown(dev);
+        continue;
+      }
+      if (OC_ATOMIC_LOAD8(dev->terminate) ||
+          process_event(dev, events[i].data.fd) < 0) {
+        break;
+      }
+    }
+
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+    expires_in = tcp_check_expiring_sessions(oc_clock_time_monotonic());
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
   }
+}
+
+#else /* !OC_HAS_FEATURE_EPOLL */
+
+static int
+udp_get_ready_socket(const ip_context_t *dev, fd_set *fds)
+{
+  const int socks[] = {
+    dev->server.sock,  dev->mcast_sock,
+#ifdef OC_IPV4
+    dev->server4.sock, dev->mcast4_sock,
+#endif /* OC_IPV4 */
+#ifdef OC_SECURITY
+    dev->secure.sock,
+#ifdef OC_IPV4
+    dev->secure4.sock,
 #endif /* OC_IPV4 */
 #endif /* OC_SECURITY */
-
-  return ADAPTER_STATUS_NONE;
+  };
+  for (size_t i = 0; i < OC_ARRAY_SIZE(socks); ++i) {
+    if (socks[i] >= 0 && FD_ISSET(socks[i], fds)) {
+      FD_CLR(socks[i], fds);
+      return socks[i];
+    }
+  }
+  return -1;
 }
 
 static bool
@@ -805,35 +1069,31 @@ process_socket_signal_event(const ip_context_t *dev, fd_set *rdfds)
 static int
 process_socket_read_event(ip_context_t *dev, fd_set *rdfds)
 {
+  int sock = udp_get_ready_socket(dev, rdfds);
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  transport_flags flags;
+  bool multicast;
+  if (sock >= 0 && udp_get_socket_flags(dev, sock, &flags, &multicast)) {
+    return udp_receive_messages(dev, sock, flags, multicast);
+  }
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
   oc_message_t *message = oc_allocate_message();
   if (message == NULL) {
     return -1;
   }
   message->endpoint.device = dev->device;
 
-  adapter_receive_state_t s = oc_udp_receive_message(dev, rdfds, message);
-  if (s == ADAPTER_STATUS_RECEIVE) {
-    goto receive;
+  adapter_receive_state_t s = ADAPTER_STATUS_NONE;
+  if (sock >= 0) {
+    s = oc_udp_receive_message(dev, sock, message);
   }
 #ifdef OC_TCP
-  if (s == ADAPTER_STATUS_NONE) {
+  else {
     s = tcp_receive_message(dev, rdfds, message);
-    if (s == ADAPTER_STATUS_RECEIVE) {
-      goto receive;
-    }
   }
 #endif /* OC_TCP */
-
-  oc_message_unref(message);
-  return s == ADAPTER_STATUS_NONE ? 0 : 1;
-
-receive:
-  OC_DBG("Incoming message of size %zd bytes from", message->length);
-  OC_LOGipaddr(message->endpoint);
-  OC_DBG("%s", "");
-
-  oc_network_receive_event(message);
-  return 1;
+  return process_received_message(message, s);
 }
 
 static int
@@ -931,24 +1191,9 @@ to_timeval(oc_clock_time_t ticks)
 }
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
 
-static void *
-network_event_thread(void *data)
+static void
+network_event_loop(ip_context_t *dev)
 {
-  ip_context_t *dev = (ip_context_t *)data;
-  FD_ZERO(&dev->rfds);
-  /* Monitor network interface changes on the platform from only the 0th
-   * logical device
-   */
-  if (dev->device == 0) {
-    FD_SET(g_ifchange_sock, &dev->rfds);
-  }
-  FD_SET(dev->shutdown_pipe[0], &dev->rfds);
-
-  udp_add_socks_to_rfd_set(dev);
-#ifdef OC_TCP
-  tcp_add_socks_to_rfd_set(dev);
-#endif /* OC_TCP */
-
 #ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
   oc_clock_time_t expires_in = 0;
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
@@ -983,10 +1228,56 @@ network_event_thread(void *data)
     expires_in = tcp_check_expiring_sessions(oc_clock_time_monotonic());
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
   }
+}
+
+#endif /* OC_HAS_FEATURE_EPOLL */
+
+static void *
+network_event_thread(void *data)
+{
+  ip_context_t *dev = (ip_context_t *)data;
+  /* Monitor network interface changes on the platform from only the 0th
+   * logical device
+   */
+  if (dev->device == 0) {
+    ip_context_rfds_fd_set(dev, g_ifchange_sock);
+  }
+  ip_context_rfds_fd_set(dev, dev->shutdown_pipe[0]);
+
+  udp_add_socks_to_rfd_set(dev);
+#ifdef OC_TCP
+  tcp_add_socks_to_rfd_set(dev);
+#endif /* OC_TCP */
+
+  network_event_loop(dev);
   pthread_exit(NULL);
   return NULL;
 }
 
+static int
+udp_get_send_socket(const ip_context_t *dev, transport_flags flags)
+{
+#ifdef OC_SECURITY
+  if (flags & SECURED) {
+#ifdef OC_IPV4
+    if (flags & IPV4) {
+      return dev->secure4.sock;
+    }
+#endif /* OC_IPV4 */
+    return dev->secure.sock;
+  }
+#endif /* OC_SECURITY */
+#ifdef OC_IPV4
+  if (flags & IPV4) {
+    return dev->server4.sock;
+  }
+#endif /* OC_IPV4 */
+#if !defined(OC_SECURITY) && !defined(OC_IPV4)
+  (void)flags;
+#endif /* !OC_SECURITY && !OC_IPV4 */
+  return dev->server.sock;
+}
+
 static int
 oc_send_buffer_internal(oc_message_t *message, bool create, bool queue)
 {
@@ -1013,32 +1304,7 @@ oc_send_buffer_internal(oc_message_t *message, bool create, bool queue)
   (void)queue;
 #endif /* OC_TCP */
 
-  int send_sock = -1;
-#ifdef OC_SECURITY
-  if (message->endpoint.flags & SECURED) {
-#ifdef OC_IPV4
-    if (message->endpoint.flags & IPV4) {
-      send_sock = dev->secure4.sock;
-    } else {
-      send_sock = dev->secure.sock;
-    }
-#else  /* !OC_IPV4 */
-    send_sock = dev->secure.sock;
-#endif /* OC_IPV4 */
-  } else
-#endif /* OC_SECURITY */
-#ifdef OC_IPV4
-    if (message->endpoint.flags & IPV4) {
-    send_sock = dev->server4.sock;
-  } else {
-    send_sock = dev->server.sock;
-  }
-#else  /* !OC_IPV4 */
-  {
-    send_sock = dev->server.sock;
-  }
-#endif /* OC_IPV4 */
-
+  int send_sock = udp_get_send_socket(dev, message->endpoint.flags);
   return (int)oc_ip_send_msg(send_sock, &receiver, message);
 }
 
@@ -1054,6 +1320,71 @@ oc_send_buffer2(oc_message_t *message, bool queue)
   return oc_send_buffer_internal(message, false, queue);
 }
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+
+typedef struct
+{
+  oc_message_t *messages[OC_UDP_BATCH_SIZE];
+  size_t count;
+} udp_send_batch_t;
+
+static udp_send_batch_t g_udp_send_batch;
+
+bool
+oc_send_buffer_batch_add(oc_message_t *message)
+{
+  if ((message->endpoint.flags & (TCP | MULTICAST | DISCOVERY)) != 0 ||
+      oc_get_ip_context_for_device(message->endpoint.device) == NULL) {
+    return false;
+  }
+  if (g_udp_send_batch.count == OC_ARRAY_SIZE(g_udp_send_batch.messages)) {
+    oc_send_buffer_batch_flush();
+  }
+  OC_DBG("Outgoing message of size %zd bytes queued to", message->length);
+  OC_LOGipaddr(message->endpoint);
+  OC_DBG("%s", "");
+  oc_message_add_ref(message);
+  g_udp_send_batch.messages[g_udp_send_batch.count] = message;
+  ++g_udp_send_batch.count;
+  return true;
+}
+
+void
+oc_send_buffer_batch_flush(void)
+{
+  oc_message_t **messages = g_udp_send_batch.messages;
+  size_t count = g_udp_send_batch.count;
+  // sendmmsg sends to a single socket, so send consecutive messages with the
+  // same device and socket together
+  struct sockaddr_storage receivers[OC_UDP_BATCH_SIZE];
+  size_t i = 0;
+  while (i < count) {
+    size_t device = messages[i]->endpoint.device;
+    const ip_context_t *dev = oc_get_ip_context_for_device(device);
+    int sock =
+      dev != NULL ? udp_get_send_socket(dev, messages[i]->endpoint.flags) : -1;
+    size_t n = 0;
+    do {
+      receivers[n] = oc_socket_get_address(&messages[i + n]->endpoint);
+      ++n;
+    } while (i + n < count && messages[i + n]->endpoint.device == device &&
+             dev != NULL &&
+             udp_get_send_socket(dev, messages[i + n]->endpoint.flags) ==
+               sock);
+    if (sock >= 0) {
+      oc_ip_send_msgs(sock, receivers, &messages[i], n);
+    }
+    for (size_t j = i; j < i + n; ++j) {
+      oc_message_unref(messages[j]);
+      messages[j] = NULL;
+    }
+    i += n;
+  }
+  g_udp_send_batch.count = 0;
+}
+
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
 #ifdef OC_CLIENT
 
 typedef enum {
@@ -1396,9 +1727,17 @@ initialize_ip_context(ip_context_t *dev, size_t device,
   dev->device = device;
   OC_LIST_STRUCT_INIT(dev, eps);
 
+#ifdef OC_HAS_FEATURE_EPOLL
+  dev->epoll_fd = oc_netpoll_create();
+  if (dev->epoll_fd < 0) {
+    return false;
+  }
+#else  /* !OC_HAS_FEATURE_EPOLL */
   if (pthread_mutex_init(&dev->rfds_mutex, NULL) != 0) {
     oc_abort("error initializing TCP adapter mutex");
   }
+  FD_ZERO(&dev->rfds);
+#endif /* OC_HAS_FEATURE_EPOLL */
 
   if (pipe(dev->shutdown_pipe) < 0) {
     OC_ERR("shutdown pipe: %d", errno);
@@ -1523,6 +1862,11 @@ oc_connectivity_shutdown(size_t device)
     return;
   }
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  // send queued messages while the sockets are still open
+  oc_send_buffer_batch_flush();
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
   OC_ATOMIC_STORE8(dev->terminate, 1);
   do {
     if (write(dev->shutdown_pipe[1], "\n", 1) < 0) {
@@ -1536,6 +1880,10 @@ oc_connectivity_shutdown(size_t device)
 
   pthread_join(dev->event_thread, NULL);
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+  udp_batch_free_messages(dev);
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
   oc_sock_listener_close(&dev->server);
   if (dev->mcast_sock >= 0) {
     close(dev->mcast_sock);
@@ -1562,7 +1910,11 @@ oc_connectivity_shutdown(size_t device)
   close(dev->shutdown_pipe[1]);
   close(dev->shutdown_pipe[0]);
 
+#ifdef OC_HAS_FEATURE_EPOLL
+  close(dev->epoll_fd);
+#else  /* !OC_HAS_FEATURE_EPOLL */
   pthread_mutex_destroy(&dev->rfds_mutex);
+#endif /* OC_HAS_FEATURE_EPOLL */
 
   free_endpoints_list(dev);
 
@@ -18,6 +18,24 @@
 
 #include "ipcontext.h"
 
+#ifdef OC_HAS_FEATURE_EPOLL
+
+#include "netpoll.h"
+
+void
+ip_context_rfds_fd_set(ip_context_t *dev, int sockfd)
+{
+  oc_netpoll_add(dev->epoll_fd, sockfd, EPOLLIN);
+}
+
+void
+ip_context_rfds_fd_clr(ip_context_t *dev, int sockfd)
+{
+  oc_netpoll_remove(dev->epoll_fd, sockfd);
+}
+
+#else /* !OC_HAS_FEATURE_EPOLL */
+
 void
 ip_context_rfds_fd_set(ip_context_t *dev, int sockfd)
 {
@@ -44,3 +62,5 @@ ip_context_rfds_fd_copy(ip_context_t *dev)
   pthread_mutex_unlock(&dev->rfds_mutex);
   return setfds;
 }
+
+#endif /* OC_HAS_FEATURE_EPOLL */
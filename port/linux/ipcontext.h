@@ -22,9 +22,13 @@
 #include "oc_endpoint.h"
 #include "socklistener.h"
 #include "util/oc_atomic.h"
+#include "util/oc_features.h"
 #ifdef OC_TCP
 #include "tcpcontext.h"
 #endif /* OC_TCP */
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+#include "ip.h"
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
 #include <pthread.h>
 #include <stdint.h>
 #include <sys/select.h>
@@ -68,16 +72,28 @@ typedef struct ip_context_t
   pthread_t event_thread;
   OC_ATOMIC_INT8_T terminate;
   size_t device;
+#ifdef OC_HAS_FEATURE_EPOLL
+  int epoll_fd; ///< epoll instance monitoring read events
+#else  /* !OC_HAS_FEATURE_EPOLL */
   pthread_mutex_t rfds_mutex;
   fd_set rfds;
+#endif /* OC_HAS_FEATURE_EPOLL */
   int shutdown_pipe[2];
   OC_ATOMIC_INT8_T flags;
+#if defined(OC_HAS_FEATURE_UDP_BATCH) && defined(OC_DYNAMIC_ALLOCATION)
+  oc_message_t *udp_rx_spares[OC_UDP_BATCH_SIZE]; ///< allocated messages not
+                                                  ///< used by the last batch
+  size_t udp_rx_spares_count; ///< used only by the network thread
+#endif /* OC_HAS_FEATURE_UDP_BATCH && OC_DYNAMIC_ALLOCATION */
 } ip_context_t;
 
 /**
  * Set a given file descriptor to a set of read descriptors (dev->rfds) under
  * the mutex(rfds_mutex).
  *
+ * With OC_HAS_FEATURE_EPOLL the file descriptor is added to the epoll instance
+ * (dev->epoll_fd) instead.
+ *
  * @param[in] dev the device network context.
  * @param[in] sockfd the file descriptor.
  */
@@ -87,11 +103,16 @@ void ip_context_rfds_fd_set(ip_context_t *dev, int sockfd);
  * Remove a given file descriptor from a set (dev->rfds) under the
  * mutex(rfds_mutex).
  *
+ * With OC_HAS_FEATURE_EPOLL the file descriptor is removed from the epoll
+ * instance (dev->epoll_fd) instead.
+ *
  * @param[in] dev the device network context.
  * @param[in] sockfd the file descriptor.
  */
 void ip_context_rfds_fd_clr(ip_context_t *dev, int sockfd);
 
+#ifndef OC_HAS_FEATURE_EPOLL
+
 /**
  * Make a copy of file descriptor set (dev->rfds) under the mutex(rfds_mutex).
  *
@@ -101,6 +122,8 @@ void ip_context_rfds_fd_clr(ip_context_t *dev, int sockfd);
  */
 fd_set ip_context_rfds_fd_copy(ip_context_t *dev);
 
+#endif /* !OC_HAS_FEATURE_EPOLL */
+
 #ifdef __cplusplus
 }
 #endif
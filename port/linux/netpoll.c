@@ -0,0 +1,84 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_EPOLL
+
+#include "netpoll.h"
+#include "port/oc_log_internal.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+
+int
+oc_netpoll_create(void)
+{
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    OC_ERR("cannot create epoll instance (error: %d)", (int)errno);
+    return -1;
+  }
+  return epoll_fd;
+}
+
+bool
+oc_netpoll_add(int epoll_fd, int fd, uint32_t events)
+{
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    OC_ERR("cannot add fd(%d) to epoll(%d) (error: %d)", fd, epoll_fd,
+           (int)errno);
+    return false;
+  }
+  return true;
+}
+
+bool
+oc_netpoll_remove(int epoll_fd, int fd)
+{
+  // a non-NULL event is required by kernels before 2.6.9
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev) < 0 && errno != ENOENT &&
+      errno != EBADF) {
+    OC_ERR("cannot remove fd(%d) from epoll(%d) (error: %d)", fd, epoll_fd,
+           (int)errno);
+    return false;
+  }
+  return true;
+}
+
+int
+oc_netpoll_timeout_ms(oc_clock_time_t ticks)
+{
+  if (ticks == 0) {
+    return -1;
+  }
+  oc_clock_time_t ms = (ticks * 1000 + OC_CLOCK_SECOND - 1) / OC_CLOCK_SECOND;
+  if (ms > INT_MAX) {
+    return INT_MAX;
+  }
+  return ms == 0 ? 1 : (int)ms;
+}
+
+#endif /* OC_HAS_FEATURE_EPOLL */
@@ -0,0 +1,79 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef NETPOLL_H
+#define NETPOLL_H
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_EPOLL
+
+#include "port/oc_clock.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create an epoll instance.
+ *
+ * @return >=0 file descriptor of the epoll instance
+ * @return -1 on failure
+ */
+int oc_netpoll_create(void);
+
+/**
+ * @brief Start monitoring a file descriptor (level-triggered).
+ *
+ * @param epoll_fd epoll instance
+ * @param fd file descriptor to monitor, stored in epoll_event.data.fd
+ * @param events mask of monitored events (EPOLLIN, EPOLLOUT, ...)
+ * @return true on success
+ * @return false on failure
+ */
+bool oc_netpoll_add(int epoll_fd, int fd, uint32_t events);
+
+/**
+ * @brief Stop monitoring a file descriptor.
+ *
+ * @param epoll_fd epoll instance
+ * @param fd monitored file descriptor
+ * @return true on success or if the file descriptor was not monitored
+ * @return false on failure
+ */
+bool oc_netpoll_remove(int epoll_fd, int fd);
+
+/**
+ * @brief Convert a timeout in clock ticks to the epoll_wait timeout.
+ *
+ * @param ticks timeout in clock ticks, 0 for no timeout
+ * @return timeout in milliseconds rounded up, -1 for no timeout
+ */
+int oc_netpoll_timeout_ms(oc_clock_time_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_EPOLL */
+
+#endif /* NETPOLL_H */
@@ -26,6 +26,22 @@
 #include "util/oc_secure_string_internal.h"
 #include "util/oc_macros_internal.h"
 
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+#include "storage_log.h"
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
+
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+#include "util/oc_list.h"
+
+#include <pthread.h>
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
+#if defined(OC_HAS_FEATURE_STORAGE_LOG) ||                                     \
+  defined(OC_HAS_FEATURE_STORAGE_WRITE_BEHIND)
+#include <fcntl.h>
+#include <stdlib.h>
+#endif /* OC_HAS_FEATURE_STORAGE_LOG || OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 #include <assert.h>
 #include <errno.h>
 #include <stdbool.h>
@@ -37,6 +53,25 @@
 static char g_store_path[OC_STORE_PATH_SIZE] = { 0 };
 static uint8_t g_store_path_len = 0;
 
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+static oc_storage_log_t *g_storage_log = NULL;
+
+static void
+storage_close_log(void)
+{
+  if (g_storage_log != NULL) {
+    oc_storage_log_close(g_storage_log);
+    g_storage_log = NULL;
+  }
+}
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
+
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+static void storage_stop_write_thread(void);
+static bool storage_read_pending(const char *path, uint8_t *buf, size_t size,
+                                 long *ret);
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 int
 oc_storage_config(const char *store)
 {
@@ -53,6 +88,11 @@ oc_storage_config(const char *store)
     return -ENOENT;
   }
 
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+  // the log of the new path is opened on the first access
+  storage_close_log();
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
+
   // remove multiple trailing slashes
   while (store_len > 1 && store[store_len - 2] == '/') {
     --store_len;
@@ -95,13 +135,20 @@ oc_storage_path(char *buffer, size_t buffer_size)
 int
 oc_storage_reset(void)
 {
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+  // the pending writes are written before the storage is disabled
+  storage_stop_write_thread();
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+  storage_close_log();
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
   g_store_path_len = 0;
   g_store_path[0] = '\0';
   return 0;
 }
 
 static int
-storage_open(const char *store, FILE **fp)
+storage_set_store_path(const char *store)
 {
   if (g_store_path_len == 0) {
     OC_ERR("failed to open storage: store path is empty");
@@ -120,7 +167,108 @@ storage_open(const char *store, FILE **fp)
   }
   memcpy(g_store_path + g_store_path_len, store, store_len);
   g_store_path[g_store_path_len + store_len] = '\0';
+  return 0;
+}
+
+#if defined(OC_HAS_FEATURE_STORAGE_LOG) ||                                     \
+  defined(OC_HAS_FEATURE_STORAGE_WRITE_BEHIND)
+
+int
+oc_storage_sync_dir(const char *path)
+{
+  const char *sep = strrchr(path, '/');
+  char *dir = NULL;
+  if (sep != NULL) {
+    size_t dir_len = sep == path ? 1 : (size_t)(sep - path);
+    dir = (char *)malloc(dir_len + 1);
+    if (dir == NULL) {
+      return -ENOMEM;
+    }
+    memcpy(dir, path, dir_len);
+    dir[dir_len] = '\0';
+  }
+  const char *dir_path = dir != NULL ? dir : ".";
+  int fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    int err = errno;
+    OC_ERR("failed to open the storage directory %s: %d", dir_path, err);
+    free(dir);
+    return -err;
+  }
+  int ret = 0;
+  if (fsync(fd) != 0) {
+    ret = -errno;
+    OC_ERR("failed to sync the storage directory %s: %d", dir_path, -ret);
+  }
+  close(fd);
+  free(dir);
+  return ret;
+}
 
+#endif /* OC_HAS_FEATURE_STORAGE_LOG || OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+
+static oc_storage_log_t *
+storage_get_log(void)
+{
+  if (g_storage_log == NULL) {
+    char path[OC_STORE_PATH_SIZE + sizeof(OC_STORAGE_LOG_FILE_NAME)];
+    memcpy(path, g_store_path, g_store_path_len);
+    memcpy(path + g_store_path_len, OC_STORAGE_LOG_FILE_NAME,
+           sizeof(OC_STORAGE_LOG_FILE_NAME));
+    g_storage_log = oc_storage_log_open(path);
+  }
+  return g_storage_log;
+}
+
+long
+oc_storage_size(const char *store)
+{
+  int ret = storage_set_store_path(store);
+  if (ret != 0) {
+    return ret;
+  }
+  oc_storage_log_t *log = storage_get_log();
+  if (log == NULL) {
+    return -ENOENT;
+  }
+  return oc_storage_log_size(log, store);
+}
+
+long
+oc_storage_read(const char *store, uint8_t *buf, size_t size)
+{
+  int ret = storage_set_store_path(store);
+  if (ret != 0) {
+    return ret;
+  }
+  oc_storage_log_t *log = storage_get_log();
+  if (log == NULL) {
+    return -ENOENT;
+  }
+  return oc_storage_log_read(log, store, buf, size);
+}
+
+long
+oc_storage_write(const char *store, const uint8_t *buf, size_t size)
+{
+  int ret = storage_set_store_path(store);
+  if (ret != 0) {
+    return ret;
+  }
+  oc_storage_log_t *log = storage_get_log();
+  if (log == NULL) {
+    return -ENOENT;
+  }
+  return oc_storage_log_write(log, store, buf, size);
+}
+
+#else /* !OC_HAS_FEATURE_STORAGE_LOG */
+
+static int
+storage_open(FILE **fp)
+{
   FILE *file = fopen(g_store_path, "rb");
   if (file == NULL) {
     int err = errno;
@@ -141,8 +289,18 @@ storage_open(const char *store, FILE **fp)
 long
 oc_storage_size(const char *store)
 {
+  int ret = storage_set_store_path(store);
+  if (ret != 0) {
+    return ret;
+  }
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+  long pending_size = 0;
+  if (storage_read_pending(g_store_path, NULL, 0, &pending_size)) {
+    return pending_size;
+  }
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
   FILE *fp = NULL;
-  int ret = storage_open(store, &fp);
+  ret = storage_open(&fp);
   if (ret != 0) {
     return ret;
   }
@@ -163,8 +321,18 @@ oc_storage_size(const char *store)
 long
 oc_storage_read(const char *store, uint8_t *buf, size_t size)
 {
+  int ret = storage_set_store_path(store);
+  if (ret != 0) {
+    return ret;
+  }
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+  long pending_size = 0;
+  if (storage_read_pending(g_store_path, buf, size, &pending_size)) {
+    return pending_size;
+  }
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
   FILE *fp = NULL;
-  int ret = storage_open(store, &fp);
+  ret = storage_open(&fp);
   if (ret != 0) {
     return ret;
   }
@@ -235,6 +403,295 @@ write_and_flush(FILE *fp, const char *file, const uint8_t *buf, size_t size)
   return (long)wsize;
 }
 
+static long
+storage_write_file(const char *path, const uint8_t *buf, size_t size)
+{
+  while (true) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+      int err = errno;
+      OC_ERR("failed to open %s for write: %d", path, err);
+      return -err;
+    }
+
+    long ret = write_and_flush(fp, path, buf, size);
+    if (fclose(fp) != 0) {
+      OC_ERR("failed to close the storage file %s: %d", path, errno);
+    }
+    if (ret < 0 && (ret == -EAGAIN || ret == -EINTR)) {
+      continue;
+    }
+    return ret;
+  }
+}
+
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+
+#define STORAGE_TMP_SUFFIX ".tmp"
+
+/* Pending write of a store, owned by the list of pending writes or by the
+ * writer thread while it is being written */
+typedef struct storage_write_t
+{
+  struct storage_write_t *next;
+  char path[OC_STORE_PATH_SIZE];
+  uint8_t *buf;
+  size_t size;
+} storage_write_t;
+
+static pthread_mutex_t g_storage_mutex = PTHREAD_MUTEX_INITIALIZER;
+// signaled when a write is queued or the writer thread should terminate
+static pthread_cond_t g_storage_queued_cv = PTHREAD_COND_INITIALIZER;
+// signaled when a write is finished
+static pthread_cond_t g_storage_written_cv = PTHREAD_COND_INITIALIZER;
+static pthread_t g_storage_thread;
+static bool g_storage_thread_running = false;
+static bool g_storage_thread_terminate = false;
+OC_LIST(g_storage_writes);
+static storage_write_t *g_storage_writing = NULL;
+static int g_storage_write_error = 0;
+static oc_storage_write_stats_t g_storage_write_stats = { 0 };
+
+/* Write the data to a temporary file and rename it to the store, so the store
+ * holds either the previous or the new data after a power loss */
+static long
+storage_write_durable(const char *path, const uint8_t *buf, size_t size)
+{
+  char tmp_path[OC_STORE_PATH_SIZE + sizeof(STORAGE_TMP_SUFFIX)];
+  int len = snprintf(tmp_path, sizeof(tmp_path), "%s" STORAGE_TMP_SUFFIX, path);
+  if (len < 0 || (size_t)len >= sizeof(tmp_path)) {
+    return -ENAMETOOLONG;
+  }
+  long ret = storage_write_file(tmp_path, buf, size);
+  if (ret < 0) {
+    remove(tmp_path);
+    return ret;
+  }
+  if (rename(tmp_path, path) != 0) {
+    int err = errno;
+    OC_ERR("failed to rename %s to %s: %d", tmp_path, path, err);
+    remove(tmp_path);
+    return -err;
+  }
+  int err = oc_storage_sync_dir(path);
+  if (err != 0) {
+    return err;
+  }
+  return ret;
+}
+
+static void
+storage_write_free(storage_write_t *write)
+{
+  free(write->buf);
+  free(write);
+}
+
+static void *
+storage_write_thread(void *data)
+{
+  (void)data;
+  pthread_mutex_lock(&g_storage_mutex);
+  while (true) {
+    while (oc_list_length(g_storage_writes) == 0 &&
+           !g_storage_thread_terminate) {
+      pthread_cond_wait(&g_storage_queued_cv, &g_storage_mutex);
+    }
+    // pending writes are written before the thread terminates
+    storage_write_t *write = (storage_write_t *)oc_list_pop(g_storage_writes);
+    if (write == NULL) {
+      break;
+    }
+    g_storage_writing = write;
+    pthread_mutex_unlock(&g_storage_mutex);
+
+    long ret = storage_write_durable(write->path, write->buf, write->size);
+
+    pthread_mutex_lock(&g_storage_mutex);
+    g_storage_writing = NULL;
+    if (ret < 0) {
+      ++g_storage_write_stats.failed;
+      if (g_storage_write_error == 0) {
+        g_storage_write_error = (int)ret;
+      }
+    } else {
+      ++g_storage_write_stats.written;
+    }
+    pthread_cond_broadcast(&g_storage_written_cv);
+    // readers only access the write while it is set as g_storage_writing
+    storage_write_free(write);
+  }
+  pthread_mutex_unlock(&g_storage_mutex);
+  return NULL;
+}
+
+static int
+storage_start_write_thread_locked(void)
+{
+  if (g_storage_thread_running) {
+    return 0;
+  }
+  int err = pthread_create(&g_storage_thread, NULL, storage_write_thread, NULL);
+  if (err != 0) {
+    OC_ERR("failed to create the storage writer thread: %d", err);
+    return -err;
+  }
+  g_storage_thread_running = true;
+  return 0;
+}
+
+static void
+storage_stop_write_thread(void)
+{
+  pthread_mutex_lock(&g_storage_mutex);
+  if (!g_storage_thread_running) {
+    pthread_mutex_unlock(&g_storage_mutex);
+    return;
+  }
+  g_storage_thread_terminate = true;
+  pthread_cond_signal(&g_storage_queued_cv);
+  pthread_mutex_unlock(&g_storage_mutex);
+
+  pthread_join(g_storage_thread, NULL);
+
+  pthread_mutex_lock(&g_storage_mutex);
+  g_storage_thread_running = false;
+  g_storage_thread_terminate = false;
+  pthread_mutex_unlock(&g_storage_mutex);
+}
+
+static storage_write_t *
+storage_find_write_locked(const char *path)
+{
+  // the pending write is newer than the write in progress
+  for (storage_write_t *write =
+         (storage_write_t *)oc_list_head(g_storage_writes);
+       write != NULL; write = write->next) {
+    if (strcmp(write->path, path) == 0) {
+      return write;
+    }
+  }
+  if (g_storage_writing != NULL && strcmp(g_storage_writing->path, path) == 0) {
+    return g_storage_writing;
+  }
+  return NULL;
+}
+
+static long
+storage_write_behind(const char *path, const uint8_t *buf, size_t size)
+{
+  uint8_t *data = NULL;
+  if (size > 0) {
+    data = (uint8_t *)malloc(size);
+    if (data == NULL) {
+      OC_ERR("failed to allocate buffer for write of %s", path);
+      return -ENOMEM;
+    }
+    memcpy(data, buf, size);
+  }
+
+  pthread_mutex_lock(&g_storage_mutex);
+  ++g_storage_write_stats.queued;
+  storage_write_t *write = storage_find_write_locked(path);
+  if (write != NULL && write != g_storage_writing) {
+    // the store was not written yet, so only the latest data are written
+    free(write->buf);
+    write->buf = data;
+    write->size = size;
+    ++g_storage_write_stats.coalesced;
+    pthread_mutex_unlock(&g_storage_mutex);
+    return (long)size;
+  }
+
+  write = (storage_write_t *)calloc(1, sizeof(storage_write_t));
+  int err = write != NULL ? storage_start_write_thread_locked() : -ENOMEM;
+  if (err != 0) {
+    --g_storage_write_stats.queued;
+    pthread_mutex_unlock(&g_storage_mutex);
+    OC_ERR("failed to queue write of %s: %d", path, err);
+    free(write);
+    free(data);
+    return err;
+  }
+  memcpy(write->path, path, strlen(path) + 1);
+  write->buf = data;
+  write->size = size;
+  oc_list_add(g_storage_writes, write);
+  pthread_cond_signal(&g_storage_queued_cv);
+  pthread_mutex_unlock(&g_storage_mutex);
+  return (long)size;
+}
+
+static bool
+storage_read_pending(const char *path, uint8_t *buf, size_t size, long *ret)
+{
+  pthread_mutex_lock(&g_storage_mutex);
+  const storage_write_t *write = storage_find_write_locked(path);
+  if (write == NULL) {
+    pthread_mutex_unlock(&g_storage_mutex);
+    return false;
+  }
+  if (buf == NULL) {
+    *ret = (long)write->size;
+  } else if (write->size > size) {
+    OC_ERR("pending write of %s is bigger (%u) than the provided buffer "
+           "size(%u)",
+           path, (unsigned)write->size, (unsigned)size);
+    *ret = -EINVAL;
+  } else {
+    if (write->size > 0) {
+      memcpy(buf, write->buf, write->size);
+    }
+    *ret = (long)write->size;
+  }
+  pthread_mutex_unlock(&g_storage_mutex);
+  return true;
+}
+
+int
+oc_storage_flush(void)
+{
+  pthread_mutex_lock(&g_storage_mutex);
+  while (oc_list_length(g_storage_writes) > 0 || g_storage_writing != NULL) {
+    pthread_cond_wait(&g_storage_written_cv, &g_storage_mutex);
+  }
+  int err = g_storage_write_error;
+  g_storage_write_error = 0;
+  pthread_mutex_unlock(&g_storage_mutex);
+  return err;
+}
+
+int
+oc_storage_shutdown(void)
+{
+  // the pending writes are written before the thread terminates
+  storage_stop_write_thread();
+  pthread_mutex_lock(&g_storage_mutex);
+  int err = g_storage_write_error;
+  g_storage_write_error = 0;
+  pthread_mutex_unlock(&g_storage_mutex);
+  return err;
+}
+
+oc_storage_write_stats_t
+oc_storage_get_write_stats(void)
+{
+  pthread_mutex_lock(&g_storage_mutex);
+  oc_storage_write_stats_t stats = g_storage_write_stats;
+  pthread_mutex_unlock(&g_storage_mutex);
+  return stats;
+}
+
+void
+oc_storage_reset_write_stats(void)
+{
+  pthread_mutex_lock(&g_storage_mutex);
+  memset(&g_storage_write_stats, 0, sizeof(g_storage_write_stats));
+  pthread_mutex_unlock(&g_storage_mutex);
+}
+
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 long
 oc_storage_write(const char *store, const uint8_t *buf, size_t size)
 {
@@ -255,22 +712,12 @@ oc_storage_write(const char *store, const uint8_t *buf, size_t size)
   memcpy(g_store_path + g_store_path_len, store, store_len);
   g_store_path[g_store_path_len + store_len] = '\0';
 
-  while (true) {
-    FILE *fp = fopen(g_store_path, "wb");
-    if (fp == NULL) {
-      int err = errno;
-      OC_ERR("failed to open %s for write: %d", g_store_path, err);
-      return -err;
-    }
-
-    long ret = write_and_flush(fp, g_store_path, buf, size);
-    if (fclose(fp) != 0) {
-      OC_ERR("failed to close the storage file %s: %d", g_store_path, errno);
-    }
-    if (ret < 0 && (ret == -EAGAIN || ret == -EINTR)) {
-      continue;
-    }
-    return ret;
-  }
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+  return storage_write_behind(g_store_path, buf, size);
+#else  /* !OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+  return storage_write_file(g_store_path, buf, size);
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
 }
+
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
 #endif /* OC_STORAGE */
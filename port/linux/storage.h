@@ -19,12 +19,51 @@
 #ifndef STORAGE_H
 #define STORAGE_H
 
+#include "util/oc_compiler.h"
+#include "util/oc_features.h"
+
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define OC_STORE_PATH_SIZE (64)
 
+#if defined(OC_HAS_FEATURE_STORAGE_LOG) ||                                     \
+  defined(OC_HAS_FEATURE_STORAGE_WRITE_BEHIND)
+
+/**
+ * @brief Sync the directory of the file, so the creation or the rename of the
+ * file survives a power loss
+ *
+ * @param path path of the file (cannot be NULL)
+ * @return 0 on success
+ * @return <0 on failure
+ */
+int oc_storage_sync_dir(const char *path) OC_NONNULL();
+
+#endif /* OC_HAS_FEATURE_STORAGE_LOG || OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+
+/** @brief Statistics of the writes of the storage */
+typedef struct oc_storage_write_stats_t
+{
+  uint32_t queued;    ///< writes passed to oc_storage_write
+  uint32_t coalesced; ///< writes which replaced a pending write of the store
+  uint32_t written;   ///< writes written to the storage
+  uint32_t failed;    ///< writes which failed
+} oc_storage_write_stats_t;
+
+/** @brief Get the statistics of the writes of the storage */
+oc_storage_write_stats_t oc_storage_get_write_stats(void);
+
+/** @brief Reset the statistics of the writes of the storage */
+void oc_storage_reset_write_stats(void);
+
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 #ifdef __cplusplus
 }
 #endif
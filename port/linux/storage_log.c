@@ -0,0 +1,757 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+
+#include "port/oc_log_internal.h"
+#include "storage.h"
+#include "storage_log.h"
+#include "util/oc_hash_index_internal.h"
+#include "util/oc_hash_internal.h"
+#include "util/oc_list.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Layout of a record:
+ *  - magic (4 bytes)
+ *  - checksum (4 bytes), FNV-1a of the rest of the header, the name and the
+ *    data
+ *  - length of the name of the store (2 bytes)
+ *  - reserved (2 bytes)
+ *  - length of the data (4 bytes)
+ *  - name of the store (without the NULL-terminator)
+ *  - data
+ * The integers are in the byte order of the host, the log is not meant to be
+ * moved to other devices.
+ */
+#define STORAGE_LOG_RECORD_MAGIC (0x4C53434FU) /* "OCSL" */
+#define STORAGE_LOG_HEADER_SIZE (16)
+#define STORAGE_LOG_CHECKSUM_OFFSET (4)
+#define STORAGE_LOG_KEY_LEN_OFFSET (8)
+#define STORAGE_LOG_DATA_LEN_OFFSET (12)
+
+#define STORAGE_LOG_COMPACT_SUFFIX ".compact"
+
+/* Maximal length of the name of a store */
+#define STORAGE_LOG_KEY_MAX (255)
+
+typedef struct storage_log_entry_t
+{
+  struct storage_log_entry_t *next;
+  off_t offset;         ///< offset of the latest record of the store
+  off_t compact_offset; ///< offset of the record in the compacted log
+  uint32_t hash;
+  uint32_t size; ///< size of the data
+  uint16_t key_len;
+  char key[]; ///< NULL-terminated name of the store
+} storage_log_entry_t;
+
+struct oc_storage_log_t
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t compact_cv;     ///< compaction requested or terminate
+  pthread_mutex_t compact_mutex; ///< serializes compactions
+  pthread_t compact_thread;
+  bool compact_thread_running;
+  bool compact_requested;
+  bool terminate;
+  int fd;
+  off_t end; ///< end of the last valid record
+  OC_LIST_STRUCT(entries);
+  oc_hash_index_t index;
+  oc_storage_log_stats_t stats;
+  char *compact_path; ///< path of the log written by a compaction
+  char path[];
+};
+
+typedef struct
+{
+  uint16_t key_len;
+  uint32_t data_len;
+  uint32_t checksum;
+} storage_log_header_t;
+
+static size_t
+storage_log_record_size(uint16_t key_len, uint32_t data_len)
+{
+  return STORAGE_LOG_HEADER_SIZE + (size_t)key_len + (size_t)data_len;
+}
+
+static uint32_t
+storage_log_checksum(const uint8_t *record, size_t record_size)
+{
+  // the checksum covers the record after the checksum field
+  return oc_hash_fnv1a(OC_HASH_FNV1A_INIT,
+                       record + STORAGE_LOG_KEY_LEN_OFFSET,
+                       record_size - STORAGE_LOG_KEY_LEN_OFFSET);
+}
+
+static void
+storage_log_encode_record(uint8_t *record, const char *key, uint16_t key_len,
+                          const uint8_t *data, uint32_t data_len)
+{
+  uint32_t magic = STORAGE_LOG_RECORD_MAGIC;
+  memcpy(record, &magic, sizeof(magic));
+  memcpy(record + STORAGE_LOG_KEY_LEN_OFFSET, &key_len, sizeof(key_len));
+  uint16_t reserved = 0;
+  memcpy(record + STORAGE_LOG_KEY_LEN_OFFSET + sizeof(key_len), &reserved,
+         sizeof(reserved));
+  memcpy(record + STORAGE_LOG_DATA_LEN_OFFSET, &data_len, sizeof(data_len));
+  memcpy(record + STORAGE_LOG_HEADER_SIZE, key, key_len);
+  if (data_len > 0) {
+    memcpy(record + STORAGE_LOG_HEADER_SIZE + key_len, data, data_len);
+  }
+  uint32_t checksum =
+    storage_log_checksum(record, storage_log_record_size(key_len, data_len));
+  memcpy(record + STORAGE_LOG_CHECKSUM_OFFSET, &checksum, sizeof(checksum));
+}
+
+static bool
+storage_log_decode_header(const uint8_t *record, storage_log_header_t *header)
+{
+  uint32_t magic = 0;
+  memcpy(&magic, record, sizeof(magic));
+  if (magic != STORAGE_LOG_RECORD_MAGIC) {
+    return false;
+  }
+  memcpy(&header->checksum, record + STORAGE_LOG_CHECKSUM_OFFSET,
+         sizeof(header->checksum));
+  memcpy(&header->key_len, record + STORAGE_LOG_KEY_LEN_OFFSET,
+         sizeof(header->key_len));
+  memcpy(&header->data_len, record + STORAGE_LOG_DATA_LEN_OFFSET,
+         sizeof(header->data_len));
+  return header->key_len > 0 && header->key_len <= STORAGE_LOG_KEY_MAX;
+}
+
+static int
+storage_log_pread(int fd, uint8_t *buf, size_t size, off_t offset)
+{
+  while (size > 0) {
+    ssize_t ret = pread(fd, buf, size, offset);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -errno;
+    }
+    if (ret == 0) {
+      return -EIO;
+    }
+    buf += ret;
+    size -= (size_t)ret;
+    offset += ret;
+  }
+  return 0;
+}
+
+static int
+storage_log_pwrite(int fd, const uint8_t *buf, size_t size, off_t offset)
+{
+  while (size > 0) {
+    ssize_t ret = pwrite(fd, buf, size, offset);
+    if (ret < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return -errno;
+    }
+    buf += ret;
+    size -= (size_t)ret;
+    offset += ret;
+  }
+  return 0;
+}
+
+static bool
+storage_log_entry_match(const void *item, const void *key)
+{
+  return strcmp(((const storage_log_entry_t *)item)->key, (const char *)key) ==
+         0;
+}
+
+static uint32_t
+storage_log_key_hash(const char *key, size_t key_len)
+{
+  return oc_hash_fnv1a(OC_HASH_FNV1A_INIT, key, key_len);
+}
+
+static storage_log_entry_t *
+storage_log_find(const oc_storage_log_t *log, const char *key, size_t key_len)
+{
+  return (storage_log_entry_t *)oc_hash_index_find(
+    &log->index, storage_log_key_hash(key, key_len), storage_log_entry_match,
+    key);
+}
+
+static size_t
+storage_log_entry_record_size(const storage_log_entry_t *entry)
+{
+  return storage_log_record_size(entry->key_len, entry->size);
+}
+
+/* Point the entry of the store to a new record, add the entry if the store is
+ * new */
+static bool
+storage_log_update(oc_storage_log_t *log, const char *key, uint16_t key_len,
+                   off_t offset, uint32_t size)
+{
+  // the key of a record is not NULL-terminated
+  char lookup[STORAGE_LOG_KEY_MAX + 1];
+  memcpy(lookup, key, key_len);
+  lookup[key_len] = '\0';
+  storage_log_entry_t *entry = storage_log_find(log, lookup, key_len);
+  if (entry != NULL) {
+    log->stats.live_bytes -= storage_log_entry_record_size(entry);
+  } else {
+    entry = (storage_log_entry_t *)malloc(sizeof(storage_log_entry_t) +
+                                          (size_t)key_len + 1);
+    if (entry == NULL) {
+      return false;
+    }
+    entry->hash = storage_log_key_hash(lookup, key_len);
+    entry->key_len = key_len;
+    memcpy(entry->key, lookup, (size_t)key_len + 1);
+    entry->compact_offset = -1;
+    if (!oc_hash_index_insert(&log->index, entry->hash, entry)) {
+      free(entry);
+      return false;
+    }
+    oc_list_add(log->entries, entry);
+    ++log->stats.stores;
+  }
+  entry->offset = offset;
+  entry->size = size;
+  log->stats.live_bytes += storage_log_entry_record_size(entry);
+  return true;
+}
+
+/* Get the size of the valid record at the start of the buffer, 0 if the
+ * record is invalid */
+static size_t
+storage_log_valid_record_size(const uint8_t *record, size_t size)
+{
+  storage_log_header_t header;
+  if (size < STORAGE_LOG_HEADER_SIZE ||
+      !storage_log_decode_header(record, &header)) {
+    return 0;
+  }
+  size_t record_size = storage_log_record_size(header.key_len, header.data_len);
+  if (record_size > size ||
+      storage_log_checksum(record, record_size) != header.checksum) {
+    return 0;
+  }
+  return record_size;
+}
+
+/* Find the offset of the next valid record, the size of the data if there is
+ * none */
+static size_t
+storage_log_find_valid_record(const uint8_t *data, size_t size, size_t offset)
+{
+  for (; size - offset >= STORAGE_LOG_HEADER_SIZE; ++offset) {
+    if (storage_log_valid_record_size(data + offset, size - offset) > 0) {
+      return offset;
+    }
+  }
+  return size;
+}
+
+/* Build the index from the records of the log file. Invalid records followed
+ * by a valid record are skipped, the invalid records at the end of the file
+ * are dropped */
+static int
+storage_log_load(oc_storage_log_t *log)
+{
+  struct stat st;
+  if (fstat(log->fd, &st) != 0) {
+    return -errno;
+  }
+  size_t file_size = (size_t)st.st_size;
+  uint8_t *data = NULL;
+  if (file_size > 0) {
+    // a single read is faster than reading the records one by one
+    data = (uint8_t *)malloc(file_size);
+    if (data == NULL) {
+      return -ENOMEM;
+    }
+    int ret = storage_log_pread(log->fd, data, file_size, 0);
+    if (ret != 0) {
+      free(data);
+      return ret;
+    }
+  }
+
+  size_t offset = 0;
+  size_t skipped = 0;
+  while (file_size - offset >= STORAGE_LOG_HEADER_SIZE) {
+    const uint8_t *record = data + offset;
+    size_t record_size =
+      storage_log_valid_record_size(record, file_size - offset);
+    if (record_size == 0) {
+      // a corrupted record in the middle of the log is skipped, the records
+      // after it are still valid
+      size_t next = storage_log_find_valid_record(data, file_size, offset + 1);
+      if (next == file_size) {
+        break;
+      }
+      OC_WRN("storage log %s: skipping %zu bytes of invalid records at %zu",
+             log->path, next - offset, offset);
+      skipped += next - offset;
+      offset = next;
+      continue;
+    }
+    storage_log_header_t header;
+    storage_log_decode_header(record, &header);
+    if (!storage_log_update(log, (const char *)record + STORAGE_LOG_HEADER_SIZE,
+                            header.key_len, (off_t)offset, header.data_len)) {
+      free(data);
+      return -ENOMEM;
+    }
+    offset += record_size;
+  }
+  free(data);
+
+  log->stats.dropped_bytes = (uint32_t)skipped;
+  if (offset < file_size) {
+    // the record was torn by a power loss during the write
+    OC_WRN("storage log %s: dropping %zu bytes of invalid records", log->path,
+           file_size - offset);
+    log->stats.dropped_bytes += (uint32_t)(file_size - offset);
+    if (ftruncate(log->fd, (off_t)offset) != 0 || fsync(log->fd) != 0) {
+      return -errno;
+    }
+  }
+  log->end = (off_t)offset;
+  log->stats.file_size = (uint64_t)offset;
+  return 0;
+}
+
+static void
+storage_log_free(oc_storage_log_t *log)
+{
+  storage_log_entry_t *entry =
+    (storage_log_entry_t *)oc_list_pop(log->entries);
+  while (entry != NULL) {
+    free(entry);
+    entry = (storage_log_entry_t *)oc_list_pop(log->entries);
+  }
+  oc_hash_index_deinit(&log->index);
+  if (log->fd >= 0) {
+    close(log->fd);
+  }
+  pthread_cond_destroy(&log->compact_cv);
+  pthread_mutex_destroy(&log->compact_mutex);
+  pthread_mutex_destroy(&log->mutex);
+  free(log);
+}
+
+oc_storage_log_t *
+oc_storage_log_open(const char *path)
+{
+  size_t path_len = strlen(path);
+  oc_storage_log_t *log = (oc_storage_log_t *)calloc(
+    1, sizeof(oc_storage_log_t) + 2 * (path_len + 1) +
+         sizeof(STORAGE_LOG_COMPACT_SUFFIX));
+  if (log == NULL) {
+    OC_ERR("storage log %s: cannot allocate log", path);
+    return NULL;
+  }
+  memcpy(log->path, path, path_len + 1);
+  log->compact_path = log->path + path_len + 1;
+  memcpy(log->compact_path, path, path_len);
+  memcpy(log->compact_path + path_len, STORAGE_LOG_COMPACT_SUFFIX,
+         sizeof(STORAGE_LOG_COMPACT_SUFFIX));
+  OC_LIST_STRUCT_INIT(log, entries);
+  pthread_mutex_init(&log->mutex, NULL);
+  pthread_mutex_init(&log->compact_mutex, NULL);
+  pthread_cond_init(&log->compact_cv, NULL);
+
+  // the log of an interrupted compaction is incomplete
+  unlink(log->compact_path);
+  log->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (log->fd < 0) {
+    OC_ERR("storage log %s: cannot open: %d", path, errno);
+    storage_log_free(log);
+    return NULL;
+  }
+  int ret = storage_log_load(log);
+  if (ret != 0) {
+    OC_ERR("storage log %s: cannot load: %d", path, ret);
+    storage_log_free(log);
+    return NULL;
+  }
+  return log;
+}
+
+void
+oc_storage_log_close(oc_storage_log_t *log)
+{
+  pthread_mutex_lock(&log->mutex);
+  log->terminate = true;
+  pthread_cond_signal(&log->compact_cv);
+  bool running = log->compact_thread_running;
+  pthread_mutex_unlock(&log->mutex);
+  if (running) {
+    pthread_join(log->compact_thread, NULL);
+  }
+  storage_log_free(log);
+}
+
+long
+oc_storage_log_size(oc_storage_log_t *log, const char *store)
+{
+  pthread_mutex_lock(&log->mutex);
+  const storage_log_entry_t *entry =
+    storage_log_find(log, store, strlen(store));
+  long ret = entry != NULL ? (long)entry->size : -ENOENT;
+  pthread_mutex_unlock(&log->mutex);
+  return ret;
+}
+
+long
+oc_storage_log_read(oc_storage_log_t *log, const char *store, uint8_t *buf,
+                    size_t size)
+{
+  pthread_mutex_lock(&log->mutex);
+  const storage_log_entry_t *entry =
+    storage_log_find(log, store, strlen(store));
+  long ret = -ENOENT;
+  if (entry != NULL) {
+    if (entry->size > size) {
+      OC_ERR("storage log %s: store %s is bigger (%u) than the provided buffer "
+             "size(%u)",
+             log->path, store, (unsigned)entry->size, (unsigned)size);
+      ret = -EINVAL;
+    } else {
+      ret = storage_log_pread(
+        log->fd, buf, entry->size,
+        entry->offset + STORAGE_LOG_HEADER_SIZE + entry->key_len);
+      if (ret == 0) {
+        ret = (long)entry->size;
+      }
+    }
+  }
+  pthread_mutex_unlock(&log->mutex);
+  return ret;
+}
+
+static bool
+storage_log_needs_compaction(const oc_storage_log_t *log)
+{
+  uint64_t size = (uint64_t)log->end;
+  return size >= OC_STORAGE_LOG_COMPACT_MIN_SIZE &&
+         size - log->stats.live_bytes > log->stats.live_bytes;
+}
+
+static void *
+storage_log_compact_thread(void *data)
+{
+  oc_storage_log_t *log = (oc_storage_log_t *)data;
+  pthread_mutex_lock(&log->mutex);
+  while (!log->terminate) {
+    if (!log->compact_requested) {
+      pthread_cond_wait(&log->compact_cv, &log->mutex);
+      continue;
+    }
+    log->compact_requested = false;
+    pthread_mutex_unlock(&log->mutex);
+    int ret = oc_storage_log_compact(log);
+    if (ret != 0) {
+      OC_ERR("storage log %s: compaction failed: %d", log->path, ret);
+    }
+    pthread_mutex_lock(&log->mutex);
+  }
+  pthread_mutex_unlock(&log->mutex);
+  return NULL;
+}
+
+static void
+storage_log_request_compaction_locked(oc_storage_log_t *log)
+{
+  if (!log->compact_thread_running) {
+    int err = pthread_create(&log->compact_thread, NULL,
+                             storage_log_compact_thread, log);
+    if (err != 0) {
+      OC_ERR("storage log %s: cannot create compaction thread: %d", log->path,
+             err);
+      return;
+    }
+    log->compact_thread_running = true;
+  }
+  log->compact_requested = true;
+  pthread_cond_signal(&log->compact_cv);
+}
+
+long
+oc_storage_log_write(oc_storage_log_t *log, const char *store,
+                     const uint8_t *buf, size_t size)
+{
+  size_t key_len = strlen(store);
+  if (key_len == 0 || key_len > STORAGE_LOG_KEY_MAX || size > UINT32_MAX ||
+      (size > 0 && buf == NULL)) {
+    return -EINVAL;
+  }
+  size_t record_size =
+    storage_log_record_size((uint16_t)key_len, (uint32_t)size);
+  uint8_t *record = (uint8_t *)malloc(record_size);
+  if (record == NULL) {
+    return -ENOMEM;
+  }
+  storage_log_encode_record(record, store, (uint16_t)key_len, buf,
+                            (uint32_t)size);
+
+  pthread_mutex_lock(&log->mutex);
+  off_t offset = log->end;
+  int ret = storage_log_pwrite(log->fd, record, record_size, offset);
+  if (ret == 0 && fdatasync(log->fd) != 0) {
+    ret = -errno;
+  }
+  free(record);
+  if (ret != 0) {
+    OC_ERR("storage log %s: cannot write store %s: %d", log->path, store, ret);
+    // drop the partially written record
+    if (ftruncate(log->fd, offset) != 0) {
+      OC_ERR("storage log %s: cannot truncate: %d", log->path, errno);
+    }
+    pthread_mutex_unlock(&log->mutex);
+    return ret;
+  }
+  log->end = offset + (off_t)record_size;
+  log->stats.file_size = (uint64_t)log->end;
+  log->stats.appended_bytes += record_size;
+  log->stats.data_bytes += size;
+  if (!storage_log_update(log, store, (uint16_t)key_len, offset,
+                          (uint32_t)size)) {
+    pthread_mutex_unlock(&log->mutex);
+    return -ENOMEM;
+  }
+  if (storage_log_needs_compaction(log)) {
+    storage_log_request_compaction_locked(log);
+  }
+  pthread_mutex_unlock(&log->mutex);
+  return (long)size;
+}
+
+/* Copy a record from the log to the compacted log, the buffer is reallocated
+ * if it is too small */
+static int
+storage_log_copy_record(int fd, off_t offset, size_t record_size, int to,
+                        off_t *to_offset, uint8_t **buf, size_t *buf_size)
+{
+  if (record_size > *buf_size) {
+    uint8_t *new_buf = (uint8_t *)realloc(*buf, record_size);
+    if (new_buf == NULL) {
+      return -ENOMEM;
+    }
+    *buf = new_buf;
+    *buf_size = record_size;
+  }
+  int ret = storage_log_pread(fd, *buf, record_size, offset);
+  if (ret != 0) {
+    return ret;
+  }
+  ret = storage_log_pwrite(to, *buf, record_size, *to_offset);
+  if (ret != 0) {
+    return ret;
+  }
+  *to_offset += (off_t)record_size;
+  return 0;
+}
+
+typedef struct
+{
+  storage_log_entry_t *entry;
+  off_t offset;         ///< offset of the record in the log
+  off_t compact_offset; ///< offset of the record in the compacted log
+  size_t record_size;
+} storage_log_snapshot_t;
+
+/* Copy the records appended after the snapshot, called with the log locked */
+static int
+storage_log_copy_tail_locked(oc_storage_log_t *log, off_t offset, int to,
+                             off_t *to_offset, uint8_t **buf, size_t *buf_size)
+{
+  while (offset < log->end) {
+    uint8_t header_buf[STORAGE_LOG_HEADER_SIZE];
+    int ret =
+      storage_log_pread(log->fd, header_buf, sizeof(header_buf), offset);
+    if (ret != 0) {
+      return ret;
+    }
+    storage_log_header_t header;
+    if (!storage_log_decode_header(header_buf, &header)) {
+      return -EIO;
+    }
+    size_t record_size =
+      storage_log_record_size(header.key_len, header.data_len);
+    char key[STORAGE_LOG_KEY_MAX + 1];
+    ret = storage_log_pread(log->fd, (uint8_t *)key, header.key_len,
+                            offset + STORAGE_LOG_HEADER_SIZE);
+    if (ret != 0) {
+      return ret;
+    }
+    key[header.key_len] = '\0';
+    storage_log_entry_t *entry = storage_log_find(log, key, header.key_len);
+    // only the latest record of a store is copied
+    if (entry != NULL && entry->offset == offset) {
+      entry->compact_offset = *to_offset;
+      ret = storage_log_copy_record(log->fd, offset, record_size, to,
+                                    to_offset, buf, buf_size);
+      if (ret != 0) {
+        return ret;
+      }
+    }
+    offset += (off_t)record_size;
+  }
+  return 0;
+}
+
+static void
+storage_log_finish_compaction_locked(oc_storage_log_t *log, bool success)
+{
+  for (storage_log_entry_t *entry =
+         (storage_log_entry_t *)oc_list_head(log->entries);
+       entry != NULL; entry = entry->next) {
+    if (success) {
+      assert(entry->compact_offset >= 0);
+      entry->offset = entry->compact_offset;
+    }
+    entry->compact_offset = -1;
+  }
+}
+
+/* Copy the latest records to a new log without blocking the writes, only the
+ * records appended during the copy and the switch to the new log are done with
+ * the log locked */
+static int
+storage_log_compact(oc_storage_log_t *log)
+{
+  pthread_mutex_lock(&log->mutex);
+  size_t count = oc_list_length(log->entries);
+  storage_log_snapshot_t *snapshot = NULL;
+  if (count > 0) {
+    snapshot = (storage_log_snapshot_t *)malloc(count * sizeof(*snapshot));
+    if (snapshot == NULL) {
+      pthread_mutex_unlock(&log->mutex);
+      return -ENOMEM;
+    }
+  }
+  size_t i = 0;
+  for (storage_log_entry_t *entry =
+         (storage_log_entry_t *)oc_list_head(log->entries);
+       entry != NULL; entry = entry->next) {
+    snapshot[i].entry = entry;
+    snapshot[i].offset = entry->offset;
+    snapshot[i].record_size = storage_log_entry_record_size(entry);
+    ++i;
+  }
+  off_t end = log->end;
+  // only compactions replace the file descriptor
+  int fd = log->fd;
+  pthread_mutex_unlock(&log->mutex);
+
+  int to = open(log->compact_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0600);
+  if (to < 0) {
+    free(snapshot);
+    return -errno;
+  }
+  off_t to_offset = 0;
+  uint8_t *buf = NULL;
+  size_t buf_size = 0;
+  int ret = 0;
+  for (i = 0; i < count && ret == 0; ++i) {
+    snapshot[i].compact_offset = to_offset;
+    ret = storage_log_copy_record(fd, snapshot[i].offset,
+                                  snapshot[i].record_size, to, &to_offset, &buf,
+                                  &buf_size);
+  }
+
+  pthread_mutex_lock(&log->mutex);
+  if (ret == 0) {
+    ret =
+      storage_log_copy_tail_locked(log, end, to, &to_offset, &buf, &buf_size);
+  }
+  for (i = 0; i < count && ret == 0; ++i) {
+    storage_log_entry_t *entry = snapshot[i].entry;
+    // the stores written during the copy were copied with the tail
+    if (entry->offset == snapshot[i].offset) {
+      entry->compact_offset = snapshot[i].compact_offset;
+    }
+  }
+  if (ret == 0 && fdatasync(to) != 0) {
+    ret = -errno;
+  }
+  if (ret == 0 && rename(log->compact_path, log->path) != 0) {
+    ret = -errno;
+  }
+  if (ret == 0) {
+    ret = oc_storage_sync_dir(log->path);
+  }
+  if (ret != 0) {
+    storage_log_finish_compaction_locked(log, false);
+    pthread_mutex_unlock(&log->mutex);
+    close(to);
+    unlink(log->compact_path);
+    free(buf);
+    free(snapshot);
+    return ret;
+  }
+  storage_log_finish_compaction_locked(log, true);
+  close(log->fd);
+  log->fd = to;
+  log->end = to_offset;
+  log->stats.file_size = (uint64_t)to_offset;
+  log->stats.compacted_bytes += (uint64_t)to_offset;
+  ++log->stats.compactions;
+  pthread_mutex_unlock(&log->mutex);
+  free(buf);
+  free(snapshot);
+  return 0;
+}
+
+int
+oc_storage_log_compact(oc_storage_log_t *log)
+{
+  pthread_mutex_lock(&log->compact_mutex);
+  int ret = storage_log_compact(log);
+  pthread_mutex_unlock(&log->compact_mutex);
+  return ret;
+}
+
+oc_storage_log_stats_t
+oc_storage_log_get_stats(oc_storage_log_t *log)
+{
+  pthread_mutex_lock(&log->mutex);
+  oc_storage_log_stats_t stats = log->stats;
+  pthread_mutex_unlock(&log->mutex);
+  return stats;
+}
+
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
@@ -0,0 +1,142 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef STORAGE_LOG_H
+#define STORAGE_LOG_H
+
+#include "util/oc_compiler.h"
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Name of the log file in the storage directory */
+#define OC_STORAGE_LOG_FILE_NAME "storage.log"
+
+#ifndef OC_STORAGE_LOG_COMPACT_MIN_SIZE
+/** Minimal size of the log file before it is compacted in the background */
+#define OC_STORAGE_LOG_COMPACT_MIN_SIZE (64 * 1024)
+#endif /* !OC_STORAGE_LOG_COMPACT_MIN_SIZE */
+
+/**
+ * @brief Append-only log of records holding the data of the stores.
+ *
+ * Each write appends a checksummed record with the name and the data of a
+ * store, an in-memory index keeps the position of the latest record of each
+ * store. When the outdated records take more space than the latest ones the
+ * log is compacted by a background thread. A torn or corrupted record at the
+ * end of the log, left by a power loss during a write, is dropped when the log
+ * is opened. A corrupted record followed by valid records is skipped and
+ * removed by the next compaction.
+ */
+typedef struct oc_storage_log_t oc_storage_log_t;
+
+/** @brief Statistics of a log */
+typedef struct oc_storage_log_stats_t
+{
+  uint64_t data_bytes;      ///< bytes of data passed to writes
+  uint64_t appended_bytes;  ///< bytes appended by writes
+  uint64_t compacted_bytes; ///< bytes written by compactions
+  uint64_t file_size;       ///< current size of the log file
+  uint64_t live_bytes;      ///< size of the latest records of the stores
+  uint32_t stores;          ///< number of stores
+  uint32_t compactions;     ///< number of finished compactions
+  uint32_t dropped_bytes;   ///< bytes of invalid records skipped on open
+} oc_storage_log_stats_t;
+
+/**
+ * @brief Open the log file, create it if it does not exist.
+ *
+ * @param path path of the log file (cannot be NULL)
+ * @return the log on success
+ * @return NULL on failure
+ */
+oc_storage_log_t *oc_storage_log_open(const char *path) OC_NONNULL();
+
+/**
+ * @brief Wait for a running compaction and close the log.
+ *
+ * @param log the log (cannot be NULL)
+ */
+void oc_storage_log_close(oc_storage_log_t *log) OC_NONNULL();
+
+/**
+ * @brief Read the data of a store.
+ *
+ * @param log the log (cannot be NULL)
+ * @param store name of the store (cannot be NULL)
+ * @param buf buffer for the data (cannot be NULL)
+ * @param size size of the buffer
+ * @return >= 0 size of the data
+ * @return -ENOENT the store was not written
+ * @return -EINVAL the buffer is too small
+ * @return <0 other read error
+ */
+long oc_storage_log_read(oc_storage_log_t *log, const char *store,
+                         uint8_t *buf, size_t size) OC_NONNULL();
+
+/**
+ * @brief Get the size of the data of a store.
+ *
+ * @param log the log (cannot be NULL)
+ * @param store name of the store (cannot be NULL)
+ * @return >= 0 size of the data
+ * @return -ENOENT the store was not written
+ */
+long oc_storage_log_size(oc_storage_log_t *log, const char *store)
+  OC_NONNULL();
+
+/**
+ * @brief Append the data of a store to the log and sync the log.
+ *
+ * @param log the log (cannot be NULL)
+ * @param store name of the store (cannot be NULL)
+ * @param buf the data
+ * @param size size of the data
+ * @return >= 0 size of the written data
+ * @return <0 on failure
+ */
+long oc_storage_log_write(oc_storage_log_t *log, const char *store,
+                          const uint8_t *buf, size_t size) OC_NONNULL(1, 2);
+
+/**
+ * @brief Rewrite the log with only the latest records of the stores.
+ *
+ * @param log the log (cannot be NULL)
+ * @return 0 on success
+ * @return <0 on failure
+ */
+int oc_storage_log_compact(oc_storage_log_t *log) OC_NONNULL();
+
+/** @brief Get the statistics of a log */
+oc_storage_log_stats_t oc_storage_log_get_stats(oc_storage_log_t *log)
+  OC_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
+
+#endif /* STORAGE_LOG_H */
@@ -30,6 +30,10 @@
 
 #ifdef OC_TCP
 
+#ifdef OC_HAS_FEATURE_EPOLL
+#include "netpoll.h"
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 #define OC_TCP_LISTEN_BACKLOG 3
 
 static int
@@ -196,10 +200,18 @@ tcp_connectivity_init(ip_context_t *dev, oc_connectivity_ports_t ports)
   }
 #endif /* OC_IPV4 */
 
+#ifdef OC_HAS_FEATURE_EPOLL
+  dev->tcp.cfds_epoll_fd = oc_netpoll_create();
+  if (dev->tcp.cfds_epoll_fd < 0) {
+    OC_ERR("Could not initialize TCP connection epoll");
+    return false;
+  }
+#else  /* !OC_HAS_FEATURE_EPOLL */
   if (pthread_mutex_init(&dev->tcp.cfds_mutex, NULL) != 0) {
     oc_abort("error initializing TCP connection mutex");
   }
   FD_ZERO(&dev->tcp.cfds);
+#endif /* OC_HAS_FEATURE_EPOLL */
 
   if (pipe(dev->tcp.connect_pipe) < 0) {
     OC_ERR("Could not initialize connection pipe");
@@ -250,25 +262,43 @@ tcp_connectivity_shutdown(ip_context_t *dev)
 
   tcp_session_shutdown(dev);
 
+#ifdef OC_HAS_FEATURE_EPOLL
+  close(dev->tcp.cfds_epoll_fd);
+#else  /* !OC_HAS_FEATURE_EPOLL */
   pthread_mutex_destroy(&dev->tcp.cfds_mutex);
+#endif /* OC_HAS_FEATURE_EPOLL */
   OC_DBG("tcp_connectivity_shutdown for device %zd", dev->device);
 }
 
+static void
+tcp_add_listener_to_rfd_set(ip_context_t *dev,
+                            const oc_sock_listener_t *listener)
+{
+  if (listener->sock >= 0) {
+    ip_context_rfds_fd_set(dev, listener->sock);
+  }
+}
+
 void
 tcp_add_socks_to_rfd_set(ip_context_t *dev)
 {
-  oc_sock_listener_fd_set(&dev->tcp.server, &dev->rfds);
+  tcp_add_listener_to_rfd_set(dev, &dev->tcp.server);
 #ifdef OC_SECURITY
-  oc_sock_listener_fd_set(&dev->tcp.secure, &dev->rfds);
+  tcp_add_listener_to_rfd_set(dev, &dev->tcp.secure);
 #endif /* OC_SECURITY */
 
 #ifdef OC_IPV4
-  oc_sock_listener_fd_set(&dev->tcp.server4, &dev->rfds);
+  tcp_add_listener_to_rfd_set(dev, &dev->tcp.server4);
 #ifdef OC_SECURITY
-  oc_sock_listener_fd_set(&dev->tcp.secure4, &dev->rfds);
+  tcp_add_listener_to_rfd_set(dev, &dev->tcp.secure4);
 #endif /* OC_SECURITY */
 #endif /* OC_IPV4 */
-  FD_SET(dev->tcp.connect_pipe[0], &dev->rfds);
+  ip_context_rfds_fd_set(dev, dev->tcp.connect_pipe[0]);
+#ifdef OC_HAS_FEATURE_EPOLL
+  // sockets waiting for connection are monitored by a nested epoll instance,
+  // which becomes readable when any of them is ready for writing
+  ip_context_rfds_fd_set(dev, dev->tcp.cfds_epoll_fd);
+#endif /* OC_HAS_FEATURE_EPOLL */
 }
 
 static adapter_receive_state_t
@@ -47,7 +47,8 @@ bool tcp_connectivity_init(ip_context_t *dev, oc_connectivity_ports_t ports);
 void tcp_connectivity_shutdown(ip_context_t *dev);
 
 /**
- * @brief Add all TCP sockets and signal pipe to read fd set.
+ * @brief Add all TCP sockets and signal pipe to read fd set (or to the epoll
+ * instance with OC_HAS_FEATURE_EPOLL).
  *
  * @param dev the device network context (cannot be NULL)
  */
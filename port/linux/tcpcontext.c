@@ -23,6 +23,24 @@
 
 #ifdef OC_TCP
 
+#ifdef OC_HAS_FEATURE_EPOLL
+
+#include "netpoll.h"
+
+void
+tcp_context_cfds_fd_set(tcp_context_t *dev, int sockfd)
+{
+  oc_netpoll_add(dev->cfds_epoll_fd, sockfd, EPOLLOUT);
+}
+
+void
+tcp_context_cfds_fd_clr(tcp_context_t *dev, int sockfd)
+{
+  oc_netpoll_remove(dev->cfds_epoll_fd, sockfd);
+}
+
+#else /* !OC_HAS_FEATURE_EPOLL */
+
 void
 tcp_context_cfds_fd_set(tcp_context_t *dev, int sockfd)
 {
@@ -50,4 +68,6 @@ tcp_context_cfds_fd_copy(tcp_context_t *dev)
   return setfds;
 }
 
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 #endif /* OC_TCP */
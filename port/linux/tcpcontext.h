@@ -20,6 +20,7 @@
 #define TCPCONTEXT_H
 
 #include "socklistener.h"
+#include "util/oc_features.h"
 
 #include <pthread.h>
 #include <sys/select.h>
@@ -45,14 +46,21 @@ typedef struct tcp_context_t
 #endif /* OC_SECURITY */
 #endif /* OC_IPV4 */
   int connect_pipe[2];
+#ifdef OC_HAS_FEATURE_EPOLL
+  int cfds_epoll_fd; ///< epoll of tcp sockets waiting for connection
+#else  /* !OC_HAS_FEATURE_EPOLL */
   pthread_mutex_t cfds_mutex;
   fd_set cfds; ///< set of tcp sockets waiting for connection
+#endif /* OC_HAS_FEATURE_EPOLL */
 } tcp_context_t;
 
 /**
  * Set a given file descriptor to a set of descriptors waiting for connect
  * (dev->cfds) under the mutex(cfds_mutex).
  *
+ * With OC_HAS_FEATURE_EPOLL the file descriptor is added to the epoll instance
+ * (dev->cfds_epoll_fd) instead.
+ *
  * @param[in] dev the device tcp context.
  * @param[in] sockfd the file descriptor.
  */
@@ -62,11 +70,16 @@ void tcp_context_cfds_fd_set(tcp_context_t *dev, int sockfd);
  * Remove a given file descriptor from a set (dev->cfds) under the
  * mutex(cfds_mutex).
  *
+ * With OC_HAS_FEATURE_EPOLL the file descriptor is removed from the epoll
+ * instance (dev->cfds_epoll_fd) instead.
+ *
  * @param[in] dev the device tcp context.
  * @param[in] sockfd the file descriptor.
  */
 void tcp_context_cfds_fd_clr(tcp_context_t *dev, int sockfd);
 
+#ifndef OC_HAS_FEATURE_EPOLL
+
 /**
  * Make a copy of file descriptor set (dev->cfds) under the mutex(cfds_mutex).
  *
@@ -76,6 +89,8 @@ void tcp_context_cfds_fd_clr(tcp_context_t *dev, int sockfd);
  */
 fd_set tcp_context_cfds_fd_copy(tcp_context_t *dev);
 
+#endif /* !OC_HAS_FEATURE_EPOLL */
+
 #ifdef __cplusplus
 }
 #endif
@@ -68,6 +68,18 @@ OC_LIST(
   g_free_session_list_async); ///< sessions to be closed; guarded by g_mutex
 OC_MEMB(g_tcp_session_s, tcp_session_t, OC_MAX_TCP_PEERS);
 
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+/* Table of sessions indexed by socket, used to find the session of a ready
+ * socket returned by epoll in O(1) */
+typedef struct
+{
+  void **items;
+  size_t size;
+} tcp_sock_index_t;
+
+static tcp_sock_index_t g_session_by_sock; ///< guarded by g_mutex
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
+
 #ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
 
 typedef struct queued_message_t
@@ -103,6 +115,10 @@ OC_LIST(g_free_waiting_session_list_async); ///< waiting sessions to be closed,
                                             /// guarded by g_mutex
 OC_MEMB(g_tcp_waiting_session_s, tcp_waiting_session_t,
         OC_MAX_TCP_PEERS); ///< guarded by g_mutex
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+/* Sessions with an ongoing connect indexed by socket; guarded by g_mutex */
+static tcp_sock_index_t g_waiting_session_by_sock;
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
 
 static oc_tcp_connect_retry_t g_connect_retry = {
   .max_count = OC_TCP_CONNECT_RETRY_MAX_COUNT,
@@ -199,6 +215,80 @@ get_interface_index(int sock)
   return 0;
 }
 
+#ifdef OC_HAS_FEATURE_EPOLL
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+static bool
+sock_index_add_locked(tcp_sock_index_t *sock_index, int sock, void *item)
+{
+  assert(sock >= 0);
+  size_t index = (size_t)sock;
+  if (index >= sock_index->size) {
+    size_t size = sock_index->size > 0 ? sock_index->size : 64;
+    while (size <= index) {
+      size *= 2;
+    }
+    void **table = (void **)realloc(sock_index->items, size * sizeof(void *));
+    if (table == NULL) {
+      OC_ERR("could not allocate TCP session table");
+      return false;
+    }
+    memset(table + sock_index->size, 0,
+           (size - sock_index->size) * sizeof(void *));
+    sock_index->items = table;
+    sock_index->size = size;
+  }
+  sock_index->items[index] = item;
+  return true;
+}
+
+static void
+sock_index_remove_locked(tcp_sock_index_t *sock_index, int sock,
+                         const void *item)
+{
+  if (sock >= 0 && (size_t)sock < sock_index->size &&
+      sock_index->items[sock] == item) {
+    sock_index->items[sock] = NULL;
+  }
+}
+
+static void *
+sock_index_find_locked(const tcp_sock_index_t *sock_index, int sock)
+{
+  if (sock < 0 || (size_t)sock >= sock_index->size) {
+    return NULL;
+  }
+  return sock_index->items[sock];
+}
+
+static void
+sock_index_free_locked(tcp_sock_index_t *sock_index)
+{
+  free(sock_index->items);
+  sock_index->items = NULL;
+  sock_index->size = 0;
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static tcp_session_t *
+find_session_by_sock_locked(int sock)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  return (tcp_session_t *)sock_index_find_locked(&g_session_by_sock, sock);
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  // the number of sessions is limited by OC_MAX_TCP_PEERS
+  tcp_session_t *session = oc_list_head(g_session_list);
+  while (session != NULL && session->sock != sock) {
+    session = session->next;
+  }
+  return session;
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 #if OC_DBG_IS_ENABLED
 static void
 log_new_session(oc_endpoint_t *endpoint, int sock, bool is_connected)
@@ -238,6 +328,12 @@ add_new_session_locked(int sock, ip_context_t *dev, oc_endpoint_t *endpoint,
   session->sock = sock;
   session->csm_state = state;
 
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+  if (!sock_index_add_locked(&g_session_by_sock, sock, session)) {
+    oc_memb_free(&g_tcp_session_s, session);
+    return NULL;
+  }
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
   oc_list_add(g_session_list, session);
 
   if ((session->endpoint.flags & SECURED) == 0) {
@@ -250,8 +346,7 @@ add_new_session_locked(int sock, ip_context_t *dev, oc_endpoint_t *endpoint,
 }
 
 static int
-accept_new_session_locked(ip_context_t *dev, int fd, fd_set *setfds,
-                          oc_endpoint_t *endpoint)
+accept_new_session_locked(ip_context_t *dev, int fd, oc_endpoint_t *endpoint)
 {
   struct sockaddr_storage receive_from;
   memset(&receive_from, 0, sizeof(receive_from));
@@ -263,7 +358,6 @@ accept_new_session_locked(ip_context_t *dev, int fd, fd_set *setfds,
     return -1;
   }
   OC_DBG("accepted incoming TCP connection (fd=%d)", new_socket);
-  FD_CLR(fd, setfds);
 
   if ((endpoint->flags & IPV6) != 0) {
     const struct sockaddr_in6 *r = (struct sockaddr_in6 *)&receive_from;
@@ -296,6 +390,9 @@ free_session_locked(tcp_session_t *session, bool signal)
 {
   oc_list_remove(g_session_list, session);
   oc_list_remove(g_free_session_list_async, session);
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+  sock_index_remove_locked(&g_session_by_sock, session->sock, session);
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
 
   if (!oc_session_events_disconnect_is_ongoing()) {
     oc_session_end_event(&session->endpoint);
@@ -326,60 +423,62 @@ free_session_for_device_locked(size_t device)
 }
 
 static adapter_receive_state_t
-tcp_receive_server_message_locked(ip_context_t *dev, fd_set *fds,
-                                  oc_message_t *message)
+tcp_accept_on_socket_locked(ip_context_t *dev, int sock, oc_message_t *message)
 {
-  if (oc_sock_listener_fd_isset(&dev->tcp.server, fds)) {
-    OC_DBG("tcp receive server_sock(fd=%d)", dev->tcp.server.sock);
-    FD_CLR(dev->tcp.server.sock, fds);
-    message->endpoint.flags = IPV6 | TCP | ACCEPTED;
-    if (accept_new_session_locked(dev, dev->tcp.server.sock, fds,
-                                  &message->endpoint) < 0) {
-      OC_ERR("accept new session fail");
-      return ADAPTER_STATUS_ERROR;
-    }
-    return ADAPTER_STATUS_ACCEPT;
+  transport_flags flags;
+  if (sock == dev->tcp.server.sock) {
+    flags = IPV6 | TCP | ACCEPTED;
   }
 #ifdef OC_SECURITY
-  if (oc_sock_listener_fd_isset(&dev->tcp.secure, fds)) {
-    OC_DBG("tcp receive secure_sock(fd=%d)", dev->tcp.secure.sock);
-    FD_CLR(dev->tcp.secure.sock, fds);
-    message->endpoint.flags = IPV6 | SECURED | TCP | ACCEPTED;
-    if (accept_new_session_locked(dev, dev->tcp.secure.sock, fds,
-                                  &message->endpoint) < 0) {
-      OC_ERR("accept new session fail");
-      return ADAPTER_STATUS_ERROR;
-    }
-    return ADAPTER_STATUS_ACCEPT;
+  else if (sock == dev->tcp.secure.sock) {
+    flags = IPV6 | SECURED | TCP | ACCEPTED;
   }
 #endif /* OC_SECURITY */
 #ifdef OC_IPV4
-  if (oc_sock_listener_fd_isset(&dev->tcp.server4, fds)) {
-    OC_DBG("tcp receive server4_sock(fd=%d)", dev->tcp.server4.sock);
-    FD_CLR(dev->tcp.server4.sock, fds);
-    message->endpoint.flags = IPV4 | TCP | ACCEPTED;
-    if (accept_new_session_locked(dev, dev->tcp.server4.sock, fds,
-                                  &message->endpoint) < 0) {
-      OC_ERR("accept new session fail");
-      return ADAPTER_STATUS_ERROR;
-    }
-    return ADAPTER_STATUS_ACCEPT;
+  else if (sock == dev->tcp.server4.sock) {
+    flags = IPV4 | TCP | ACCEPTED;
   }
 #ifdef OC_SECURITY
-  if (oc_sock_listener_fd_isset(&dev->tcp.secure4, fds)) {
-    OC_DBG("tcp receive secure4_sock(fd=%d)", dev->tcp.secure4.sock);
-    FD_CLR(dev->tcp.secure4.sock, fds);
-    message->endpoint.flags = IPV4 | SECURED | TCP | ACCEPTED;
-    if (accept_new_session_locked(dev, dev->tcp.secure4.sock, fds,
-                                  &message->endpoint) < 0) {
-      OC_ERR("accept new session fail");
-      return ADAPTER_STATUS_ERROR;
-    }
-    return ADAPTER_STATUS_ACCEPT;
+  else if (sock == dev->tcp.secure4.sock) {
+    flags = IPV4 | SECURED | TCP | ACCEPTED;
   }
 #endif /* OC_SECURITY */
 #endif /* OC_IPV4 */
-  return ADAPTER_STATUS_NONE;
+  else {
+    return ADAPTER_STATUS_NONE;
+  }
+
+  OC_DBG("tcp receive listener sock(fd=%d)", sock);
+  message->endpoint.flags = flags;
+  if (accept_new_session_locked(dev, sock, &message->endpoint) < 0) {
+    OC_ERR("accept new session fail");
+    return ADAPTER_STATUS_ERROR;
+  }
+  return ADAPTER_STATUS_ACCEPT;
+}
+
+static int
+tcp_get_ready_listener(const ip_context_t *dev, fd_set *fds)
+{
+  const oc_sock_listener_t *listeners[] = {
+    &dev->tcp.server,
+#ifdef OC_SECURITY
+    &dev->tcp.secure,
+#endif /* OC_SECURITY */
+#ifdef OC_IPV4
+    &dev->tcp.server4,
+#ifdef OC_SECURITY
+    &dev->tcp.secure4,
+#endif /* OC_SECURITY */
+#endif /* OC_IPV4 */
+  };
+  for (size_t i = 0; i < OC_ARRAY_SIZE(listeners); ++i) {
+    if (oc_sock_listener_fd_isset(listeners[i], fds)) {
+      FD_CLR(listeners[i]->sock, fds);
+      return listeners[i]->sock;
+    }
+  }
+  return -1;
 }
 
 static tcp_session_t *
@@ -467,9 +566,10 @@ tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
   pthread_mutex_lock(&g_mutex);
   message->endpoint.device = dev->device;
 
-  adapter_receive_state_t ret =
-    tcp_receive_server_message_locked(dev, fds, message);
-  if (ret != ADAPTER_STATUS_NONE) {
+  adapter_receive_state_t ret;
+  int listener = tcp_get_ready_listener(dev, fds);
+  if (listener >= 0) {
+    ret = tcp_accept_on_socket_locked(dev, listener, message);
     goto tcp_receive_message_done;
   }
 
@@ -493,6 +593,35 @@ tcp_receive_message_done:
   return ret;
 }
 
+#ifdef OC_HAS_FEATURE_EPOLL
+
+adapter_receive_state_t
+tcp_receive_message_from_socket(ip_context_t *dev, int sock,
+                                oc_message_t *message)
+{
+  pthread_mutex_lock(&g_mutex);
+  message->endpoint.device = dev->device;
+
+  adapter_receive_state_t ret = tcp_accept_on_socket_locked(dev, sock, message);
+  if (ret != ADAPTER_STATUS_NONE) {
+    pthread_mutex_unlock(&g_mutex);
+    return ret;
+  }
+
+  tcp_session_t *session = find_session_by_sock_locked(sock);
+  if (session == NULL) {
+    OC_DBG("could not find TCP session for socket(fd=%d)", sock);
+    pthread_mutex_unlock(&g_mutex);
+    return ADAPTER_STATUS_NONE;
+  }
+  OC_DBG("tcp receive session(fd=%d)", session->sock);
+  ret = tcp_session_receive_message_locked(session, message);
+  pthread_mutex_unlock(&g_mutex);
+  return ret;
+}
+
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 #if OC_DBG_IS_ENABLED
 static void
 log_tcp_session(const void *session, const oc_endpoint_t *endpoint,
@@ -591,17 +720,32 @@ add_new_waiting_session_locked(int sock, ip_context_t *dev,
   return ws;
 }
 
-static void
-tcp_waiting_session_set_socked_locked(tcp_context_t *tcp, int sock)
+static bool
+tcp_waiting_session_set_socked_locked(tcp_waiting_session_t *ws)
 {
-  if (sock > 0) {
-    tcp_context_cfds_fd_set(tcp, sock);
+  if (ws->sock > 0) {
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+    if (!sock_index_add_locked(&g_waiting_session_by_sock, ws->sock, ws)) {
+      return false;
+    }
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
+    tcp_context_cfds_fd_set(&ws->dev->tcp, ws->sock);
   }
-  signal_network_thread(tcp);
+  signal_network_thread(&ws->dev->tcp);
   OC_DBG(
     "signaled network event thread to monitor the newly added session(fd=%d) "
     "waiting for connect",
-    sock);
+    ws->sock);
+  return true;
+}
+
+static void
+tcp_waiting_session_clr_socket_locked(tcp_waiting_session_t *ws)
+{
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+  sock_index_remove_locked(&g_waiting_session_by_sock, ws->sock, ws);
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
+  tcp_context_cfds_fd_clr(&ws->dev->tcp, ws->sock);
 }
 
 static tcp_waiting_session_t *
@@ -616,7 +760,12 @@ tcp_create_waiting_session_locked(int sock, ip_context_t *dev,
     OC_ERR("could not record new waiting TCP session");
     return NULL;
   }
-  tcp_waiting_session_set_socked_locked(&dev->tcp, sock);
+  if (!tcp_waiting_session_set_socked_locked(ws)) {
+    // the socket is closed by the caller
+    oc_list_remove(g_waiting_session_list, ws);
+    oc_memb_free(&g_tcp_waiting_session_s, ws);
+    return NULL;
+  }
   return ws;
 }
 
@@ -683,6 +832,9 @@ free_session_async_locked(tcp_session_t *s)
 {
   oc_list_remove(g_session_list, s);
   oc_list_add(g_free_session_list_async, s);
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+  sock_index_remove_locked(&g_session_by_sock, s->sock, s);
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
 
   signal_network_thread(&s->dev->tcp);
   OC_DBG("signaled network event thread to monitor that the session needs to "
@@ -696,6 +848,9 @@ free_waiting_session_async_locked(tcp_waiting_session_t *ws)
 {
   oc_list_remove(g_waiting_session_list, ws);
   oc_list_add(g_free_waiting_session_list_async, ws);
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+  sock_index_remove_locked(&g_waiting_session_by_sock, ws->sock, ws);
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
 
   signal_network_thread(&ws->dev->tcp);
   OC_DBG("signaled network event thread to monitor that the session needs to "
@@ -747,7 +902,7 @@ free_waiting_session_locked(tcp_waiting_session_t *session, bool has_expired,
     signal_network_thread(&session->dev->tcp);
   }
   if (session->sock >= 0) {
-    tcp_context_cfds_fd_clr(&session->dev->tcp, session->sock);
+    tcp_waiting_session_clr_socket_locked(session);
     close(session->sock);
   }
 
@@ -814,6 +969,16 @@ tcp_session_shutdown(const ip_context_t *dev)
   free_waiting_session_for_device_locked(dev->device);
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
   tcp_process_async_sessions_locked();
+#if defined(OC_HAS_FEATURE_EPOLL) && defined(OC_DYNAMIC_ALLOCATION)
+  if (oc_list_length(g_session_list) == 0) {
+    sock_index_free_locked(&g_session_by_sock);
+  }
+#ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
+  if (oc_list_length(g_waiting_session_list) == 0) {
+    sock_index_free_locked(&g_waiting_session_by_sock);
+  }
+#endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
+#endif /* OC_HAS_FEATURE_EPOLL && OC_DYNAMIC_ALLOCATION */
   pthread_mutex_unlock(&g_mutex);
 }
 
@@ -1085,7 +1250,7 @@ tcp_try_connect_waiting_session_locked(tcp_waiting_session_t *ws, int *err)
   if (s == NULL) {
     return false;
   }
-  tcp_context_cfds_fd_clr(&ws->dev->tcp, ws->sock);
+  tcp_waiting_session_clr_socket_locked(ws);
   ws->sock = -1; // socket was taken by the ongoing session
 
   if (!tcp_cleanup_connected_waiting_session_locked(ws, s)) {
@@ -1146,7 +1311,7 @@ tcp_retry_waiting_session_locked(tcp_waiting_session_t *ws,
   OC_DBG("try connect waiting session(%p, fd=%d): %u", (void *)ws, ws->sock,
          (unsigned)ws->retry.count);
   if (ws->sock >= 0) {
-    tcp_context_cfds_fd_clr(&ws->dev->tcp, ws->sock);
+    tcp_waiting_session_clr_socket_locked(ws);
     OC_DBG("close waiting session socket(fd=%d)", ws->sock);
     close(ws->sock);
     ws->sock = -1;
@@ -1173,7 +1338,9 @@ tcp_retry_waiting_session_locked(tcp_waiting_session_t *ws,
     ws->retry.start = now_mt;
     ws->retry.force = 0;
     ws->sock = cs.fd;
-    tcp_waiting_session_set_socked_locked(&ws->dev->tcp, ws->sock);
+    if (!tcp_waiting_session_set_socked_locked(ws)) {
+      return -1;
+    }
     return OC_TCP_SOCKET_STATE_CONNECTING;
   }
   return -1;
@@ -1229,7 +1396,7 @@ tcp_process_waiting_session_locked(tcp_waiting_session_t *ws)
   if (!tcp_try_connect_waiting_session_locked(ws, &error)) {
     OC_DBG("failed to connect session(%p, fd=%d)", (void *)ws, ws->sock);
     if (ws->sock >= 0) {
-      tcp_context_cfds_fd_clr(&ws->dev->tcp, ws->sock);
+      tcp_waiting_session_clr_socket_locked(ws);
       close(ws->sock);
       ws->sock = -1;
     }
@@ -1266,6 +1433,42 @@ tcp_process_waiting_sessions(fd_set *fds)
   return ret;
 }
 
+#ifdef OC_HAS_FEATURE_EPOLL
+
+static tcp_waiting_session_t *
+find_waiting_session_by_sock_locked(int sock)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  return (tcp_waiting_session_t *)sock_index_find_locked(
+    &g_waiting_session_by_sock, sock);
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  // the number of waiting sessions is limited by OC_MAX_TCP_PEERS
+  tcp_waiting_session_t *ws = oc_list_head(g_waiting_session_list);
+  while (ws != NULL && ws->sock != sock) {
+    ws = ws->next;
+  }
+  return ws;
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+bool
+tcp_process_waiting_session_socket(int sock)
+{
+  pthread_mutex_lock(&g_mutex);
+  tcp_waiting_session_t *ws = find_waiting_session_by_sock_locked(sock);
+  if (ws == NULL) {
+    pthread_mutex_unlock(&g_mutex);
+    return false;
+  }
+  OC_DBG("tcp session(%p) connect (fd=%d): %u", (void *)ws, ws->sock,
+         (unsigned)ws->retry.count);
+  tcp_process_waiting_session_locked(ws);
+  pthread_mutex_unlock(&g_mutex);
+  return true;
+}
+
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 static int
 oc_tcp_connect_to_endpoint(ip_context_t *dev, oc_endpoint_t *endpoint,
                            on_tcp_connect_t on_tcp_connect,
@@ -101,6 +101,25 @@ int oc_tcp_send_buffer2(oc_message_t *message, bool queue);
 adapter_receive_state_t tcp_receive_message(ip_context_t *dev, fd_set *fds,
                                             oc_message_t *message);
 
+#ifdef OC_HAS_FEATURE_EPOLL
+/**
+ * @brief Accept a connection on a listening socket or receive data from
+ * a session socket.
+ *
+ * @param dev the device network context (cannot be NULL)
+ * @param sock socket with an available read event
+ * @param message message to store the received data
+ * @return ADAPTER_STATUS_NONE the socket is not a TCP socket of an ongoing
+ * session or a listening socket of the device
+ * @return adapter_receive_state_t otherwise
+ *
+ * @note thread-safe
+ */
+adapter_receive_state_t tcp_receive_message_from_socket(ip_context_t *dev,
+                                                        int sock,
+                                                        oc_message_t *message);
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 /**
  * @brief Schedule the session associated with the endpoint to be stopped and
  * deallocated (if it exists).
@@ -146,6 +165,19 @@ oc_clock_time_t tcp_check_expiring_sessions(oc_clock_time_t now_mt);
  * @return false no session was found
  */
 bool tcp_process_waiting_sessions(fd_set *fds);
+
+#ifdef OC_HAS_FEATURE_EPOLL
+/**
+ * @brief Process the TCP session waiting to be opened with the given socket,
+ * same as tcp_process_waiting_sessions for a single socket with an available
+ * write event.
+ *
+ * @param sock socket with an available write event
+ * @return true session with the socket was found and processed
+ * @return false no session was found
+ */
+bool tcp_process_waiting_session_socket(int sock);
+#endif /* OC_HAS_FEATURE_EPOLL */
 #endif /* OC_HAS_FEATURE_TCP_ASYNC_CONNECT */
 
 #ifdef __cplusplus
@@ -64,6 +64,23 @@ void oc_connectivity_shutdown(size_t device);
  */
 int oc_send_buffer2(oc_message_t *message, bool queue);
 
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+/**
+ * @brief Queue an unicast UDP message to be sent in a batch with other queued
+ * messages.
+ *
+ * The queue is sent by oc_send_buffer_batch_flush or when it becomes full.
+ *
+ * @param message message to be sent (cannot be NULL)
+ * @return true message was queued, a reference to the message was taken
+ * @return false message cannot be batched and must be sent by oc_send_buffer
+ */
+bool oc_send_buffer_batch_add(oc_message_t *message);
+
+/** @brief Send all messages queued by oc_send_buffer_batch_add */
+void oc_send_buffer_batch_flush(void);
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
+
 #ifdef OC_HAS_FEATURE_TCP_ASYNC_CONNECT
 typedef struct
 {
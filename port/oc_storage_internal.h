@@ -20,6 +20,7 @@
 #define OC_PORT_STORAGE_INTERNAL_H
 
 #include "util/oc_compiler.h"
+#include "util/oc_features.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -55,6 +56,33 @@ bool oc_storage_path(char *buffer, size_t buffer_size);
  */
 long oc_storage_size(const char *store) OC_NONNULL();
 
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+
+/**
+ * @brief wait until all pending writes are written to the storage
+ *
+ * Writes are only queued by oc_storage_write and written by a background
+ * thread. Call this function to make sure the stores are durable, e.g. before
+ * a shutdown or after a factory reset.
+ *
+ * @return 0 if all writes since the previous flush succeeded
+ * @return <0 error of the first failed write
+ */
+int oc_storage_flush(void);
+
+/**
+ * @brief write all pending writes and stop the background writer thread
+ *
+ * The storage stays configured, the thread is started again by the next
+ * oc_storage_write.
+ *
+ * @return 0 if all writes since the previous flush succeeded
+ * @return <0 error of the first failed write
+ */
+int oc_storage_shutdown(void);
+
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 #ifdef __cplusplus
 }
 #endif
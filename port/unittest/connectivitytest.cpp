@@ -41,6 +41,12 @@
 #include <gtest/gtest.h>
 #include <optional>
 #include <string>
+#include <vector>
+
+#ifdef OC_HAS_FEATURE_EPOLL
+#include <sys/select.h>
+#include <unistd.h>
+#endif /* OC_HAS_FEATURE_EPOLL */
 
 static constexpr size_t kDeviceID = 0;
 
@@ -602,6 +608,56 @@ TEST_F(TestConnectivityWithServer, oc_tcp_send_buffer2)
   oc_message_unref(msg);
 }
 
+#ifdef OC_HAS_FEATURE_EPOLL
+
+/** with epoll the network thread is not limited to descriptors below
+ * FD_SETSIZE */
+TEST_F(TestConnectivityWithServer, oc_tcp_connect_high_fd)
+{
+  // occupy the descriptors below FD_SETSIZE, so that the sockets of the new
+  // session are created above it
+  struct FileDescriptors {
+    std::vector<int> fds{};
+    ~FileDescriptors()
+    {
+      for (int f : fds) {
+        close(f);
+      }
+    }
+  } guard{};
+  int fd = -1;
+  while ((fd = dup(STDIN_FILENO)) >= 0 && fd < FD_SETSIZE) {
+    guard.fds.push_back(fd);
+  }
+  if (fd < 0) {
+    GTEST_SKIP() << "cannot allocate enough file descriptors";
+  }
+  guard.fds.push_back(fd);
+
+  auto epOpt = findEndpoint(kDeviceID);
+  ASSERT_TRUE(epOpt.has_value());
+  auto ep = std::move(*epOpt);
+
+  int ret = oc_tcp_connect(&ep, on_tcp_connect, this);
+  EXPECT_LE(0, ret);
+  if (ret == OC_TCP_SOCKET_STATE_CONNECTING) {
+    OC_DBG("oc_tcp_connect_high_fd wait");
+    oc::TestDevice::PoolEvents(5);
+  }
+  EXPECT_EQ(OC_TCP_SOCKET_STATE_CONNECTED, oc_tcp_connection_state(&ep));
+
+  coap_packet_t packet = {};
+  coap_tcp_init_message(&packet, CSM_7_01);
+  oc_message_t *msg = oc_allocate_message();
+  memcpy(&msg->endpoint, &ep, sizeof(oc_endpoint_t));
+  msg->length =
+    coap_serialize_message(&packet, msg->data, oc_message_buffer_size(msg));
+  EXPECT_EQ(msg->length, oc_send_buffer2(msg, false));
+  oc_message_unref(msg);
+}
+
+#endif /* OC_HAS_FEATURE_EPOLL */
+
 /** fail sending a message to an address without an ongoing or waiting TCP
  * session */
 TEST_F(TestConnectivityWithServer, oc_tcp_send_buffer2_not_connected)
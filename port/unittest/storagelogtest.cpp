@@ -0,0 +1,437 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_STORAGE_LOG
+
+#include "port/linux/storage_log.h"
+#include "tests/gtest/Benchmark.h"
+#include "tests/gtest/Utility.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const std::string kLogDir{ "storage_test" };
+static const std::string kLogPath{ kLogDir + "/log_test.log" };
+
+class TestStorageLog : public testing::Test {
+public:
+  void SetUp() override { std::filesystem::remove(kLogPath); }
+
+  void TearDown() override
+  {
+    if (log_ != nullptr) {
+      oc_storage_log_close(log_);
+      log_ = nullptr;
+    }
+    std::filesystem::remove(kLogPath);
+  }
+
+  void Open()
+  {
+    if (log_ != nullptr) {
+      oc_storage_log_close(log_);
+    }
+    log_ = oc_storage_log_open(kLogPath.c_str());
+    ASSERT_NE(nullptr, log_);
+  }
+
+  long Write(const std::string &store, const std::string &data)
+  {
+    auto in = oc::GetVector<uint8_t>(data);
+    return oc_storage_log_write(log_, store.c_str(), in.data(), in.size());
+  }
+
+  std::string Read(const std::string &store)
+  {
+    std::array<uint8_t, 256> buf{};
+    long ret = oc_storage_log_read(log_, store.c_str(), buf.data(), buf.size());
+    if (ret < 0) {
+      return {};
+    }
+    std::string out{};
+    std::copy_n(buf.begin(), static_cast<size_t>(ret),
+                std::back_inserter(out));
+    return out;
+  }
+
+  oc_storage_log_t *log_{ nullptr };
+};
+
+TEST_F(TestStorageLog, WriteRead)
+{
+  Open();
+  EXPECT_EQ(-ENOENT, oc_storage_log_size(log_, "store"));
+  std::array<uint8_t, 16> buf{};
+  EXPECT_EQ(-ENOENT,
+            oc_storage_log_read(log_, "store", buf.data(), buf.size()));
+
+  ASSERT_EQ(12, Write("store", "storage data"));
+  EXPECT_EQ(12, oc_storage_log_size(log_, "store"));
+  EXPECT_EQ("storage data", Read("store"));
+
+  // the latest record is read
+  ASSERT_EQ(9, Write("store", "overwrite"));
+  EXPECT_EQ("overwrite", Read("store"));
+  ASSERT_EQ(0, Write("empty", ""));
+  EXPECT_EQ(0, oc_storage_log_size(log_, "empty"));
+
+  // buffer too small
+  EXPECT_EQ(-EINVAL, oc_storage_log_read(log_, "store", buf.data(), 1));
+
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  EXPECT_EQ(2, stats.stores);
+  EXPECT_EQ(21, stats.data_bytes);
+  EXPECT_EQ(stats.appended_bytes, stats.file_size);
+  EXPECT_LT(stats.live_bytes, stats.file_size);
+}
+
+TEST_F(TestStorageLog, Write_Fail)
+{
+  Open();
+  auto in = oc::GetVector<uint8_t>("storage data");
+  EXPECT_EQ(-EINVAL, oc_storage_log_write(log_, "", in.data(), in.size()));
+  auto store = std::string(256, 'a');
+  EXPECT_EQ(-EINVAL,
+            oc_storage_log_write(log_, store.c_str(), in.data(), in.size()));
+  EXPECT_EQ(-EINVAL, oc_storage_log_write(log_, "store", nullptr, 1));
+  EXPECT_EQ(0, oc_storage_log_get_stats(log_).file_size);
+}
+
+TEST_F(TestStorageLog, Reopen)
+{
+  Open();
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_LE(0, Write("store" + std::to_string(i % 3),
+                       "storage data " + std::to_string(i)));
+  }
+  Open();
+  EXPECT_EQ("storage data 9", Read("store0"));
+  EXPECT_EQ("storage data 7", Read("store1"));
+  EXPECT_EQ("storage data 8", Read("store2"));
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  EXPECT_EQ(3, stats.stores);
+  EXPECT_EQ(0, stats.dropped_bytes);
+}
+
+static void
+appendToFile(const std::string &path, const std::vector<uint8_t> &data)
+{
+  FILE *fp = fopen(path.c_str(), "ab");
+  ASSERT_NE(nullptr, fp);
+  EXPECT_EQ(data.size(), fwrite(data.data(), 1, data.size(), fp));
+  fclose(fp);
+}
+
+TEST_F(TestStorageLog, Recover_TornRecord)
+{
+  Open();
+  ASSERT_LE(0, Write("store", "storage data"));
+  uint64_t size = oc_storage_log_get_stats(log_).file_size;
+  oc_storage_log_close(log_);
+  log_ = nullptr;
+
+  // a record interrupted by a power loss, the header is complete but the data
+  // are missing
+  std::ifstream in(kLogPath, std::ios::binary);
+  std::vector<uint8_t> record(size);
+  in.read(reinterpret_cast<char *>(record.data()),
+          static_cast<std::streamsize>(record.size()));
+  in.close();
+  record.resize(record.size() - 4);
+  appendToFile(kLogPath, record);
+
+  Open();
+  EXPECT_EQ("storage data", Read("store"));
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  EXPECT_EQ(size - 4, stats.dropped_bytes);
+  EXPECT_EQ(size, stats.file_size);
+  EXPECT_EQ(size, std::filesystem::file_size(kLogPath));
+
+  // new records are appended after the last valid record
+  ASSERT_LE(0, Write("store", "overwrite"));
+  Open();
+  EXPECT_EQ("overwrite", Read("store"));
+  EXPECT_EQ(0, oc_storage_log_get_stats(log_).dropped_bytes);
+}
+
+TEST_F(TestStorageLog, Recover_CorruptedRecord)
+{
+  Open();
+  ASSERT_LE(0, Write("store", "storage data"));
+  uint64_t size = oc_storage_log_get_stats(log_).file_size;
+  ASSERT_LE(0, Write("store", "overwrite"));
+  oc_storage_log_close(log_);
+  log_ = nullptr;
+
+  // flip a byte of the data of the last record
+  int fd = open(kLogPath.c_str(), O_RDWR);
+  ASSERT_LE(0, fd);
+  uint8_t byte = 0;
+  off_t last = static_cast<off_t>(std::filesystem::file_size(kLogPath) - 1);
+  ASSERT_EQ(1, pread(fd, &byte, 1, last));
+  byte ^= 0xFF;
+  ASSERT_EQ(1, pwrite(fd, &byte, 1, last));
+  close(fd);
+
+  // the corrupted record is dropped, the previous data are kept
+  Open();
+  EXPECT_EQ("storage data", Read("store"));
+  EXPECT_EQ(size, oc_storage_log_get_stats(log_).file_size);
+  EXPECT_LT(0, oc_storage_log_get_stats(log_).dropped_bytes);
+}
+
+static void
+flipByte(const std::string &path, off_t offset)
+{
+  int fd = open(path.c_str(), O_RDWR);
+  ASSERT_LE(0, fd);
+  uint8_t byte = 0;
+  ASSERT_EQ(1, pread(fd, &byte, 1, offset));
+  byte ^= 0xFF;
+  ASSERT_EQ(1, pwrite(fd, &byte, 1, offset));
+  close(fd);
+}
+
+TEST_F(TestStorageLog, Recover_CorruptedRecordInTheMiddle)
+{
+  Open();
+  ASSERT_LE(0, Write("store1", "storage data 1"));
+  ASSERT_LE(0, Write("store2", "storage data 2"));
+  uint64_t start = oc_storage_log_get_stats(log_).file_size;
+  ASSERT_LE(0, Write("store2", "overwrite 2"));
+  uint64_t end = oc_storage_log_get_stats(log_).file_size;
+  ASSERT_LE(0, Write("store3", "storage data 3"));
+  uint64_t size = oc_storage_log_get_stats(log_).file_size;
+  oc_storage_log_close(log_);
+  log_ = nullptr;
+
+  // the magic and the data of the record are corrupted
+  flipByte(kLogPath, static_cast<off_t>(start));
+  flipByte(kLogPath, static_cast<off_t>(end - 1));
+
+  // only the corrupted record is skipped, the records after it are kept
+  Open();
+  EXPECT_EQ("storage data 1", Read("store1"));
+  EXPECT_EQ("storage data 2", Read("store2"));
+  EXPECT_EQ("storage data 3", Read("store3"));
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  EXPECT_EQ(end - start, stats.dropped_bytes);
+  EXPECT_EQ(size, stats.file_size);
+  EXPECT_EQ(size, std::filesystem::file_size(kLogPath));
+
+  // new records are appended after the last valid record
+  ASSERT_LE(0, Write("store2", "overwrite 2"));
+  Open();
+  EXPECT_EQ("overwrite 2", Read("store2"));
+  EXPECT_EQ(end - start, oc_storage_log_get_stats(log_).dropped_bytes);
+
+  // the corrupted record is removed by the compaction
+  ASSERT_EQ(0, oc_storage_log_compact(log_));
+  Open();
+  EXPECT_EQ("storage data 1", Read("store1"));
+  EXPECT_EQ("overwrite 2", Read("store2"));
+  EXPECT_EQ("storage data 3", Read("store3"));
+  EXPECT_EQ(0, oc_storage_log_get_stats(log_).dropped_bytes);
+}
+
+TEST_F(TestStorageLog, Compact)
+{
+  Open();
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_LE(0, Write("store" + std::to_string(i % 4),
+                       "storage data " + std::to_string(i)));
+  }
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  ASSERT_EQ(0, oc_storage_log_compact(log_));
+
+  oc_storage_log_stats_t compacted = oc_storage_log_get_stats(log_);
+  EXPECT_EQ(1, compacted.compactions);
+  EXPECT_EQ(stats.live_bytes, compacted.file_size);
+  EXPECT_EQ(compacted.file_size, compacted.compacted_bytes);
+  EXPECT_EQ(compacted.file_size, std::filesystem::file_size(kLogPath));
+  EXPECT_FALSE(std::filesystem::exists(kLogPath + ".compact"));
+  for (int i = 96; i < 100; ++i) {
+    EXPECT_EQ("storage data " + std::to_string(i),
+              Read("store" + std::to_string(i % 4)));
+  }
+
+  // writes continue in the compacted log
+  ASSERT_LE(0, Write("store0", "overwrite"));
+  Open();
+  EXPECT_EQ("overwrite", Read("store0"));
+  EXPECT_EQ("storage data 99", Read("store3"));
+  EXPECT_EQ(4, oc_storage_log_get_stats(log_).stores);
+}
+
+TEST_F(TestStorageLog, Compact_Background)
+{
+  Open();
+  // overwrite a few stores until the outdated records exceed the minimal size
+  // of the log for a compaction
+  std::string data(200, 'x');
+  int writes = 0;
+  while (oc_storage_log_get_stats(log_).appended_bytes <
+         2 * OC_STORAGE_LOG_COMPACT_MIN_SIZE) {
+    data[0] = static_cast<char>('a' + writes % 26);
+    ASSERT_LE(0, Write("store" + std::to_string(writes % 8), data));
+    ++writes;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (oc_storage_log_get_stats(log_).compactions == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  EXPECT_LT(0, stats.compactions);
+  EXPECT_LT(stats.file_size, stats.appended_bytes);
+
+  // the data written during the compaction are kept
+  for (int i = writes - 8; i < writes; ++i) {
+    data[0] = static_cast<char>('a' + i % 26);
+    EXPECT_EQ(data, Read("store" + std::to_string(i % 8)));
+  }
+  Open();
+  for (int i = writes - 8; i < writes; ++i) {
+    data[0] = static_cast<char>('a' + i % 26);
+    EXPECT_EQ(data, Read("store" + std::to_string(i % 8)));
+  }
+}
+
+namespace {
+
+// previous implementation: each store is a file rewritten by each write
+void
+writeFile(const std::string &path, const std::vector<uint8_t> &data)
+{
+  FILE *fp = fopen(path.c_str(), "wb");
+  ASSERT_NE(nullptr, fp);
+  ASSERT_EQ(data.size(), fwrite(data.data(), 1, data.size(), fp));
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(0, fsync(fileno(fp)));
+  fclose(fp);
+}
+
+size_t
+readFile(const std::string &path, std::vector<uint8_t> &buf)
+{
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) {
+    return 0;
+  }
+  size_t ret = fread(buf.data(), 1, buf.size(), fp);
+  fclose(fp);
+  return ret;
+}
+
+// data written to the device by a file rewrite, the file system writes whole
+// blocks
+uint64_t
+fileWriteBytes(size_t size)
+{
+  constexpr uint64_t kBlockSize = 4096;
+  return (size + kBlockSize - 1) / kBlockSize * kBlockSize;
+}
+
+} // namespace
+
+TEST_F(TestStorageLog, Benchmark)
+{
+  // a gateway with many devices, each has several small stores rewritten a few
+  // times
+  constexpr size_t kStores = 120;
+  constexpr size_t kRewrites = 3;
+  constexpr size_t kRounds = 5;
+  std::vector<uint8_t> data(96, 0xAB);
+  auto storeName = [](size_t i) {
+    return "store_" + std::to_string(i % 8) + "_" + std::to_string(i);
+  };
+
+  std::string files_dir = kLogDir + "/log_bench_files";
+  std::filesystem::remove_all(files_dir);
+  std::filesystem::create_directory(files_dir);
+  uint64_t files_bytes = 0;
+  for (size_t r = 0; r < kRewrites; ++r) {
+    for (size_t i = 0; i < kStores; ++i) {
+      writeFile(files_dir + "/" + storeName(i), data);
+      files_bytes += fileWriteBytes(data.size());
+    }
+  }
+
+  Open();
+  for (size_t r = 0; r < kRewrites; ++r) {
+    for (size_t i = 0; i < kStores; ++i) {
+      ASSERT_EQ(data.size(), oc_storage_log_write(log_, storeName(i).c_str(),
+                                                  data.data(), data.size()));
+    }
+  }
+  ASSERT_EQ(0, oc_storage_log_compact(log_));
+  oc_storage_log_stats_t stats = oc_storage_log_get_stats(log_);
+  uint64_t log_bytes = stats.appended_bytes + stats.compacted_bytes;
+  printf("[ BENCH    ] StorageLog.WriteAmplification: files %.1f, log %.1f\n",
+         static_cast<double>(files_bytes) / stats.data_bytes,
+         static_cast<double>(log_bytes) / stats.data_bytes);
+  EXPECT_LT(log_bytes, files_bytes);
+  oc_storage_log_close(log_);
+  log_ = nullptr;
+
+  // startup: load all stores
+  std::vector<uint8_t> buf(256);
+  double files_load = 0;
+  double log_load = 0;
+  for (size_t round = 0; round < kRounds; ++round) {
+    auto files = oc::Benchmark("StorageLog.LoadFiles", 1, [&](size_t) {
+      for (size_t i = 0; i < kStores; ++i) {
+        EXPECT_EQ(data.size(), readFile(files_dir + "/" + storeName(i), buf));
+      }
+    });
+    auto log = oc::Benchmark("StorageLog.LoadLog", 1, [&](size_t) {
+      oc_storage_log_t *l = oc_storage_log_open(kLogPath.c_str());
+      ASSERT_NE(nullptr, l);
+      for (size_t i = 0; i < kStores; ++i) {
+        EXPECT_EQ(data.size(), oc_storage_log_read(l, storeName(i).c_str(),
+                                                   buf.data(), buf.size()));
+      }
+      oc_storage_log_close(l);
+    });
+    if (round == 0 || files.NsPerOp() < files_load) {
+      files_load = files.NsPerOp();
+    }
+    if (round == 0 || log.NsPerOp() < log_load) {
+      log_load = log.NsPerOp();
+    }
+  }
+  printf("[ BENCH    ] StorageLog.Load: best of %zu rounds: files %.1f ns, log "
+         "%.1f ns\n",
+         kRounds, files_load, log_load);
+  std::filesystem::remove_all(files_dir);
+}
+
+#endif /* OC_HAS_FEATURE_STORAGE_LOG */
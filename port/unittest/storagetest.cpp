@@ -225,4 +225,113 @@ TEST_F(TestStorage, Read_FailBufferTooSmall)
   EXPECT_GT(0, ret);
 }
 
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+
+static std::string
+readStore(const std::string &store)
+{
+  std::array<uint8_t, 100> buf{};
+  long ret = oc_storage_read(store.c_str(), buf.data(), buf.size());
+  if (ret < 0) {
+    return {};
+  }
+  std::string out{};
+  std::copy_n(buf.begin(), static_cast<size_t>(ret), std::back_inserter(out));
+  return out;
+}
+
+TEST_F(TestStorage, WriteBehind_Coalesce)
+{
+  ASSERT_EQ(0, oc_storage_config(testStorage.c_str()));
+  oc_storage_reset_write_stats();
+
+  std::string file_name = "storage_file";
+  constexpr uint32_t kWrites = 100;
+  for (uint32_t i = 0; i < kWrites; ++i) {
+    std::string str = "storage data " + std::to_string(i);
+    auto in = oc::GetVector<uint8_t>(str);
+    ASSERT_EQ(in.size(),
+              oc_storage_write(file_name.c_str(), in.data(), in.size()));
+    // pending data are read back
+    EXPECT_EQ(str, readStore(file_name));
+    EXPECT_EQ(in.size(), oc_storage_size(file_name.c_str()));
+  }
+  EXPECT_EQ(0, oc_storage_flush());
+
+  oc_storage_write_stats_t stats = oc_storage_get_write_stats();
+  EXPECT_EQ(kWrites, stats.queued);
+  EXPECT_LT(0, stats.written);
+  EXPECT_EQ(kWrites, stats.written + stats.coalesced);
+  EXPECT_EQ(0, stats.failed);
+
+  // the store holds the last data and the temporary file was renamed
+  EXPECT_EQ("storage data 99", readStore(file_name));
+  EXPECT_FALSE(std::filesystem::exists(testStorage + kPathSeparator +
+                                       file_name + ".tmp"));
+}
+
+TEST_F(TestStorage, WriteBehind_FlushError)
+{
+  ASSERT_EQ(0, oc_storage_config("storage_missing_dir"));
+  oc_storage_reset_write_stats();
+
+  // the write is queued, the failure is reported by the flush
+  auto in = oc::GetVector<uint8_t>("storage data");
+  EXPECT_EQ(in.size(), oc_storage_write("storage_file", in.data(), in.size()));
+  EXPECT_GT(0, oc_storage_flush());
+  EXPECT_EQ(0, oc_storage_flush());
+  EXPECT_EQ(1, oc_storage_get_write_stats().failed);
+  EXPECT_GT(0, oc_storage_size("storage_file"));
+}
+
+TEST_F(TestStorage, WriteBehind_Reset)
+{
+  ASSERT_EQ(0, oc_storage_config(testStorage.c_str()));
+  auto in = oc::GetVector<uint8_t>("storage data");
+  ASSERT_EQ(in.size(), oc_storage_write("storage_file", in.data(), in.size()));
+  // empty data clear the store
+  ASSERT_EQ(0, oc_storage_write("storage_empty", in.data(), 0));
+
+  // pending writes are written before the storage is disabled
+  ASSERT_EQ(0, oc_storage_reset());
+  ASSERT_EQ(0, oc_storage_config(testStorage.c_str()));
+  EXPECT_EQ("storage data", readStore("storage_file"));
+  EXPECT_EQ(0, oc_storage_size("storage_empty"));
+}
+
+TEST_F(TestStorage, WriteBehind_Shutdown)
+{
+  ASSERT_EQ(0, oc_storage_config(testStorage.c_str()));
+  oc_storage_reset_write_stats();
+  auto in = oc::GetVector<uint8_t>("storage data");
+  ASSERT_EQ(in.size(), oc_storage_write("storage_file", in.data(), in.size()));
+
+  // pending writes are written before the writer thread is stopped
+  EXPECT_EQ(0, oc_storage_shutdown());
+  EXPECT_EQ(1, oc_storage_get_write_stats().written);
+  EXPECT_EQ("storage data", readStore("storage_file"));
+  // stopping a stopped thread is a no-op
+  EXPECT_EQ(0, oc_storage_shutdown());
+
+  // the storage stays configured and the next write starts the thread again
+  EXPECT_TRUE(oc_storage_path(nullptr, 0));
+  auto in2 = oc::GetVector<uint8_t>("storage data 2");
+  ASSERT_EQ(in2.size(),
+            oc_storage_write("storage_file", in2.data(), in2.size()));
+  EXPECT_EQ(0, oc_storage_flush());
+  EXPECT_EQ(2, oc_storage_get_write_stats().written);
+  EXPECT_EQ("storage data 2", readStore("storage_file"));
+}
+
+TEST_F(TestStorage, WriteBehind_ShutdownError)
+{
+  ASSERT_EQ(0, oc_storage_config("storage_missing_dir"));
+  auto in = oc::GetVector<uint8_t>("storage data");
+  EXPECT_EQ(in.size(), oc_storage_write("storage_file", in.data(), in.size()));
+  EXPECT_GT(0, oc_storage_shutdown());
+  EXPECT_EQ(0, oc_storage_flush());
+}
+
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 #endif /* OC_STORAGE */
@@ -0,0 +1,205 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_features.h"
+
+#ifdef OC_HAS_FEATURE_UDP_BATCH
+
+#include "api/oc_message_internal.h"
+#include "api/oc_platform_internal.h"
+#include "oc_api.h"
+#include "oc_buffer.h"
+#include "port/linux/ip.h"
+#include "port/linux/netsocket.h"
+#include "port/oc_allocator_internal.h"
+#include "tests/gtest/Device.h"
+
+#include <array>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static constexpr size_t kBatchCount{ 8 };
+#else  /* !OC_DYNAMIC_ALLOCATION */
+// static pools of messages are small
+static constexpr size_t kBatchCount{ 2 };
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+class TestUDPBatch : public testing::Test {
+public:
+  static void SetUpTestCase()
+  {
+#ifdef OC_HAS_FEATURE_ALLOCATOR_MUTEX
+    oc_allocator_mutex_init();
+#endif /* OC_HAS_FEATURE_ALLOCATOR_MUTEX */
+  }
+
+  static void TearDownTestCase()
+  {
+#ifdef OC_HAS_FEATURE_ALLOCATOR_MUTEX
+    oc_allocator_mutex_destroy();
+#endif /* OC_HAS_FEATURE_ALLOCATOR_MUTEX */
+  }
+
+  void SetUp() override
+  {
+    oc_ip_batch_stats_reset();
+    receiver_ = oc_netsocket_create_ipv6(0);
+    ASSERT_LE(0, receiver_);
+    sender_ = oc_netsocket_create_ipv6(0);
+    ASSERT_LE(0, sender_);
+  }
+
+  void TearDown() override
+  {
+    close(sender_);
+    close(receiver_);
+  }
+
+  static uint16_t getPort(int sock)
+  {
+    sockaddr_in6 addr{};
+    socklen_t len = sizeof(addr);
+    EXPECT_EQ(0, getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &len));
+    return ntohs(addr.sin6_port);
+  }
+
+  int sender_{ -1 };
+  int receiver_{ -1 };
+};
+
+TEST_F(TestUDPBatch, SendAndReceive)
+{
+  sockaddr_storage receiver{};
+  auto *r6 = reinterpret_cast<sockaddr_in6 *>(&receiver);
+  r6->sin6_family = AF_INET6;
+  r6->sin6_addr = in6addr_loopback;
+  r6->sin6_port = htons(getPort(receiver_));
+
+  constexpr size_t kCount = kBatchCount;
+  std::array<sockaddr_storage, kCount> receivers{};
+  std::array<oc_message_t *, kCount> out{};
+  for (size_t i = 0; i < kCount; ++i) {
+    receivers[i] = receiver;
+    out[i] = oc_message_allocate_outgoing();
+    ASSERT_NE(nullptr, out[i]);
+    out[i]->endpoint.flags = IPV6;
+    out[i]->length = i + 1;
+    memset(out[i]->data, static_cast<int>('a' + i), out[i]->length);
+  }
+  EXPECT_EQ(static_cast<int>(kCount),
+            oc_ip_send_msgs(sender_, receivers.data(), out.data(), kCount));
+
+  std::array<oc_message_t *, kCount> in{};
+  for (size_t i = 0; i < kCount; ++i) {
+    in[i] = oc_allocate_message();
+    ASSERT_NE(nullptr, in[i]);
+  }
+  size_t received = 0;
+  while (received < kCount) {
+    int ret = oc_ip_recv_msgs(receiver_, &in[received], kCount - received,
+                              false);
+    ASSERT_LT(0, ret);
+    received += static_cast<size_t>(ret);
+  }
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(out[i]->length, in[i]->length);
+    EXPECT_EQ(0, memcmp(out[i]->data, in[i]->data, in[i]->length));
+    EXPECT_EQ(getPort(sender_), in[i]->endpoint.addr.ipv6.port);
+    oc_message_unref(out[i]);
+    oc_message_unref(in[i]);
+  }
+
+  oc_ip_batch_stats_t stats = oc_ip_batch_stats();
+  EXPECT_EQ(1, stats.send_calls);
+  EXPECT_EQ(kCount, stats.send_messages);
+  EXPECT_EQ(kCount, stats.send_max_batch);
+  EXPECT_LE(1, stats.recv_calls);
+  EXPECT_EQ(kCount, stats.recv_messages);
+  EXPECT_LE(1, stats.recv_max_batch);
+
+  oc_ip_batch_stats_reset();
+  stats = oc_ip_batch_stats();
+  EXPECT_EQ(0, stats.send_calls);
+  EXPECT_EQ(0, stats.recv_messages);
+}
+
+TEST_F(TestUDPBatch, SendToDisabledSocket)
+{
+  sockaddr_storage receiver{};
+  oc_message_t *msg = oc_allocate_message();
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ(-1, oc_ip_send_msgs(-1, &receiver, &msg, 1));
+  oc_message_unref(msg);
+}
+
+static constexpr size_t kDeviceID{ 0 };
+
+class TestUDPBatchWithServer : public testing::Test {
+public:
+  static void SetUpTestCase() { ASSERT_TRUE(oc::TestDevice::StartServer()); }
+
+  static void TearDownTestCase() { oc::TestDevice::StopServer(); }
+
+  void SetUp() override { oc_ip_batch_stats_reset(); }
+
+  void TearDown() override { oc::TestDevice::Reset(); }
+};
+
+/** requests posted before the event loop runs are sent in a single batch */
+TEST_F(TestUDPBatchWithServer, GetRequests)
+{
+  auto epOpt = oc::TestDevice::GetEndpoint(kDeviceID, IPV6, TCP | SECURED);
+  ASSERT_TRUE(epOpt.has_value());
+  auto ep = std::move(*epOpt);
+
+  constexpr int kCount = static_cast<int>(kBatchCount);
+  auto get_handler = [](oc_client_response_t *data) {
+    EXPECT_EQ(OC_STATUS_OK, data->code);
+    auto *responses = static_cast<int *>(data->user_data);
+    ++(*responses);
+    if (*responses == kCount) {
+      oc::TestDevice::Terminate();
+    }
+  };
+
+  auto timeout = 1s;
+  int responses = 0;
+  for (int i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(oc_do_get_with_timeout(OCF_PLATFORM_URI, &ep, nullptr,
+                                       timeout.count(), get_handler, HIGH_QOS,
+                                       &responses));
+  }
+  oc::TestDevice::PoolEventsMsV1(timeout, true);
+  EXPECT_EQ(kCount, responses);
+
+  oc_ip_batch_stats_t stats = oc_ip_batch_stats();
+  // requests and responses
+  EXPECT_LE(static_cast<uint32_t>(2 * kCount), stats.send_messages);
+  EXPECT_LE(static_cast<uint32_t>(kCount), stats.send_max_batch);
+  EXPECT_LE(static_cast<uint32_t>(2 * kCount), stats.recv_messages);
+}
+
+#endif /* OC_HAS_FEATURE_UDP_BATCH */
@@ -54,6 +54,10 @@
 #include "api/oc_etag_internal.h"
 #endif /* OC_HAS_FEATURE_ETAG */
 
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+#include "port/oc_storage_internal.h"
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
+
 #include <assert.h>
 
 #ifdef OC_DYNAMIC_ALLOCATION
@@ -700,6 +704,13 @@ oc_pstat_reset_device(size_t device, bool shutdown)
   oc_sec_pstat_t ps = { .s = OC_DOS_RESET };
   bool ret = oc_pstat_handle_state(&ps, device, false, shutdown);
   oc_sec_dump_pstat(device);
+#ifdef OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+  // the device must not come up with the state from before the reset after a
+  // power loss
+  if (oc_storage_flush() != 0) {
+    OC_ERR("failed to write the storage of reset device(%zu)", device);
+  }
+#endif /* OC_HAS_FEATURE_STORAGE_WRITE_BEHIND */
   return ret;
 }
 
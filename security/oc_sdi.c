@@ -19,6 +19,7 @@
 #ifdef OC_SECURITY
 
 #include "api/oc_core_res_internal.h"
+#include "api/oc_discovery_internal.h"
 #include "api/oc_rep_internal.h"
 #include "oc_sdi_internal.h"
 #include "oc_api.h"
@@ -81,6 +82,7 @@ oc_sec_sdi_default(size_t device)
   g_sdi[device].priv = false;
   memset(&(g_sdi[device].uuid), 0, sizeof(oc_uuid_t));
   oc_free_string(&g_sdi[device].name);
+  oc_discovery_cache_invalidate();
   oc_sec_dump_sdi(device);
 }
 
@@ -97,6 +99,7 @@ oc_sec_sdi_copy(oc_sec_sdi_t *dst, const oc_sec_sdi_t *src)
   dst->priv = src->priv;
   memcpy(&dst->uuid, &src->uuid, sizeof(src->uuid));
   oc_copy_string(&dst->name, &src->name);
+  oc_discovery_cache_invalidate();
 }
 
 void
@@ -106,6 +109,7 @@ oc_sec_sdi_clear(oc_sec_sdi_t *sdi)
   sdi->priv = false;
   memset(&sdi->uuid, 0, sizeof(sdi->uuid));
   oc_free_string(&sdi->name);
+  oc_discovery_cache_invalidate();
 }
 
 typedef struct sdi_decode_data_t
@@ -219,6 +223,7 @@ oc_sec_sdi_decode_with_state(const oc_rep_t *rep, oc_dostype_t state,
   if (sdi_data.priv_found) {
     sdi->priv = sdi_data.priv;
   }
+  oc_discovery_cache_invalidate();
   return true;
 }
 
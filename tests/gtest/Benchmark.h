@@ -0,0 +1,75 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+namespace oc {
+
+/** Result of a single benchmark run */
+struct BenchmarkResult
+{
+  std::string name;
+  size_t iterations;
+  std::chrono::nanoseconds elapsed;
+
+  /** Average duration of a single iteration in nanoseconds */
+  double NsPerOp() const
+  {
+    if (iterations == 0) {
+      return 0;
+    }
+    return static_cast<double>(elapsed.count()) /
+           static_cast<double>(iterations);
+  }
+
+  /** Print the result to stdout */
+  void Print() const
+  {
+    printf("[ BENCH    ] %s: %zu iterations in %.3f ms (%.1f ns/op)\n",
+           name.c_str(), iterations,
+           static_cast<double>(elapsed.count()) / 1e6, NsPerOp());
+  }
+};
+
+/**
+ * Run fn(i) for i in [0, iterations) and measure the total duration.
+ *
+ * The functor is expected to do the measured work only, setup and teardown
+ * should be done outside of the measured loop.
+ */
+template<typename Fn>
+BenchmarkResult
+Benchmark(const std::string &name, size_t iterations, Fn &&fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    fn(i);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start);
+  BenchmarkResult res{ name, iterations, elapsed };
+  res.Print();
+  return res;
+}
+
+} // namespace oc
@@ -31,8 +31,7 @@ RepPool::RepPool(size_t size)
 #else  /* !OC_DYNAMIC_ALLOCATION */
   buffer_.resize(size);
   oc_rep_new_v1(buffer_.data(), buffer_.size());
-  memset(rep_objects_alloc_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(char));
-  memset(rep_objects_pool_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
+  oc_memb_init(&rep_objects_);
 #endif /* OC_DYNAMIC_ALLOCATION */
 }
 
@@ -51,8 +50,7 @@ RepPool::Clear()
 #else  /* !OC_DYNAMIC_ALLOCATION */
   buffer_.resize(size_);
   oc_rep_new_v1(buffer_.data(), buffer_.size());
-  memset(rep_objects_alloc_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(char));
-  memset(rep_objects_pool_, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
+  oc_memb_init(&rep_objects_);
 #endif /* OC_DYNAMIC_ALLOCATION */
 }
 
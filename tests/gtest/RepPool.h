@@ -54,13 +54,14 @@ private:
   size_t size_;
 #ifdef OC_DYNAMIC_ALLOCATION
   uint8_t *buffer_{ nullptr };
-  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr };
+  oc_memb rep_objects_{ sizeof(oc_rep_t), 0, nullptr, nullptr, nullptr,
+                        OC_MEMB_STATE_INIT };
 #else  /* !OC_DYNAMIC_ALLOCATION */
   char rep_objects_alloc_[OC_MAX_NUM_REP_OBJECTS];
   oc_rep_t rep_objects_pool_[OC_MAX_NUM_REP_OBJECTS];
   oc_memb rep_objects_{ sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                         rep_objects_alloc_, (void *)rep_objects_pool_,
-                        nullptr };
+                        nullptr, OC_MEMB_STATE_INIT };
   std::vector<uint8_t> buffer_{};
 #endif /* OC_DYNAMIC_ALLOCATION */
 };
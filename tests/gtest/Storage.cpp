@@ -50,6 +50,8 @@ Storage::Config()
 int
 Storage::Clear()
 {
+  // the storage can write pending data until it is reset
+  int ret = oc_storage_reset();
   try {
     for (const auto &entry : std::filesystem::directory_iterator(path_)) {
       std::filesystem::remove_all(entry.path());
@@ -57,7 +59,7 @@ Storage::Clear()
   } catch (...) {
     // ignore errors
   }
-  return oc_storage_reset();
+  return ret;
 }
 
 } // namespace oc
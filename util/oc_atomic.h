@@ -52,6 +52,10 @@ extern "C" {
 
 #define OC_ATOMIC_DECREMENT32(x) __atomic_sub_fetch(&(x), 1, __ATOMIC_SEQ_CST)
 
+// Add val to x and return the new value of x
+#define OC_ATOMIC_ADD32(x, val)                                                \
+  __atomic_add_fetch(&(x), (val), __ATOMIC_SEQ_CST)
+
 // Function compares the contents of x with the contents of expected. If equal,
 // the operation is a read-modify-write operation that writes desired into x.
 // If they are not equal, the operation is a read and the current contents of
@@ -95,6 +99,9 @@ extern "C" {
 
 #define OC_ATOMIC_DECREMENT32(x) _InterlockedDecrement((&x))
 
+// _InterlockedExchangeAdd returns the initial value of x
+#define OC_ATOMIC_ADD32(x, val) (_InterlockedExchangeAdd((&x), (val)) + (val))
+
 #define OC_ATOMIC_COMPARE_AND_SWAP8(x, expected, desired, result)              \
   do {                                                                         \
     char _oc_compare_and_swap_initial =                                        \
@@ -146,6 +153,8 @@ atomics for your platform to this file")
 
 #define OC_ATOMIC_DECREMENT32(x) --(x)
 
+#define OC_ATOMIC_ADD32(x, val) ((x) += (val))
+
 // Copy the semantics of the Unix version of OC_ATOMIC_COMPARE_AND_SWAP32
 // using non-atomic operations.
 #define OC_ATOMIC_COMPARE_AND_SWAP32(x, expected, desired, result)             \
@@ -40,7 +40,21 @@
 #include "port/oc_log_internal.h"
 #include "util/oc_timer_internal.h"
 
-static struct oc_etimer *g_timerlist;
+static struct oc_etimer *
+etimer_from_node(const oc_heap_node_t *node)
+{
+  return OC_HEAP_ENTRY(node, struct oc_etimer, node);
+}
+
+static bool
+etimer_expires_before(const oc_heap_node_t *a, const oc_heap_node_t *b)
+{
+  return oc_timer_expiration_time(&etimer_from_node(a)->timer) <
+         oc_timer_expiration_time(&etimer_from_node(b)->timer);
+}
+
+/* Pending timers ordered by the expiration time */
+static oc_heap_t g_timers = OC_HEAP_INIT(etimer_expires_before);
 static oc_clock_time_t
   g_next_expiration; ///< next expiration time in monotonic clock ticks
 
@@ -49,81 +63,67 @@ OC_PROCESS(oc_etimer_process, "Event timer");
 static void
 etimer_update_time(void)
 {
-  if (g_timerlist == NULL) {
+  const oc_heap_node_t *top = oc_heap_top(&g_timers);
+  if (top == NULL) {
     OC_DBG("etimer: no expiring timers");
     g_next_expiration = 0;
     return;
   }
 
   oc_clock_time_t now = oc_timer_now();
-  struct oc_etimer *t = g_timerlist;
   /* Must calculate distance to next time into account due to wraps */
-  oc_clock_time_t tdist = oc_timer_until(&t->timer, now);
-  for (t = t->next; t != NULL; t = t->next) {
-    oc_clock_time_t tdist2 = oc_timer_until(&t->timer, now);
-    if (tdist2 < tdist) {
-      tdist = tdist2;
-    }
-  }
-  g_next_expiration = now + tdist;
+  g_next_expiration = now + oc_timer_until(&etimer_from_node(top)->timer, now);
   OC_DBG("etimer: next expiration=%ld", (long)g_next_expiration);
 }
 
 static bool
 etimer_process_poll(void)
 {
-  struct oc_etimer *prev = NULL;
-  for (struct oc_etimer *t = g_timerlist; t != NULL; prev = t, t = t->next) {
-    if (!oc_timer_expired(&t->timer)) {
-      continue;
-    }
-    if (oc_process_post(t->p, OC_PROCESS_EVENT_TIMER, t) != OC_PROCESS_ERR_OK) {
-      OC_DBG("cannot send timer event to process, scheduling retry by polling");
-      oc_process_poll(&oc_etimer_process);
-      continue;
-    }
+  oc_heap_node_t *top = oc_heap_top(&g_timers);
+  if (top == NULL) {
+    return false;
+  }
+  struct oc_etimer *t = etimer_from_node(top);
+  if (!oc_timer_expired(&t->timer)) {
+    return false;
+  }
+  if (oc_process_post(t->p, OC_PROCESS_EVENT_TIMER, t) != OC_PROCESS_ERR_OK) {
+    OC_DBG("cannot send timer event to process, scheduling retry by polling");
+    oc_process_poll(&oc_etimer_process);
+    return false;
+  }
 
-    /* Reset the process ID of the event timer, to signal that the
-       etimer has expired. This is later checked in the
-       oc_etimer_expired() function. */
-    t->p = OC_PROCESS_NONE;
-    if (prev != NULL) {
-      prev->next = t->next;
-    } else {
-      g_timerlist = t->next;
-    }
-    t->next = NULL;
-    etimer_update_time();
-    return true;
+  /* Reset the process ID of the event timer, to signal that the
+     etimer has expired. This is later checked in the
+     oc_etimer_expired() function. */
+  t->p = OC_PROCESS_NONE;
+  oc_heap_pop(&g_timers);
+  etimer_update_time();
+  return true;
+}
+
+static bool
+etimer_is_owned_by_process(const oc_heap_node_t *node, const void *data)
+{
+  const struct oc_etimer *t = etimer_from_node(node);
+  if (t->p != (const struct oc_process *)data) {
+    return false;
   }
-  return false;
+  OC_DBG("etimer(%p) removed from pending list", (const void *)t);
+  return true;
 }
 
 static void
 etimer_remove_process_pending_timers(const struct oc_process *p)
 {
-  while (g_timerlist != NULL && g_timerlist->p == p) {
-    OC_DBG("etimer(%p) removed from pending list", (void *)g_timerlist);
-    g_timerlist = g_timerlist->next;
-  }
-
-  if (g_timerlist == NULL) {
-    return;
-  }
-  struct oc_etimer *t = g_timerlist;
-  while (t->next != NULL) {
-    if (t->next->p == p) {
-      OC_DBG("etimer(%p) removed from pending list", (void *)t->next);
-      t->next = t->next->next;
-    } else
-      t = t->next;
-  }
+  oc_heap_remove_if(&g_timers, etimer_is_owned_by_process, p);
+  etimer_update_time();
 }
 
 OC_PROCESS_THREAD(oc_etimer_process, ev, data)
 {
   OC_PROCESS_BEGIN();
-  g_timerlist = NULL;
+  g_timers.root = NULL;
 
   while (oc_process_is_running(&oc_etimer_process)) {
     OC_PROCESS_YIELD();
@@ -155,22 +155,9 @@ etimer_add_timer(struct oc_etimer *timer)
 {
   oc_process_poll(&oc_etimer_process);
 
-  bool is_in_list = false;
-  if (timer->p != OC_PROCESS_NONE) {
-    for (const struct oc_etimer *t = g_timerlist; t != NULL; t = t->next) {
-      if (t == timer) {
-        /* Timer already in list. */
-        is_in_list = true;
-        break;
-      }
-    }
-  }
-
-  if (!is_in_list) {
-    /* Timer not in list -> add it to front. */
-    timer->next = g_timerlist;
-    g_timerlist = timer;
-  }
+  /* The expiration time has changed, requeue the timer if it is pending. */
+  oc_heap_remove(&g_timers, &timer->node);
+  oc_heap_insert(&g_timers, &timer->node);
   timer->p = OC_PROCESS_CURRENT();
   etimer_update_time();
 }
@@ -210,6 +197,10 @@ void
 oc_etimer_adjust(struct oc_etimer *et, int timediff)
 {
   et->timer.start += timediff;
+  if (oc_heap_contains(&g_timers, &et->node)) {
+    oc_heap_remove(&g_timers, &et->node);
+    oc_heap_insert(&g_timers, &et->node);
+  }
   etimer_update_time();
 }
 
@@ -234,7 +225,7 @@ oc_etimer_start_time(const struct oc_etimer *et)
 bool
 oc_etimer_pending(void)
 {
-  return g_timerlist != NULL;
+  return oc_heap_top(&g_timers) != NULL;
 }
 
 oc_clock_time_t
@@ -246,30 +237,10 @@ oc_etimer_next_expiration_time(void)
 void
 oc_etimer_stop(struct oc_etimer *et)
 {
-  /* First check if et is the first event timer on the list. */
-  if (et == g_timerlist) {
-    g_timerlist = g_timerlist->next;
-
+  if (oc_heap_contains(&g_timers, &et->node)) {
+    oc_heap_remove(&g_timers, &et->node);
     etimer_update_time();
-  } else {
-    /* Else walk through the list and try to find the item before the
-       et timer. */
-    struct oc_etimer *t;
-    for (t = g_timerlist; t != NULL && t->next != et; t = t->next)
-      ;
-
-    if (t != NULL) {
-      /* We've found the item before the event timer that we are about
-   to remove. We point the items next pointer to the event after
-   the removed item. */
-      t->next = et->next;
-
-      etimer_update_time();
-    }
   }
-
-  /* Remove the next pointer from the item to be removed. */
-  et->next = NULL;
   /* Set the timer as expired */
   et->p = OC_PROCESS_NONE;
 }
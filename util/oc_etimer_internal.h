@@ -57,6 +57,7 @@
 #include "oc_config.h"
 #include "oc_process.h"
 #include "oc_timer_internal.h"
+#include "util/oc_heap_internal.h"
 
 #include <stdbool.h>
 
@@ -75,7 +76,7 @@ extern "C" {
 struct oc_etimer
 {
   struct oc_timer timer;
-  struct oc_etimer *next;
+  oc_heap_node_t node;  // node in the queue of pending timers
   struct oc_process *p; // oc_process associated with the timer
 };
 
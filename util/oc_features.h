@@ -34,6 +34,16 @@
 #define OC_HAS_FEATURE_TCP_ASYNC_CONNECT
 #endif /* __linux__ && !__ANDROID_API__ && OC_CLIENT && OC_TCP */
 
+#if defined(__linux__) && !defined(__ANDROID_API__) && defined(OC_EPOLL)
+/* Use epoll instead of select in the network event loop */
+#define OC_HAS_FEATURE_EPOLL
+#endif /* __linux__ && !__ANDROID_API__ && OC_EPOLL */
+
+#if defined(__linux__) && !defined(__ANDROID_API__) && defined(OC_UDP_BATCH)
+/* Receive and send UDP datagrams in batches using recvmmsg/sendmmsg */
+#define OC_HAS_FEATURE_UDP_BATCH
+#endif /* __linux__ && !__ANDROID_API__ && OC_UDP_BATCH */
+
 #if defined(OC_PUSH) && defined(OC_SERVER) && defined(OC_CLIENT) &&            \
   defined(OC_DYNAMIC_ALLOCATION) && defined(OC_COLLECTIONS_IF_CREATE)
 #define OC_HAS_FEATURE_PUSH
@@ -67,6 +77,99 @@
 #define OC_HAS_FEATURE_ETAG_INTERFACE
 #endif /* OC_HAS_FEATURE_ETAG && OC_STORAGE */
 
+#if defined(OC_ETAG_DIRTY_TRACKING) && defined(OC_HAS_FEATURE_ETAG) &&         \
+  defined(OC_STORAGE)
+/* Keep the checksums of resource payloads until the resources report a change
+ * and write the ETag stores of the changed devices once per poll cycle */
+#define OC_HAS_FEATURE_ETAG_DIRTY_TRACKING
+#endif /* OC_ETAG_DIRTY_TRACKING && OC_HAS_FEATURE_ETAG && OC_STORAGE */
+
+#if defined(OC_RESOURCE_INDEX) && defined(OC_SERVER)
+/* Lookup application resources and collections by (device, URI) in a hash
+ * index instead of a linear scan of the resource lists */
+#define OC_HAS_FEATURE_RESOURCE_INDEX
+#endif /* OC_RESOURCE_INDEX && OC_SERVER */
+
+#ifdef OC_REQUEST_INDEX
+/* Lookup transactions, client callbacks and block-wise buffers by token and
+ * message ID in hash indexes instead of a linear scan of their lists */
+#define OC_HAS_FEATURE_REQUEST_INDEX
+#endif /* OC_REQUEST_INDEX */
+
+#if defined(OC_NOTIFICATION_SHARED_PAYLOAD) && defined(OC_SERVER)
+/* Encode a notification once for all observers with equal variants of their
+ * endpoints, the representation of the resources must not depend on other
+ * properties of the observer (e.g. its address) */
+#define OC_HAS_FEATURE_NOTIFICATION_SHARED_PAYLOAD
+#endif /* OC_NOTIFICATION_SHARED_PAYLOAD && OC_SERVER */
+
+#if defined(OC_OBSERVER_INDEX) && defined(OC_SERVER)
+/* Keep observers in lists per resource and per client endpoint and lookup them
+ * by endpoint and token in a hash index instead of a linear scan of the global
+ * list of observers */
+#define OC_HAS_FEATURE_OBSERVER_INDEX
+#endif /* OC_OBSERVER_INDEX && OC_SERVER */
+
+#if defined(OC_NOTIFICATION_SCHEDULER) && defined(OC_SERVER)
+/* Coalesce the changes of resources with a notification policy and limit the
+ * rate of notifications of resources and observers */
+#define OC_HAS_FEATURE_NOTIFICATION_SCHEDULER
+#endif /* OC_NOTIFICATION_SCHEDULER && OC_SERVER */
+
+#if defined(OC_COAP_HEADER_TEMPLATE) && defined(OC_SERVER)
+/* Keep the serialized CoAP header and options of the last notification of an
+ * observer and patch only the fields that differ in the next notifications */
+#define OC_HAS_FEATURE_COAP_HEADER_TEMPLATE
+#endif /* OC_COAP_HEADER_TEMPLATE && OC_SERVER */
+
+#ifdef OC_COAP_FAST_PARSER
+/* Index the boundaries of all options of a received CoAP message in a single
+ * pass before decoding them */
+#define OC_HAS_FEATURE_COAP_FAST_PARSER
+#endif /* OC_COAP_FAST_PARSER */
+
+#ifdef OC_NETWORK_EVENT_QUEUE
+/* Pass received messages and TCP connect events from the network threads to
+ * the event loop through bounded lock-free queues */
+#define OC_HAS_FEATURE_NETWORK_EVENT_QUEUE
+#endif /* OC_NETWORK_EVENT_QUEUE */
+
+#if defined(__linux__) && !defined(__ANDROID_API__) &&                         \
+  defined(OC_STORAGE_LOG) && defined(OC_STORAGE) &&                            \
+  defined(OC_DYNAMIC_ALLOCATION)
+/* Keep the stores in a single append-only log file instead of a file per
+ * store */
+#define OC_HAS_FEATURE_STORAGE_LOG
+#endif /* __linux__ && !__ANDROID_API__ && OC_STORAGE_LOG && OC_STORAGE &&     \
+          OC_DYNAMIC_ALLOCATION */
+
+#if defined(__linux__) && !defined(__ANDROID_API__) &&                         \
+  defined(OC_STORAGE_WRITE_BEHIND) && defined(OC_STORAGE) &&                   \
+  defined(OC_DYNAMIC_ALLOCATION) && !defined(OC_HAS_FEATURE_STORAGE_LOG)
+/* Write the stores on a background thread and coalesce the writes of a store
+ * which was not written yet */
+#define OC_HAS_FEATURE_STORAGE_WRITE_BEHIND
+#endif /* __linux__ && !__ANDROID_API__ && OC_STORAGE_WRITE_BEHIND &&          \
+          OC_STORAGE && OC_DYNAMIC_ALLOCATION && !OC_HAS_FEATURE_STORAGE_LOG */
+
+#if defined(OC_BLOCKWISE_STREAM) && defined(OC_BLOCK_WISE)
+/* Pass the bodies of block-wise transfers to callbacks block by block instead
+ * of reassembling them in a buffer */
+#define OC_HAS_FEATURE_BLOCKWISE_STREAM
+#endif /* OC_BLOCKWISE_STREAM && OC_BLOCK_WISE */
+
+#if defined(OC_DISCOVERY_CACHE) && defined(OC_DYNAMIC_ALLOCATION)
+/* Keep the encoded responses of discovery requests and serve them until a
+ * resource is added or removed or a property listed in them changes */
+#define OC_HAS_FEATURE_DISCOVERY_CACHE
+#endif /* OC_DISCOVERY_CACHE && OC_DYNAMIC_ALLOCATION */
+
+#if defined(OC_MMEM_TLSF) && !defined(OC_DYNAMIC_ALLOCATION)
+/* Allocate from the static memory pools by a two-level segregated fit
+ * allocator instead of compacting the pools on each free */
+#define OC_HAS_FEATURE_MMEM_TLSF
+#endif /* OC_MMEM_TLSF && !OC_DYNAMIC_ALLOCATION */
+
 #if defined(OC_DYNAMIC_ALLOCATION) && !defined(OC_INOUT_BUFFER_SIZE)
 #define OC_HAS_FEATURE_MESSAGE_DYNAMIC_BUFFER
 #endif /* OC_DYNAMIC_ALLOCATION && !OC_INOUT_BUFFER_SIZE */
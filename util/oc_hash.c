@@ -0,0 +1,46 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include "util/oc_hash_internal.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FNV1A_PRIME (16777619U)
+
+uint32_t
+oc_hash_fnv1a(uint32_t hash, const void *data, size_t size)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= FNV1A_PRIME;
+  }
+  return hash;
+}
+
+uint32_t
+oc_hash_fnv1a_uint(uint32_t hash, uint64_t value)
+{
+  // hash the value byte by byte so the result doesn't depend on endianness
+  for (int i = 0; i < 8; ++i) {
+    hash ^= (uint8_t)(value >> (i * 8));
+    hash *= FNV1A_PRIME;
+  }
+  return hash;
+}
@@ -0,0 +1,202 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include "oc_config.h"
+#include "util/oc_hash_index_internal.h"
+
+#include <string.h>
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#include <stdlib.h>
+
+#define HASH_INDEX_INITIAL_CAPACITY (16)
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static size_t
+hash_index_home(const oc_hash_index_t *index, uint32_t hash)
+{
+  return (size_t)hash % index->capacity;
+}
+
+static size_t
+hash_index_next(const oc_hash_index_t *index, size_t slot)
+{
+  ++slot;
+  return slot < index->capacity ? slot : 0;
+}
+
+/* Store the item to the first empty slot of its probe sequence, so items with
+ * equal hashes are probed in the insertion order. */
+static void
+hash_index_place(oc_hash_index_t *index, uint32_t hash, void *item)
+{
+  size_t slot = hash_index_home(index, hash);
+  while (index->entries[slot].item != NULL) {
+    slot = hash_index_next(index, slot);
+  }
+  index->entries[slot].item = item;
+  index->entries[slot].hash = hash;
+  ++index->count;
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+static bool
+hash_index_grow(oc_hash_index_t *index)
+{
+  size_t capacity = index->capacity > 0 ? index->capacity * 2
+                                        : HASH_INDEX_INITIAL_CAPACITY;
+  oc_hash_index_entry_t *entries =
+    (oc_hash_index_entry_t *)calloc(capacity, sizeof(oc_hash_index_entry_t));
+  if (entries == NULL) {
+    return false;
+  }
+
+  oc_hash_index_t grown = {
+    .entries = entries,
+    .capacity = capacity,
+    .count = 0,
+    .fixed = false,
+  };
+  if (index->count > 0) {
+    // start after an empty slot, no probe sequence wraps over it, so items
+    // with equal hashes are reinserted in their original order
+    size_t start = 0;
+    while (index->entries[start].item != NULL) {
+      ++start;
+    }
+    for (size_t i = 1; i <= index->capacity; ++i) {
+      const oc_hash_index_entry_t *entry =
+        &index->entries[(start + i) % index->capacity];
+      if (entry->item != NULL) {
+        hash_index_place(&grown, entry->hash, entry->item);
+      }
+    }
+  }
+  free(index->entries);
+  *index = grown;
+  return true;
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+void
+oc_hash_index_deinit(oc_hash_index_t *index)
+{
+  if (index->fixed) {
+    memset(index->entries, 0, index->capacity * sizeof(oc_hash_index_entry_t));
+    index->count = 0;
+    return;
+  }
+#ifdef OC_DYNAMIC_ALLOCATION
+  free(index->entries);
+#endif /* OC_DYNAMIC_ALLOCATION */
+  index->entries = NULL;
+  index->capacity = 0;
+  index->count = 0;
+}
+
+/* Make room for one more item */
+static bool
+hash_index_reserve(oc_hash_index_t *index)
+{
+  // keep the load factor under 3/4 in dynamic tables, at least one slot must
+  // stay empty to terminate the probing
+  if ((index->count + 1) * 4 <= index->capacity * 3) {
+    return true;
+  }
+  if (index->fixed) {
+    return index->count + 1 < index->capacity;
+  }
+#ifdef OC_DYNAMIC_ALLOCATION
+  return hash_index_grow(index);
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  return false;
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+bool
+oc_hash_index_insert(oc_hash_index_t *index, uint32_t hash, void *item)
+{
+  if (!hash_index_reserve(index)) {
+    return false;
+  }
+  hash_index_place(index, hash, item);
+  return true;
+}
+
+static bool
+hash_index_in_range(size_t from, size_t slot, size_t to)
+{
+  // is slot cyclically in (from, to]
+  return from <= to ? (from < slot && slot <= to) : (from < slot || slot <= to);
+}
+
+bool
+oc_hash_index_remove(oc_hash_index_t *index, uint32_t hash, const void *item)
+{
+  if (index->count == 0) {
+    return false;
+  }
+  size_t slot = hash_index_home(index, hash);
+  while (index->entries[slot].item != item) {
+    if (index->entries[slot].item == NULL) {
+      return false;
+    }
+    slot = hash_index_next(index, slot);
+  }
+
+  // backward shift deletion, keeps the probe sequences without tombstones
+  size_t hole = slot;
+  size_t next = hash_index_next(index, hole);
+  while (index->entries[next].item != NULL) {
+    size_t home = hash_index_home(index, index->entries[next].hash);
+    if (!hash_index_in_range(hole, home, next)) {
+      index->entries[hole] = index->entries[next];
+      hole = next;
+    }
+    next = hash_index_next(index, next);
+  }
+  index->entries[hole].item = NULL;
+  index->entries[hole].hash = 0;
+  --index->count;
+  return true;
+}
+
+void *
+oc_hash_index_find(const oc_hash_index_t *index, uint32_t hash,
+                   oc_hash_index_match_fn_t match, const void *key)
+{
+  if (index->count == 0) {
+    return NULL;
+  }
+  for (size_t slot = hash_index_home(index, hash);
+       index->entries[slot].item != NULL; slot = hash_index_next(index, slot)) {
+    if (index->entries[slot].hash == hash &&
+        match(index->entries[slot].item, key)) {
+      return index->entries[slot].item;
+    }
+  }
+  return NULL;
+}
+
+size_t
+oc_hash_index_count(const oc_hash_index_t *index)
+{
+  return index->count;
+}
@@ -0,0 +1,133 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#ifndef OC_HASH_INDEX_INTERNAL_H
+#define OC_HASH_INDEX_INTERNAL_H
+
+#include "util/oc_compiler.h"
+#include "util/oc_macros_internal.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Open-addressing (linear probing) index of items by a 32-bit hash.
+ *
+ * The index stores only pointers to the items and their hashes, the key is
+ * compared by a match function provided to the lookup. Several items can share
+ * the same key, the lookup returns the items with equal keys in the order in
+ * which they were inserted.
+ *
+ * A zero-initialized index grows its table dynamically (requires
+ * OC_DYNAMIC_ALLOCATION), an index initialized by OC_HASH_INDEX_STATIC_INIT
+ * uses the provided fixed storage.
+ */
+typedef struct oc_hash_index_entry_t
+{
+  void *item; ///< NULL for an empty slot
+  uint32_t hash;
+} oc_hash_index_entry_t;
+
+typedef struct oc_hash_index_t
+{
+  oc_hash_index_entry_t *entries;
+  size_t capacity;
+  size_t count;
+  bool fixed; ///< entries is a static storage, the table cannot grow
+} oc_hash_index_t;
+
+/**
+ * @brief Initializer of an index using a static array of entries as storage.
+ *
+ * At most OC_ARRAY_SIZE(storage) - 1 items can be stored, size the storage to
+ * about twice the maximal number of items to keep the lookups short.
+ */
+#define OC_HASH_INDEX_STATIC_INIT(storage)                                     \
+  {                                                                            \
+    (storage), OC_ARRAY_SIZE(storage), 0, true                                 \
+  }
+
+/**
+ * @brief Function used to compare the key of an indexed item.
+ *
+ * @param item the indexed item
+ * @param key the key passed to oc_hash_index_find
+ * @return true the item matches the key
+ * @return false otherwise
+ */
+typedef bool (*oc_hash_index_match_fn_t)(const void *item, const void *key);
+
+/**
+ * @brief Release the memory of a dynamic index, the index is empty afterwards.
+ *
+ * @param index the index (cannot be NULL)
+ */
+void oc_hash_index_deinit(oc_hash_index_t *index) OC_NONNULL();
+
+/**
+ * @brief Add an item to the index.
+ *
+ * @param index the index (cannot be NULL)
+ * @param hash hash of the key of the item
+ * @param item the item (cannot be NULL)
+ * @return true on success
+ * @return false the index is full or the allocation of a bigger table failed
+ */
+bool oc_hash_index_insert(oc_hash_index_t *index, uint32_t hash, void *item)
+  OC_NONNULL();
+
+/**
+ * @brief Remove an item from the index.
+ *
+ * @param index the index (cannot be NULL)
+ * @param hash hash of the key with which the item was inserted
+ * @param item the item (cannot be NULL)
+ * @return true the item was removed
+ * @return false the item was not found
+ */
+bool oc_hash_index_remove(oc_hash_index_t *index, uint32_t hash,
+                          const void *item) OC_NONNULL();
+
+/**
+ * @brief Find the first inserted item with the given hash accepted by the
+ * match function.
+ *
+ * @param index the index (cannot be NULL)
+ * @param hash hash of the key
+ * @param match function comparing the key of an item (cannot be NULL)
+ * @param key the key passed to the match function
+ * @return void* the found item
+ * @return NULL no item matched
+ */
+void *oc_hash_index_find(const oc_hash_index_t *index, uint32_t hash,
+                         oc_hash_index_match_fn_t match, const void *key)
+  OC_NONNULL(1, 3);
+
+/** @brief Get the number of items in the index */
+size_t oc_hash_index_count(const oc_hash_index_t *index) OC_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HASH_INDEX_INTERNAL_H */
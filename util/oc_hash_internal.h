@@ -0,0 +1,58 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#ifndef OC_HASH_INTERNAL_H
+#define OC_HASH_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Initial value of a 32-bit FNV-1a hash */
+#define OC_HASH_FNV1A_INIT (2166136261U)
+
+/**
+ * @brief Update a 32-bit FNV-1a hash with a buffer of data.
+ *
+ * @param hash The current hash value (use OC_HASH_FNV1A_INIT to start a new
+ * hash calculation).
+ * @param data The buffer of data to hash.
+ * @param size The size of the buffer.
+ *
+ * @return The updated hash value.
+ */
+uint32_t oc_hash_fnv1a(uint32_t hash, const void *data, size_t size);
+
+/**
+ * @brief Update a 32-bit FNV-1a hash with an unsigned integer value.
+ *
+ * @param hash The current hash value.
+ * @param value The value to hash.
+ *
+ * @return The updated hash value.
+ */
+uint32_t oc_hash_fnv1a_uint(uint32_t hash, uint64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HASH_INTERNAL_H */
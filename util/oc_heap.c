@@ -0,0 +1,171 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include "util/oc_heap_internal.h"
+
+static void
+heap_node_clear(oc_heap_node_t *node)
+{
+  node->child = NULL;
+  node->sibling = NULL;
+  node->prev = NULL;
+}
+
+/* Link two detached trees, the root with the greater key becomes the leftmost
+ * child of the other root */
+static oc_heap_node_t *
+heap_meld(const oc_heap_t *heap, oc_heap_node_t *a, oc_heap_node_t *b)
+{
+  if (heap->less(b, a)) {
+    oc_heap_node_t *tmp = a;
+    a = b;
+    b = tmp;
+  }
+  b->prev = a;
+  b->sibling = a->child;
+  if (a->child != NULL) {
+    a->child->prev = b;
+  }
+  a->child = b;
+  return a;
+}
+
+/* Standard two-pass pairing: meld the siblings in pairs from left to right,
+ * then meld the pairs from right to left */
+static oc_heap_node_t *
+heap_merge_pairs(const oc_heap_t *heap, oc_heap_node_t *first)
+{
+  if (first == NULL) {
+    return NULL;
+  }
+
+  // the melded pairs are chained by the sibling pointer in reverse order
+  oc_heap_node_t *pairs = NULL;
+  while (first != NULL) {
+    oc_heap_node_t *a = first;
+    oc_heap_node_t *b = a->sibling;
+    a->prev = NULL;
+    a->sibling = NULL;
+    if (b == NULL) {
+      first = NULL;
+    } else {
+      first = b->sibling;
+      b->prev = NULL;
+      b->sibling = NULL;
+      a = heap_meld(heap, a, b);
+    }
+    a->sibling = pairs;
+    pairs = a;
+  }
+
+  oc_heap_node_t *root = pairs;
+  pairs = pairs->sibling;
+  root->sibling = NULL;
+  while (pairs != NULL) {
+    oc_heap_node_t *next = pairs->sibling;
+    pairs->sibling = NULL;
+    root = heap_meld(heap, root, pairs);
+    pairs = next;
+  }
+  return root;
+}
+
+void
+oc_heap_insert(oc_heap_t *heap, oc_heap_node_t *node)
+{
+  heap_node_clear(node);
+  heap->root = heap->root != NULL ? heap_meld(heap, heap->root, node) : node;
+}
+
+oc_heap_node_t *
+oc_heap_pop(oc_heap_t *heap)
+{
+  oc_heap_node_t *root = heap->root;
+  if (root == NULL) {
+    return NULL;
+  }
+  heap->root = heap_merge_pairs(heap, root->child);
+  heap_node_clear(root);
+  return root;
+}
+
+void
+oc_heap_remove(oc_heap_t *heap, oc_heap_node_t *node)
+{
+  if (node == heap->root) {
+    oc_heap_pop(heap);
+    return;
+  }
+  if (node->prev == NULL) {
+    // not in the heap
+    return;
+  }
+
+  if (node->prev->child == node) {
+    node->prev->child = node->sibling;
+  } else {
+    node->prev->sibling = node->sibling;
+  }
+  if (node->sibling != NULL) {
+    node->sibling->prev = node->prev;
+  }
+  oc_heap_node_t *subtree = heap_merge_pairs(heap, node->child);
+  heap_node_clear(node);
+  if (subtree != NULL) {
+    heap->root = heap_meld(heap, heap->root, subtree);
+  }
+}
+
+bool
+oc_heap_contains(const oc_heap_t *heap, const oc_heap_node_t *node)
+{
+  return node == heap->root || node->prev != NULL;
+}
+
+oc_heap_node_t *
+oc_heap_top(const oc_heap_t *heap)
+{
+  return heap->root;
+}
+
+void
+oc_heap_remove_if(oc_heap_t *heap, oc_heap_remove_filter_fn_t filter,
+                  const void *data)
+{
+  // flatten the trees to a stack chained by the sibling pointer and reinsert
+  // the nodes that are kept
+  oc_heap_node_t *stack = heap->root;
+  heap->root = NULL;
+  while (stack != NULL) {
+    oc_heap_node_t *node = stack;
+    stack = node->sibling;
+    oc_heap_node_t *child = node->child;
+    if (child != NULL) {
+      oc_heap_node_t *last = child;
+      while (last->sibling != NULL) {
+        last = last->sibling;
+      }
+      last->sibling = stack;
+      stack = child;
+    }
+    heap_node_clear(node);
+    if (!filter(node, data)) {
+      oc_heap_insert(heap, node);
+    }
+  }
+}
@@ -0,0 +1,106 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#ifndef OC_HEAP_INTERNAL_H
+#define OC_HEAP_INTERNAL_H
+
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Intrusive priority queue (pairing heap).
+ *
+ * The node is embedded in the queued item, so the heap never allocates. Insert
+ * and access of the minimal item are O(1), removal of the minimal or of an
+ * arbitrary item is O(log n) amortized.
+ */
+typedef struct oc_heap_node_t
+{
+  struct oc_heap_node_t *child;   ///< leftmost child
+  struct oc_heap_node_t *sibling; ///< next sibling
+  struct oc_heap_node_t *prev; ///< parent of the leftmost child, otherwise the
+                               ///< previous sibling
+} oc_heap_node_t;
+
+/**
+ * @brief Ordering of the items.
+ *
+ * @return true the item of node a must be dequeued before the item of node b
+ * @return false otherwise
+ */
+typedef bool (*oc_heap_less_fn_t)(const oc_heap_node_t *a,
+                                  const oc_heap_node_t *b);
+
+typedef struct oc_heap_t
+{
+  oc_heap_node_t *root;
+  oc_heap_less_fn_t less;
+} oc_heap_t;
+
+/** @brief Initializer of an empty heap */
+#define OC_HEAP_INIT(less_fn)                                                  \
+  {                                                                            \
+    NULL, (less_fn)                                                            \
+  }
+
+/** @brief Get the item containing the node */
+#define OC_HEAP_ENTRY(node, type, member)                                      \
+  ((type *)(void *)((char *)(node)-offsetof(type, member)))
+
+/** @brief Add a node, the node must not be in a heap. */
+void oc_heap_insert(oc_heap_t *heap, oc_heap_node_t *node) OC_NONNULL();
+
+/** @brief Remove a node from the heap, does nothing if the node is not in the
+ * heap. The key of the node may have changed since the insertion. */
+void oc_heap_remove(oc_heap_t *heap, oc_heap_node_t *node) OC_NONNULL();
+
+/** @brief Remove and return the minimal node, NULL if the heap is empty. */
+oc_heap_node_t *oc_heap_pop(oc_heap_t *heap) OC_NONNULL();
+
+/** @brief Check if the node is in the heap. */
+bool oc_heap_contains(const oc_heap_t *heap, const oc_heap_node_t *node)
+  OC_NONNULL();
+
+/** @brief Get the minimal node, NULL if the heap is empty. */
+oc_heap_node_t *oc_heap_top(const oc_heap_t *heap) OC_NONNULL();
+
+/** @brief Function selecting nodes removed by oc_heap_remove_if */
+typedef bool (*oc_heap_remove_filter_fn_t)(const oc_heap_node_t *node,
+                                           const void *data);
+
+/**
+ * @brief Remove all nodes selected by the filter in O(n).
+ *
+ * @param heap the heap (cannot be NULL)
+ * @param filter function selecting the nodes to remove (cannot be NULL)
+ * @param data user data passed to the filter
+ */
+void oc_heap_remove_if(oc_heap_t *heap, oc_heap_remove_filter_fn_t filter,
+                       const void *data) OC_NONNULL(1, 2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_HEAP_INTERNAL_H */
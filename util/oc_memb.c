@@ -46,7 +46,55 @@ oc_memb_init(struct oc_memb *m)
 {
   if (m->num > 0) {
     memset(m->count, 0, m->num);
-    memset(m->mem, 0, (unsigned)m->num * sizeof(char *));
+    memset(m->mem, 0, (size_t)m->num * m->size);
+  }
+  m->free_head = 0;
+  m->unused = 0;
+  memset(&m->stats, 0, sizeof(m->stats));
+}
+
+/* Freed blocks are chained by the 1-based index of the next freed block stored
+ * at the start of the block. Blocks smaller than the index are not chained and
+ * are found by a scan of the reference counts. */
+static bool
+memb_can_link(const struct oc_memb *m)
+{
+  return m->size >= sizeof(unsigned short);
+}
+
+static char *
+memb_block(const struct oc_memb *m, unsigned short index)
+{
+  return (char *)m->mem + (ptrdiff_t)index * m->size;
+}
+
+static unsigned short
+memb_find_free(struct oc_memb *m)
+{
+  if (m->free_head != 0) {
+    unsigned short index = (unsigned short)(m->free_head - 1);
+    memcpy(&m->free_head, memb_block(m, index), sizeof(m->free_head));
+    return index;
+  }
+  if (m->unused < m->num) {
+    return m->unused++;
+  }
+  if (!memb_can_link(m)) {
+    for (unsigned short i = 0; i < m->num; ++i) {
+      if (m->count[i] == 0) {
+        return i;
+      }
+    }
+  }
+  return m->num;
+}
+
+static void
+memb_stats_alloc(struct oc_memb *m)
+{
+  ++m->stats.in_use;
+  if (m->stats.in_use > m->stats.max_in_use) {
+    m->stats.max_in_use = m->stats.in_use;
   }
 }
 
@@ -64,19 +112,12 @@ _oc_memb_alloc(
 
   void *ptr = NULL;
   if (m->num > 0) {
-    unsigned short i = 0;
-    for (; i < m->num; i++) {
-      if (m->count[i] == 0) {
-        /* If this block was unused, we increase the reference count to
-     indicate that it now is used and return a pointer to the
-     memory block. */
-        ++(m->count[i]);
-        break;
-      }
-    }
-
+    unsigned short i = memb_find_free(m);
     if (i < m->num) {
-      ptr = (void *)((char *)m->mem + (ptrdiff_t)(i * m->size));
+      /* The block was unused, we increase the reference count to indicate that
+       * it now is used and return a pointer to the memory block. */
+      ++(m->count[i]);
+      ptr = memb_block(m, i);
       memset(ptr, 0, m->size);
     }
   }
@@ -89,8 +130,10 @@ _oc_memb_alloc(
   if (!ptr) {
     /* No free block was found, so we return NULL to indicate failure to
        allocate block. */
+    ++m->stats.failures;
     return NULL;
   }
+  memb_stats_alloc(m);
 
 #ifdef OC_MEMORY_TRACE
   oc_mem_trace_add_pace(func, m->size, MEM_TRACE_ALLOC, ptr);
@@ -99,6 +142,29 @@ _oc_memb_alloc(
   return ptr;
 }
 
+static void
+memb_free_block(struct oc_memb *m, void *ptr)
+{
+  if (!oc_memb_inmemb(m, ptr)) {
+    return;
+  }
+  ptrdiff_t offset = (char *)ptr - (char *)m->mem;
+  if (offset % m->size != 0) {
+    return;
+  }
+  unsigned short i = (unsigned short)(offset / m->size);
+  if (m->count[i] == 0) {
+    /* Make sure that we don't deallocate free memory. */
+    return;
+  }
+  --(m->count[i]);
+  --m->stats.in_use;
+  if (memb_can_link(m)) {
+    memcpy(ptr, &m->free_head, sizeof(m->free_head));
+    m->free_head = (unsigned short)(i + 1);
+  }
+}
+
 char
 _oc_memb_free(
 #ifdef OC_MEMORY_TRACE
@@ -116,24 +182,13 @@ _oc_memb_free(
 #endif
 
   if (m->num > 0) {
-    /* Walk through the list of blocks and try to find the block to
-       which the pointer "ptr" points to. */
-    const char *ptr2 = (char *)m->mem;
-    for (int i = 0; i < m->num; ++i) {
-      if (ptr2 == (char *)ptr) {
-        /* We've found to block to which "ptr" points so we decrease the
-           reference count and return the new value of it. */
-        if (m->count[i] > 0) {
-          /* Make sure that we don't deallocate free memory. */
-          --(m->count[i]);
-        }
-        break;
-      }
-      ptr2 += m->size;
-    }
+    memb_free_block(m, ptr);
   }
 #ifdef OC_DYNAMIC_ALLOCATION
   else {
+    if (ptr != NULL && m->stats.in_use > 0) {
+      --m->stats.in_use;
+    }
     free(ptr);
   }
 #endif /* OC_DYNAMIC_ALLOCATION */
@@ -153,13 +208,23 @@ oc_memb_inmemb(const struct oc_memb *m, const void *ptr)
 int
 oc_memb_numfree(const struct oc_memb *m)
 {
-  int num_free = 0;
-  for (unsigned short i = 0; i < m->num; ++i) {
-    if (m->count[i] == 0) {
-      ++num_free;
-    }
+  if (m->num == 0) {
+    return 0;
   }
-  return num_free;
+  return (int)(m->num - m->stats.in_use);
+}
+
+oc_memb_stats_t
+oc_memb_get_stats(const struct oc_memb *m)
+{
+  return m->stats;
+}
+
+void
+oc_memb_reset_stats(struct oc_memb *m)
+{
+  m->stats.max_in_use = m->stats.in_use;
+  m->stats.failures = 0;
 }
 
 void
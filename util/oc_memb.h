@@ -52,6 +52,7 @@
 #include "util/oc_compiler.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -96,15 +97,18 @@ extern "C" {
 extern "C" {
 #endif
 #define OC_MEMB(name, structure, num)                                          \
-  static struct oc_memb name = { sizeof(structure), 0, NULL, NULL, NULL }
+  static struct oc_memb name = { sizeof(structure), 0, NULL, NULL, NULL,       \
+                                 OC_MEMB_STATE_INIT }
 #define OC_MEMB_LOCAL(name, structure, num)                                    \
-  struct oc_memb name = { sizeof(structure), 0, NULL, NULL, NULL }
+  struct oc_memb name = { sizeof(structure), 0, NULL, NULL, NULL,              \
+                          OC_MEMB_STATE_INIT }
 #define OC_MEMB_STATIC(name, structure, num)                                   \
   static char CC_CONCAT(name, _memb_count)[num];                               \
   static structure CC_CONCAT(name, _memb_mem)[num];                            \
   static struct oc_memb name = { sizeof(structure), num,                       \
                                  CC_CONCAT(name, _memb_count),                 \
-                                 (void *)CC_CONCAT(name, _memb_mem), NULL }
+                                 (void *)CC_CONCAT(name, _memb_mem), NULL,     \
+                                 OC_MEMB_STATE_INIT }
 #else /* OC_DYNAMIC_ALLOCATION */
 #ifdef __cplusplus
 }
@@ -118,7 +122,8 @@ extern "C" {
   static structure CC_CONCAT(name, _memb_mem)[num];                            \
   static struct oc_memb name = { sizeof(structure), num,                       \
                                  CC_CONCAT(name, _memb_count),                 \
-                                 (void *)CC_CONCAT(name, _memb_mem), NULL }
+                                 (void *)CC_CONCAT(name, _memb_mem), NULL,     \
+                                 OC_MEMB_STATE_INIT }
 #define OC_MEMB_LOCAL(name, structure, num)                                    \
   char CC_CONCAT(name, _memb_count)[num];                                      \
   memset(CC_CONCAT(name, _memb_count), 0, num * sizeof(char));                 \
@@ -126,13 +131,29 @@ extern "C" {
   memset(CC_CONCAT(name, _memb_mem), 0, num * sizeof(structure));              \
   struct oc_memb name = { sizeof(structure), num,                              \
                           CC_CONCAT(name, _memb_count),                        \
-                          (void *)CC_CONCAT(name, _memb_mem), NULL }
+                          (void *)CC_CONCAT(name, _memb_mem), NULL,            \
+                          OC_MEMB_STATE_INIT }
 
 // TODO: update struct oc_memb rep_objects
 #endif /* !OC_DYNAMIC_ALLOCATION */
 
 typedef void (*oc_memb_buffers_avail_callback_t)(int);
 
+/** Usage statistics of a memory block */
+typedef struct oc_memb_stats_t
+{
+  size_t in_use;     ///< number of currently allocated blocks
+  size_t max_in_use; ///< high-water mark of in_use
+  size_t failures;   ///< number of failed allocations
+} oc_memb_stats_t;
+
+/** Initializer of the allocator state and statistics of a memory block */
+#define OC_MEMB_STATE_INIT                                                     \
+  0, 0,                                                                        \
+  {                                                                            \
+    0, 0, 0                                                                    \
+  }
+
 struct oc_memb
 {
   unsigned short size;
@@ -140,10 +161,15 @@ struct oc_memb
   char *count;
   void *mem;
   oc_memb_buffers_avail_callback_t buffers_avail_cb;
+  unsigned short free_head; ///< 1-based index of the first block in the list of
+                            ///< freed blocks, 0 if the list is empty
+  unsigned short unused;    ///< blocks from this index were never allocated
+  oc_memb_stats_t stats;
 };
 
 /**
  * Initialize a memory block that was declared with MEMB().
+ * All blocks are freed and the statistics are reset.
  *
  * \param m A memory block previously declared with MEMB().
  */
@@ -220,6 +246,22 @@ bool oc_memb_inmemb(const struct oc_memb *m, const void *ptr);
 OC_API
 int oc_memb_numfree(const struct oc_memb *m);
 
+/**
+ * @brief Get the usage statistics of given memory block.
+ * @param m A memory block previously declared with MEMB().
+ * @return usage statistics of the memory block.
+ */
+OC_API
+oc_memb_stats_t oc_memb_get_stats(const struct oc_memb *m) OC_NONNULL();
+
+/**
+ * @brief Reset the failure count and set the high-water mark to the current
+ * usage of given memory block.
+ * @param m A memory block previously declared with MEMB().
+ */
+OC_API
+void oc_memb_reset_stats(struct oc_memb *m) OC_NONNULL();
+
 #ifdef __cplusplus
 }
 #endif
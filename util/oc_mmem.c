@@ -37,6 +37,7 @@
 #include "oc_mmem.h"
 #include "oc_mmem_internal.h"
 #include "port/oc_log_internal.h"
+#include "util/oc_features.h"
 
 #ifdef OC_MEMORY_TRACE
 #include "util/oc_mem_trace_internal.h"
@@ -50,6 +51,10 @@
 #include <stdlib.h>
 #endif /* OC_DYNAMIC_ALLOCATION */
 
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+#include "util/oc_tlsf_internal.h"
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
+
 #ifndef OC_DYNAMIC_ALLOCATION
 #if !defined(OC_BYTES_POOL_SIZE) || !defined(OC_INTS_POOL_SIZE) ||             \
   !defined(OC_DOUBLES_POOL_SIZE)
@@ -57,6 +62,41 @@
 #endif /* !OC_BYTES_POOL_SIZE || !OC_INTS_POOL_SIZE || !OC_DOUBLES_POOL_SIZE   \
         */
 
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+
+#define MMEM_BYTES_GRANULES OC_TLSF_GRANULES(OC_BYTES_POOL_SIZE)
+#define MMEM_INTS_GRANULES OC_TLSF_GRANULES(OC_INTS_POOL_SIZE * sizeof(int64_t))
+#define MMEM_DOUBLES_GRANULES                                                  \
+  OC_TLSF_GRANULES(OC_DOUBLES_POOL_SIZE * sizeof(double))
+
+/* ints and doubles take at most one granule */
+#if MMEM_BYTES_GRANULES > OC_TLSF_MAX_GRANULES ||                             \
+  OC_INTS_POOL_SIZE > OC_TLSF_MAX_GRANULES ||                                  \
+  OC_DOUBLES_POOL_SIZE > OC_TLSF_MAX_GRANULES
+#error "Pool size exceeds the limit of the TLSF allocator"
+#endif
+
+/* Blocks are allocated from size class free lists and are never moved, free
+ * returns the block to the lists in O(1) */
+static uint64_t g_mmem_bytes[MMEM_BYTES_GRANULES];
+static uint8_t g_mmem_bytes_boundaries[OC_TLSF_BOUNDARIES_SIZE(
+  MMEM_BYTES_GRANULES)];
+static oc_tlsf_t g_mmem_bytes_tlsf;
+
+static uint64_t g_mmem_ints[MMEM_INTS_GRANULES];
+static uint8_t g_mmem_ints_boundaries[OC_TLSF_BOUNDARIES_SIZE(
+  MMEM_INTS_GRANULES)];
+static oc_tlsf_t g_mmem_ints_tlsf;
+
+static uint64_t g_mmem_doubles[MMEM_DOUBLES_GRANULES];
+static uint8_t g_mmem_doubles_boundaries[OC_TLSF_BOUNDARIES_SIZE(
+  MMEM_DOUBLES_GRANULES)];
+static oc_tlsf_t g_mmem_doubles_tlsf;
+
+static bool g_mmem_tlsf_initialized = false;
+
+#else /* !OC_HAS_FEATURE_MMEM_TLSF */
+
 static unsigned char g_mmem_bytes[OC_BYTES_POOL_SIZE] = { 0 };
 static unsigned int g_mmem_avail_bytes = OC_BYTES_POOL_SIZE;
 OC_LIST(g_mmem_bytes_list);
@@ -68,6 +108,7 @@ OC_LIST(g_mmem_ints_list);
 static double g_mmem_doubles[OC_DOUBLES_POOL_SIZE] = { 0.0 };
 static unsigned int g_mmem_avail_doubles = OC_DOUBLES_POOL_SIZE;
 OC_LIST(g_mmem_doubles_list);
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
 #endif /* !OC_DYNAMIC_ALLOCATION */
 
 static uint8_t
@@ -84,6 +125,39 @@ memm_type_size(oc_mmem_pool_t pool_type)
   return 0;
 }
 
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+
+static void
+mmem_tlsf_init(void)
+{
+  oc_tlsf_init(&g_mmem_bytes_tlsf, g_mmem_bytes, g_mmem_bytes_boundaries,
+               MMEM_BYTES_GRANULES);
+  oc_tlsf_init(&g_mmem_ints_tlsf, g_mmem_ints, g_mmem_ints_boundaries,
+               MMEM_INTS_GRANULES);
+  oc_tlsf_init(&g_mmem_doubles_tlsf, g_mmem_doubles, g_mmem_doubles_boundaries,
+               MMEM_DOUBLES_GRANULES);
+  g_mmem_tlsf_initialized = true;
+}
+
+static oc_tlsf_t *
+mmem_tlsf(oc_mmem_pool_t pool_type)
+{
+  if (!g_mmem_tlsf_initialized) {
+    mmem_tlsf_init();
+  }
+  switch (pool_type) {
+  case BYTE_POOL:
+    return &g_mmem_bytes_tlsf;
+  case INT_POOL:
+    return &g_mmem_ints_tlsf;
+  case DOUBLE_POOL:
+    return &g_mmem_doubles_tlsf;
+  }
+  return NULL;
+}
+
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
+
 size_t
 _oc_mmem_alloc(
 #ifdef OC_MEMORY_TRACE
@@ -101,7 +175,17 @@ _oc_mmem_alloc(
 #ifdef OC_DYNAMIC_ALLOCATION
   m->ptr = malloc(size * type_size);
   m->size = size;
-#else  /* !OC_DYNAMIC_ALLOCATION */
+#elif defined(OC_HAS_FEATURE_MMEM_TLSF)
+  oc_tlsf_t *tlsf = mmem_tlsf(pool_type);
+  void *ptr = tlsf != NULL ? oc_tlsf_alloc(tlsf, bytes_allocated) : NULL;
+  if (ptr == NULL) {
+    OC_WRN("pool %d exhausted", (int)pool_type);
+    return 0;
+  }
+  m->next = NULL;
+  m->ptr = ptr;
+  m->size = size;
+#else  /* !OC_DYNAMIC_ALLOCATION && !OC_HAS_FEATURE_MMEM_TLSF */
   switch (pool_type) {
   case BYTE_POOL:
     if (g_mmem_avail_bytes < size) {
@@ -164,7 +248,14 @@ _oc_mmem_free(
   oc_mem_trace_add_pace(func, bytes_freed, MEM_TRACE_FREE, m->ptr);
 #endif /* OC_MEMORY_TRACE */
 
-#ifndef OC_DYNAMIC_ALLOCATION
+#if defined(OC_HAS_FEATURE_MMEM_TLSF)
+  oc_tlsf_t *tlsf = mmem_tlsf(pool_type);
+  if (tlsf != NULL && m->ptr != NULL) {
+    oc_tlsf_free(tlsf, m->ptr, m->size * type_size);
+  }
+  m->ptr = NULL;
+  m->size = 0;
+#elif !defined(OC_DYNAMIC_ALLOCATION)
   struct oc_mmem *n;
 
   if (m->next != NULL) {
@@ -231,6 +322,13 @@ _oc_mmem_free(
 size_t
 oc_mmem_available_size(oc_mmem_pool_t pool_type)
 {
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+  const oc_tlsf_t *tlsf = mmem_tlsf(pool_type);
+  if (tlsf == NULL) {
+    return 0;
+  }
+  return oc_tlsf_free_size(tlsf) / memm_type_size(pool_type);
+#else  /* !OC_HAS_FEATURE_MMEM_TLSF */
   if (pool_type == BYTE_POOL) {
     return g_mmem_avail_bytes;
   }
@@ -241,6 +339,7 @@ oc_mmem_available_size(oc_mmem_pool_t pool_type)
     return g_mmem_avail_doubles;
   }
   return 0;
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
 }
 
 #endif /* !OC_DYNAMIC_ALLOCATION */
@@ -253,12 +352,16 @@ oc_mmem_init(void)
   if (initialized) {
     return;
   }
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+  mmem_tlsf_init();
+#else  /* !OC_HAS_FEATURE_MMEM_TLSF */
   oc_list_init(g_mmem_bytes_list);
   oc_list_init(g_mmem_ints_list);
   oc_list_init(g_mmem_doubles_list);
   g_mmem_avail_bytes = OC_BYTES_POOL_SIZE;
   g_mmem_avail_ints = OC_INTS_POOL_SIZE;
   g_mmem_avail_doubles = OC_DOUBLES_POOL_SIZE;
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
   initialized = true;
 #endif /* OC_DYNAMIC_ALLOCATION */
 }
@@ -0,0 +1,134 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_mpsc_queue_internal.h"
+
+/*
+ * The sequence of the slot of position pos is relative to the first position
+ * of the slot (pos & mask), so zero-initialized slots are free:
+ *  - pos - (pos & mask), the slot is free for the producer of position pos
+ *  - pos - (pos & mask) + 1, the slot holds the item of position pos
+ * The consumer frees the slot for the producer of position pos + capacity.
+ */
+
+static uint32_t
+mpsc_queue_round(const oc_mpsc_queue_t *queue, uint32_t pos)
+{
+  return pos - (pos & queue->mask);
+}
+
+bool
+oc_mpsc_queue_push(oc_mpsc_queue_t *queue, void *item)
+{
+  uint32_t pos = OC_ATOMIC_LOAD32(queue->enqueue_pos);
+  for (;;) {
+    oc_mpsc_queue_slot_t *slot = &queue->slots[pos & queue->mask];
+    uint32_t sequence = OC_ATOMIC_LOAD32(slot->sequence);
+    int32_t diff = (int32_t)(sequence - mpsc_queue_round(queue, pos));
+    if (diff == 0) {
+      bool claimed = false;
+      OC_ATOMIC_COMPARE_AND_SWAP32(queue->enqueue_pos, pos, pos + 1, claimed);
+      if (claimed) {
+        slot->item = item;
+        // publish the item to the consumer
+        OC_ATOMIC_STORE32(slot->sequence, mpsc_queue_round(queue, pos) + 1);
+        return true;
+      }
+      // pos was updated to the current enqueue position
+      continue;
+    }
+    if (diff < 0) {
+      // the slot still holds the item of the previous round
+      return false;
+    }
+    // another producer claimed the position
+    pos = OC_ATOMIC_LOAD32(queue->enqueue_pos);
+  }
+}
+
+static oc_mpsc_queue_slot_t *
+mpsc_queue_published_slot(const oc_mpsc_queue_t *queue, uint32_t pos)
+{
+  oc_mpsc_queue_slot_t *slot = &queue->slots[pos & queue->mask];
+  if (OC_ATOMIC_LOAD32(slot->sequence) != mpsc_queue_round(queue, pos) + 1) {
+    return NULL;
+  }
+  return slot;
+}
+
+void *
+oc_mpsc_queue_pop(oc_mpsc_queue_t *queue)
+{
+  for (;;) {
+    uint32_t pos = queue->dequeue_pos;
+    oc_mpsc_queue_slot_t *slot = mpsc_queue_published_slot(queue, pos);
+    if (slot == NULL) {
+      return NULL;
+    }
+    void *item = slot->item;
+    slot->item = NULL;
+    OC_ATOMIC_STORE32(slot->sequence,
+                      mpsc_queue_round(queue, pos) + queue->mask + 1);
+    queue->dequeue_pos = pos + 1;
+    // removed items leave empty slots
+    if (item != NULL) {
+      return item;
+    }
+  }
+}
+
+void *
+oc_mpsc_queue_pop_wait(oc_mpsc_queue_t *queue)
+{
+  while (queue->dequeue_pos != OC_ATOMIC_LOAD32(queue->enqueue_pos)) {
+    // the producer of the oldest item has claimed its slot, so it is about to
+    // publish the item
+    void *item = oc_mpsc_queue_pop(queue);
+    if (item != NULL) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+uint32_t
+oc_mpsc_queue_size(const oc_mpsc_queue_t *queue)
+{
+  return OC_ATOMIC_LOAD32(queue->enqueue_pos) - queue->dequeue_pos;
+}
+
+int
+oc_mpsc_queue_remove_if(oc_mpsc_queue_t *queue,
+                        oc_mpsc_queue_remove_filter_fn_t filter,
+                        const void *data)
+{
+  int removed = 0;
+  uint32_t end = OC_ATOMIC_LOAD32(queue->enqueue_pos);
+  for (uint32_t pos = queue->dequeue_pos; pos != end; ++pos) {
+    oc_mpsc_queue_slot_t *slot = mpsc_queue_published_slot(queue, pos);
+    if (slot == NULL || slot->item == NULL) {
+      continue;
+    }
+    if (filter(slot->item, data)) {
+      // the slot stays owned by the consumer until it is popped
+      slot->item = NULL;
+      ++removed;
+    }
+  }
+  return removed;
+}
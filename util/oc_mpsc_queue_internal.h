@@ -0,0 +1,130 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef OC_MPSC_QUEUE_INTERNAL_H
+#define OC_MPSC_QUEUE_INTERNAL_H
+
+#include "util/oc_atomic.h"
+#include "util/oc_compiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bounded lock-free queue of pointers with multiple producers and a
+ * single consumer.
+ *
+ * The queue is a ring of slots. Each slot carries a sequence number telling
+ * whether it is free for the producer of a position or holds an item for the
+ * consumer, so producers only contend on the enqueue position and the consumer
+ * never writes to shared state other than the sequence of the dequeued slot.
+ *
+ * Items pushed by a single thread are popped in the order they were pushed.
+ */
+typedef struct oc_mpsc_queue_slot_t
+{
+  OC_ATOMIC_UINT32_T sequence;
+  void *item;
+} oc_mpsc_queue_slot_t;
+
+typedef struct oc_mpsc_queue_t
+{
+  oc_mpsc_queue_slot_t *slots;
+  uint32_t mask;                  ///< number of slots - 1
+  OC_ATOMIC_UINT32_T enqueue_pos; ///< next position of the producers
+  uint32_t dequeue_pos;           ///< next position of the consumer
+} oc_mpsc_queue_t;
+
+/**
+ * @brief Define an empty queue, the zero-initialized slots need no further
+ * initialization.
+ *
+ * @param name name of the queue
+ * @param capacity number of slots, must be a power of two
+ */
+#define OC_MPSC_QUEUE(name, capacity)                                          \
+  OC_STATIC_ASSERT((capacity) > 0 && ((capacity) & ((capacity)-1)) == 0,       \
+                   "capacity of " #name " must be a power of two");            \
+  static oc_mpsc_queue_slot_t name##_slots[capacity];                          \
+  static oc_mpsc_queue_t name = { name##_slots, (capacity)-1, 0, 0 }
+
+/**
+ * @brief Add an item to the queue, can be called by any thread.
+ *
+ * @param queue the queue (cannot be NULL)
+ * @param item the item (cannot be NULL)
+ * @return true the item was added
+ * @return false the queue is full
+ */
+bool oc_mpsc_queue_push(oc_mpsc_queue_t *queue, void *item) OC_NONNULL();
+
+/**
+ * @brief Remove the oldest item from the queue, must be called only by the
+ * consumer.
+ *
+ * @param queue the queue (cannot be NULL)
+ * @return the item
+ * @return NULL the queue is empty or the oldest item is still being pushed
+ */
+void *oc_mpsc_queue_pop(oc_mpsc_queue_t *queue) OC_NONNULL();
+
+/**
+ * @brief Remove the oldest item from the queue, must be called only by the
+ * consumer. Waits until an item which is still being pushed is added.
+ *
+ * @param queue the queue (cannot be NULL)
+ * @return the item
+ * @return NULL the queue is empty
+ */
+void *oc_mpsc_queue_pop_wait(oc_mpsc_queue_t *queue) OC_NONNULL();
+
+/**
+ * @brief Get the number of items in the queue, including items which are
+ * still being pushed.
+ */
+uint32_t oc_mpsc_queue_size(const oc_mpsc_queue_t *queue) OC_NONNULL();
+
+/**
+ * @brief Function selecting items removed by oc_mpsc_queue_remove_if, the
+ * function takes the ownership of a removed item.
+ */
+typedef bool (*oc_mpsc_queue_remove_filter_fn_t)(void *item, const void *data);
+
+/**
+ * @brief Remove the items selected by the filter, must be called only by the
+ * consumer. Items which are still being pushed are skipped.
+ *
+ * @param queue the queue (cannot be NULL)
+ * @param filter function selecting the items to remove (cannot be NULL)
+ * @param data user data passed to the filter
+ * @return number of removed items
+ */
+int oc_mpsc_queue_remove_if(oc_mpsc_queue_t *queue,
+                            oc_mpsc_queue_remove_filter_fn_t filter,
+                            const void *data) OC_NONNULL(1, 2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_MPSC_QUEUE_INTERNAL_H */
@@ -362,6 +362,17 @@ oc_process_nevents(void)
   return (int)g_nevents + OC_ATOMIC_LOAD8(g_poll_requested);
 }
 
+bool
+oc_process_is_event_queue_full(void)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  // the queue grows
+  return false;
+#else  /* !OC_DYNAMIC_ALLOCATION */
+  return g_nevents == OC_PROCESS_NUMEVENTS;
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
 bool
 oc_process_needs_poll(void)
 {
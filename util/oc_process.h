@@ -541,6 +541,13 @@ int oc_process_is_running(const struct oc_process *p);
  */
 int oc_process_nevents(void);
 
+/**
+ *  Check if the event queue is full.
+ *
+ * \return True if an event cannot be posted until an event is processed.
+ */
+bool oc_process_is_event_queue_full(void);
+
 /**
  *  Check if processes need to be polled.
  *
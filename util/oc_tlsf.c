@@ -0,0 +1,307 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include "port/oc_log_internal.h"
+#include "util/oc_tlsf_internal.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/* A free block stores its size and the 1-based indexes of its neighbours in
+ * the class list in the first granule, and its size again in the last two
+ * bytes of the last granule, so the start of a free block preceding a freed
+ * block can be found. */
+enum {
+  TLSF_SIZE_OFFSET = 0,
+  TLSF_NEXT_OFFSET = 2,
+  TLSF_PREV_OFFSET = 4,
+  TLSF_FOOTER_OFFSET = OC_TLSF_GRANULE_SIZE - 2,
+};
+
+typedef struct
+{
+  unsigned fl;
+  unsigned sl;
+} tlsf_class_t;
+
+/* index of the most significant set bit, value must not be 0 */
+static unsigned
+tlsf_fls(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return 31U - (unsigned)__builtin_clz(value);
+#else  /* !__GNUC__ && !__clang__ */
+  unsigned bit = 0;
+  while (value >>= 1) {
+    ++bit;
+  }
+  return bit;
+#endif /* __GNUC__ || __clang__ */
+}
+
+/* index of the least significant set bit, value must not be 0 */
+static unsigned
+tlsf_ffs(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned)__builtin_ctz(value);
+#else  /* !__GNUC__ && !__clang__ */
+  unsigned bit = 0;
+  while ((value & 1) == 0) {
+    value >>= 1;
+    ++bit;
+  }
+  return bit;
+#endif /* __GNUC__ || __clang__ */
+}
+
+static tlsf_class_t
+tlsf_class(uint32_t granules)
+{
+  tlsf_class_t c;
+  if (granules < OC_TLSF_SL_COUNT) {
+    c.fl = 0;
+    c.sl = granules;
+    return c;
+  }
+  unsigned log2 = tlsf_fls(granules);
+  c.fl = log2 - OC_TLSF_SL_LOG2 + 1;
+  c.sl = (granules >> (log2 - OC_TLSF_SL_LOG2)) & (OC_TLSF_SL_COUNT - 1);
+  return c;
+}
+
+static uint16_t
+tlsf_get(const oc_tlsf_t *tlsf, uint16_t granule, size_t offset)
+{
+  uint16_t value;
+  memcpy(&value, tlsf->buffer + (size_t)granule * OC_TLSF_GRANULE_SIZE + offset,
+         sizeof(value));
+  return value;
+}
+
+static void
+tlsf_set(oc_tlsf_t *tlsf, uint16_t granule, size_t offset, uint16_t value)
+{
+  memcpy(tlsf->buffer + (size_t)granule * OC_TLSF_GRANULE_SIZE + offset,
+         &value, sizeof(value));
+}
+
+static bool
+tlsf_is_boundary(const oc_tlsf_t *tlsf, uint16_t granule)
+{
+  return (tlsf->boundaries[granule / 8] & (1U << (granule % 8))) != 0;
+}
+
+static void
+tlsf_set_boundary(oc_tlsf_t *tlsf, uint16_t granule, bool set)
+{
+  if (set) {
+    tlsf->boundaries[granule / 8] |= (uint8_t)(1U << (granule % 8));
+  } else {
+    tlsf->boundaries[granule / 8] &= (uint8_t)~(1U << (granule % 8));
+  }
+}
+
+static void
+tlsf_insert(oc_tlsf_t *tlsf, uint16_t block, uint16_t size)
+{
+  tlsf_class_t c = tlsf_class(size);
+  uint16_t head = tlsf->heads[c.fl][c.sl];
+  tlsf_set(tlsf, block, TLSF_SIZE_OFFSET, size);
+  tlsf_set(tlsf, block, TLSF_NEXT_OFFSET, head);
+  tlsf_set(tlsf, block, TLSF_PREV_OFFSET, 0);
+  tlsf_set(tlsf, (uint16_t)(block + size - 1), TLSF_FOOTER_OFFSET, size);
+  if (head != 0) {
+    tlsf_set(tlsf, (uint16_t)(head - 1), TLSF_PREV_OFFSET,
+             (uint16_t)(block + 1));
+  }
+  tlsf->heads[c.fl][c.sl] = (uint16_t)(block + 1);
+  tlsf->sl_bitmap[c.fl] |= (uint8_t)(1U << c.sl);
+  tlsf->fl_bitmap |= (uint16_t)(1U << c.fl);
+  tlsf_set_boundary(tlsf, block, true);
+  tlsf_set_boundary(tlsf, (uint16_t)(block + size - 1), true);
+}
+
+static void
+tlsf_remove(oc_tlsf_t *tlsf, uint16_t block, uint16_t size)
+{
+  tlsf_class_t c = tlsf_class(size);
+  uint16_t next = tlsf_get(tlsf, block, TLSF_NEXT_OFFSET);
+  uint16_t prev = tlsf_get(tlsf, block, TLSF_PREV_OFFSET);
+  if (next != 0) {
+    tlsf_set(tlsf, (uint16_t)(next - 1), TLSF_PREV_OFFSET, prev);
+  }
+  if (prev != 0) {
+    tlsf_set(tlsf, (uint16_t)(prev - 1), TLSF_NEXT_OFFSET, next);
+  } else {
+    tlsf->heads[c.fl][c.sl] = next;
+    if (next == 0) {
+      tlsf->sl_bitmap[c.fl] &= (uint8_t)~(1U << c.sl);
+      if (tlsf->sl_bitmap[c.fl] == 0) {
+        tlsf->fl_bitmap &= (uint16_t)~(1U << c.fl);
+      }
+    }
+  }
+  tlsf_set_boundary(tlsf, block, false);
+  tlsf_set_boundary(tlsf, (uint16_t)(block + size - 1), false);
+}
+
+void
+oc_tlsf_init(oc_tlsf_t *tlsf, void *buffer, uint8_t *boundaries,
+             size_t granules)
+{
+  memset(tlsf, 0, sizeof(*tlsf));
+  if (granules > OC_TLSF_MAX_GRANULES) {
+    OC_WRN("tlsf: buffer of %zu granules truncated to %d", granules,
+           OC_TLSF_MAX_GRANULES);
+    granules = OC_TLSF_MAX_GRANULES;
+  }
+  tlsf->buffer = (uint8_t *)buffer;
+  tlsf->boundaries = boundaries;
+  tlsf->capacity = (uint16_t)granules;
+  memset(boundaries, 0, OC_TLSF_BOUNDARIES_SIZE(granules));
+  if (granules > 0) {
+    tlsf_insert(tlsf, 0, tlsf->capacity);
+    tlsf->free = tlsf->capacity;
+  }
+}
+
+static uint32_t
+tlsf_granules(size_t size)
+{
+  if (size == 0) {
+    return 1;
+  }
+  size_t granules = OC_TLSF_GRANULES(size);
+  return granules > OC_TLSF_MAX_GRANULES ? OC_TLSF_MAX_GRANULES + 1
+                                         : (uint32_t)granules;
+}
+
+/* First block of the smallest non-empty class in which all blocks have at
+ * least given size, 0 if there is none */
+static uint16_t
+tlsf_find_fit(const oc_tlsf_t *tlsf, uint32_t granules)
+{
+  if (granules >= OC_TLSF_SL_COUNT) {
+    // round up to the next class
+    granules += (1U << (tlsf_fls(granules) - OC_TLSF_SL_LOG2)) - 1;
+  }
+  tlsf_class_t c = tlsf_class(granules);
+  if (c.fl >= OC_TLSF_FL_COUNT) {
+    return 0;
+  }
+  uint32_t sl_map = tlsf->sl_bitmap[c.fl] & (~0U << c.sl);
+  if (sl_map == 0) {
+    uint32_t fl_map = tlsf->fl_bitmap & (~0U << (c.fl + 1));
+    if (fl_map == 0) {
+      return 0;
+    }
+    c.fl = tlsf_ffs(fl_map);
+    sl_map = tlsf->sl_bitmap[c.fl];
+  }
+  c.sl = tlsf_ffs(sl_map);
+  return tlsf->heads[c.fl][c.sl];
+}
+
+/* Free block of at least given size */
+static uint16_t
+tlsf_find(const oc_tlsf_t *tlsf, uint32_t granules)
+{
+  uint16_t head = tlsf_find_fit(tlsf, granules);
+  if (head != 0) {
+    return head;
+  }
+  // the class of the size may contain a large enough block, this makes the
+  // allocation of the last free block possible
+  tlsf_class_t c = tlsf_class(granules);
+  if (c.fl >= OC_TLSF_FL_COUNT) {
+    return 0;
+  }
+  for (head = tlsf->heads[c.fl][c.sl]; head != 0;
+       head = tlsf_get(tlsf, (uint16_t)(head - 1), TLSF_NEXT_OFFSET)) {
+    if (tlsf_get(tlsf, (uint16_t)(head - 1), TLSF_SIZE_OFFSET) >= granules) {
+      return head;
+    }
+  }
+  return 0;
+}
+
+void *
+oc_tlsf_alloc(oc_tlsf_t *tlsf, size_t size)
+{
+  uint32_t granules = tlsf_granules(size);
+  if (granules > tlsf->free) {
+    return NULL;
+  }
+  uint16_t head = tlsf_find(tlsf, granules);
+  if (head == 0) {
+    return NULL;
+  }
+  uint16_t block = (uint16_t)(head - 1);
+  uint16_t block_size = tlsf_get(tlsf, block, TLSF_SIZE_OFFSET);
+  tlsf_remove(tlsf, block, block_size);
+  if (block_size > granules) {
+    tlsf_insert(tlsf, (uint16_t)(block + granules),
+                (uint16_t)(block_size - granules));
+  }
+  tlsf->free = (uint16_t)(tlsf->free - granules);
+  return tlsf->buffer + (size_t)block * OC_TLSF_GRANULE_SIZE;
+}
+
+void
+oc_tlsf_free(oc_tlsf_t *tlsf, void *ptr, size_t size)
+{
+  const uint8_t *p = (const uint8_t *)ptr;
+  size_t offset = (size_t)(p - tlsf->buffer);
+  if (p < tlsf->buffer || offset % OC_TLSF_GRANULE_SIZE != 0 ||
+      offset / OC_TLSF_GRANULE_SIZE >= tlsf->capacity) {
+    OC_ERR("tlsf: invalid pointer");
+    return;
+  }
+  uint16_t block = (uint16_t)(offset / OC_TLSF_GRANULE_SIZE);
+  uint32_t granules = tlsf_granules(size);
+  if (block + granules > tlsf->capacity || tlsf_is_boundary(tlsf, block)) {
+    OC_ERR("tlsf: invalid block");
+    return;
+  }
+  tlsf->free = (uint16_t)(tlsf->free + granules);
+
+  // merge with the adjacent free blocks
+  uint16_t start = block;
+  uint32_t merged = granules;
+  if (block > 0 && tlsf_is_boundary(tlsf, (uint16_t)(block - 1))) {
+    uint16_t prev_size =
+      tlsf_get(tlsf, (uint16_t)(block - 1), TLSF_FOOTER_OFFSET);
+    start = (uint16_t)(block - prev_size);
+    tlsf_remove(tlsf, start, prev_size);
+    merged += prev_size;
+  }
+  uint32_t end = block + granules;
+  if (end < tlsf->capacity && tlsf_is_boundary(tlsf, (uint16_t)end)) {
+    uint16_t next_size = tlsf_get(tlsf, (uint16_t)end, TLSF_SIZE_OFFSET);
+    tlsf_remove(tlsf, (uint16_t)end, next_size);
+    merged += next_size;
+  }
+  tlsf_insert(tlsf, start, (uint16_t)merged);
+}
+
+size_t
+oc_tlsf_free_size(const oc_tlsf_t *tlsf)
+{
+  return (size_t)tlsf->free * OC_TLSF_GRANULE_SIZE;
+}
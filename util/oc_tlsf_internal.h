@@ -0,0 +1,114 @@
+/******************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#ifndef OC_TLSF_INTERNAL_H
+#define OC_TLSF_INTERNAL_H
+
+#include "util/oc_compiler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Two-level segregated fit allocator over a fixed buffer.
+ *
+ * The buffer is split to granules of OC_TLSF_GRANULE_SIZE bytes and an
+ * allocation takes a whole number of granules. Free blocks are kept in lists
+ * by size classes, so allocation and free (including the merge with the
+ * adjacent free blocks) are O(1). Only when no class of larger blocks has a
+ * free block, the list of the class of the requested size is searched. No
+ * header is stored in the allocated blocks, the caller must pass the allocated
+ * size to oc_tlsf_free.
+ */
+
+/** Size of the allocation unit, the buffer must be aligned to it */
+#define OC_TLSF_GRANULE_SIZE (8)
+
+/** Maximal number of granules in a buffer */
+#define OC_TLSF_MAX_GRANULES (UINT16_MAX)
+
+/** Number of granules needed to store given number of bytes */
+#define OC_TLSF_GRANULES(size)                                                 \
+  (((size) + OC_TLSF_GRANULE_SIZE - 1) / OC_TLSF_GRANULE_SIZE)
+
+/** Size of the bitmap of block boundaries for given number of granules */
+#define OC_TLSF_BOUNDARIES_SIZE(granules) (((granules) + 7) / 8)
+
+#define OC_TLSF_SL_LOG2 (2)
+#define OC_TLSF_SL_COUNT (1 << OC_TLSF_SL_LOG2)
+#define OC_TLSF_FL_COUNT (15)
+
+typedef struct oc_tlsf_t
+{
+  uint8_t *buffer;     ///< granules
+  uint8_t *boundaries; ///< bit is set for the first and the last granule of
+                       ///< each free block
+  uint16_t capacity;   ///< number of granules
+  uint16_t free;       ///< number of free granules
+  uint16_t fl_bitmap;  ///< first level classes with a free block
+  uint8_t sl_bitmap[OC_TLSF_FL_COUNT]; ///< second level classes with a free
+                                       ///< block
+  uint16_t heads[OC_TLSF_FL_COUNT]
+                [OC_TLSF_SL_COUNT]; ///< 1-based index of the first free block
+                                    ///< of each class, 0 if the class is empty
+} oc_tlsf_t;
+
+/**
+ * @brief Initialize the allocator, the whole buffer is free.
+ *
+ * @param tlsf allocator to initialize (cannot be NULL)
+ * @param buffer buffer of granules aligned to OC_TLSF_GRANULE_SIZE (cannot be
+ * NULL)
+ * @param boundaries bitmap of OC_TLSF_BOUNDARIES_SIZE(granules) bytes (cannot
+ * be NULL)
+ * @param granules number of granules in the buffer, at most
+ * OC_TLSF_MAX_GRANULES
+ */
+void oc_tlsf_init(oc_tlsf_t *tlsf, void *buffer, uint8_t *boundaries,
+                  size_t granules) OC_NONNULL();
+
+/**
+ * @brief Allocate a block.
+ *
+ * @param tlsf allocator (cannot be NULL)
+ * @param size size of the block in bytes, a zero size takes one granule
+ * @return pointer to the block, NULL if there is no free block large enough
+ */
+void *oc_tlsf_alloc(oc_tlsf_t *tlsf, size_t size) OC_NONNULL();
+
+/**
+ * @brief Free a block.
+ *
+ * @param tlsf allocator (cannot be NULL)
+ * @param ptr pointer returned by oc_tlsf_alloc (cannot be NULL)
+ * @param size size passed to oc_tlsf_alloc
+ */
+void oc_tlsf_free(oc_tlsf_t *tlsf, void *ptr, size_t size) OC_NONNULL();
+
+/** @brief Number of free bytes */
+size_t oc_tlsf_free_size(const oc_tlsf_t *tlsf) OC_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_TLSF_INTERNAL_H */
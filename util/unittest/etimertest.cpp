@@ -25,6 +25,7 @@
 #include "util/oc_process.h"
 #include "util/oc_process_internal.h"
 
+#include "tests/gtest/Benchmark.h"
 #include "tests/gtest/Clock.h"
 
 #include <chrono>
@@ -32,6 +33,7 @@
 #include <gtest/gtest.h>
 #include <inttypes.h>
 #include <memory>
+#include <string>
 #include <vector>
 
 OC_PROCESS(oc_test_process_1, "Testing process 1");
@@ -387,3 +389,39 @@ TEST_F(TestEventTimer, Adjust)
 
   oc_etimer_stop(&et);
 }
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+/** arming, peeking at the next expiration and cancelling of a timer must not
+ * degrade with the number of armed timers */
+TEST_F(TestEventTimer, Benchmark)
+{
+  constexpr size_t kTimers = 100000;
+  std::vector<oc_etimer> timers(kTimers);
+  oc_clock_time_t interval = oc::DurationToTicks(1h);
+
+  OC_PROCESS_CONTEXT_BEGIN(&oc_test_process_1)
+  oc::Benchmark("arm " + std::to_string(kTimers) + " timers", kTimers,
+                [&timers, interval](size_t i) {
+                  oc_etimer_set(&timers[i], interval + i % 1000);
+                });
+  OC_PROCESS_CONTEXT_END(&oc_test_process_1)
+  ASSERT_TRUE(oc_etimer_pending());
+
+  oc_clock_time_t next = 0;
+  oc::Benchmark("next expiration of " + std::to_string(kTimers) + " timers",
+                kTimers, [&next](size_t) {
+                  next = oc_etimer_next_expiration_time();
+                  ASSERT_NE(0, next);
+                });
+  EXPECT_EQ(oc_etimer_expiration_time(&timers[0]), next);
+
+  // cancel in arbitrary order
+  oc::Benchmark("cancel " + std::to_string(kTimers) + " timers", kTimers,
+                [&timers](size_t i) {
+                  oc_etimer_stop(&timers[(i * 7919) % kTimers]);
+                });
+  EXPECT_FALSE(oc_etimer_pending());
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
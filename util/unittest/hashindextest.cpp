@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "oc_config.h"
+#include "util/oc_hash_index_internal.h"
+
+#include <array>
+#include <gtest/gtest.h>
+#include <vector>
+
+struct TestHashIndexItem
+{
+  int key;
+  int value;
+};
+
+class TestHashIndex : public testing::Test {
+public:
+  static bool matchKey(const void *item, const void *key)
+  {
+    return static_cast<const TestHashIndexItem *>(item)->key ==
+           *static_cast<const int *>(key);
+  }
+
+  static TestHashIndexItem *find(const oc_hash_index_t *index, uint32_t hash,
+                                 int key)
+  {
+    return static_cast<TestHashIndexItem *>(
+      oc_hash_index_find(index, hash, matchKey, &key));
+  }
+};
+
+TEST_F(TestHashIndex, StaticInsertFindRemove)
+{
+  oc_hash_index_entry_t storage[8]{};
+  oc_hash_index_t index = OC_HASH_INDEX_STATIC_INIT(storage);
+  EXPECT_EQ(nullptr, find(&index, 1, 1));
+
+  std::array<TestHashIndexItem, 7> items{};
+  for (size_t i = 0; i < items.size(); ++i) {
+    items[i].key = static_cast<int>(i);
+    // all items share two probe sequences
+    ASSERT_TRUE(oc_hash_index_insert(&index, static_cast<uint32_t>(i % 2),
+                                     &items[i]));
+  }
+  EXPECT_EQ(items.size(), oc_hash_index_count(&index));
+  // one slot must stay empty
+  TestHashIndexItem full{};
+  EXPECT_FALSE(oc_hash_index_insert(&index, 0, &full));
+
+  for (size_t i = 0; i < items.size(); ++i) {
+    EXPECT_EQ(&items[i], find(&index, static_cast<uint32_t>(i % 2),
+                              static_cast<int>(i)));
+  }
+  // wrong hash
+  EXPECT_EQ(nullptr, find(&index, 1, 0));
+
+  // removal shifts the following items back, they must stay reachable
+  EXPECT_TRUE(oc_hash_index_remove(&index, 0, &items[0]));
+  EXPECT_FALSE(oc_hash_index_remove(&index, 0, &items[0]));
+  EXPECT_TRUE(oc_hash_index_remove(&index, 1, &items[3]));
+  EXPECT_EQ(items.size() - 2, oc_hash_index_count(&index));
+  EXPECT_EQ(nullptr, find(&index, 0, 0));
+  EXPECT_EQ(nullptr, find(&index, 1, 3));
+  for (size_t i : { 1, 2, 4, 5, 6 }) {
+    EXPECT_EQ(&items[i], find(&index, static_cast<uint32_t>(i % 2),
+                              static_cast<int>(i)));
+  }
+
+  oc_hash_index_deinit(&index);
+  EXPECT_EQ(0, oc_hash_index_count(&index));
+  EXPECT_EQ(nullptr, find(&index, 1, 1));
+  // static storage is reusable after deinit
+  EXPECT_TRUE(oc_hash_index_insert(&index, 1, &items[1]));
+  EXPECT_EQ(&items[1], find(&index, 1, 1));
+}
+
+TEST_F(TestHashIndex, EqualKeysInInsertionOrder)
+{
+  oc_hash_index_entry_t storage[8]{};
+  oc_hash_index_t index = OC_HASH_INDEX_STATIC_INIT(storage);
+
+  std::array<TestHashIndexItem, 3> items{};
+  for (size_t i = 0; i < items.size(); ++i) {
+    items[i].key = 42;
+    items[i].value = static_cast<int>(i);
+    // start at the end of the table to wrap the probe sequence
+    ASSERT_TRUE(oc_hash_index_insert(&index, 7, &items[i]));
+  }
+  for (const auto &item : items) {
+    TestHashIndexItem *found = find(&index, 7, 42);
+    ASSERT_NE(nullptr, found);
+    EXPECT_EQ(item.value, found->value);
+    EXPECT_TRUE(oc_hash_index_remove(&index, 7, found));
+  }
+  EXPECT_EQ(0, oc_hash_index_count(&index));
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+TEST_F(TestHashIndex, Grow)
+{
+  oc_hash_index_t index{};
+  constexpr int kCount = 1000;
+  std::vector<TestHashIndexItem> items(kCount);
+  for (int i = 0; i < kCount; ++i) {
+    items[i].key = i;
+    // few distinct hashes to create long probe sequences
+    ASSERT_TRUE(
+      oc_hash_index_insert(&index, static_cast<uint32_t>(i % 10), &items[i]));
+  }
+  EXPECT_EQ(kCount, oc_hash_index_count(&index));
+  EXPECT_LE(kCount * 4, index.capacity * 3);
+
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_EQ(&items[i], find(&index, static_cast<uint32_t>(i % 10), i));
+  }
+  for (int i = 0; i < kCount; i += 2) {
+    EXPECT_TRUE(
+      oc_hash_index_remove(&index, static_cast<uint32_t>(i % 10), &items[i]));
+  }
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_EQ(i % 2 == 0 ? nullptr : &items[i],
+              find(&index, static_cast<uint32_t>(i % 10), i));
+  }
+
+  oc_hash_index_deinit(&index);
+  EXPECT_EQ(0, oc_hash_index_count(&index));
+  EXPECT_EQ(nullptr, index.entries);
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
@@ -0,0 +1,178 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_heap_internal.h"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+struct TestHeapItem
+{
+  int key;
+  oc_heap_node_t node;
+};
+
+class TestHeap : public testing::Test {
+public:
+  static TestHeapItem *item(const oc_heap_node_t *node)
+  {
+    return OC_HEAP_ENTRY(node, TestHeapItem, node);
+  }
+
+  static bool less(const oc_heap_node_t *a, const oc_heap_node_t *b)
+  {
+    return item(a)->key < item(b)->key;
+  }
+
+  static std::vector<int> popAll(oc_heap_t *heap)
+  {
+    std::vector<int> keys{};
+    for (oc_heap_node_t *node = oc_heap_pop(heap); node != nullptr;
+         node = oc_heap_pop(heap)) {
+      keys.push_back(item(node)->key);
+    }
+    return keys;
+  }
+
+  static std::vector<TestHeapItem> makeItems(size_t count)
+  {
+    std::vector<TestHeapItem> items(count);
+    std::vector<int> keys(count);
+    for (size_t i = 0; i < count; ++i) {
+      keys[i] = static_cast<int>(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937{ 42 });
+    for (size_t i = 0; i < count; ++i) {
+      items[i].key = keys[i];
+    }
+    return items;
+  }
+};
+
+TEST_F(TestHeap, Empty)
+{
+  oc_heap_t heap = OC_HEAP_INIT(less);
+  EXPECT_EQ(nullptr, oc_heap_top(&heap));
+  EXPECT_EQ(nullptr, oc_heap_pop(&heap));
+
+  TestHeapItem it{};
+  EXPECT_FALSE(oc_heap_contains(&heap, &it.node));
+  // removal of a node which is not in the heap is a no-op
+  oc_heap_remove(&heap, &it.node);
+  EXPECT_EQ(nullptr, oc_heap_top(&heap));
+}
+
+TEST_F(TestHeap, PopInOrder)
+{
+  oc_heap_t heap = OC_HEAP_INIT(less);
+  auto items = makeItems(1000);
+  for (auto &it : items) {
+    oc_heap_insert(&heap, &it.node);
+    EXPECT_TRUE(oc_heap_contains(&heap, &it.node));
+  }
+  EXPECT_EQ(0, item(oc_heap_top(&heap))->key);
+
+  auto keys = popAll(&heap);
+  ASSERT_EQ(items.size(), keys.size());
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  for (const auto &it : items) {
+    EXPECT_FALSE(oc_heap_contains(&heap, &it.node));
+  }
+}
+
+TEST_F(TestHeap, Remove)
+{
+  oc_heap_t heap = OC_HEAP_INIT(less);
+  auto items = makeItems(1000);
+  for (auto &it : items) {
+    oc_heap_insert(&heap, &it.node);
+  }
+  // restructure the heap before the removal
+  std::vector<oc_heap_node_t *> popped{};
+  for (int i = 0; i < 10; ++i) {
+    popped.push_back(oc_heap_pop(&heap));
+  }
+  for (auto *node : popped) {
+    oc_heap_insert(&heap, node);
+  }
+
+  for (auto &it : items) {
+    if (it.key % 3 == 0) {
+      oc_heap_remove(&heap, &it.node);
+      EXPECT_FALSE(oc_heap_contains(&heap, &it.node));
+    }
+  }
+  auto keys = popAll(&heap);
+  EXPECT_EQ(items.size() - (items.size() + 2) / 3, keys.size());
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  EXPECT_TRUE(std::none_of(keys.begin(), keys.end(),
+                           [](int key) { return key % 3 == 0; }));
+}
+
+TEST_F(TestHeap, RemoveChangedKey)
+{
+  oc_heap_t heap = OC_HEAP_INIT(less);
+  auto items = makeItems(100);
+  for (auto &it : items) {
+    oc_heap_insert(&heap, &it.node);
+  }
+  oc_heap_pop(&heap);
+
+  // requeue with a new key
+  for (auto &it : items) {
+    if (it.key == 50) {
+      it.key = -1;
+      oc_heap_remove(&heap, &it.node);
+      oc_heap_insert(&heap, &it.node);
+    }
+  }
+  EXPECT_EQ(-1, item(oc_heap_top(&heap))->key);
+  auto keys = popAll(&heap);
+  EXPECT_EQ(items.size() - 1, keys.size());
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+}
+
+TEST_F(TestHeap, RemoveIf)
+{
+  oc_heap_t heap = OC_HEAP_INIT(less);
+  auto items = makeItems(1000);
+  for (auto &it : items) {
+    oc_heap_insert(&heap, &it.node);
+  }
+  oc_heap_pop(&heap);
+
+  int odd = 1;
+  oc_heap_remove_if(
+    &heap,
+    [](const oc_heap_node_t *node, const void *data) {
+      return item(node)->key % 2 == *static_cast<const int *>(data);
+    },
+    &odd);
+  for (const auto &it : items) {
+    if (it.key % 2 != 0) {
+      EXPECT_FALSE(oc_heap_contains(&heap, &it.node));
+    }
+  }
+  auto keys = popAll(&heap);
+  EXPECT_EQ(items.size() / 2 - 1, keys.size());
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  EXPECT_TRUE(std::all_of(keys.begin(), keys.end(),
+                          [](int key) { return key % 2 == 0; }));
+}
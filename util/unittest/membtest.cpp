@@ -0,0 +1,219 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "tests/gtest/Benchmark.h"
+#include "util/oc_memb.h"
+
+#include <array>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestBlock
+{
+  uint64_t a;
+  uint64_t b;
+};
+
+template<typename T, size_t N>
+struct TestPool
+{
+  std::array<char, N> count{};
+  std::array<T, N> mem{};
+  oc_memb memb{ static_cast<unsigned short>(sizeof(T)),
+                static_cast<unsigned short>(N),
+                count.data(),
+                mem.data(),
+                nullptr,
+                OC_MEMB_STATE_INIT };
+};
+
+} // namespace
+
+class TestMemb : public testing::Test {};
+
+TEST_F(TestMemb, AllocFree)
+{
+  TestPool<TestBlock, 4> pool{};
+  EXPECT_EQ(4, oc_memb_numfree(&pool.memb));
+
+  std::set<void *> blocks{};
+  for (size_t i = 0; i < 4; ++i) {
+    auto *block = static_cast<TestBlock *>(oc_memb_alloc(&pool.memb));
+    ASSERT_NE(nullptr, block);
+    EXPECT_TRUE(oc_memb_inmemb(&pool.memb, block));
+    EXPECT_EQ(0, block->a);
+    block->a = i + 1;
+    blocks.insert(block);
+  }
+  EXPECT_EQ(4, blocks.size());
+  EXPECT_EQ(0, oc_memb_numfree(&pool.memb));
+  EXPECT_EQ(nullptr, oc_memb_alloc(&pool.memb));
+
+  // freed blocks are reused and cleared
+  auto *first = static_cast<TestBlock *>(*blocks.begin());
+  oc_memb_free(&pool.memb, first);
+  EXPECT_EQ(1, oc_memb_numfree(&pool.memb));
+  auto *block = static_cast<TestBlock *>(oc_memb_alloc(&pool.memb));
+  EXPECT_EQ(first, block);
+  EXPECT_EQ(0, block->a);
+
+  for (void *b : blocks) {
+    oc_memb_free(&pool.memb, b);
+  }
+  EXPECT_EQ(4, oc_memb_numfree(&pool.memb));
+}
+
+TEST_F(TestMemb, FreeInvalid)
+{
+  TestPool<TestBlock, 2> pool{};
+  void *block = oc_memb_alloc(&pool.memb);
+  ASSERT_NE(nullptr, block);
+
+  // pointers outside of the pool or inside of a block are ignored
+  TestBlock other{};
+  oc_memb_free(&pool.memb, &other);
+  oc_memb_free(&pool.memb, static_cast<char *>(block) + 1);
+  EXPECT_EQ(1, oc_memb_numfree(&pool.memb));
+
+  // double free must not put the block to the free list twice
+  oc_memb_free(&pool.memb, block);
+  oc_memb_free(&pool.memb, block);
+  EXPECT_EQ(2, oc_memb_numfree(&pool.memb));
+  void *b1 = oc_memb_alloc(&pool.memb);
+  void *b2 = oc_memb_alloc(&pool.memb);
+  ASSERT_NE(nullptr, b1);
+  ASSERT_NE(nullptr, b2);
+  EXPECT_NE(b1, b2);
+  EXPECT_EQ(nullptr, oc_memb_alloc(&pool.memb));
+}
+
+TEST_F(TestMemb, SmallBlocks)
+{
+  // blocks too small to store the free list link
+  TestPool<char, 3> pool{};
+  std::vector<void *> blocks{};
+  for (size_t i = 0; i < 3; ++i) {
+    blocks.push_back(oc_memb_alloc(&pool.memb));
+    ASSERT_NE(nullptr, blocks.back());
+  }
+  EXPECT_EQ(nullptr, oc_memb_alloc(&pool.memb));
+  oc_memb_free(&pool.memb, blocks[1]);
+  EXPECT_EQ(blocks[1], oc_memb_alloc(&pool.memb));
+}
+
+TEST_F(TestMemb, Stats)
+{
+  TestPool<TestBlock, 3> pool{};
+  oc_memb_stats_t stats = oc_memb_get_stats(&pool.memb);
+  EXPECT_EQ(0, stats.in_use);
+  EXPECT_EQ(0, stats.max_in_use);
+  EXPECT_EQ(0, stats.failures);
+
+  std::array<void *, 3> blocks{};
+  for (auto &block : blocks) {
+    block = oc_memb_alloc(&pool.memb);
+  }
+  EXPECT_EQ(nullptr, oc_memb_alloc(&pool.memb));
+  EXPECT_EQ(nullptr, oc_memb_alloc(&pool.memb));
+  oc_memb_free(&pool.memb, blocks[0]);
+  oc_memb_free(&pool.memb, blocks[1]);
+  stats = oc_memb_get_stats(&pool.memb);
+  EXPECT_EQ(1, stats.in_use);
+  EXPECT_EQ(3, stats.max_in_use);
+  EXPECT_EQ(2, stats.failures);
+
+  oc_memb_reset_stats(&pool.memb);
+  stats = oc_memb_get_stats(&pool.memb);
+  EXPECT_EQ(1, stats.in_use);
+  EXPECT_EQ(1, stats.max_in_use);
+  EXPECT_EQ(0, stats.failures);
+
+  oc_memb_init(&pool.memb);
+  stats = oc_memb_get_stats(&pool.memb);
+  EXPECT_EQ(0, stats.in_use);
+  EXPECT_EQ(0, stats.max_in_use);
+  EXPECT_EQ(3, oc_memb_numfree(&pool.memb));
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+
+TEST_F(TestMemb, DynamicStats)
+{
+  oc_memb memb{ sizeof(TestBlock), 0, nullptr, nullptr, nullptr,
+                OC_MEMB_STATE_INIT };
+  void *b1 = oc_memb_alloc(&memb);
+  void *b2 = oc_memb_alloc(&memb);
+  ASSERT_NE(nullptr, b1);
+  ASSERT_NE(nullptr, b2);
+  oc_memb_free(&memb, b1);
+  oc_memb_stats_t stats = oc_memb_get_stats(&memb);
+  EXPECT_EQ(1, stats.in_use);
+  EXPECT_EQ(2, stats.max_in_use);
+  oc_memb_free(&memb, b2);
+  EXPECT_EQ(0, oc_memb_get_stats(&memb).in_use);
+}
+
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static int g_buffers_avail{ -1 };
+
+TEST_F(TestMemb, BuffersAvailCallback)
+{
+  TestPool<TestBlock, 2> pool{};
+  oc_memb_set_buffers_avail_cb(&pool.memb, [](int avail) {
+    g_buffers_avail = avail;
+  });
+  void *b1 = oc_memb_alloc(&pool.memb);
+  void *b2 = oc_memb_alloc(&pool.memb);
+  oc_memb_free(&pool.memb, b1);
+  EXPECT_EQ(1, g_buffers_avail);
+  oc_memb_free(&pool.memb, b2);
+  EXPECT_EQ(2, g_buffers_avail);
+}
+
+/** allocation must not scan the pool */
+TEST_F(TestMemb, Benchmark)
+{
+  constexpr size_t kBlocks = 10000;
+  using LargePool = TestPool<TestBlock, kBlocks>;
+  auto pool = std::make_unique<LargePool>();
+  // keep all but the last block allocated
+  for (size_t i = 0; i < kBlocks - 1; ++i) {
+    ASSERT_NE(nullptr, oc_memb_alloc(&pool->memb));
+  }
+
+  constexpr size_t kIterations = 100000;
+  oc::Benchmark("alloc and free, " + std::to_string(kBlocks - 1) +
+                  " blocks in use",
+                kIterations, [&pool](size_t) {
+                  void *block = oc_memb_alloc(&pool->memb);
+                  ASSERT_NE(nullptr, block);
+                  oc_memb_free(&pool->memb, block);
+                });
+  oc::Benchmark("alloc from a full pool", kIterations, [&pool](size_t) {
+    void *block = oc_memb_alloc(&pool->memb);
+    ASSERT_NE(nullptr, block);
+    ASSERT_EQ(nullptr, oc_memb_alloc(&pool->memb));
+    oc_memb_free(&pool->memb, block);
+  });
+}
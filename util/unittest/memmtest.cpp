@@ -16,14 +16,34 @@
  *
  ****************************************************************************/
 
-#include <util/oc_mmem_internal.h>
+#include "tests/gtest/Benchmark.h"
+#include "util/oc_features.h"
+#include "util/oc_mmem_internal.h"
+
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+#include "util/oc_tlsf_internal.h"
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
 
 #include <cstdint>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 
 class TestMemoryPool : public testing::Test {
 public:
   static void SetUpTestCase() { oc_mmem_init(); }
+
+#ifndef OC_DYNAMIC_ALLOCATION
+  /** Number of items of a pool taken by an allocation of one byte */
+  static size_t byteAllocationSize()
+  {
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+    return OC_TLSF_GRANULE_SIZE;
+#else  /* !OC_HAS_FEATURE_MMEM_TLSF */
+    return 1;
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
+  }
+#endif /* !OC_DYNAMIC_ALLOCATION */
 };
 
 TEST_F(TestMemoryPool, AllocAndDeallocByte)
@@ -101,7 +121,8 @@ TEST_F(TestMemoryPool, AllocateMultipleBytes)
   ASSERT_NE(byte1.ptr, nullptr);
   ASSERT_EQ(byte1.size, 1);
 #ifndef OC_DYNAMIC_ALLOCATION
-  EXPECT_EQ(bytePoolSize - 1, oc_mmem_available_size(BYTE_POOL));
+  EXPECT_EQ(bytePoolSize - byteAllocationSize(),
+            oc_mmem_available_size(BYTE_POOL));
 #endif // OC_DYNAMIC_ALLOCATION
   uint8_t byte1Value = 0x42;
   memcpy(byte1.ptr, &byte1Value, 1);
@@ -112,7 +133,8 @@ TEST_F(TestMemoryPool, AllocateMultipleBytes)
   ASSERT_NE(byte2.ptr, nullptr);
   ASSERT_EQ(byte2.size, 1);
 #ifndef OC_DYNAMIC_ALLOCATION
-  EXPECT_EQ(bytePoolSize - 2, oc_mmem_available_size(BYTE_POOL));
+  EXPECT_EQ(bytePoolSize - 2 * byteAllocationSize(),
+            oc_mmem_available_size(BYTE_POOL));
 #endif // OC_DYNAMIC_ALLOCATION
   uint8_t byte2Value = 0x43;
   memcpy(byte2.ptr, &byte2Value, 1);
@@ -125,7 +147,8 @@ TEST_F(TestMemoryPool, AllocateMultipleBytes)
 
   oc_mmem_free(&byte1, BYTE_POOL);
 #ifndef OC_DYNAMIC_ALLOCATION
-  EXPECT_EQ(bytePoolSize - 1, oc_mmem_available_size(BYTE_POOL));
+  EXPECT_EQ(bytePoolSize - byteAllocationSize(),
+            oc_mmem_available_size(BYTE_POOL));
 #endif // OC_DYNAMIC_ALLOCATION
   memcpy(&exp, byte2.ptr, 1);
   EXPECT_EQ(exp, byte2Value);
@@ -285,3 +308,63 @@ TEST_F(TestMemoryPool, ExhaustDoublePool)
 }
 
 #endif // OC_DYNAMIC_ALLOCATION
+
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+
+TEST_F(TestMemoryPool, BlocksAreNotMoved)
+{
+  size_t bytePoolSize = oc_mmem_available_size(BYTE_POOL);
+  oc_mmem byte1{};
+  ASSERT_EQ(10, oc_mmem_alloc(&byte1, 10, BYTE_POOL));
+  oc_mmem byte2{};
+  ASSERT_EQ(10, oc_mmem_alloc(&byte2, 10, BYTE_POOL));
+  void *ptr2 = byte2.ptr;
+
+  oc_mmem_free(&byte1, BYTE_POOL);
+  EXPECT_EQ(ptr2, byte2.ptr);
+  // the freed block is reused
+  oc_mmem byte3{};
+  ASSERT_EQ(10, oc_mmem_alloc(&byte3, 10, BYTE_POOL));
+  EXPECT_NE(ptr2, byte3.ptr);
+
+  oc_mmem_free(&byte3, BYTE_POOL);
+  oc_mmem_free(&byte2, BYTE_POOL);
+  EXPECT_EQ(bytePoolSize, oc_mmem_available_size(BYTE_POOL));
+}
+
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
+
+/** free and allocate blocks in a pool filled by blocks of the same size */
+TEST_F(TestMemoryPool, Benchmark)
+{
+  static constexpr size_t kBlockSize = 16;
+#ifdef OC_DYNAMIC_ALLOCATION
+  size_t count = 100;
+  std::string backend = "malloc";
+#else /* !OC_DYNAMIC_ALLOCATION */
+  size_t count = oc_mmem_available_size(BYTE_POOL) / kBlockSize;
+#ifdef OC_HAS_FEATURE_MMEM_TLSF
+  std::string backend = "tlsf";
+#else  /* !OC_HAS_FEATURE_MMEM_TLSF */
+  std::string backend = "compacting";
+#endif /* OC_HAS_FEATURE_MMEM_TLSF */
+#endif /* OC_DYNAMIC_ALLOCATION */
+  // the pool keeps pointers to the blocks, the vector must not be resized
+  std::vector<oc_mmem> blocks(count);
+  for (auto &block : blocks) {
+    ASSERT_EQ(kBlockSize, oc_mmem_alloc(&block, kBlockSize, BYTE_POOL));
+  }
+
+  oc::Benchmark("free and alloc, " + std::to_string(count) + " blocks, " +
+                  backend + " pool",
+                100000, [&blocks](size_t i) {
+                  oc_mmem &block = blocks[i % blocks.size()];
+                  oc_mmem_free(&block, BYTE_POOL);
+                  ASSERT_EQ(kBlockSize,
+                            oc_mmem_alloc(&block, kBlockSize, BYTE_POOL));
+                });
+
+  for (auto &block : blocks) {
+    oc_mmem_free(&block, BYTE_POOL);
+  }
+}
@@ -0,0 +1,235 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "tests/gtest/Benchmark.h"
+#include "util/oc_list.h"
+#include "util/oc_mpsc_queue_internal.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Item
+{
+  Item *next; // used by oc_list in the benchmark
+  size_t producer;
+  size_t seq;
+};
+
+} // namespace
+
+class TestMPSCQueue : public testing::Test {
+public:
+  static constexpr uint32_t kCapacity = 8;
+
+  void SetUp() override
+  {
+    slots_.fill({});
+    queue_ = { slots_.data(), kCapacity - 1, 0, 0 };
+    for (size_t i = 0; i < items_.size(); ++i) {
+      items_[i] = { nullptr, 0, i };
+    }
+  }
+
+  std::array<oc_mpsc_queue_slot_t, kCapacity> slots_{};
+  oc_mpsc_queue_t queue_{};
+  std::array<Item, 4 * kCapacity> items_{};
+};
+
+TEST_F(TestMPSCQueue, PushPop)
+{
+  EXPECT_EQ(nullptr, oc_mpsc_queue_pop(&queue_));
+  EXPECT_EQ(0, oc_mpsc_queue_size(&queue_));
+
+  EXPECT_TRUE(oc_mpsc_queue_push(&queue_, &items_[0]));
+  EXPECT_TRUE(oc_mpsc_queue_push(&queue_, &items_[1]));
+  EXPECT_EQ(2, oc_mpsc_queue_size(&queue_));
+  EXPECT_EQ(&items_[0], oc_mpsc_queue_pop(&queue_));
+  EXPECT_EQ(&items_[1], oc_mpsc_queue_pop(&queue_));
+  EXPECT_EQ(nullptr, oc_mpsc_queue_pop(&queue_));
+  EXPECT_EQ(nullptr, oc_mpsc_queue_pop_wait(&queue_));
+}
+
+TEST_F(TestMPSCQueue, Full)
+{
+  for (uint32_t i = 0; i < kCapacity; ++i) {
+    ASSERT_TRUE(oc_mpsc_queue_push(&queue_, &items_[i]));
+  }
+  EXPECT_FALSE(oc_mpsc_queue_push(&queue_, &items_[kCapacity]));
+  EXPECT_EQ(kCapacity, oc_mpsc_queue_size(&queue_));
+
+  // a popped item frees a slot
+  EXPECT_EQ(&items_[0], oc_mpsc_queue_pop(&queue_));
+  EXPECT_TRUE(oc_mpsc_queue_push(&queue_, &items_[kCapacity]));
+  EXPECT_FALSE(oc_mpsc_queue_push(&queue_, &items_[kCapacity + 1]));
+  for (uint32_t i = 1; i <= kCapacity; ++i) {
+    EXPECT_EQ(&items_[i], oc_mpsc_queue_pop_wait(&queue_));
+  }
+  EXPECT_EQ(nullptr, oc_mpsc_queue_pop(&queue_));
+}
+
+TEST_F(TestMPSCQueue, Wrap)
+{
+  // start close to the overflow of the positions
+  uint32_t start = UINT32_MAX - kCapacity - 2;
+  queue_.enqueue_pos = start;
+  queue_.dequeue_pos = start;
+  for (uint32_t i = 0; i < kCapacity; ++i) {
+    uint32_t pos = start + i;
+    slots_[pos & (kCapacity - 1)].sequence = pos - (pos & (kCapacity - 1));
+  }
+
+  for (size_t round = 0; round < 8; ++round) {
+    for (size_t i = 0; i < kCapacity / 2 + round % 3; ++i) {
+      ASSERT_TRUE(oc_mpsc_queue_push(&queue_, &items_[i]));
+    }
+    for (size_t i = 0; i < kCapacity / 2 + round % 3; ++i) {
+      ASSERT_EQ(&items_[i], oc_mpsc_queue_pop(&queue_));
+    }
+    ASSERT_EQ(nullptr, oc_mpsc_queue_pop(&queue_));
+  }
+  EXPECT_LT(queue_.dequeue_pos, start);
+}
+
+TEST_F(TestMPSCQueue, RemoveIf)
+{
+  for (uint32_t i = 0; i < kCapacity; ++i) {
+    ASSERT_TRUE(oc_mpsc_queue_push(&queue_, &items_[i]));
+  }
+  auto odd = [](void *item, const void *) {
+    return static_cast<Item *>(item)->seq % 2 == 1;
+  };
+  EXPECT_EQ(kCapacity / 2, oc_mpsc_queue_remove_if(&queue_, odd, nullptr));
+  EXPECT_EQ(0, oc_mpsc_queue_remove_if(&queue_, odd, nullptr));
+
+  // removed items are skipped
+  for (uint32_t i = 0; i < kCapacity; i += 2) {
+    EXPECT_EQ(&items_[i], oc_mpsc_queue_pop(&queue_));
+  }
+  EXPECT_EQ(nullptr, oc_mpsc_queue_pop(&queue_));
+  EXPECT_EQ(0, oc_mpsc_queue_size(&queue_));
+}
+
+namespace {
+
+// push items from several threads while a consumer pops them, returns the
+// number of failed pushes
+template<typename Push, typename Pop>
+size_t
+runProducers(size_t producers, size_t items_per_producer, Push push, Pop pop,
+             std::vector<std::vector<Item>> &items)
+{
+  items.assign(producers, std::vector<Item>(items_per_producer));
+  std::atomic<size_t> failed{ 0 };
+  std::atomic<size_t> running{ producers };
+  std::vector<std::thread> threads{};
+  for (size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p]() {
+      for (size_t i = 0; i < items_per_producer; ++i) {
+        Item *item = &items[p][i];
+        *item = { nullptr, p, i };
+        while (!push(item)) {
+          ++failed;
+          std::this_thread::yield();
+        }
+      }
+      --running;
+    });
+  }
+
+  std::vector<size_t> next(producers, 0);
+  size_t popped = 0;
+  while (popped < producers * items_per_producer) {
+    Item *item = pop();
+    if (item == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    // the items of a producer are popped in order
+    EXPECT_EQ(next[item->producer], item->seq);
+    next[item->producer] = item->seq + 1;
+    ++popped;
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, running.load());
+  return failed.load();
+}
+
+} // namespace
+
+TEST_F(TestMPSCQueue, Concurrent)
+{
+  std::vector<std::vector<Item>> items{};
+  // the queue is small, so the producers wait for the consumer
+  runProducers(
+    4, 20000, [this](Item *item) { return oc_mpsc_queue_push(&queue_, item); },
+    [this]() { return static_cast<Item *>(oc_mpsc_queue_pop(&queue_)); },
+    items);
+  EXPECT_EQ(nullptr, oc_mpsc_queue_pop_wait(&queue_));
+  EXPECT_EQ(0, oc_mpsc_queue_size(&queue_));
+}
+
+// measures the speed only, run with --gtest_also_run_disabled_tests
+TEST_F(TestMPSCQueue, DISABLED_Benchmark)
+{
+  constexpr size_t kProducers = 4;
+  constexpr size_t kItems = 50000;
+  constexpr size_t kIterations = 3;
+  std::vector<std::vector<Item>> items{};
+
+  // previous implementation: a list guarded by a mutex
+  std::mutex mutex{};
+  OC_LIST_LOCAL(list);
+  auto locked = oc::Benchmark(
+    "NetworkEvents.MutexList", kIterations, [&](size_t) {
+      runProducers(
+        kProducers, kItems,
+        [&](Item *item) {
+          std::lock_guard<std::mutex> lock(mutex);
+          oc_list_add(list, item);
+          return true;
+        },
+        [&]() {
+          std::lock_guard<std::mutex> lock(mutex);
+          return static_cast<Item *>(oc_list_pop(list));
+        },
+        items);
+    });
+
+  std::vector<oc_mpsc_queue_slot_t> slots(256);
+  oc_mpsc_queue_t queue = { slots.data(),
+                            static_cast<uint32_t>(slots.size() - 1), 0, 0 };
+  auto lockfree = oc::Benchmark(
+    "NetworkEvents.MPSCQueue", kIterations, [&](size_t) {
+      runProducers(
+        kProducers, kItems,
+        [&](Item *item) { return oc_mpsc_queue_push(&queue, item); },
+        [&]() { return static_cast<Item *>(oc_mpsc_queue_pop(&queue)); },
+        items);
+    });
+  printf("[ BENCH    ] lock-free queue is %.1fx faster\n",
+         locked.NsPerOp() / lockfree.NsPerOp());
+}
@@ -0,0 +1,148 @@
+/****************************************************************************
+ *
+ * Copyright (c) 2024 plgd.dev s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "util/oc_tlsf_internal.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+class TestTLSF : public testing::Test {
+public:
+  static constexpr size_t kGranules = 64;
+
+  void SetUp() override
+  {
+    oc_tlsf_init(&tlsf_, buffer_.data(), boundaries_.data(), kGranules);
+  }
+
+  uint8_t *base() { return reinterpret_cast<uint8_t *>(buffer_.data()); }
+
+  oc_tlsf_t tlsf_{};
+  std::array<uint64_t, kGranules> buffer_{};
+  std::array<uint8_t, OC_TLSF_BOUNDARIES_SIZE(kGranules)> boundaries_{};
+};
+
+TEST_F(TestTLSF, AllocFree)
+{
+  EXPECT_EQ(kGranules * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+
+  void *a = oc_tlsf_alloc(&tlsf_, 1);
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ((kGranules - 1) * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+  // a zero size takes a granule
+  void *b = oc_tlsf_alloc(&tlsf_, 0);
+  ASSERT_NE(nullptr, b);
+  void *c = oc_tlsf_alloc(&tlsf_, 3 * OC_TLSF_GRANULE_SIZE + 1);
+  ASSERT_NE(nullptr, c);
+  EXPECT_EQ((kGranules - 6) * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(c) % OC_TLSF_GRANULE_SIZE);
+
+  oc_tlsf_free(&tlsf_, b, 0);
+  oc_tlsf_free(&tlsf_, a, 1);
+  oc_tlsf_free(&tlsf_, c, 3 * OC_TLSF_GRANULE_SIZE + 1);
+  EXPECT_EQ(kGranules * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+
+  // all blocks were merged back
+  void *all = oc_tlsf_alloc(&tlsf_, kGranules * OC_TLSF_GRANULE_SIZE);
+  EXPECT_EQ(base(), all);
+}
+
+TEST_F(TestTLSF, Exhaust)
+{
+  std::vector<void *> blocks{};
+  for (size_t i = 0; i < kGranules; ++i) {
+    void *block = oc_tlsf_alloc(&tlsf_, OC_TLSF_GRANULE_SIZE);
+    ASSERT_NE(nullptr, block);
+    blocks.push_back(block);
+  }
+  EXPECT_EQ(0, oc_tlsf_free_size(&tlsf_));
+  EXPECT_EQ(nullptr, oc_tlsf_alloc(&tlsf_, 1));
+
+  // free every other block, no two granules are adjacent
+  for (size_t i = 0; i < blocks.size(); i += 2) {
+    oc_tlsf_free(&tlsf_, blocks[i], OC_TLSF_GRANULE_SIZE);
+  }
+  EXPECT_EQ(kGranules / 2 * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+  EXPECT_EQ(nullptr, oc_tlsf_alloc(&tlsf_, 2 * OC_TLSF_GRANULE_SIZE));
+  // filling the holes merges the neighbours
+  oc_tlsf_free(&tlsf_, blocks[1], OC_TLSF_GRANULE_SIZE);
+  EXPECT_EQ(blocks[0], oc_tlsf_alloc(&tlsf_, 3 * OC_TLSF_GRANULE_SIZE));
+}
+
+TEST_F(TestTLSF, FreeInvalid)
+{
+  void *a = oc_tlsf_alloc(&tlsf_, OC_TLSF_GRANULE_SIZE);
+  ASSERT_NE(nullptr, a);
+  size_t free = oc_tlsf_free_size(&tlsf_);
+
+  uint64_t other{};
+  oc_tlsf_free(&tlsf_, &other, 1);
+  oc_tlsf_free(&tlsf_, base() + 1, 1);
+  oc_tlsf_free(&tlsf_, base() + kGranules * OC_TLSF_GRANULE_SIZE, 1);
+  EXPECT_EQ(free, oc_tlsf_free_size(&tlsf_));
+
+  oc_tlsf_free(&tlsf_, a, OC_TLSF_GRANULE_SIZE);
+  // double free of a block merged with a following free block
+  oc_tlsf_free(&tlsf_, a, OC_TLSF_GRANULE_SIZE);
+  EXPECT_EQ(kGranules * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+}
+
+TEST_F(TestTLSF, Random)
+{
+  struct Block
+  {
+    uint8_t *ptr;
+    size_t size;
+    uint8_t fill;
+  };
+  std::vector<Block> blocks{};
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> sizes(1, 6 * OC_TLSF_GRANULE_SIZE);
+  for (int i = 0; i < 10000; ++i) {
+    if (blocks.empty() || gen() % 2 == 0) {
+      size_t size = sizes(gen);
+      auto *ptr = static_cast<uint8_t *>(oc_tlsf_alloc(&tlsf_, size));
+      if (ptr == nullptr) {
+        continue;
+      }
+      ASSERT_GE(ptr, base());
+      ASSERT_LE(ptr + size, base() + kGranules * OC_TLSF_GRANULE_SIZE);
+      auto fill = static_cast<uint8_t>(i);
+      memset(ptr, fill, size);
+      blocks.push_back({ ptr, size, fill });
+      continue;
+    }
+    size_t index = gen() % blocks.size();
+    Block block = blocks[index];
+    blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(index));
+    // allocated blocks must not overlap
+    ASSERT_TRUE(std::all_of(block.ptr, block.ptr + block.size,
+                            [&block](uint8_t v) { return v == block.fill; }));
+    oc_tlsf_free(&tlsf_, block.ptr, block.size);
+  }
+  for (const auto &block : blocks) {
+    oc_tlsf_free(&tlsf_, block.ptr, block.size);
+  }
+  EXPECT_EQ(kGranules * OC_TLSF_GRANULE_SIZE, oc_tlsf_free_size(&tlsf_));
+  EXPECT_EQ(base(), oc_tlsf_alloc(&tlsf_, kGranules * OC_TLSF_GRANULE_SIZE));
+}